@@ -9,12 +9,10 @@
 #include <bindable/PixelShader.h>
 #include <bindable/IndexBuffer.h>
 #include <bindable/InputLayout.h>
-#include <bindable/TextureCube.h>
+#include <bindable/ManagedTexture.h>
 #include <bindable/TextureSampler.h>
 
-#include "stb_image.h"
-
-Cubemap::Cubemap(Graphics& gfx, std::string path)
+Cubemap::Cubemap(Graphics& gfx, ResourceManager& resources, std::string path, UINT placeholder)
 	: IDrawable()
 {
 	Vertex* data = new Vertex[8];
@@ -45,7 +43,7 @@ Cubemap::Cubemap(Graphics& gfx, std::string path)
 	addBindable(new InputLayout(gfx, vertex_desc_buffer, sizeof(vertex_desc_buffer) / sizeof(D3D11_INPUT_ELEMENT_DESC), cubemap_vs_shader->getBytecode()));
 	addBindable(new PixelShader(gfx, "cubemap_ps.cso"));
 	addBindable(new TextureSampler(gfx, 0, D3D11_FILTER_MIN_MAG_MIP_LINEAR ));
-	addBindable(new TextureCube(gfx, path, 0));
+	addBindable(new ManagedTexture(resources, resources.loadTextureCube(path, placeholder), 0));
 }
 
 Cubemap::~Cubemap()
@@ -13,12 +13,14 @@
 #include <vector>
 
 #include <drawable/IDrawable.h>
+#include <resource/ResourceManager.h>
 #include <Graphics.h>
 
 class Cubemap : public IDrawable
 {
 public:
-	Cubemap(Graphics& gfx, std::string path);
+	// The faces load through resources, placeholder is the color drawn until they are uploaded
+	Cubemap(Graphics& gfx, ResourceManager& resources, std::string path, UINT placeholder);
 	~Cubemap();
 };
 
@@ -150,6 +150,11 @@ void Graphics::drawIndexed(UINT indexCount)
 	d3d_context->DrawIndexed(indexCount, 0, 0);
 }
 
+void Graphics::drawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+{
+	d3d_context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
 void Graphics::present()
 {
 	swap_chain->Present(1, 0);
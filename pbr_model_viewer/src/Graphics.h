@@ -14,6 +14,7 @@
 class Graphics
 {
 	friend class IBindable;
+	friend class D3D11ResourceDevice;
 public:
 	Graphics(HWND hwnd, int screen_width, int screen_height);
 	~Graphics();
@@ -21,6 +22,7 @@ public:
 	void clear(const FLOAT clear_color[4]);
 	void change_fill_mode(D3D11_FILL_MODE mode);
 	void drawIndexed(UINT indexCount);
+	void drawIndexed(UINT indexCount, UINT startIndex, INT baseVertex);
 	void present();
 
 private:
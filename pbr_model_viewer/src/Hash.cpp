@@ -0,0 +1,114 @@
+#include "Hash.h"
+
+#include <cstring>
+
+#include <MappedFile.h>
+
+static const uint64_t prime_1 = 0x9E3779B185EBCA87ull;
+static const uint64_t prime_2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t prime_3 = 0x165667B19E3779F9ull;
+static const uint64_t prime_4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t prime_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char* p)
+{
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t read32(const unsigned char* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint64_t round(uint64_t acc, uint64_t input)
+{
+	acc += input * prime_2;
+	acc = rotl(acc, 31);
+	return acc * prime_1;
+}
+
+static inline uint64_t merge_round(uint64_t acc, uint64_t value)
+{
+	acc ^= round(0, value);
+	return acc * prime_1 + prime_4;
+}
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const unsigned char* end = p + size;
+	uint64_t hash;
+
+	if (size >= 32)
+	{
+		// Four independent lanes so the multiplies pipeline
+		uint64_t v1 = seed + prime_1 + prime_2;
+		uint64_t v2 = seed + prime_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - prime_1;
+		const unsigned char* limit = end - 32;
+		do
+		{
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		hash = merge_round(hash, v1);
+		hash = merge_round(hash, v2);
+		hash = merge_round(hash, v3);
+		hash = merge_round(hash, v4);
+	}
+	else
+	{
+		hash = seed + prime_5;
+	}
+
+	hash += size;
+	for (; p + 8 <= end; p += 8)
+	{
+		hash ^= round(0, read64(p));
+		hash = rotl(hash, 27) * prime_1 + prime_4;
+	}
+	if (p + 4 <= end)
+	{
+		hash ^= uint64_t(read32(p)) * prime_1;
+		hash = rotl(hash, 23) * prime_2 + prime_3;
+		p += 4;
+	}
+	for (; p < end; p++)
+	{
+		hash ^= (*p) * prime_5;
+		hash = rotl(hash, 11) * prime_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= prime_2;
+	hash ^= hash >> 29;
+	hash *= prime_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+bool hash_file(const std::string& filename, uint64_t& hash)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+	hash = hash_bytes(file.getData(), file.getSize());
+	return true;
+}
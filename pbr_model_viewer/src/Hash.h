@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// 64 bit XXH64 hash of a block of memory
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+
+// Hashes the whole content of a file through a memory mapping, returns false if it can't be opened
+bool hash_file(const std::string& filename, uint64_t& hash);
+
+inline uint64_t hash_combine(uint64_t hash, uint64_t value)
+{
+	return hash_bytes(&value, sizeof(value), hash);
+}
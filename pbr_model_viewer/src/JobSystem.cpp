@@ -0,0 +1,216 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+// Index of the worker running on this thread, or no_worker for threads outside the pool
+static const size_t no_worker = size_t(-1);
+static thread_local size_t current_worker = no_worker;
+
+JobSystem::WorkStealingDeque::WorkStealingDeque()
+	: m_top(0)
+	, m_bottom(0)
+{
+	for (std::atomic<Job*>& job : m_jobs)
+	{
+		job.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+bool JobSystem::WorkStealingDeque::push(Job* job)
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= capacity)
+	{
+		return false;
+	}
+	m_jobs[bottom & (capacity - 1)].store(job, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::pop()
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+	if (top > bottom)
+	{
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job* job = m_jobs[bottom & (capacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last job, race the thieves for it
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::steal()
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+	Job* job = m_jobs[top & (capacity - 1)].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return job;
+}
+
+JobSystem::JobSystem(size_t worker_count)
+	: m_queued(0)
+	, m_stop(false)
+{
+	for (size_t i = 0; i < worker_count; i++)
+	{
+		m_deques.emplace_back(new WorkStealingDeque());
+	}
+	for (size_t i = 0; i < worker_count; i++)
+	{
+		m_workers.emplace_back(&JobSystem::workerMain, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	for (Job* job : m_shared)
+	{
+		delete job;
+	}
+}
+
+JobSystem& JobSystem::get()
+{
+	// Keep at least one worker, jobs submitted by the main thread would otherwise only run once it waits
+	static JobSystem job_system(std::max<size_t>(2, std::thread::hardware_concurrency()) - 1);
+	return job_system;
+}
+
+void JobSystem::submit(JobFunction func, JobCounter* counter)
+{
+	if (counter)
+	{
+		counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	Job* job = new Job{ std::move(func), counter };
+	m_queued.fetch_add(1, std::memory_order_release);
+
+	// Workers keep their own jobs local, everyone else and full deques go through the shared queue
+	bool queued = current_worker != no_worker && m_deques[current_worker]->push(job);
+	if (!queued)
+	{
+		std::lock_guard<std::mutex> lock(m_sharedMutex);
+		m_shared.push_back(job);
+	}
+
+	// Taking the lock orders the wake up after a sleeping worker's check of m_queued
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wake.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	while (!counter.isDone())
+	{
+		Job* job = findJob(current_worker);
+		if (job)
+		{
+			execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::workerMain(size_t index)
+{
+	current_worker = index;
+	while (true)
+	{
+		Job* job = findJob(index);
+		if (job)
+		{
+			execute(job);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+		if (m_stop)
+		{
+			return;
+		}
+	}
+}
+
+JobSystem::Job* JobSystem::findJob(size_t self)
+{
+	if (m_queued.load(std::memory_order_acquire) <= 0)
+	{
+		return nullptr;
+	}
+
+	Job* job = self != no_worker ? m_deques[self]->pop() : nullptr;
+	if (!job)
+	{
+		std::lock_guard<std::mutex> lock(m_sharedMutex);
+		if (!m_shared.empty())
+		{
+			job = m_shared.front();
+			m_shared.pop_front();
+		}
+	}
+
+	// Steal starting from the next worker so thieves spread over the victims
+	size_t worker_count = m_deques.size();
+	size_t first = self != no_worker ? self + 1 : 0;
+	for (size_t i = 0; !job && i < worker_count; i++)
+	{
+		size_t victim = (first + i) % worker_count;
+		if (victim != self)
+		{
+			job = m_deques[victim]->steal();
+		}
+	}
+
+	if (job)
+	{
+		m_queued.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+void JobSystem::execute(Job* job)
+{
+	job->func();
+	if (job->counter)
+	{
+		job->counter->m_pending.fetch_sub(1, std::memory_order_release);
+	}
+	delete job;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of unfinished jobs of a group. Jobs may submit children to the counter of their parent,
+// which then only reaches zero once the whole tree is done.
+class JobCounter
+{
+public:
+	JobCounter() : m_pending(0) {}
+
+	bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	std::atomic<int> m_pending;
+};
+
+// Fixed size work stealing thread pool shared by the whole app. Every worker pushes the jobs it submits on its own
+// lock-free deque and pops them back LIFO, idle workers steal FIFO from the others. Threads outside the pool submit
+// through a shared queue. Waiting on a counter runs queued jobs in the meantime, so jobs can wait on their children
+// and the main thread never just blocks.
+class JobSystem
+{
+public:
+	typedef std::function<void()> JobFunction;
+
+	explicit JobSystem(size_t worker_count);
+	~JobSystem();
+
+	// The shared pool, one worker per hardware thread besides the main thread
+	static JobSystem& get();
+
+	// Queues func. counter, if any, is incremented now and decremented once func has returned.
+	void submit(JobFunction func, JobCounter* counter);
+	// Runs queued jobs on the calling thread until counter reaches zero
+	void wait(JobCounter& counter);
+
+	// Workers plus the thread that waits, how many threads can run jobs at once
+	size_t getThreadCount() const { return m_workers.size() + 1; }
+
+private:
+	struct Job
+	{
+		JobFunction func;
+		JobCounter* counter;
+	};
+
+	// Chase-Lev deque with a fixed capacity. Only the owning worker pushes and pops at the bottom, anyone steals at the top.
+	class WorkStealingDeque
+	{
+	public:
+		WorkStealingDeque();
+
+		bool push(Job* job);
+		Job* pop();
+		Job* steal();
+
+	private:
+		static const int64_t capacity = 4096;
+
+		std::atomic<int64_t> m_top;
+		std::atomic<int64_t> m_bottom;
+		std::atomic<Job*> m_jobs[capacity];
+	};
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void workerMain(size_t index);
+	Job* findJob(size_t self);
+	void execute(Job* job);
+
+	std::vector<std::unique_ptr<WorkStealingDeque>> m_deques;
+	std::vector<std::thread> m_workers;
+	std::mutex m_sharedMutex;
+	std::deque<Job*> m_shared;
+	std::atomic<int> m_queued;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<bool> m_stop;
+};
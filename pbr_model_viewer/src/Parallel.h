@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <JobSystem.h>
+
+// Splits [0, count) in contiguous ranges of at least min_range elements and calls func(begin, end)
+// for each of them as a job on the shared JobSystem, using at most max_workers ranges. The calling thread processes
+// the first range itself and then helps with the rest, so it is safe to call from inside another job.
+template<typename Func>
+inline void parallel_for_workers(size_t max_workers, size_t count, size_t min_range, Func func)
+{
+	size_t workers = std::max<size_t>(1, max_workers);
+	workers = std::min(workers, (count + min_range - 1) / std::max<size_t>(1, min_range));
+	if (workers <= 1)
+	{
+		if (count > 0) func(size_t(0), count);
+		return;
+	}
+
+	JobSystem& job_system = JobSystem::get();
+	JobCounter counter;
+	size_t range = (count + workers - 1) / workers;
+	for (size_t begin = range; begin < count; begin += range)
+	{
+		size_t end = std::min(count, begin + range);
+		job_system.submit([&func, begin, end]() { func(begin, end); }, &counter);
+	}
+	func(size_t(0), range);
+	job_system.wait(counter);
+}
+
+// parallel_for_workers with one range per thread of the JobSystem
+template<typename Func>
+inline void parallel_for(size_t count, size_t min_range, Func func)
+{
+	parallel_for_workers(JobSystem::get().getThreadCount(), count, min_range, func);
+}
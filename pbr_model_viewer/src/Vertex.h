@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include <d3d11.h>
 #include <directxmath.h>
 
@@ -19,4 +21,29 @@ static D3D11_INPUT_ELEMENT_DESC vertex_desc_buffer[6] = {
 	{"TEXCOORDS", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 40, D3D11_INPUT_PER_VERTEX_DATA, 0},
 	{"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 48, D3D11_INPUT_PER_VERTEX_DATA, 0},
 	{"BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 60, D3D11_INPUT_PER_VERTEX_DATA, 0}
-};
\ No newline at end of file
+};
+
+// Quantized vertex, 20 bytes instead of 72:
+// - position as snorm16 relative to the mesh bounds, w holds the sign of the bitangent
+// - normal and tangent as octahedral snorm16
+// - uvs as half floats
+// The bounds needed to dequantize the position are provided by a constant buffer (see MeshDequantization).
+typedef struct CompactVertex {
+	int16_t position[4];
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t uvs[2];
+} CompactVertex;
+
+static D3D11_INPUT_ELEMENT_DESC compact_vertex_desc_buffer[4] = {
+	{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	{"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	{"TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	{"TEXCOORDS", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0}
+};
+
+// Vertex shader constant buffer used to rebuild positions from CompactVertex
+typedef struct MeshDequantization {
+	DirectX::XMFLOAT4 boundsCenter;
+	DirectX::XMFLOAT4 boundsExtent;
+} MeshDequantization;
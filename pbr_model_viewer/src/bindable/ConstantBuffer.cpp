@@ -7,7 +7,14 @@ ConstantBuffer::~ConstantBuffer()
 
 void ConstantBuffer::bind(Graphics& gfx)
 {
-	getContext(gfx)->VSSetConstantBuffers(m_slot, 1, &m_buffer);
+	if (m_stage == Pixel)
+	{
+		getContext(gfx)->PSSetConstantBuffers(m_slot, 1, &m_buffer);
+	}
+	else
+	{
+		getContext(gfx)->VSSetConstantBuffers(m_slot, 1, &m_buffer);
+	}
 }
 
 void ConstantBuffer::update(Graphics& gfx, void const* data, UINT size)
@@ -6,8 +6,15 @@
 class ConstantBuffer : public IBindable
 {
 public:
+	// Shader stage the buffer is bound to
+	enum Stage
+	{
+		Vertex,
+		Pixel,
+	};
+
 	template<typename T>
-	ConstantBuffer(Graphics& gfx, T* data, UINT slot);
+	ConstantBuffer(Graphics& gfx, T* data, UINT slot, Stage stage = Vertex);
 	~ConstantBuffer();
 
 	virtual void bind(Graphics& gfx) override;
@@ -17,12 +24,14 @@ public:
 private:
 	ID3D11Buffer* m_buffer;
 	UINT m_slot;
+	Stage m_stage;
 };
 
 template<typename T>
-inline ConstantBuffer::ConstantBuffer(Graphics& gfx, T* data, UINT slot)
+inline ConstantBuffer::ConstantBuffer(Graphics& gfx, T* data, UINT slot, Stage stage)
 	: m_buffer(nullptr)
 	, m_slot(slot)
+	, m_stage(stage)
 {
 	D3D11_BUFFER_DESC desc;
 	desc.ByteWidth = sizeof(T);
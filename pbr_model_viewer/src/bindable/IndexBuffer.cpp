@@ -1,19 +1,35 @@
 #include "IndexBuffer.h"
 
-IndexBuffer::IndexBuffer(Graphics& gfx, UINT* indices, UINT count)
+#include <mesh/IndexNarrowing.h>
+
+IndexBuffer::IndexBuffer(Graphics& gfx, const UINT* indices, UINT count)
 	: m_indexBuffer(nullptr)
 	, m_indexCount(count)
+	, m_format(DXGI_FORMAT_R32_UINT)
+	, m_indexSize(sizeof(UINT))
 {
+	// Indices are local to their submesh, so most buffers fit in 16 bits and only need half the memory
+	std::vector<uint16_t> narrow_indices_data;
+	const void* data = indices;
+	if (fits_16bit_indices(indices, count))
+	{
+		narrow_indices_data.resize(count);
+		narrow_indices(indices, count, narrow_indices_data.data());
+		data = narrow_indices_data.data();
+		m_format = DXGI_FORMAT_R16_UINT;
+		m_indexSize = sizeof(uint16_t);
+	}
+
 	D3D11_BUFFER_DESC vertex_indices_desc;
-	vertex_indices_desc.ByteWidth = m_indexCount * sizeof(UINT);
+	vertex_indices_desc.ByteWidth = m_indexCount * m_indexSize;
 	vertex_indices_desc.Usage = D3D11_USAGE_IMMUTABLE;
 	vertex_indices_desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	vertex_indices_desc.CPUAccessFlags = 0;
 	vertex_indices_desc.MiscFlags = 0;
-	vertex_indices_desc.StructureByteStride = sizeof(UINT);
+	vertex_indices_desc.StructureByteStride = m_indexSize;
 
 	D3D11_SUBRESOURCE_DATA vertex_indices_subresource_data;
-	vertex_indices_subresource_data.pSysMem = indices;
+	vertex_indices_subresource_data.pSysMem = data;
 
 
 	getDevice(gfx)->CreateBuffer(&vertex_indices_desc, &vertex_indices_subresource_data, &m_indexBuffer);
@@ -26,5 +42,5 @@ IndexBuffer::~IndexBuffer()
 
 void IndexBuffer::bind(Graphics& gfx)
 {
-	getContext(gfx)->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	getContext(gfx)->IASetIndexBuffer(m_indexBuffer, m_format, 0);
 }
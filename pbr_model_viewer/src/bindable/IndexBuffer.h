@@ -8,16 +8,21 @@
 class IndexBuffer : public IBindable
 {
 public:
-	IndexBuffer(Graphics& gfx, UINT* indices, UINT count);
+	IndexBuffer(Graphics& gfx, const UINT* indices, UINT count);
 	virtual ~IndexBuffer();
 
 	virtual void bind(Graphics& gfx) override;
 
 	UINT getIndexCount() const { return m_indexCount; }
+	// Either 2 or 4 bytes, chosen from the largest index when the buffer is created
+	UINT getIndexSize() const { return m_indexSize; }
+	DXGI_FORMAT getFormat() const { return m_format; }
 
 private:
 	ID3D11Buffer* m_indexBuffer;
 	UINT m_indexCount;
+	DXGI_FORMAT m_format;
+	UINT m_indexSize;
 	UINT m_stride;
 	UINT m_offset;
 };
@@ -0,0 +1,20 @@
+#include "ManagedTexture.h"
+
+ManagedTexture::ManagedTexture(ResourceManager& resources, TextureHandle handle, UINT slot)
+	: m_resources(resources)
+	, m_handle(handle)
+	, m_slot(slot)
+{
+}
+
+ManagedTexture::~ManagedTexture()
+{
+	m_resources.release(m_handle);
+}
+
+void ManagedTexture::bind(Graphics& gfx)
+{
+	m_resources.markVisible(m_handle);
+	ID3D11ShaderResourceView* srv = static_cast<ID3D11ShaderResourceView*>(m_resources.getTexture(m_handle));
+	getContext(gfx)->PSSetShaderResources(m_slot, 1, &srv);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <bindable/IBindable.h>
+#include <resource/ResourceManager.h>
+#include <Graphics.h>
+
+// Texture of a ResourceManager bound to a pixel shader slot. Binds the placeholder while the texture loads,
+// owns the handle and releases it when deleted.
+class ManagedTexture : public IBindable
+{
+public:
+	ManagedTexture(ResourceManager& resources, TextureHandle handle, UINT slot);
+	~ManagedTexture();
+
+	virtual void bind(Graphics& gfx) override;
+
+	TextureHandle getHandle() const { return m_handle; }
+	UINT getSlot() const { return m_slot; }
+
+private:
+	ResourceManager& m_resources;
+	TextureHandle m_handle;
+	UINT m_slot;
+};
@@ -68,16 +68,45 @@ void IDrawable::deleteBindable( IBindable* bindable )
 									   } ), m_bindables.end() );
 }
 
+void IDrawable::removeBindable( IBindable* bindable )
+{
+	m_bindables.erase( std::remove( m_bindables.begin(), m_bindables.end(), bindable ), m_bindables.end() );
+}
+
+void IDrawable::setTexture( ManagedTexture* texture )
+{
+	auto it = std::find_if( m_bindables.begin(), m_bindables.end(), [texture] ( IBindable* bindable )
+							{
+								ManagedTexture* other = dynamic_cast<ManagedTexture*>( bindable );
+								return other && other->getSlot() == texture->getSlot();
+							} );
+	if ( it != m_bindables.end() )
+	{
+		delete *it;
+		m_bindables.erase( it );
+	}
+	addBindable( texture );
+}
+
 void IDrawable::draw(Graphics& gfx)
 {
-	if (m_vertices && m_indices)
+	if (bindAll(gfx))
 	{
-		for (IBindable* bindable : m_bindables)
-		{
-			bindable->bind(gfx);
-		}
-		m_vertices->bind(gfx);
-		m_indices->bind(gfx);
 		gfx.drawIndexed(m_indices->getIndexCount());
 	}
 }
+
+bool IDrawable::bindAll(Graphics& gfx)
+{
+	if (!m_vertices || !m_indices)
+	{
+		return false;
+	}
+	for (IBindable* bindable : m_bindables)
+	{
+		bindable->bind(gfx);
+	}
+	m_vertices->bind(gfx);
+	m_indices->bind(gfx);
+	return true;
+}
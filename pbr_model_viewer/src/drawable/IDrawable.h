@@ -5,6 +5,7 @@
 #include <bindable/IBindable.h>
 #include <bindable/VertexBuffer.h>
 #include <bindable/IndexBuffer.h>
+#include <bindable/ManagedTexture.h>
 #include <bindable/PixelShader.h>
 #include <Graphics.h>
 
@@ -18,8 +19,17 @@ public:
 	void changePixelShader( PixelShader* new_ps );
 	virtual void addBindable( IBindable* bindable );
 	virtual void deleteBindable( IBindable* bindable );
+	// Detaches a bindable that is owned elsewhere, without deleting it
+	virtual void removeBindable( IBindable* bindable );
+	// Adds a texture, deleting the one previously bound to the same slot
+	void setTexture( ManagedTexture* texture );
 	virtual void draw(Graphics& gfx);
 
+protected:
+	// Binds every bindable plus the vertex and index buffers, returns false if there is no mesh to draw
+	bool bindAll(Graphics& gfx);
+	IndexBuffer* getIndices() const { return m_indices; }
+
 private:
 	VertexBuffer* m_vertices;
 	IndexBuffer* m_indices;
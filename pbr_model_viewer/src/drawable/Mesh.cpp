@@ -0,0 +1,149 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <mesh/MeshletBuilder.h>
+
+Mesh::Mesh()
+	: IDrawable()
+	, m_boundsCenter(0.0f, 0.0f, 0.0f)
+	, m_boundsRadius(0.0f)
+	, m_lod(0)
+	, m_visibleMeshlets(0)
+	, m_visibleTriangles(0)
+{
+}
+
+Mesh::~Mesh()
+{
+}
+
+void Mesh::setSubmeshes(const std::vector<Submesh>& submeshes)
+{
+	m_submeshes = submeshes;
+	resetCulling();
+}
+
+void Mesh::setMeshlets(const std::vector<Meshlet>& meshlets)
+{
+	m_meshlets = meshlets;
+	resetCulling();
+}
+
+void Mesh::setLods(const std::vector<MeshLod>& lods, const std::vector<Submesh>& lod_submeshes)
+{
+	m_lods = lods;
+	m_lodSubmeshes = lod_submeshes;
+	m_lod = 0;
+	resetCulling();
+}
+
+void Mesh::setBounds(const DirectX::XMFLOAT3& bounds_min, const DirectX::XMFLOAT3& bounds_max)
+{
+	m_boundsCenter = { (bounds_min.x + bounds_max.x) * 0.5f, (bounds_min.y + bounds_max.y) * 0.5f, (bounds_min.z + bounds_max.z) * 0.5f };
+	float dx = bounds_max.x - m_boundsCenter.x, dy = bounds_max.y - m_boundsCenter.y, dz = bounds_max.z - m_boundsCenter.z;
+	m_boundsRadius = std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+void Mesh::selectLod(const Camera& camera, float viewport_height, float max_pixel_error)
+{
+	if (m_lods.empty())
+	{
+		return;
+	}
+
+	// Errors are measured from the closest point of the bounding sphere, clamped to the near plane
+	DirectX::XMFLOAT3 camera_position;
+	DirectX::XMStoreFloat3(&camera_position, camera.position);
+	float dx = camera_position.x - m_boundsCenter.x, dy = camera_position.y - m_boundsCenter.y, dz = camera_position.z - m_boundsCenter.z;
+	float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - m_boundsRadius, 0.1f);
+	float pixels_per_unit = viewport_height / (2.0f * distance * std::tan(camera.fov * 0.5f));
+
+	UINT level = 0;
+	while (level + 1 < m_lods.size() && m_lods[level + 1].error * pixels_per_unit <= max_pixel_error)
+	{
+		level++;
+	}
+	setLod(level);
+}
+
+void Mesh::setLod(UINT level)
+{
+	m_lod = m_lods.empty() ? 0 : std::min(level, (UINT)m_lods.size() - 1);
+}
+
+UINT Mesh::getMeshletCount() const
+{
+	return m_lods.empty() ? (UINT)m_meshlets.size() : m_lods[m_lod].meshletCount;
+}
+
+void Mesh::cull(const Camera& camera)
+{
+	if (m_meshlets.empty())
+	{
+		resetCulling();
+		return;
+	}
+
+	DirectX::XMFLOAT4 planes[6];
+	extract_frustum_planes(camera.m_viewProjMatrix, planes);
+	DirectX::XMFLOAT3 camera_position;
+	DirectX::XMStoreFloat3(&camera_position, camera.position);
+
+	// Meshlets are contiguous in the index arena, so consecutive visible ones merge into a single draw
+	size_t first_meshlet = m_lods.empty() ? 0 : m_lods[m_lod].firstMeshlet;
+	size_t meshlet_count = getMeshletCount();
+	m_drawRanges.clear();
+	m_visibleMeshlets = 0;
+	m_visibleTriangles = 0;
+	for (size_t m = first_meshlet; m < first_meshlet + meshlet_count; m++)
+	{
+		const Meshlet& meshlet = m_meshlets[m];
+		if (!is_meshlet_visible(meshlet, planes, camera_position))
+		{
+			continue;
+		}
+		m_visibleMeshlets++;
+		m_visibleTriangles += meshlet.indexCount / 3;
+		if (!m_drawRanges.empty())
+		{
+			DrawRange& last = m_drawRanges.back();
+			if (last.baseVertex == meshlet.baseVertex && last.firstIndex + last.indexCount == meshlet.firstIndex)
+			{
+				last.indexCount += meshlet.indexCount;
+				continue;
+			}
+		}
+		m_drawRanges.push_back({ meshlet.baseVertex, meshlet.firstIndex, meshlet.indexCount });
+	}
+}
+
+void Mesh::resetCulling()
+{
+	const Submesh* ranges = m_submeshes.data();
+	if (!m_lods.empty())
+	{
+		ranges = m_lodSubmeshes.data() + m_lods[m_lod].firstSubmesh;
+	}
+	m_drawRanges.clear();
+	m_visibleTriangles = 0;
+	for (size_t s = 0; s < m_submeshes.size(); s++)
+	{
+		m_drawRanges.push_back({ ranges[s].baseVertex, ranges[s].firstIndex, ranges[s].indexCount });
+		m_visibleTriangles += ranges[s].indexCount / 3;
+	}
+	m_visibleMeshlets = getMeshletCount();
+}
+
+void Mesh::draw(Graphics& gfx)
+{
+	if (!bindAll(gfx))
+	{
+		return;
+	}
+	for (const DrawRange& range : m_drawRanges)
+	{
+		gfx.drawIndexed(range.indexCount, range.firstIndex, range.baseVertex);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include <Camera.h>
+#include <drawable/IDrawable.h>
+#include <mesh/MeshData.h>
+#include <Graphics.h>
+
+// Drawable for an imported model. Every submesh shares the same vertex and index buffers,
+// so they are bound once and each submesh is drawn with its own range of the arena.
+class Mesh : public IDrawable
+{
+public:
+	Mesh();
+	virtual ~Mesh();
+
+	void setSubmeshes(const std::vector<Submesh>& submeshes);
+	const std::vector<Submesh>& getSubmeshes() const { return m_submeshes; }
+	void setMeshlets(const std::vector<Meshlet>& meshlets);
+	void setLods(const std::vector<MeshLod>& lods, const std::vector<Submesh>& lod_submeshes);
+	const std::vector<MeshLod>& getLods() const { return m_lods; }
+	void setBounds(const DirectX::XMFLOAT3& bounds_min, const DirectX::XMFLOAT3& bounds_max);
+
+	// Picks the coarsest level whose error projects to at most max_pixel_error pixels at the current camera distance
+	void selectLod(const Camera& camera, float viewport_height, float max_pixel_error);
+	void setLod(UINT level);
+	UINT getLod() const { return m_lod; }
+
+	// Culls the meshlets of the current level against the camera frustum and by facing, the next draws only submit the visible index ranges
+	void cull(const Camera& camera);
+	// Draws every submesh of the current level whole again
+	void resetCulling();
+	UINT getMeshletCount() const;
+	UINT getVisibleMeshletCount() const { return m_visibleMeshlets; }
+	UINT getVisibleTriangleCount() const { return m_visibleTriangles; }
+
+	virtual void draw(Graphics& gfx) override;
+
+private:
+	// Index range submitted by a single draw call
+	struct DrawRange
+	{
+		UINT baseVertex;
+		UINT firstIndex;
+		UINT indexCount;
+	};
+
+	std::vector<Submesh> m_submeshes;
+	std::vector<Meshlet> m_meshlets;
+	std::vector<MeshLod> m_lods;
+	std::vector<Submesh> m_lodSubmeshes;
+	DirectX::XMFLOAT3 m_boundsCenter;
+	float m_boundsRadius;
+	UINT m_lod;
+	std::vector<DrawRange> m_drawRanges;
+	UINT m_visibleMeshlets;
+	UINT m_visibleTriangles;
+};
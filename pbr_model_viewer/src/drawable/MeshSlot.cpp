@@ -0,0 +1,85 @@
+#include "MeshSlot.h"
+
+#include <algorithm>
+
+MeshSlot::MeshSlot()
+	: m_pending(nullptr)
+	, m_current(nullptr)
+	, m_frame(0)
+{
+}
+
+MeshSlot::~MeshSlot()
+{
+	clear({});
+}
+
+void MeshSlot::publish(LoadedMesh* loaded)
+{
+	// Release pairs with the acquire in beginFrame, so the render thread sees the mesh fully built
+	LoadedMesh* replaced = m_pending.exchange(loaded, std::memory_order_acq_rel);
+	release(replaced, {});
+}
+
+bool MeshSlot::beginFrame(const std::vector<IBindable*>& shared_bindables)
+{
+	if (!m_pending.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+	LoadedMesh* loaded = m_pending.exchange(nullptr, std::memory_order_acq_rel);
+	if (!loaded)
+	{
+		return false;
+	}
+	if (m_current)
+	{
+		for (IBindable* bindable : shared_bindables)
+		{
+			if (bindable) m_current->mesh->removeBindable(bindable);
+		}
+		m_retired.push_back({ m_current, m_frame });
+	}
+	m_current = loaded;
+	return true;
+}
+
+void MeshSlot::endFrame()
+{
+	m_frame++;
+	auto done = std::partition(m_retired.begin(), m_retired.end(), [this](const RetiredMesh& retired)
+	{
+		return retired.frame + mesh_retire_frames > m_frame;
+	});
+	for (auto it = done; it != m_retired.end(); ++it)
+	{
+		release(it->loaded, {});
+	}
+	m_retired.erase(done, m_retired.end());
+}
+
+void MeshSlot::clear(const std::vector<IBindable*>& shared_bindables)
+{
+	release(m_pending.exchange(nullptr, std::memory_order_acq_rel), {});
+	release(m_current, shared_bindables);
+	m_current = nullptr;
+	for (const RetiredMesh& retired : m_retired)
+	{
+		release(retired.loaded, {});
+	}
+	m_retired.clear();
+}
+
+void MeshSlot::release(LoadedMesh* loaded, const std::vector<IBindable*>& shared_bindables)
+{
+	if (!loaded)
+	{
+		return;
+	}
+	for (IBindable* bindable : shared_bindables)
+	{
+		if (bindable) loaded->mesh->removeBindable(bindable);
+	}
+	delete loaded->mesh;
+	delete loaded;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <bindable/IBindable.h>
+#include <drawable/Mesh.h>
+#include <mesh/MeshLoadStats.h>
+#include <mesh/VertexCompression.h>
+
+// Frames a replaced mesh stays alive after the swap, the default DXGI maximum frame latency
+static const UINT mesh_retire_frames = 3;
+
+// A complete drawable built by the loading thread, together with everything the UI shows about it
+struct LoadedMesh
+{
+	Mesh* mesh;
+	MeshLoadStats stats;
+	VertexCompressionStats compactStats;
+	bool compact;
+	UINT indexSize;
+	UINT indexCount;
+};
+
+// Hands meshes from the loading thread to the render loop, so the current mesh keeps drawing while the next one is built.
+// The loader publishes into a pending slot with an atomic exchange, the render loop picks it up at the start of a frame
+// and keeps the replaced mesh alive for mesh_retire_frames more frames so the GPU is done with it before it is deleted.
+class MeshSlot
+{
+public:
+	MeshSlot();
+	~MeshSlot();
+
+	// Loading thread. Takes ownership, a mesh that was published but never picked up is deleted.
+	void publish(LoadedMesh* loaded);
+
+	// Render thread, before drawing. Makes the pending mesh current and returns true if there was one.
+	// Bindables the replaced mesh shares with the rest of the app are detached from it instead of being deleted with it.
+	bool beginFrame(const std::vector<IBindable*>& shared_bindables);
+	// Render thread, after present. Deletes the meshes retired long enough ago.
+	void endFrame();
+	// Render thread, deletes every mesh once the loading thread is done
+	void clear(const std::vector<IBindable*>& shared_bindables);
+
+	// Render thread only
+	LoadedMesh* getCurrent() const { return m_current; }
+
+private:
+	struct RetiredMesh
+	{
+		LoadedMesh* loaded;
+		UINT64 frame;
+	};
+
+	MeshSlot(const MeshSlot&) = delete;
+	MeshSlot& operator=(const MeshSlot&) = delete;
+
+	static void release(LoadedMesh* loaded, const std::vector<IBindable*>& shared_bindables);
+
+	std::atomic<LoadedMesh*> m_pending;
+	LoadedMesh* m_current;
+	std::vector<RetiredMesh> m_retired;
+	UINT64 m_frame;
+};
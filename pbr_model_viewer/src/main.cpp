@@ -7,37 +7,45 @@
 #include <directxmath.h>
 #include <directxcolors.h>
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <thread>
+#include <atomic>
 
 #include "imgui/imgui.h"
 #include "imgui/ImGuiFileDialog.h"
 #include "imgui/imgui_impl_win32.h"
 #include "imgui/imgui_impl_dx11.h"
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
 #include "Graphics.h"
 #include "Camera.h"
 #include "Vertex.h"
 #include "Grid.h"
 #include "Cubemap.h"
+#include "JobSystem.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <drawable/IDrawable.h>
+#include <drawable/Mesh.h>
+#include <drawable/MeshSlot.h>
+#include <mesh/LoadProgress.h>
+#include <mesh/MeshData.h>
+#include <mesh/MeshLoader.h>
+#include <mesh/VertexCompression.h>
 #include <bindable/IBindable.h>
+#include <bindable/ConstantBuffer.h>
 #include <bindable/VertexBuffer.h>
 #include <bindable/IndexBuffer.h>
 #include <bindable/InputLayout.h>
 #include <bindable/VertexShader.h>
 #include <bindable/PixelShader.h>
-#include <bindable/Texture.h>
+#include <bindable/ManagedTexture.h>
 #include <bindable/TextureSampler.h>
-#include <bindable/TextureCube.h>
+#include <resource/D3D11ResourceDevice.h>
+#include <resource/ResourceManager.h>
+#include <resource/TextureData.h>
 
 DirectX::XMFLOAT2 operator-(DirectX::XMFLOAT2 a, DirectX::XMFLOAT2 b)
 {
@@ -65,21 +73,170 @@ int screen_height = 720;
 // Graphics
 Graphics* gfx = nullptr;
 Cubemap* cubemap = nullptr;
-TextureCube* cubemap_texture = nullptr;
-
-// Mesh
-IDrawable* mesh = nullptr;
+ManagedTexture* cubemap_texture = nullptr;
+
+// Textures load in the background, at most upload_budget_bytes of them reach the GPU per frame
+// and a placeholder color is bound until then
+static const size_t upload_budget_bytes = 32 << 20;
+// Textures no material uses anymore stay cached up to this size, for when the same file is loaded again
+static const size_t unused_texture_cache_bytes = 256 << 20;
+// Every texture on the GPU, resident or unused, past which the least recently drawn lose their largest mips
+static const size_t texture_budget_bytes = 512 << 20;
+static const UINT albedo_placeholder = 0xFF808080;
+static const UINT normal_placeholder = 0x00000000; // Zero length, the shader keeps the vertex normal
+static const UINT orm_placeholder = 0xFF0080FF; // No occlusion, mid roughness, not metallic
+static const UINT cubemap_placeholder = 0xFF000000;
+D3D11ResourceDevice* resource_device = nullptr;
+ResourceManager* resources = nullptr;
+
+// Mesh. The loading thread publishes new meshes into mesh_slot, the globals below mirror its current mesh
+// and are only touched by the render thread.
+MeshSlot mesh_slot;
+Mesh* mesh = nullptr;
 PixelShader* pbr_ps = nullptr;
+MeshLoadStats mesh_stats = {};
+VertexCompressionStats compact_vertex_stats = {};
+bool mesh_is_compact = false;
+UINT mesh_index_size = sizeof( UINT );
+UINT mesh_index_count = 0;
+// Occlusion, roughness and metallic files picked for the current mesh, packed into one texture bound to slot 2
+PackedTextureSources orm_sources = { {}, orm_placeholder };
+
+// Pixel shader constants of the current mesh. Each PBR map slot either samples its texture or uses its factor,
+// the placeholder color while no map is loaded and the mean of a map that turned out constant.
+struct MaterialConstants
+{
+	float factors[3][4];
+	UINT useTexture[4];
+};
+MaterialConstants material;
+ConstantBuffer* material_buffer = nullptr;
+
+// Map loaded into a PBR slot of the current mesh, its texture is dropped once it turns out constant
+struct PbrMap
+{
+	ManagedTexture* texture;
+	TextureAnalysis analysis;
+	bool analyzed;
+	bool constant;
+};
+PbrMap pbr_maps[3] = {};
+static const char* pbr_map_names[3] = { "Albedo", "Normal", "ORM" };
 
 // View options
 bool show_wireframe = false;
 bool show_grid = false;
 bool show_cubemap = false;
+bool show_mesh_info = false;
+bool use_compact_vertices = false;
+bool use_meshlet_culling = true;
+bool use_automatic_lod = true;
+float lod_pixel_error = 1.0f;
+int forced_lod = 0;
+MeshImportSettings mesh_import_settings;
+bool compress_textures = true;
+bool use_bc1_albedo = false;
+bool use_kaiser_mips = false;
+bool collapse_constant_maps = true;
+int constant_map_tolerance = 2;
+int texture_budget_mb = int( texture_budget_bytes >> 20 );
+
+// Block compressed format of the PBR map bound to slot, RGBA8 when compression is off
+DXGI_FORMAT pbr_map_format( UINT slot )
+{
+	if ( !compress_textures ) return DXGI_FORMAT_R8G8B8A8_UNORM;
+	switch ( slot )
+	{
+	case 0: return use_bc1_albedo ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC7_UNORM;
+	case 1: return DXGI_FORMAT_BC5_UNORM;
+	default: return DXGI_FORMAT_BC7_UNORM;
+	}
+}
+
+// Albedo mips are filtered in linear space and normal map mips renormalized
+MipSettings pbr_map_mips( UINT slot )
+{
+	MipSettings settings;
+	settings.content = slot == 0 ? MipSettings::Color : slot == 1 ? MipSettings::Normal : MipSettings::Linear;
+	settings.filter = use_kaiser_mips ? MipSettings::Kaiser : MipSettings::Box;
+	return settings;
+}
+
+// Factor of slot from a color packed as 0xAABBGGRR
+void set_material_factor( UINT slot, UINT color )
+{
+	for ( UINT channel = 0; channel < 4; channel++ )
+	{
+		material.factors[slot][channel] = float( ( color >> ( channel * 8 ) ) & 0xFF ) / 255.0f;
+	}
+}
+
+// Every slot back on its placeholder factor, for a new mesh
+void reset_material()
+{
+	material = {};
+	set_material_factor( 0, albedo_placeholder );
+	set_material_factor( 1, normal_placeholder );
+	set_material_factor( 2, orm_placeholder );
+	for ( PbrMap& map : pbr_maps )
+	{
+		map = {};
+	}
+}
+
+// Binds a loading map to slot and switches the mesh to the PBR shader
+void set_pbr_map( UINT slot, TextureHandle texture )
+{
+	pbr_maps[slot] = {};
+	pbr_maps[slot].texture = new ManagedTexture( *resources, texture, slot );
+	mesh->setTexture( pbr_maps[slot].texture );
+	mesh->changePixelShader( pbr_ps );
+	material.useTexture[slot] = 1;
+	material_buffer->update( *gfx, &material, sizeof( material ) );
+}
+
+// Picks up the analysis of the maps that finished loading, a constant one goes from its texture to its factor
+void update_pbr_maps()
+{
+	for ( UINT slot = 0; slot < 3; slot++ )
+	{
+		PbrMap& map = pbr_maps[slot];
+		if ( !map.texture || map.analyzed ) continue;
+		const TextureAnalysis* analysis = resources->getAnalysis( map.texture->getHandle() );
+		if ( !analysis ) continue;
+		map.analysis = *analysis;
+		map.analyzed = true;
+		if ( resources->isConstant( map.texture->getHandle() ) )
+		{
+			map.constant = true;
+			set_material_factor( slot, analysis->getMeanColor() );
+			material.useTexture[slot] = 0;
+			material_buffer->update( *gfx, &material, sizeof( material ) );
+			mesh->deleteBindable( map.texture );
+			map.texture = nullptr;
+		}
+	}
+}
+
+// Adds the file picked for an ORM channel and packs the files picked so far. DDS and KTX2 files are uploaded as
+// stored, so they can't be repacked: one is taken as a whole ORM map with occlusion, roughness and metallic in rgb,
+// and the next image picked starts a new pack.
+void load_orm_texture( UINT channel, const std::string& filename )
+{
+	if ( is_texture_container( filename ) )
+	{
+		orm_sources = { {}, orm_placeholder };
+		set_pbr_map( 2, resources->loadTexture( filename, orm_placeholder, pbr_map_format( 2 ), pbr_map_mips( 2 ) ) );
+		return;
+	}
+	orm_sources.filenames[channel] = filename;
+	set_pbr_map( 2, resources->loadPackedTexture( orm_sources, pbr_map_format( 2 ), pbr_map_mips( 2 ) ) );
+}
 
 // Loading popup
-std::thread load_mesh_thread;
-std::thread load_cubemap_thread;
-bool show_loading_popup = false;
+JobCounter load_mesh_job;
+std::atomic<bool> show_loading_popup(false);
+LoadProgress mesh_load_progress;
 
 // Camera
 Camera* cam;
@@ -91,78 +248,78 @@ float near_plane = 0.1f;
 float far_plane = 500.0f;
 
 
-void load_obj_file(Graphics* gfx, std::string filename) {
+void load_obj_file(Graphics* gfx, std::string filename, MeshImportSettings settings, bool compact) {
 	show_loading_popup = true;
 
-	// Initialize mesh
-	if ( mesh ) delete mesh;
-	mesh = new IDrawable;
-	VertexShader* mesh_vs_shader = new VertexShader( *gfx, "mesh_vs.cso" );
-	mesh->addBindable( mesh_vs_shader );
-	mesh->addBindable( new InputLayout( *gfx, vertex_desc_buffer, sizeof( vertex_desc_buffer ) / sizeof( D3D11_INPUT_ELEMENT_DESC ), mesh_vs_shader->getBytecode() ) );
-	mesh->addBindable( new PixelShader( *gfx, "mesh_ps.cso" ) );
-	mesh->addBindable( new TextureSampler( *gfx, 0, D3D11_FILTER_ANISOTROPIC ) );
-	
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(filename,
-		aiProcess_CalcTangentSpace |
-		aiProcess_Triangulate |
-		aiProcess_GenNormals |
-		aiProcess_ValidateDataStructure |
-		aiProcess_GenUVCoords |
-		aiProcess_FixInfacingNormals |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_SortByPType);
-
-	aiNode* rootNode = scene->mRootNode;
-	aiMesh* ai_mesh = scene->mMeshes[rootNode->mChildren[0]->mMeshes[0]];
-
-	// Destroy old vertex buffer if existed and create new with parsed vertices
-	UINT vertices_count = ai_mesh->mNumVertices;
-	Vertex* vertex_buffer_data = new Vertex[vertices_count];
-	for (unsigned int i = 0; i < ai_mesh->mNumVertices; i++)
+	// Import every mesh of the scene into a single vertex and index arena, or map it from the mesh cache
+	MeshLoader loader;
+	if (!loader.load(filename, settings, mesh_load_progress))
 	{
-		Vertex vert;
-		vert.position.x = ai_mesh->mVertices[i].x;
-		vert.position.y = ai_mesh->mVertices[i].y;
-		vert.position.z = ai_mesh->mVertices[i].z;
-
-		vert.normal.x = ai_mesh->mNormals[i].x;
-		vert.normal.y = ai_mesh->mNormals[i].y;
-		vert.normal.z = ai_mesh->mNormals[i].z;
-
-		vert.uvs.x = ai_mesh->mTextureCoords[0][i].x;
-		vert.uvs.y = ai_mesh->mTextureCoords[0][i].y;
-
-		vert.tangent.x = ai_mesh->mTangents[i].x;
-		vert.tangent.y = ai_mesh->mTangents[i].y;
-		vert.tangent.z = ai_mesh->mTangents[i].z;
-
-		vert.bitangent.x = ai_mesh->mBitangents[i].x;
-		vert.bitangent.y = ai_mesh->mBitangents[i].y;
-		vert.bitangent.z = ai_mesh->mBitangents[i].z;
-
-		vertex_buffer_data[i] = vert;
+		mesh_load_progress.setPhase(mesh_load_progress.isCancelRequested() ? LoadProgress::Canceled : LoadProgress::Failed);
+		show_loading_popup = false;
+		return;
 	}
-	VertexBuffer* vertices = new VertexBuffer(*gfx, vertex_buffer_data, vertices_count);
 
-	// Destroy old index buffer if existed and create new with parsed indices
-	UINT indices_count = ai_mesh->mNumFaces * 3;
-	UINT* vertex_indices_data = new UINT[indices_count];
-	for (unsigned int i = 0; i < ai_mesh->mNumFaces; i++)
+	// Initialize mesh
+	mesh_load_progress.setPhase(LoadProgress::Uploading);
+	Mesh* new_mesh = new Mesh;
+	new_mesh->addBindable( new PixelShader( *gfx, "mesh_ps.cso" ) );
+	new_mesh->addBindable( new TextureSampler( *gfx, 0, D3D11_FILTER_ANISOTROPIC ) );
+
+	MeshView view = loader.getView();
+	VertexBuffer* vertices = nullptr;
+	VertexCompressionStats compact_stats = {};
+	if ( compact )
 	{
-		aiFace face = ai_mesh->mFaces[i];
-		for (unsigned int j = 0; j < face.mNumIndices; j++)
-			vertex_indices_data[i * 3 + j] = face.mIndices[j];
+		// Quantize to the 20 byte layout, the bounds go to the vertex shader to rebuild positions
+		MeshDequantization dequantization = make_dequantization( view.boundsMin, view.boundsMax );
+		std::vector<CompactVertex> compact_vertices( view.vertexCount );
+		compress_vertices( view.vertices, view.vertexCount, dequantization, compact_vertices.data() );
+		compact_stats = measure_compression_error( view.vertices, compact_vertices.data(), view.vertexCount, dequantization );
+		vertices = new VertexBuffer( *gfx, compact_vertices.data(), view.vertexCount );
+
+		VertexShader* compact_vs_shader = new VertexShader( *gfx, "mesh_compact_vs.cso" );
+		new_mesh->addBindable( compact_vs_shader );
+		new_mesh->addBindable( new InputLayout( *gfx, compact_vertex_desc_buffer, sizeof( compact_vertex_desc_buffer ) / sizeof( D3D11_INPUT_ELEMENT_DESC ), compact_vs_shader->getBytecode() ) );
+		new_mesh->addBindable( new ConstantBuffer( *gfx, &dequantization, 2 ) );
 	}
-	IndexBuffer* indices = new IndexBuffer(*gfx, vertex_indices_data, indices_count);
-
-	mesh->setMesh(vertices, indices);
+	else
+	{
+		vertices = new VertexBuffer( *gfx, view.vertices, view.vertexCount );
 
-	if ( cubemap_texture ) mesh->addBindable( cubemap_texture );
+		VertexShader* mesh_vs_shader = new VertexShader( *gfx, "mesh_vs.cso" );
+		new_mesh->addBindable( mesh_vs_shader );
+		new_mesh->addBindable( new InputLayout( *gfx, vertex_desc_buffer, sizeof( vertex_desc_buffer ) / sizeof( D3D11_INPUT_ELEMENT_DESC ), mesh_vs_shader->getBytecode() ) );
+	}
+	IndexBuffer* indices = new IndexBuffer(*gfx, view.indices, view.indexCount);
+	new_mesh->setMesh(vertices, indices);
+	new_mesh->setSubmeshes(std::vector<Submesh>(view.submeshes, view.submeshes + view.submeshCount));
+	new_mesh->setMeshlets(std::vector<Meshlet>(view.meshlets, view.meshlets + view.meshletCount));
+	new_mesh->setLods(std::vector<MeshLod>(view.lods, view.lods + view.lodCount),
+					  std::vector<Submesh>(view.lodSubmeshes, view.lodSubmeshes + view.lodSubmeshCount));
+	new_mesh->setBounds(view.boundsMin, view.boundsMax);
+
+	// Last chance to cancel, dropping the new mesh frees everything created so far
+	if (mesh_load_progress.isCancelRequested())
+	{
+		delete new_mesh;
+		mesh_load_progress.setPhase(LoadProgress::Canceled);
+		show_loading_popup = false;
+		return;
+	}
 
+	// The render loop swaps it in at the start of its next frame, the old mesh keeps drawing until then
+	LoadedMesh* loaded = new LoadedMesh;
+	loaded->mesh = new_mesh;
+	loaded->stats = loader.getStats();
+	loaded->compactStats = compact_stats;
+	loaded->compact = compact;
+	loaded->indexSize = indices->getIndexSize();
+	loaded->indexCount = indices->getIndexCount();
+	mesh_slot.publish(loaded);
+
+	mesh_load_progress.setPhase(LoadProgress::Done);
 	show_loading_popup = false;
-	ImGui::CloseCurrentPopup();
 }
 
 
@@ -251,6 +408,8 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 	// Initialize graphics
 	gfx = new Graphics(hwnd, screen_width, screen_height);
 	pbr_ps = new PixelShader( *gfx, "mesh_pbr_ps.cso" );
+	resource_device = new D3D11ResourceDevice( *gfx );
+	resources = new ResourceManager( *resource_device, upload_budget_bytes, unused_texture_cache_bytes, texture_budget_bytes );
 
 	// Camera
 	cam = new Camera(*gfx, camera_position, camera_lookat_vector, camera_right, camera_up, DirectX::XM_PI / 4.0f, float(screen_width) / float(screen_height));
@@ -272,30 +431,57 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 			DispatchMessage(&msg);
 		}
 
-		// Draw if not loading any mesh
-		if (!show_loading_popup) {
+		// Upload the textures decoded since the last frame
+		resources->setConstantTolerance( collapse_constant_maps ? constant_map_tolerance : -1 );
+		resources->setTextureBudget( size_t( texture_budget_mb ) << 20 );
+		resources->update();
 
-			gfx->clear(clear_color_black);
+		// Pick up a mesh the loading thread finished, the cubemap texture is shared by every mesh and stays alive
+		if ( mesh_slot.beginFrame( { cubemap_texture, pbr_ps } ) )
+		{
+			LoadedMesh* loaded = mesh_slot.getCurrent();
+			mesh = loaded->mesh;
+			if ( cubemap_texture ) mesh->addBindable( cubemap_texture );
+			mesh_stats = loaded->stats;
+			compact_vertex_stats = loaded->compactStats;
+			mesh_is_compact = loaded->compact;
+			mesh_index_size = loaded->indexSize;
+			mesh_index_count = loaded->indexCount;
+			orm_sources = { {}, orm_placeholder };
+			reset_material();
+			material_buffer = new ConstantBuffer( *gfx, &material, 0, ConstantBuffer::Pixel );
+			mesh->addBindable( material_buffer );
+		}
+		if ( mesh ) update_pbr_maps();
 
-			if (show_grid)
-			{
-				grid.draw();
-			}
+		// Keep drawing the current mesh while the next one loads
+		gfx->clear(clear_color_black);
 
-			if (cubemap && show_cubemap)
-			{
-				cubemap->draw(*gfx);
-			}
+		if (show_grid)
+		{
+			grid.draw();
+		}
 
-			// Set wireframe or solid mode according to view options
-			if (show_wireframe) {
-				gfx->change_fill_mode(D3D11_FILL_WIREFRAME);
-			}
-			else {
-				gfx->change_fill_mode(D3D11_FILL_SOLID);
-			}
+		if (cubemap && show_cubemap)
+		{
+			cubemap->draw(*gfx);
+		}
 
-			if( mesh ) mesh->draw(*gfx);
+		// Set wireframe or solid mode according to view options
+		if (show_wireframe) {
+			gfx->change_fill_mode(D3D11_FILL_WIREFRAME);
+		}
+		else {
+			gfx->change_fill_mode(D3D11_FILL_SOLID);
+		}
+
+		if( mesh )
+		{
+			if ( use_automatic_lod ) mesh->selectLod(*cam, float( screen_height ), lod_pixel_error);
+			else mesh->setLod(UINT( forced_lod ));
+			if ( use_meshlet_culling ) mesh->cull(*cam);
+			else mesh->resetCulling();
+			mesh->draw(*gfx);
 		}
 
 		// Start the Dear ImGui frame
@@ -323,6 +509,29 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 				ImGui::MenuItem("Wireframe", nullptr, &show_wireframe);
 				ImGui::MenuItem("Grid", nullptr, &show_grid);
 				ImGui::MenuItem("Cubemap", nullptr, &show_cubemap);
+				ImGui::MenuItem("Mesh info", nullptr, &show_mesh_info);
+				ImGui::MenuItem("Meshlet culling", nullptr, &use_meshlet_culling);
+				ImGui::MenuItem("Automatic LOD", nullptr, &use_automatic_lod);
+				ImGui::MenuItem("Generate LODs (next load)", nullptr, &mesh_import_settings.generateLods);
+				ImGui::MenuItem("Native OBJ parser (next load)", nullptr, &mesh_import_settings.nativeObjParser);
+				ImGui::SliderFloat("Weld epsilon (next load)", &mesh_import_settings.weldEpsilon, 0.0f, 0.01f, "%g");
+				ImGui::MenuItem("Recompute normals (next load)", nullptr, &mesh_import_settings.recomputeNormals);
+				ImGui::SliderFloat("Crease angle (next load)", &mesh_import_settings.creaseAngle, 0.0f, 180.0f, "%.0f deg");
+				ImGui::MenuItem("Compact vertices (next load)", nullptr, &use_compact_vertices);
+				ImGui::MenuItem("Reduce overdraw (next load)", nullptr, &mesh_import_settings.reduceOverdraw);
+				ImGui::MenuItem("Compress textures (next load)", nullptr, &compress_textures);
+				ImGui::MenuItem("BC1 albedo (next load)", nullptr, &use_bc1_albedo, compress_textures);
+				ImGui::MenuItem("Kaiser mip filter (next load)", nullptr, &use_kaiser_mips);
+				ImGui::MenuItem("Collapse constant maps (next load)", nullptr, &collapse_constant_maps);
+				if (collapse_constant_maps)
+				{
+					ImGui::SliderInt("Constant map tolerance", &constant_map_tolerance, 0, 16);
+				}
+				ImGui::SliderInt("Texture budget", &texture_budget_mb, 16, 2048, "%d MB");
+				if (mesh_import_settings.reduceOverdraw)
+				{
+					ImGui::SliderFloat("Max ACMR loss", &mesh_import_settings.overdrawThreshold, 1.0f, 1.5f, "%.2fx");
+				}
 				ImGui::EndMenu();
 			}
 			ImGui::EndMainMenuBar();
@@ -331,27 +540,164 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 		{
 			if ( ImGui::Button( "Load albedo texture" ) )
 			{
-				ImGuiFileDialog::Instance()->OpenDialog( "open_albedo_dialog", "Choose albedo texture", "Image files (*.jpeg/jpg *.png *.tga *.bmp){.jpeg,.jpg,.png,.tga,.bmp}", "." );
+				ImGuiFileDialog::Instance()->OpenDialog( "open_albedo_dialog", "Choose albedo texture", "Image files (*.jpeg/jpg *.png *.tga *.bmp *.dds *.ktx2){.jpeg,.jpg,.png,.tga,.bmp,.dds,.ktx2}", "." );
 			}
 			if ( ImGui::Button( "Load normal map" ) )
 			{
-				ImGuiFileDialog::Instance()->OpenDialog( "open_normal_dialog", "Choose normal map", "Image files (*.jpeg/jpg *.png *.tga *.bmp){.jpeg,.jpg,.png,.tga,.bmp}", "." );
+				ImGuiFileDialog::Instance()->OpenDialog( "open_normal_dialog", "Choose normal map", "Image files (*.jpeg/jpg *.png *.tga *.bmp *.dds *.ktx2){.jpeg,.jpg,.png,.tga,.bmp,.dds,.ktx2}", "." );
+			}
+			if ( ImGui::Button( "Load occlusion map" ) )
+			{
+				ImGuiFileDialog::Instance()->OpenDialog( "open_occlusion_dialog", "Choose occlusion map", "Image files (*.jpeg/jpg *.png *.tga *.bmp *.dds *.ktx2){.jpeg,.jpg,.png,.tga,.bmp,.dds,.ktx2}", "." );
+			}
+			if ( ImGui::Button( "Load roughness map" ) )
+			{
+				ImGuiFileDialog::Instance()->OpenDialog( "open_roughness_dialog", "Choose roughness map", "Image files (*.jpeg/jpg *.png *.tga *.bmp *.dds *.ktx2){.jpeg,.jpg,.png,.tga,.bmp,.dds,.ktx2}", "." );
 			}
 			if ( ImGui::Button( "Load metallic map" ) )
 			{
-				ImGuiFileDialog::Instance()->OpenDialog( "open_metallic_dialog", "Choose metallic map", "Image files (*.jpeg/jpg *.png *.tga *.bmp){.jpeg,.jpg,.png,.tga,.bmp}", "." );
+				ImGuiFileDialog::Instance()->OpenDialog( "open_metallic_dialog", "Choose metallic map", "Image files (*.jpeg/jpg *.png *.tga *.bmp *.dds *.ktx2){.jpeg,.jpg,.png,.tga,.bmp,.dds,.ktx2}", "." );
+			}
+			const TextureCacheStats& texture_stats = resources->getCacheStats();
+			ImGui::Separator();
+			ImGui::Text( "Textures: %u resident (%.1f MB), %u unused (%.1f MB)", texture_stats.residentTextures,
+						 texture_stats.residentBytes / ( 1024.0f * 1024.0f ), texture_stats.unusedTextures, texture_stats.unusedBytes / ( 1024.0f * 1024.0f ) );
+			ImGui::Text( "Cache: %u hits, %u misses (%.0f%%)", texture_stats.hits, texture_stats.misses, texture_stats.getHitRate() * 100.0f );
+			const TextureCompressionStats& compression_stats = resources->getCompressionStats();
+			if ( compression_stats.compressedTextures > 0 || compression_stats.diskCacheHits > 0 )
+			{
+				ImGui::Text( "Compressed: %u (%.1f MPix/s, %.1f dB PSNR), %u from disk cache", compression_stats.compressedTextures,
+							 compression_stats.getMegapixelsPerSecond(), compression_stats.getAveragePsnr(), compression_stats.diskCacheHits );
+			}
+			if ( compression_stats.packedTextures > 0 )
+			{
+				ImGui::Text( "ORM packing: %u textures, %.1f MB saved", compression_stats.packedTextures,
+							 compression_stats.packedBytesSaved / ( 1024.0 * 1024.0 ) );
+			}
+			if ( compression_stats.mipMegapixels > 0.0 )
+			{
+				ImGui::Text( "Mips: %.1f MPix generated (%.1f MPix/s)", compression_stats.mipMegapixels, compression_stats.getMipMegapixelsPerSecond() );
+			}
+			if ( compression_stats.constantTextures > 0 )
+			{
+				ImGui::Text( "Constant maps: %u replaced by material factors", compression_stats.constantTextures );
+			}
+			const TextureResidency& residency = resources->getResidency();
+			ImGui::Text( "Budget: %.1f of %.0f MB, %.1f MB of mips dropped (%u levels dropped, %u restored)", residency.getResidentBytes() / ( 1024.0f * 1024.0f ),
+						 residency.getBudget() / ( 1024.0f * 1024.0f ), residency.getEvictedBytes() / ( 1024.0f * 1024.0f ), texture_stats.evictedLevels,
+						 texture_stats.restoredLevels );
+			const TextureStreamingStats& streaming_stats = resources->getStreamingStats();
+			if ( streaming_stats.streamedTextures > 0 )
+			{
+				ImGui::Text( "Streaming: first texels %.0f ms (last %.0f), full resolution %.0f ms (last %.0f)", streaming_stats.getAverageFirstTexelMs(),
+							 streaming_stats.lastFirstTexelMs, streaming_stats.getAverageFullResolutionMs(), streaming_stats.lastFullResolutionMs );
+			}
+			for ( UINT slot = 0; slot < 3; slot++ )
+			{
+				const PbrMap& map = pbr_maps[slot];
+				// Levels missing once loaded were dropped for the budget, before that the full resolution is on its way.
+				// Maps that can't be analyzed never set analyzed, so the load state tells them apart.
+				if ( map.texture && resources->getResidentMip( map.texture->getHandle() ) > 0 )
+				{
+					bool ready = resources->getState( map.texture->getHandle() ) == ResourceManager::Ready;
+					ImGui::Text( "%s: %s, mip %u resident", pbr_map_names[slot], ready ? "over budget" : "streaming",
+								 resources->getResidentMip( map.texture->getHandle() ) );
+				}
+				if ( !map.analyzed ) continue;
+				// Range per channel, uniformity of the least uniform one
+				const TextureAnalysis& analysis = map.analysis;
+				float uniformity = std::min( { analysis.uniformity[0], analysis.uniformity[1], analysis.uniformity[2], analysis.uniformity[3] } );
+				ImGui::Text( "%s: range %u/%u/%u/%u, %.0f%% uniform%s", pbr_map_names[slot], analysis.getRange( 0 ), analysis.getRange( 1 ),
+							 analysis.getRange( 2 ), analysis.getRange( 3 ), uniformity * 100.0f, map.constant ? ", constant" : "" );
+			}
+			if ( resources->getLoadingCount() > 0 )
+			{
+				ImGui::Text( "Loading %u, %.1f MB waiting for upload", resources->getLoadingCount(), resources->getPendingUploadBytes() / ( 1024.0f * 1024.0f ) );
+			}
+			ImGui::End();
+		}
+		if ( mesh && show_mesh_info && ImGui::Begin( "Mesh info", &show_mesh_info, ImGuiWindowFlags_AlwaysAutoResize ) )
+		{
+			ImGui::Text( "Submeshes: %u", mesh_stats.submeshCount );
+			ImGui::Text( "Vertices: %u", mesh_stats.vertexCount );
+			ImGui::Text( "Triangles: %u", mesh_stats.indexCount / 3 );
+			ImGui::Text( "Meshlets: %u visible of %u, %u triangles drawn", mesh->getVisibleMeshletCount(), mesh->getMeshletCount(),
+						 mesh->getVisibleTriangleCount() );
+			UINT vertex_size = mesh_is_compact ? sizeof( CompactVertex ) : sizeof( Vertex );
+			ImGui::Text( "Vertex format: %s, %u bytes/vertex (%.1f MB)", mesh_is_compact ? "compact" : "full", vertex_size,
+						 double( vertex_size ) * mesh_stats.vertexCount / ( 1024.0 * 1024.0 ) );
+			ImGui::Text( "Index format: %u bit (%.1f MB)", mesh_index_size * 8,
+						 double( mesh_index_size ) * mesh_index_count / ( 1024.0 * 1024.0 ) );
+			if ( mesh_is_compact )
+			{
+				ImGui::Text( "Saved %.1f MB against the full layout",
+							 double( sizeof( Vertex ) - sizeof( CompactVertex ) ) * mesh_stats.vertexCount / ( 1024.0 * 1024.0 ) );
+				ImGui::Text( "Max error: position %g, normal %.3f deg, tangent %.3f deg, uv %g",
+							 compact_vertex_stats.maxPositionError, compact_vertex_stats.maxNormalError,
+							 compact_vertex_stats.maxTangentError, compact_vertex_stats.maxUvError );
+			}
+			ImGui::Separator();
+			ImGui::Text( "File hash: %.1f ms", mesh_stats.hashMs );
+			if ( mesh_stats.cacheHit )
+			{
+				ImGui::Text( "Mesh cache hit: %.1f ms (cold import %.1f ms, %.1fx slower)", mesh_stats.cacheMs, mesh_stats.getImportTotalMs(),
+							 mesh_stats.cacheMs > 0.0 ? mesh_stats.getImportTotalMs() / mesh_stats.cacheMs : 0.0 );
+			}
+			if ( mesh_stats.nativeObj )
+			{
+				ImGui::Text( "OBJ parse: %.1f ms, welding: %.1f ms, vertex build: %.1f ms", mesh_stats.objParse.parseMs,
+							 mesh_stats.objParse.weldMs, mesh_stats.objParse.vertexMs );
+			}
+			else
+			{
+				ImGui::Text( "Assimp import: %.1f ms", mesh_stats.importMs );
+			}
+			ImGui::Text( "Read throughput: %.1f MB/s (%.1f MB, native OBJ target %.0f MB/s)", mesh_stats.getImportMbPerSecond(),
+						 double( mesh_stats.fileSize ) / ( 1024.0 * 1024.0 ), obj_target_mb_per_second );
+			ImGui::Text( "Vertex conversion: %.1f ms (%.1f Mverts/s)", mesh_stats.convertMs,
+						 mesh_stats.convertMs > 0.0 ? mesh_stats.vertexCount / ( mesh_stats.convertMs * 1000.0 ) : 0.0 );
+			ImGui::Text( "Normal generation: %.1f ms (%u vertices split at creases)", mesh_stats.normalMs, mesh_stats.normalSplitVertices );
+			if ( !mesh_stats.nativeObj || mesh_stats.normalMs > 0.0 )
+			{
+				ImGui::Text( "Vertex welding: %.1f ms (%u duplicates removed)", mesh_stats.weldMs, mesh_stats.weldedVertices );
+			}
+			ImGui::Text( "Tangent generation: %.1f ms (%u vertices split at mirrored uvs)", mesh_stats.tangentMs, mesh_stats.tangentSplitVertices );
+			ImGui::Text( "Vertex cache optimization: %.1f ms", mesh_stats.optimizeMs );
+			ImGui::Text( "Meshlet build: %.1f ms", mesh_stats.meshletMs );
+			ImGui::Text( "LOD generation: %.1f ms", mesh_stats.simplifyMs );
+			ImGui::Separator();
+			const std::vector<MeshLod>& lods = mesh->getLods();
+			for ( size_t level = 0; level < lods.size(); level++ )
+			{
+				ImGui::Text( "%sLOD %zu: %u triangles, error %g", level == mesh->getLod() ? "> " : "  ", level, lods[level].indexCount / 3, lods[level].error );
+			}
+			if ( use_automatic_lod )
+			{
+				ImGui::SliderFloat( "Max error (pixels)", &lod_pixel_error, 0.25f, 8.0f, "%.2f" );
+			}
+			else if ( lods.size() > 1 )
+			{
+				ImGui::SliderInt( "LOD", &forced_lod, 0, int( lods.size() ) - 1 );
+			}
+			ImGui::Text( "ACMR: %.3f -> %.3f", mesh_stats.vertexCacheBefore.getAcmr(), mesh_stats.vertexCacheAfter.getAcmr() );
+			ImGui::Text( "ATVR: %.3f -> %.3f", mesh_stats.vertexCacheBefore.getAtvr(), mesh_stats.vertexCacheAfter.getAtvr() );
+			if ( mesh_stats.overdrawAfter.coveredPixels > 0.0f )
+			{
+				ImGui::Text( "Overdraw: %.3f -> %.3f (%.0f -> %.0f shaded pixels per view)",
+							 mesh_stats.overdrawBefore.getOverdraw(), mesh_stats.overdrawAfter.getOverdraw(),
+							 mesh_stats.overdrawBefore.shadedPixels, mesh_stats.overdrawAfter.shadedPixels );
 			}
-            if ( ImGui::Button( "Load roughness map" ) )
-            {
-                ImGuiFileDialog::Instance()->OpenDialog( "open_roughness_dialog", "Choose roughness map", "Image files (*.jpeg/jpg *.png *.tga *.bmp){.jpeg,.jpg,.png,.tga,.bmp}", "." );
-            }
 			ImGui::End();
 		}
 		if (ImGuiFileDialog::Instance()->Display("open_mesh_dialog")) {
 			if (ImGuiFileDialog::Instance()->IsOk()) {
 				std::string filename = ImGuiFileDialog::Instance()->GetFilePathName();
-				if (load_mesh_thread.joinable()) load_mesh_thread.join();
-				load_mesh_thread = std::thread(load_obj_file, gfx, filename);
+				JobSystem::get().wait(load_mesh_job);
+				mesh_load_progress.reset();
+				show_loading_popup = true;
+				MeshImportSettings settings = mesh_import_settings;
+				bool compact = use_compact_vertices;
+				JobSystem::get().submit([filename, settings, compact]() { load_obj_file(gfx, filename, settings, compact); }, &load_mesh_job);
 				ImGui::OpenPopup("Loading...", 0);
 			}
 			ImGuiFileDialog::Instance()->Close();
@@ -360,8 +706,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 		{
 			if ( ImGuiFileDialog::Instance()->IsOk() )
 			{
-				mesh->addBindable( new Texture( *gfx, ImGuiFileDialog::Instance()->GetFilePathName(), 0 ) );
-				mesh->changePixelShader( pbr_ps );
+				set_pbr_map( 0, resources->loadTexture( ImGuiFileDialog::Instance()->GetFilePathName(), albedo_placeholder, pbr_map_format( 0 ), pbr_map_mips( 0 ) ) );
 			}
 			ImGuiFileDialog::Instance()->Close();
 		}
@@ -369,17 +714,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 		{
 			if ( ImGuiFileDialog::Instance()->IsOk() )
 			{
-				mesh->addBindable( new Texture( *gfx, ImGuiFileDialog::Instance()->GetFilePathName(), 1 ) );
-				mesh->changePixelShader( pbr_ps );
+				set_pbr_map( 1, resources->loadTexture( ImGuiFileDialog::Instance()->GetFilePathName(), normal_placeholder, pbr_map_format( 1 ), pbr_map_mips( 1 ) ) );
 			}
 			ImGuiFileDialog::Instance()->Close();
 		}
-		if ( ImGuiFileDialog::Instance()->Display( "open_metallic_dialog" ) )
+		if ( ImGuiFileDialog::Instance()->Display( "open_occlusion_dialog" ) )
 		{
 			if ( ImGuiFileDialog::Instance()->IsOk() )
 			{
-				mesh->addBindable( new Texture( *gfx, ImGuiFileDialog::Instance()->GetFilePathName(), 2 ) );
-				mesh->changePixelShader( pbr_ps );
+				load_orm_texture( 0, ImGuiFileDialog::Instance()->GetFilePathName() );
 			}
 			ImGuiFileDialog::Instance()->Close();
 		}
@@ -387,8 +730,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 		{
 			if ( ImGuiFileDialog::Instance()->IsOk() )
 			{
-				mesh->addBindable( new Texture( *gfx, ImGuiFileDialog::Instance()->GetFilePathName(), 3 ) );
-				mesh->changePixelShader( pbr_ps );
+				load_orm_texture( 1, ImGuiFileDialog::Instance()->GetFilePathName() );
+			}
+			ImGuiFileDialog::Instance()->Close();
+		}
+		if ( ImGuiFileDialog::Instance()->Display( "open_metallic_dialog" ) )
+		{
+			if ( ImGuiFileDialog::Instance()->IsOk() )
+			{
+				load_orm_texture( 2, ImGuiFileDialog::Instance()->GetFilePathName() );
 			}
 			ImGuiFileDialog::Instance()->Close();
 		}
@@ -397,39 +747,65 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine,
 			if ( ImGuiFileDialog::Instance()->IsOk() )
 			{
 				if ( cubemap ) delete cubemap;
-				cubemap = new Cubemap( *gfx, ImGuiFileDialog::Instance()->GetCurrentPath() );
-				if ( mesh ) mesh->deleteBindable( cubemap_texture );
+				cubemap = new Cubemap( *gfx, *resources, ImGuiFileDialog::Instance()->GetCurrentPath(), cubemap_placeholder );
+				if ( mesh ) mesh->removeBindable( cubemap_texture );
 				if ( cubemap_texture ) delete cubemap_texture;
-				cubemap_texture = new TextureCube( *gfx, ImGuiFileDialog::Instance()->GetCurrentPath(), 4 );
+				TextureHandle texture = resources->loadTextureCube( ImGuiFileDialog::Instance()->GetCurrentPath(), cubemap_placeholder );
+				cubemap_texture = new ManagedTexture( *resources, texture, 4 );
 				if ( mesh ) mesh->addBindable( cubemap_texture );
 				show_cubemap = true;
 			}
 			ImGuiFileDialog::Instance()->Close();
 		}
-		if (show_loading_popup) {
-			ImGui::SetNextWindowSize(ImVec2(160, 50));
-			if (ImGui::BeginPopupModal("Loading...", nullptr, ImGuiWindowFlags_NoMove |
-															  ImGuiWindowFlags_NoResize |
-															  ImGuiWindowFlags_NoScrollbar |
-															  ImGuiWindowFlags_NoScrollWithMouse)) {
-				ImGui::LabelText("", "Loading mesh...");
-				ImGui::EndPopup();
+		ImGui::SetNextWindowSize(ImVec2(260, 110));
+		if (ImGui::BeginPopupModal("Loading...", nullptr, ImGuiWindowFlags_NoMove |
+														  ImGuiWindowFlags_NoResize |
+														  ImGuiWindowFlags_NoScrollbar |
+														  ImGuiWindowFlags_NoScrollWithMouse)) {
+			LoadProgress::Phase phase = mesh_load_progress.getPhase();
+			if (mesh_load_progress.getStepCount() > 0)
+			{
+				ImGui::Text("%s (%d/%d)", LoadProgress::getPhaseName(phase), mesh_load_progress.getStep(), mesh_load_progress.getStepCount());
+			}
+			else
+			{
+				ImGui::Text("%s", LoadProgress::getPhaseName(phase));
+			}
+			ImGui::ProgressBar(mesh_load_progress.getProgress());
+			if (mesh_load_progress.isCancelRequested())
+			{
+				ImGui::Text("Canceling...");
+			}
+			else if (ImGui::Button("Cancel"))
+			{
+				mesh_load_progress.cancel();
+			}
+			if (!show_loading_popup)
+			{
+				ImGui::CloseCurrentPopup();
 			}
+			ImGui::EndPopup();
 		}
 		ImGui::Render();
 		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 
 		// Trigger a back buffer swap in the swap chain
 		gfx->present();
+		mesh_slot.endFrame();
 	}
 
 	// Cleanup
-	// Loading thread cleanup
-	if (load_mesh_thread.joinable()) load_mesh_thread.join();
+	// Loading job cleanup
+	JobSystem::get().wait(load_mesh_job);
 
 	// Graphics cleanup
-	if ( mesh ) delete mesh;
+	mesh_slot.clear( { cubemap_texture, pbr_ps } );
+	mesh = nullptr;
+	if ( cubemap_texture ) delete cubemap_texture;
+	delete pbr_ps;
 	if ( cubemap ) delete cubemap;
+	delete resources;
+	delete resource_device;
 	delete gfx;
 
 	// Windows cleanup
@@ -0,0 +1,42 @@
+#include "IndexNarrowing.h"
+
+#include <emmintrin.h>
+
+bool fits_16bit_indices(const uint32_t* indices, size_t count)
+{
+	// OR everything together, any bit above the low 16 means a wide index
+	__m128i bits = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		bits = _mm_or_si128(bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i)));
+		bits = _mm_or_si128(bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4)));
+	}
+	uint32_t lanes[4];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), bits);
+	uint32_t tail = lanes[0] | lanes[1] | lanes[2] | lanes[3];
+	for (; i < count; i++)
+	{
+		tail |= indices[i];
+	}
+	return (tail & 0xFFFF0000u) == 0;
+}
+
+void narrow_indices(const uint32_t* indices, size_t count, uint16_t* out)
+{
+	// SSE2 only has a signed saturating pack, so shift [0, 65535] into the signed range and back
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16(short(0x8000));
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i)), bias32);
+		__m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4)), bias32);
+		__m128i packed = _mm_xor_si128(_mm_packs_epi32(low, high), bias16);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+	}
+	for (; i < count; i++)
+	{
+		out[i] = uint16_t(indices[i]);
+	}
+}
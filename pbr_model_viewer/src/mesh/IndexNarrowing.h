@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// True if every index is representable in 16 bits
+bool fits_16bit_indices(const uint32_t* indices, size_t count);
+
+// Narrows 32 bit indices to 16 bits, every index must be lower than 65536
+void narrow_indices(const uint32_t* indices, size_t count, uint16_t* out);
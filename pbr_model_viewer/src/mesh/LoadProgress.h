@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+
+// Progress of a mesh load. The loading thread publishes into it and the UI thread polls it every frame,
+// the UI thread can also request a cancel which the loader honours at the next phase boundary.
+class LoadProgress
+{
+public:
+	enum Phase
+	{
+		Idle,
+		Hashing,
+		Reading,
+		PostProcessing,
+		Converting,
+		Normals,
+		Welding,
+		Tangents,
+		Optimizing,
+		Simplifying,
+		Uploading,
+		Done,
+		Canceled,
+		Failed
+	};
+
+	LoadProgress() { reset(); }
+
+	void reset()
+	{
+		m_phase = Idle;
+		m_progress = 0.0f;
+		m_step = 0;
+		m_stepCount = 0;
+		m_cancel = false;
+	}
+
+	void setPhase(Phase phase)
+	{
+		m_step = 0;
+		m_stepCount = 0;
+		m_progress = 0.0f;
+		m_phase = phase;
+	}
+	void setProgress(float progress) { m_progress = progress; }
+	void setStep(int step, int step_count)
+	{
+		m_stepCount = step_count;
+		m_step = step;
+		m_progress = step_count > 0 ? float(step) / float(step_count) : 0.0f;
+	}
+
+	Phase getPhase() const { return m_phase; }
+	float getProgress() const { return m_progress; }
+	int getStep() const { return m_step; }
+	int getStepCount() const { return m_stepCount; }
+	bool isFinished() const { return m_phase == Done || m_phase == Canceled || m_phase == Failed; }
+
+	void cancel() { m_cancel = true; }
+	bool isCancelRequested() const { return m_cancel; }
+
+	static const char* getPhaseName(Phase phase)
+	{
+		switch (phase)
+		{
+		case Idle: return "Waiting";
+		case Hashing: return "Hashing file";
+		case Reading: return "Reading file";
+		case PostProcessing: return "Post-processing";
+		case Converting: return "Converting vertices";
+		case Normals: return "Generating normals";
+		case Welding: return "Welding vertices";
+		case Tangents: return "Generating tangents";
+		case Optimizing: return "Optimizing vertex cache";
+		case Simplifying: return "Generating LODs";
+		case Uploading: return "Uploading to GPU";
+		case Done: return "Done";
+		case Canceled: return "Canceled";
+		case Failed: return "Failed";
+		}
+		return "";
+	}
+
+private:
+	std::atomic<Phase> m_phase;
+	std::atomic<float> m_progress;
+	std::atomic<int> m_step;
+	std::atomic<int> m_stepCount;
+	std::atomic<bool> m_cancel;
+};
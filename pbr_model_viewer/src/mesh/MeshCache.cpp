@@ -0,0 +1,180 @@
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <fstream>
+
+// Bump whenever the layout of the header, of Vertex or of any section changes
+static const uint32_t mesh_cache_magic = 0x43564D50; // "PMVC"
+static const uint32_t mesh_cache_version = 9;
+static const uint64_t section_alignment = 16;
+
+struct MeshCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t vertexStride;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t submeshCount;
+	uint32_t meshletCount;
+	uint32_t lodCount;
+	uint32_t lodSubmeshCount;
+	float boundsMin[3];
+	float boundsMax[3];
+	MeshLoadStats stats;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t submeshOffset;
+	uint64_t meshletOffset;
+	uint64_t lodOffset;
+	uint64_t lodSubmeshOffset;
+	uint64_t fileSize;
+};
+
+static uint64_t align_offset(uint64_t offset)
+{
+	return (offset + section_alignment - 1) & ~(section_alignment - 1);
+}
+
+MeshCache::MeshCache(const std::string& directory)
+	: m_directory(directory)
+{
+}
+
+MeshCache::~MeshCache()
+{
+}
+
+bool MeshCache::open(uint64_t key)
+{
+	close();
+	if (!m_file.open(getPath(key)))
+	{
+		return false;
+	}
+
+	// Reject anything truncated or written by another version
+	const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(m_file.getData());
+	bool valid = m_file.getSize() >= sizeof(MeshCacheHeader) &&
+		header->magic == mesh_cache_magic &&
+		header->version == mesh_cache_version &&
+		header->key == key &&
+		header->vertexStride == sizeof(Vertex) &&
+		header->fileSize == m_file.getSize() &&
+		header->vertexOffset + uint64_t(header->vertexCount) * sizeof(Vertex) <= header->fileSize &&
+		header->indexOffset + uint64_t(header->indexCount) * sizeof(UINT) <= header->fileSize &&
+		header->submeshOffset + uint64_t(header->submeshCount) * sizeof(Submesh) <= header->fileSize &&
+		header->meshletOffset + uint64_t(header->meshletCount) * sizeof(Meshlet) <= header->fileSize &&
+		header->lodOffset + uint64_t(header->lodCount) * sizeof(MeshLod) <= header->fileSize &&
+		header->lodSubmeshOffset + uint64_t(header->lodSubmeshCount) * sizeof(Submesh) <= header->fileSize;
+	if (!valid)
+	{
+		close();
+	}
+	return valid;
+}
+
+void MeshCache::close()
+{
+	m_file.close();
+}
+
+bool MeshCache::store(uint64_t key, const MeshView& view, const MeshLoadStats& stats)
+{
+	MeshCacheHeader header = {};
+	header.magic = mesh_cache_magic;
+	header.version = mesh_cache_version;
+	header.key = key;
+	header.vertexStride = sizeof(Vertex);
+	header.vertexCount = view.vertexCount;
+	header.indexCount = view.indexCount;
+	header.submeshCount = view.submeshCount;
+	header.meshletCount = view.meshletCount;
+	header.lodCount = view.lodCount;
+	header.lodSubmeshCount = view.lodSubmeshCount;
+	header.boundsMin[0] = view.boundsMin.x;
+	header.boundsMin[1] = view.boundsMin.y;
+	header.boundsMin[2] = view.boundsMin.z;
+	header.boundsMax[0] = view.boundsMax.x;
+	header.boundsMax[1] = view.boundsMax.y;
+	header.boundsMax[2] = view.boundsMax.z;
+	header.stats = stats;
+	header.vertexOffset = align_offset(sizeof(MeshCacheHeader));
+	header.indexOffset = align_offset(header.vertexOffset + uint64_t(view.vertexCount) * sizeof(Vertex));
+	header.submeshOffset = align_offset(header.indexOffset + uint64_t(view.indexCount) * sizeof(UINT));
+	header.meshletOffset = align_offset(header.submeshOffset + uint64_t(view.submeshCount) * sizeof(Submesh));
+	header.lodOffset = align_offset(header.meshletOffset + uint64_t(view.meshletCount) * sizeof(Meshlet));
+	header.lodSubmeshOffset = align_offset(header.lodOffset + uint64_t(view.lodCount) * sizeof(MeshLod));
+	header.fileSize = header.lodSubmeshOffset + uint64_t(view.lodSubmeshCount) * sizeof(Submesh);
+
+	CreateDirectoryA(m_directory.c_str(), nullptr);
+
+	// Write to a temporary file and rename it so a crash never leaves a half written entry behind
+	std::string path = getPath(key);
+	std::string temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			return false;
+		}
+		const char padding[section_alignment] = {};
+		auto write_section = [&file, &padding](uint64_t offset, const void* data, uint64_t size)
+		{
+			uint64_t position = (uint64_t)file.tellp();
+			file.write(padding, std::streamsize(offset - position));
+			file.write(static_cast<const char*>(data), std::streamsize(size));
+		};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		write_section(header.vertexOffset, view.vertices, uint64_t(view.vertexCount) * sizeof(Vertex));
+		write_section(header.indexOffset, view.indices, uint64_t(view.indexCount) * sizeof(UINT));
+		write_section(header.submeshOffset, view.submeshes, uint64_t(view.submeshCount) * sizeof(Submesh));
+		write_section(header.meshletOffset, view.meshlets, uint64_t(view.meshletCount) * sizeof(Meshlet));
+		write_section(header.lodOffset, view.lods, uint64_t(view.lodCount) * sizeof(MeshLod));
+		write_section(header.lodSubmeshOffset, view.lodSubmeshes, uint64_t(view.lodSubmeshCount) * sizeof(Submesh));
+		if (!file)
+		{
+			file.close();
+			std::remove(temp_path.c_str());
+			return false;
+		}
+	}
+	std::remove(path.c_str());
+	return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+MeshView MeshCache::getView() const
+{
+	const unsigned char* data = m_file.getData();
+	const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(data);
+
+	MeshView view;
+	view.vertices = reinterpret_cast<const Vertex*>(data + header->vertexOffset);
+	view.vertexCount = header->vertexCount;
+	view.indices = reinterpret_cast<const UINT*>(data + header->indexOffset);
+	view.indexCount = header->indexCount;
+	view.submeshes = reinterpret_cast<const Submesh*>(data + header->submeshOffset);
+	view.submeshCount = header->submeshCount;
+	view.meshlets = reinterpret_cast<const Meshlet*>(data + header->meshletOffset);
+	view.meshletCount = header->meshletCount;
+	view.lods = reinterpret_cast<const MeshLod*>(data + header->lodOffset);
+	view.lodCount = header->lodCount;
+	view.lodSubmeshes = reinterpret_cast<const Submesh*>(data + header->lodSubmeshOffset);
+	view.lodSubmeshCount = header->lodSubmeshCount;
+	view.boundsMin = { header->boundsMin[0], header->boundsMin[1], header->boundsMin[2] };
+	view.boundsMax = { header->boundsMax[0], header->boundsMax[1], header->boundsMax[2] };
+	return view;
+}
+
+MeshLoadStats MeshCache::getStats() const
+{
+	return reinterpret_cast<const MeshCacheHeader*>(m_file.getData())->stats;
+}
+
+std::string MeshCache::getPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.meshcache", (unsigned long long)key);
+	return m_directory + "\\" + name;
+}
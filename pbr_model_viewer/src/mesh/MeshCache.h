@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <MappedFile.h>
+#include <mesh/MeshData.h>
+#include <mesh/MeshLoadStats.h>
+
+// On disk cache of fully processed meshes. Entries are keyed by the hash of the source file content
+// combined with the import settings, and are memory mapped on load so the vertex and index arrays
+// can be handed to the GPU buffers without any parsing.
+class MeshCache
+{
+public:
+	explicit MeshCache(const std::string& directory);
+	~MeshCache();
+
+	// Maps the entry for key if it exists and matches the current format
+	bool open(uint64_t key);
+	void close();
+	// Writes a new entry, stats are the ones of the cold import that produced it
+	bool store(uint64_t key, const MeshView& view, const MeshLoadStats& stats);
+
+	// Only valid while the entry is open
+	MeshView getView() const;
+	MeshLoadStats getStats() const;
+
+private:
+	std::string getPath(uint64_t key) const;
+
+	std::string m_directory;
+	MappedFile m_file;
+};
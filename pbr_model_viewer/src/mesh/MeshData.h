@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+
+#include <d3d11.h>
+#include <directxmath.h>
+
+#include <Vertex.h>
+
+// Range of the packed index arena that belongs to a single aiMesh instance.
+// Indices inside the range are local to the submesh and get rebased with baseVertex when drawn.
+struct Submesh
+{
+	UINT baseVertex;
+	UINT vertexCount;
+	UINT firstIndex;
+	UINT indexCount;
+};
+
+// Run of consecutive triangles of one submesh, at most meshlet_max_vertices unique vertices and meshlet_max_triangles triangles,
+// with the bounds the renderer uses to cull it against the frustum and by facing
+struct Meshlet
+{
+	DirectX::XMFLOAT3 center;
+	float radius;
+	// Every triangle normal is within the cone; coneCutoff 1 means the meshlet can never be backface culled
+	DirectX::XMFLOAT3 coneAxis;
+	float coneCutoff;
+	UINT baseVertex;
+	UINT vertexCount;
+	UINT firstIndex;
+	UINT indexCount;
+};
+
+// One level of detail, level 0 being the imported mesh. Its ranges are lodSubmeshes[firstSubmesh] onwards,
+// one per submesh, indexing the same vertices as level 0.
+struct MeshLod
+{
+	// Largest distance the simplified surface moved away from the original, in model units
+	float error;
+	UINT indexCount;
+	UINT firstSubmesh;
+	UINT firstMeshlet;
+	UINT meshletCount;
+};
+
+// CPU side copy of a whole imported model: one vertex arena, one index arena and the submesh table
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	std::vector<Submesh> submeshes;
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshLod> lods;
+	std::vector<Submesh> lodSubmeshes;
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+};
+
+// Non owning view of the mesh arrays, pointing either into a MeshData or into a mapped cache file
+struct MeshView
+{
+	const Vertex* vertices;
+	UINT vertexCount;
+	const UINT* indices;
+	UINT indexCount;
+	const Submesh* submeshes;
+	UINT submeshCount;
+	const Meshlet* meshlets;
+	UINT meshletCount;
+	const MeshLod* lods;
+	UINT lodCount;
+	const Submesh* lodSubmeshes;
+	UINT lodSubmeshCount;
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+};
+
+inline MeshView make_mesh_view(const MeshData& mesh_data)
+{
+	MeshView view;
+	view.vertices = mesh_data.vertices.data();
+	view.vertexCount = (UINT)mesh_data.vertices.size();
+	view.indices = mesh_data.indices.data();
+	view.indexCount = (UINT)mesh_data.indices.size();
+	view.submeshes = mesh_data.submeshes.data();
+	view.submeshCount = (UINT)mesh_data.submeshes.size();
+	view.meshlets = mesh_data.meshlets.data();
+	view.meshletCount = (UINT)mesh_data.meshlets.size();
+	view.lods = mesh_data.lods.data();
+	view.lodCount = (UINT)mesh_data.lods.size();
+	view.lodSubmeshes = mesh_data.lodSubmeshes.data();
+	view.lodSubmeshCount = (UINT)mesh_data.lodSubmeshes.size();
+	view.boundsMin = mesh_data.boundsMin;
+	view.boundsMax = mesh_data.boundsMax;
+	return view;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Hash.h>
+
+// User options that change the processed mesh, all of them are part of the mesh cache key
+struct MeshImportSettings
+{
+	// Sort triangle clusters to draw the outer surfaces first, giving up at most overdrawThreshold ACMR against the vertex cache order
+	bool reduceOverdraw = false;
+	float overdrawThreshold = 1.05f;
+	// Append a chain of simplified levels the renderer picks from by screen space error
+	bool generateLods = true;
+	// Read .obj files with the native parser instead of assimp
+	bool nativeObjParser = true;
+	// Grid size vertex components are rounded to before welding the assimp output, 0 welds bit identical vertices only
+	float weldEpsilon = 0.0f;
+	// Smooth normals are generated for meshes without them, or for every mesh when recomputeNormals is set.
+	// Faces bent more than creaseAngle degrees from each other keep a hard edge.
+	bool recomputeNormals = false;
+	float creaseAngle = 60.0f;
+
+	uint64_t getHash() const
+	{
+		// Field by field so padding never reaches the hash
+		uint64_t hash = hash_combine(0, reduceOverdraw ? 1 : 0);
+		hash = hash_combine(hash, reduceOverdraw ? uint64_t(overdrawThreshold * 1000.0f) : 0);
+		hash = hash_combine(hash, generateLods ? 1 : 0);
+		hash = hash_combine(hash, nativeObjParser ? 1 : 0);
+		hash = hash_combine(hash, uint64_t(double(weldEpsilon) * 1e9));
+		hash = hash_combine(hash, recomputeNormals ? 1 : 0);
+		hash = hash_combine(hash, uint64_t(creaseAngle * 1000.0f));
+		return hash;
+	}
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <d3d11.h>
+
+#include <mesh/MeshOptimizer.h>
+#include <mesh/ObjParser.h>
+#include <mesh/OverdrawAnalyzer.h>
+
+// Timings in milliseconds and results of a mesh load, shown in the mesh info window.
+// Plain data so the cache can store the stats of the cold import next to the mesh.
+struct MeshLoadStats
+{
+	bool cacheHit;
+	// The file went through the native OBJ parser, importMs and convertMs then cover its parse and vertex build
+	bool nativeObj;
+	uint64_t fileSize;
+	double hashMs;
+	double cacheMs;
+	double importMs;
+	double convertMs;
+	double normalMs;
+	double weldMs;
+	double tangentMs;
+	double optimizeMs;
+	double simplifyMs;
+	double meshletMs;
+	UINT vertexCount;
+	UINT indexCount;
+	UINT submeshCount;
+	UINT meshletCount;
+	UINT lodCount;
+	UINT normalSplitVertices;
+	UINT weldedVertices;
+	UINT tangentSplitVertices;
+	VertexCacheStats vertexCacheBefore;
+	VertexCacheStats vertexCacheAfter;
+	// Only measured when the overdraw optimization is enabled
+	OverdrawStats overdrawBefore;
+	OverdrawStats overdrawAfter;
+	ObjParseStats objParse;
+
+	// Time the cold import took, to compare against cacheMs on a hit
+	double getImportTotalMs() const { return importMs + convertMs + normalMs + weldMs + tangentMs + optimizeMs + simplifyMs + meshletMs; }
+	// Read throughput of the source file, parse and vertex build included
+	double getImportMbPerSecond() const
+	{
+		double ms = importMs + convertMs;
+		return ms > 0.0 ? double(fileSize) / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+	}
+};
@@ -0,0 +1,393 @@
+#include "MeshLoader.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cctype>
+#include <chrono>
+
+#include <Windows.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
+#include <assimp/postprocess.h>
+
+#include <Hash.h>
+#include <mesh/MeshletBuilder.h>
+#include <mesh/MeshOptimizer.h>
+#include <mesh/MeshSimplifier.h>
+#include <mesh/NormalGenerator.h>
+#include <mesh/ObjParser.h>
+#include <mesh/OverdrawAnalyzer.h>
+#include <mesh/TangentGenerator.h>
+#include <mesh/VertexConversion.h>
+#include <mesh/VertexWelder.h>
+
+static const unsigned int post_process_flags =
+	aiProcess_Triangulate |
+	aiProcess_ValidateDataStructure |
+	aiProcess_GenUVCoords |
+	aiProcess_FixInfacingNormals |
+	aiProcess_SortByPType;
+
+static const char* mesh_cache_directory = "mesh_cache";
+
+// Forwards assimp's read and post-process callbacks into LoadProgress, and aborts the import when a cancel is requested
+class ImportProgressHandler : public Assimp::ProgressHandler
+{
+public:
+	explicit ImportProgressHandler(LoadProgress& progress)
+		: m_progress(progress)
+	{
+	}
+
+	virtual bool Update(float percentage) override
+	{
+		return !m_progress.isCancelRequested();
+	}
+
+	virtual void UpdateFileRead(int current_step, int number_of_steps) override
+	{
+		if (m_progress.getPhase() != LoadProgress::Reading) m_progress.setPhase(LoadProgress::Reading);
+		m_progress.setStep(current_step, number_of_steps);
+	}
+
+	virtual void UpdatePostProcess(int current_step, int number_of_steps) override
+	{
+		if (m_progress.getPhase() != LoadProgress::PostProcessing) m_progress.setPhase(LoadProgress::PostProcessing);
+		m_progress.setStep(current_step, number_of_steps);
+	}
+
+private:
+	LoadProgress& m_progress;
+};
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool is_obj_file(const std::string& filename)
+{
+	size_t dot = filename.find_last_of('.');
+	if (dot == std::string::npos)
+	{
+		return false;
+	}
+	std::string extension = filename.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower((unsigned char)c)); });
+	return extension == "obj";
+}
+
+static uint64_t file_size(const std::string& filename)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return 0;
+	}
+	return (uint64_t(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+}
+
+MeshLoader::MeshLoader()
+	: m_cache(mesh_cache_directory)
+	, m_view()
+	, m_stats()
+{
+}
+
+MeshLoader::~MeshLoader()
+{
+}
+
+bool MeshLoader::load(const std::string& filename, const MeshImportSettings& settings, LoadProgress& progress)
+{
+	release();
+	m_stats = MeshLoadStats();
+	auto start = std::chrono::high_resolution_clock::now();
+
+	progress.setPhase(LoadProgress::Hashing);
+
+	// The cache key covers the file content and everything that changes the processed result
+	uint64_t file_hash = 0;
+	bool hashed = hash_file(filename, file_hash);
+	uint64_t key = hash_combine(hash_combine(file_hash, post_process_flags), settings.getHash());
+	m_stats.hashMs = elapsed_ms(start);
+	if (progress.isCancelRequested())
+	{
+		return false;
+	}
+
+	start = std::chrono::high_resolution_clock::now();
+	progress.setPhase(LoadProgress::Reading);
+	if (hashed && m_cache.open(key))
+	{
+		// Keep the stats of the cold import that produced the entry, to compare against the cache load time
+		double hash_ms = m_stats.hashMs;
+		m_view = m_cache.getView();
+		m_stats = m_cache.getStats();
+		m_stats.cacheHit = true;
+		m_stats.hashMs = hash_ms;
+		m_stats.cacheMs = elapsed_ms(start);
+		return m_view.submeshCount > 0;
+	}
+
+	if (!import(filename, settings, progress))
+	{
+		release();
+		return false;
+	}
+	m_view = make_mesh_view(m_data);
+	if (hashed)
+	{
+		m_cache.store(key, m_view, m_stats);
+	}
+	return true;
+}
+
+void MeshLoader::release()
+{
+	// Swap with empty containers so the memory is actually given back
+	m_instances = std::vector<MeshInstance>();
+	m_submeshHasNormals = std::vector<bool>();
+	m_data = MeshData();
+	m_view = MeshView();
+	m_cache.close();
+}
+
+bool MeshLoader::import(const std::string& filename, const MeshImportSettings& settings, LoadProgress& progress)
+{
+	MeshData& mesh_data = m_data;
+
+	// OBJ files go through the native parser, assimp takes over anything it can't read or that lacks normals or uvs
+	bool imported = false;
+	if (settings.nativeObjParser && is_obj_file(filename))
+	{
+		progress.setPhase(LoadProgress::Reading);
+		m_stats.nativeObj = parse_obj(filename, mesh_data, m_stats.objParse, progress);
+		imported = m_stats.nativeObj;
+		if (progress.isCancelRequested())
+		{
+			return false;
+		}
+		if (imported)
+		{
+			m_stats.importMs = m_stats.objParse.parseMs + m_stats.objParse.weldMs;
+			m_stats.convertMs = m_stats.objParse.vertexMs;
+		}
+		else
+		{
+			mesh_data = MeshData();
+		}
+	}
+	if (!imported)
+	{
+		if (!importScene(filename, progress) || progress.isCancelRequested())
+		{
+			return false;
+		}
+	}
+
+	// Smooth normals for meshes that come without them, or for all of them when asked to recompute
+	std::vector<bool> normal_mask(mesh_data.submeshes.size(), settings.recomputeNormals);
+	for (size_t s = 0; s < m_submeshHasNormals.size() && s < normal_mask.size(); s++)
+	{
+		normal_mask[s] = normal_mask[s] || !m_submeshHasNormals[s];
+	}
+	bool generate_normals_needed = std::find(normal_mask.begin(), normal_mask.end(), true) != normal_mask.end();
+	if (generate_normals_needed)
+	{
+		progress.setPhase(LoadProgress::Normals);
+		auto start = std::chrono::high_resolution_clock::now();
+		m_stats.normalSplitVertices = generate_normals(mesh_data, settings.creaseAngle, normal_mask);
+		m_stats.normalMs = elapsed_ms(start);
+		if (progress.isCancelRequested())
+		{
+			return false;
+		}
+	}
+
+	// Assimp leaves one vertex per face corner and normal generation splits vertices per corner, merge the identical ones
+	if (!imported || generate_normals_needed)
+	{
+		progress.setPhase(LoadProgress::Welding);
+		auto start = std::chrono::high_resolution_clock::now();
+		m_stats.weldedVertices = weld_vertices(mesh_data, settings.weldEpsilon);
+		m_stats.weldMs = elapsed_ms(start);
+	}
+	if (progress.isCancelRequested())
+	{
+		return false;
+	}
+	m_stats.fileSize = file_size(filename);
+
+	// Tangent frames are always generated here, on the welded mesh, even for files that come with their own
+	progress.setPhase(LoadProgress::Tangents);
+	auto start = std::chrono::high_resolution_clock::now();
+	m_stats.tangentSplitVertices = generate_tangents(mesh_data);
+	m_stats.tangentMs = elapsed_ms(start);
+	if (progress.isCancelRequested())
+	{
+		return false;
+	}
+
+	// Bounds of the whole model, after node transforms
+	mesh_data.boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	mesh_data.boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (const Vertex& vert : mesh_data.vertices)
+	{
+		mesh_data.boundsMin.x = std::min(mesh_data.boundsMin.x, vert.position.x);
+		mesh_data.boundsMin.y = std::min(mesh_data.boundsMin.y, vert.position.y);
+		mesh_data.boundsMin.z = std::min(mesh_data.boundsMin.z, vert.position.z);
+		mesh_data.boundsMax.x = std::max(mesh_data.boundsMax.x, vert.position.x);
+		mesh_data.boundsMax.y = std::max(mesh_data.boundsMax.y, vert.position.y);
+		mesh_data.boundsMax.z = std::max(mesh_data.boundsMax.z, vert.position.z);
+	}
+
+	// Reorder triangles for the post-transform cache and vertices for linear fetches
+	progress.setPhase(LoadProgress::Optimizing);
+	if (settings.reduceOverdraw)
+	{
+		m_stats.overdrawBefore = measure_overdraw(mesh_data);
+	}
+	start = std::chrono::high_resolution_clock::now();
+	optimize_mesh(mesh_data, settings.reduceOverdraw ? settings.overdrawThreshold : 0.0f, m_stats.vertexCacheBefore, m_stats.vertexCacheAfter);
+	m_stats.optimizeMs = elapsed_ms(start);
+	if (settings.reduceOverdraw)
+	{
+		m_stats.overdrawAfter = measure_overdraw(mesh_data);
+	}
+
+	if (progress.isCancelRequested())
+	{
+		return false;
+	}
+
+	// Coarser levels for distant views, appended to the index arena
+	progress.setPhase(LoadProgress::Simplifying);
+	start = std::chrono::high_resolution_clock::now();
+	generate_lods(mesh_data, settings.generateLods ? max_lod_count : 1);
+	m_stats.simplifyMs = elapsed_ms(start);
+	m_stats.lodCount = (UINT)mesh_data.lods.size();
+	if (progress.isCancelRequested())
+	{
+		return false;
+	}
+
+	// Clusters for per frame culling, built on the final triangle order of every level
+	start = std::chrono::high_resolution_clock::now();
+	build_meshlets(mesh_data);
+	m_stats.meshletMs = elapsed_ms(start);
+	m_stats.meshletCount = mesh_data.lods[0].meshletCount;
+	if (progress.isCancelRequested())
+	{
+		return false;
+	}
+	m_stats.vertexCount = (UINT)mesh_data.vertices.size();
+	m_stats.indexCount = (UINT)mesh_data.indices.size();
+	m_stats.submeshCount = (UINT)mesh_data.submeshes.size();
+
+	return !mesh_data.submeshes.empty();
+}
+
+bool MeshLoader::importScene(const std::string& filename, LoadProgress& progress)
+{
+	MeshData& mesh_data = m_data;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// The importer takes ownership of the handler. It returns null if the handler aborted the import,
+	// and frees the partially built scene itself.
+	Assimp::Importer importer;
+	importer.SetProgressHandler(new ImportProgressHandler(progress));
+	const aiScene* scene = importer.ReadFile(filename, post_process_flags);
+	if (!scene || !scene->mRootNode || progress.isCancelRequested())
+	{
+		return false;
+	}
+
+	m_stats.importMs = elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+
+	// Walk the whole node tree so every mesh instance ends up in the arena
+	m_instances.clear();
+	collectInstances(scene, scene->mRootNode, aiMatrix4x4());
+
+	// Size both arenas in a single pre-pass so nothing gets reallocated while filling them
+	size_t vertices_count = 0;
+	size_t indices_count = 0;
+	for (const MeshInstance& instance : m_instances)
+	{
+		vertices_count += instance.mesh->mNumVertices;
+		indices_count += instance.mesh->mNumFaces * 3;
+	}
+	mesh_data.vertices.resize(vertices_count);
+	mesh_data.indices.resize(indices_count);
+	mesh_data.submeshes.clear();
+	mesh_data.submeshes.reserve(m_instances.size());
+	m_submeshHasNormals.clear();
+
+	progress.setPhase(LoadProgress::Converting);
+	UINT base_vertex = 0;
+	UINT first_index = 0;
+	for (const MeshInstance& instance : m_instances)
+	{
+		progress.setProgress(float(base_vertex) / float(std::max<size_t>(1, vertices_count)));
+		Submesh submesh;
+		submesh.baseVertex = base_vertex;
+		submesh.vertexCount = instance.mesh->mNumVertices;
+		submesh.firstIndex = first_index;
+		submesh.indexCount = instance.mesh->mNumFaces * 3;
+
+		convertVertices(instance, mesh_data.vertices.data() + base_vertex);
+		convertIndices(instance.mesh, mesh_data.indices.data() + first_index);
+
+		mesh_data.submeshes.push_back(submesh);
+		m_submeshHasNormals.push_back(instance.mesh->HasNormals());
+		base_vertex += instance.mesh->mNumVertices;
+		first_index += submesh.indexCount;
+	}
+
+	m_stats.convertMs = elapsed_ms(start);
+	m_instances.clear();
+	return true;
+}
+
+void MeshLoader::collectInstances(const aiScene* scene, const aiNode* node, const aiMatrix4x4& parent_transform)
+{
+	aiMatrix4x4 transform = parent_transform * node->mTransformation;
+	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	{
+		const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+		// SortByPType leaves points and lines in their own meshes, we only draw triangle lists
+		if (mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE || mesh->mNumFaces == 0)
+		{
+			continue;
+		}
+		m_instances.push_back({ mesh, transform });
+	}
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	{
+		collectInstances(scene, node->mChildren[i], transform);
+	}
+}
+
+void MeshLoader::convertVertices(const MeshInstance& instance, Vertex* out)
+{
+	convert_vertices(instance.mesh, out);
+
+	// Bake the node transform into the vertices, most nodes are identity so skip those
+	if (!instance.transform.IsIdentity())
+	{
+		transform_vertices(out, instance.mesh->mNumVertices, instance.transform);
+	}
+}
+
+void MeshLoader::convertIndices(const aiMesh* mesh, UINT* out)
+{
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+	{
+		const aiFace& face = mesh->mFaces[i];
+		out[i * 3 + 0] = face.mIndices[0];
+		out[i * 3 + 1] = face.mIndices[1];
+		out[i * 3 + 2] = face.mIndices[2];
+	}
+}
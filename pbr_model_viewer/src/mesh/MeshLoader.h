@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <assimp/scene.h>
+
+#include <mesh/LoadProgress.h>
+#include <mesh/MeshCache.h>
+#include <mesh/MeshData.h>
+#include <mesh/MeshImportSettings.h>
+#include <mesh/MeshLoadStats.h>
+
+class MeshLoader
+{
+public:
+	MeshLoader();
+	~MeshLoader();
+
+	// Loads the processed mesh from the cache if possible, otherwise imports it with the native OBJ parser or assimp and caches the result.
+	// Returns false if the load failed or got canceled through progress, in which case nothing stays allocated.
+	bool load(const std::string& filename, const MeshImportSettings& settings, LoadProgress& progress);
+
+	// Arrays of the last load, valid while the loader is alive
+	MeshView getView() const { return m_view; }
+	const MeshLoadStats& getStats() const { return m_stats; }
+
+private:
+	// An aiMesh referenced by a node, together with the accumulated node transform
+	struct MeshInstance
+	{
+		const aiMesh* mesh;
+		aiMatrix4x4 transform;
+	};
+
+	bool import(const std::string& filename, const MeshImportSettings& settings, LoadProgress& progress);
+	bool importScene(const std::string& filename, LoadProgress& progress);
+	void release();
+	void collectInstances(const aiScene* scene, const aiNode* node, const aiMatrix4x4& parent_transform);
+	void convertVertices(const MeshInstance& instance, Vertex* out);
+	void convertIndices(const aiMesh* mesh, UINT* out);
+
+	std::vector<MeshInstance> m_instances;
+	// Whether each submesh of the assimp import came with normals, the native OBJ parser requires them
+	std::vector<bool> m_submeshHasNormals;
+	MeshData m_data;
+	MeshCache m_cache;
+	MeshView m_view;
+	MeshLoadStats m_stats;
+};
@@ -0,0 +1,349 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <Parallel.h>
+
+VertexCacheStats analyze_vertex_cache(const UINT* indices, UINT index_count, UINT vertex_count, UINT cache_size)
+{
+	VertexCacheStats stats = {};
+	stats.triangleCount = index_count / 3;
+
+	// FIFO cache through timestamps, a vertex is cached if it was inserted less than cache_size misses ago
+	std::vector<UINT> timestamps(vertex_count, 0);
+	std::vector<bool> referenced(vertex_count, false);
+	UINT time = cache_size + 1;
+	for (UINT i = 0; i < index_count; i++)
+	{
+		UINT v = indices[i];
+		if (time - timestamps[v] > cache_size)
+		{
+			timestamps[v] = time++;
+			stats.transformedVertices++;
+		}
+		if (!referenced[v])
+		{
+			referenced[v] = true;
+			stats.vertexCount++;
+		}
+	}
+	return stats;
+}
+
+void optimize_vertex_cache(UINT* indices, UINT index_count, UINT vertex_count, UINT cache_size)
+{
+	UINT triangle_count = index_count / 3;
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	// Vertex to triangle adjacency in CSR form, live_triangles counts the not yet emitted ones
+	std::vector<UINT> live_triangles(vertex_count, 0);
+	for (UINT i = 0; i < triangle_count * 3; i++)
+	{
+		live_triangles[indices[i]]++;
+	}
+	std::vector<UINT> adjacency_offsets(vertex_count + 1, 0);
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+	}
+	std::vector<UINT> adjacency(triangle_count * 3);
+	{
+		std::vector<UINT> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (UINT i = 0; i < triangle_count * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = i / 3;
+		}
+	}
+
+	std::vector<UINT> timestamps(vertex_count, 0);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<UINT> dead_end_stack;
+	std::vector<UINT> candidates;
+	std::vector<UINT> output;
+	output.reserve(triangle_count * 3);
+
+	UINT time = cache_size + 1;
+	UINT cursor = 0;
+	int fanning_vertex = 0;
+	while (fanning_vertex >= 0)
+	{
+		// Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (UINT a = adjacency_offsets[fanning_vertex]; a < adjacency_offsets[fanning_vertex + 1]; a++)
+		{
+			UINT t = adjacency[a];
+			if (emitted[t])
+			{
+				continue;
+			}
+			for (UINT c = 0; c < 3; c++)
+			{
+				UINT v = indices[t * 3 + c];
+				output.push_back(v);
+				dead_end_stack.push_back(v);
+				candidates.push_back(v);
+				live_triangles[v]--;
+				if (time - timestamps[v] > cache_size)
+				{
+					timestamps[v] = time++;
+				}
+			}
+			emitted[t] = true;
+		}
+
+		// Next fanning vertex is the candidate that will still be in cache after emitting its triangles, the oldest one first
+		int next_vertex = -1;
+		int best_priority = -1;
+		for (UINT v : candidates)
+		{
+			if (live_triangles[v] == 0)
+			{
+				continue;
+			}
+			int priority = 0;
+			if (time - timestamps[v] + 2 * live_triangles[v] <= cache_size)
+			{
+				priority = int(time - timestamps[v]);
+			}
+			if (priority > best_priority)
+			{
+				best_priority = priority;
+				next_vertex = int(v);
+			}
+		}
+
+		// Dead end, go back to a recently used vertex with triangles left, otherwise scan forward
+		while (next_vertex < 0 && !dead_end_stack.empty())
+		{
+			UINT v = dead_end_stack.back();
+			dead_end_stack.pop_back();
+			if (live_triangles[v] > 0)
+			{
+				next_vertex = int(v);
+			}
+		}
+		while (next_vertex < 0 && cursor < vertex_count)
+		{
+			if (live_triangles[cursor] > 0)
+			{
+				next_vertex = int(cursor);
+			}
+			cursor++;
+		}
+		fanning_vertex = next_vertex;
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+// Simulates one triangle on a FIFO cache and returns how many of its vertices missed
+static UINT cache_triangle(const UINT* triangle, std::vector<UINT>& timestamps, UINT& time, UINT cache_size)
+{
+	UINT misses = 0;
+	for (UINT c = 0; c < 3; c++)
+	{
+		UINT v = triangle[c];
+		if (time - timestamps[v] > cache_size)
+		{
+			timestamps[v] = time++;
+			misses++;
+		}
+	}
+	return misses;
+}
+
+void optimize_overdraw(const Vertex* vertices, UINT vertex_count, UINT* indices, UINT index_count, float threshold, UINT cache_size)
+{
+	UINT triangle_count = index_count / 3;
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	// Hard boundaries where the cache order starts a disjoint patch, all three vertices missing
+	std::vector<UINT> timestamps(vertex_count, 0);
+	UINT time = cache_size + 1;
+	std::vector<UINT> hard_clusters;
+	for (UINT t = 0; t < triangle_count; t++)
+	{
+		if (cache_triangle(indices + t * 3, timestamps, time, cache_size) == 3 || t == 0)
+		{
+			hard_clusters.push_back(t);
+		}
+	}
+	hard_clusters.push_back(triangle_count);
+
+	// Split further wherever the running ACMR since the last split is within threshold of the patch ACMR,
+	// each split restarts with a cold cache so that is the cost of drawing the clusters in any order
+	std::vector<UINT> clusters;
+	for (size_t h = 0; h + 1 < hard_clusters.size(); h++)
+	{
+		UINT start = hard_clusters[h];
+		UINT end = hard_clusters[h + 1];
+
+		time += cache_size + 1;
+		UINT patch_misses = 0;
+		for (UINT t = start; t < end; t++)
+		{
+			patch_misses += cache_triangle(indices + t * 3, timestamps, time, cache_size);
+		}
+		float target_acmr = threshold * float(patch_misses) / float(end - start);
+
+		clusters.push_back(start);
+		time += cache_size + 1;
+		UINT running_misses = 0;
+		UINT running_triangles = 0;
+		for (UINT t = start; t < end; t++)
+		{
+			running_misses += cache_triangle(indices + t * 3, timestamps, time, cache_size);
+			running_triangles++;
+			if (float(running_misses) <= target_acmr * float(running_triangles) && t + 1 < end)
+			{
+				clusters.push_back(t + 1);
+				time += cache_size + 1;
+				running_misses = 0;
+				running_triangles = 0;
+			}
+		}
+
+		// The tail never reached the target, merge it into the previous cluster of the patch
+		if (running_triangles > 0 && clusters.back() != start && float(running_misses) > target_acmr * float(running_triangles))
+		{
+			clusters.pop_back();
+		}
+	}
+	clusters.push_back(triangle_count);
+	size_t cluster_count = clusters.size() - 1;
+
+	// Mesh centroid over the referenced corners
+	double center[3] = {};
+	for (UINT i = 0; i < triangle_count * 3; i++)
+	{
+		const DirectX::XMFLOAT3& p = vertices[indices[i]].position;
+		center[0] += p.x;
+		center[1] += p.y;
+		center[2] += p.z;
+	}
+	for (double& c : center)
+	{
+		c /= triangle_count * 3;
+	}
+
+	// Occlusion potential, how far the cluster lies outwards along its average normal; outer shells occlude the rest
+	std::vector<float> sort_keys(cluster_count);
+	for (size_t c = 0; c < cluster_count; c++)
+	{
+		float centroid[3] = {};
+		float normal[3] = {};
+		float area_sum = 0.0f;
+		for (UINT t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const DirectX::XMFLOAT3& a = vertices[indices[t * 3 + 0]].position;
+			const DirectX::XMFLOAT3& b = vertices[indices[t * 3 + 1]].position;
+			const DirectX::XMFLOAT3& p = vertices[indices[t * 3 + 2]].position;
+			float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+			float e2[3] = { p.x - a.x, p.y - a.y, p.z - a.z };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			centroid[0] += (a.x + b.x + p.x) * area;
+			centroid[1] += (a.y + b.y + p.y) * area;
+			centroid[2] += (a.z + b.z + p.z) * area;
+			normal[0] += n[0];
+			normal[1] += n[1];
+			normal[2] += n[2];
+			area_sum += area;
+		}
+		float inverse_area = area_sum > 0.0f ? 1.0f / (area_sum * 3.0f) : 0.0f;
+		float normal_length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float inverse_normal = normal_length > 0.0f ? 1.0f / normal_length : 0.0f;
+		sort_keys[c] = 0.0f;
+		for (int k = 0; k < 3; k++)
+		{
+			sort_keys[c] += (centroid[k] * inverse_area - float(center[k])) * normal[k] * inverse_normal;
+		}
+	}
+
+	std::vector<UINT> order(cluster_count);
+	for (size_t c = 0; c < cluster_count; c++)
+	{
+		order[c] = UINT(c);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](UINT a, UINT b) { return sort_keys[a] > sort_keys[b]; });
+
+	std::vector<UINT> output;
+	output.reserve(triangle_count * 3);
+	for (UINT c : order)
+	{
+		output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void optimize_vertex_fetch(Vertex* vertices, UINT vertex_count, UINT* indices, UINT index_count)
+{
+	const UINT unassigned = UINT(-1);
+	std::vector<UINT> remap(vertex_count, unassigned);
+	UINT next = 0;
+	for (UINT i = 0; i < index_count; i++)
+	{
+		UINT& target = remap[indices[i]];
+		if (target == unassigned)
+		{
+			target = next++;
+		}
+		indices[i] = target;
+	}
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		if (remap[v] == unassigned)
+		{
+			remap[v] = next++;
+		}
+	}
+
+	std::vector<Vertex> reordered(vertex_count);
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		reordered[remap[v]] = vertices[v];
+	}
+	std::copy(reordered.begin(), reordered.end(), vertices);
+}
+
+void optimize_mesh(MeshData& mesh_data, float overdraw_threshold, VertexCacheStats& before, VertexCacheStats& after)
+{
+	size_t submesh_count = mesh_data.submeshes.size();
+	std::vector<VertexCacheStats> submesh_before(submesh_count);
+	std::vector<VertexCacheStats> submesh_after(submesh_count);
+	parallel_for(submesh_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t s = begin; s < end; s++)
+		{
+			const Submesh& submesh = mesh_data.submeshes[s];
+			Vertex* vertices = mesh_data.vertices.data() + submesh.baseVertex;
+			UINT* indices = mesh_data.indices.data() + submesh.firstIndex;
+
+			submesh_before[s] = analyze_vertex_cache(indices, submesh.indexCount, submesh.vertexCount);
+			optimize_vertex_cache(indices, submesh.indexCount, submesh.vertexCount);
+			if (overdraw_threshold > 0.0f)
+			{
+				optimize_overdraw(vertices, submesh.vertexCount, indices, submesh.indexCount, overdraw_threshold);
+			}
+			optimize_vertex_fetch(vertices, submesh.vertexCount, indices, submesh.indexCount);
+			submesh_after[s] = analyze_vertex_cache(indices, submesh.indexCount, submesh.vertexCount);
+		}
+	});
+
+	before = VertexCacheStats();
+	after = VertexCacheStats();
+	for (size_t s = 0; s < submesh_count; s++)
+	{
+		before.add(submesh_before[s]);
+		after.add(submesh_after[s]);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mesh/MeshData.h>
+
+// Post-transform cache simulation size, roughly what current GPUs reuse
+static const UINT vertex_cache_size = 16;
+
+// Result of simulating a FIFO post-transform vertex cache over an index buffer
+struct VertexCacheStats
+{
+	UINT transformedVertices;
+	UINT triangleCount;
+	UINT vertexCount;
+
+	// Average cache miss ratio, transformed vertices per triangle (0.5 best, 3 worst)
+	float getAcmr() const { return triangleCount ? float(transformedVertices) / float(triangleCount) : 0.0f; }
+	// Average transform to vertex ratio (1 best)
+	float getAtvr() const { return vertexCount ? float(transformedVertices) / float(vertexCount) : 0.0f; }
+
+	void add(const VertexCacheStats& other)
+	{
+		transformedVertices += other.transformedVertices;
+		triangleCount += other.triangleCount;
+		vertexCount += other.vertexCount;
+	}
+};
+
+VertexCacheStats analyze_vertex_cache(const UINT* indices, UINT index_count, UINT vertex_count, UINT cache_size = vertex_cache_size);
+
+// Reorders the triangles in place for post-transform cache reuse with Tipsify (Sander et al. 2007), linear in the index count
+void optimize_vertex_cache(UINT* indices, UINT index_count, UINT vertex_count, UINT cache_size = vertex_cache_size);
+
+// Renumbers the vertices in the order the indices first reference them so the vertex fetch walks memory linearly.
+// Unreferenced vertices are moved to the end so the vertex count doesn't change.
+void optimize_vertex_fetch(Vertex* vertices, UINT vertex_count, UINT* indices, UINT index_count);
+
+// Reorders vertex cache optimized triangles to reduce overdraw (Sander et al. 2007). The index buffer is split into
+// clusters whose ACMR stays within threshold times the input ACMR, then clusters facing away from the mesh center are drawn first.
+// The sort is view independent so it helps from any direction the orbit camera looks from.
+void optimize_overdraw(const Vertex* vertices, UINT vertex_count, UINT* indices, UINT index_count, float threshold, UINT cache_size = vertex_cache_size);
+
+// Runs the optimizations on every submesh in parallel, stats receive the whole mesh before and after.
+// A zero overdraw_threshold skips the overdraw pass.
+void optimize_mesh(MeshData& mesh_data, float overdraw_threshold, VertexCacheStats& before, VertexCacheStats& after);
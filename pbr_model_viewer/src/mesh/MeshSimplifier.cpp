@@ -0,0 +1,556 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <mesh/MeshOptimizer.h>
+#include <Parallel.h>
+
+namespace
+{
+	const UINT invalid_vertex = UINT(-1);
+
+	// How a vertex may move, see can_collapse
+	enum VertexKind
+	{
+		Manifold,
+		Border,
+		Seam,
+		Locked,
+	};
+
+	// Manifold vertices collapse onto anything, border and seam vertices only onto their own kind
+	const bool can_collapse[4][4] = {
+		{ true, true, true, true },
+		{ false, true, false, false },
+		{ false, false, true, false },
+		{ false, false, false, false },
+	};
+
+	// Open border edges get a perpendicular plane with this weight so they don't shrink
+	const float border_weight = 10.0f;
+	// Scales the attribute change of a collapse against its squared length
+	const float attribute_weight = 0.5f;
+
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	Float3 sub(Float3 a, Float3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	float dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	Float3 cross(Float3 a, Float3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	// Weighted sum of squared plane distances, error() divides by the weight so it is a squared distance
+	struct Quadric
+	{
+		float a00, a11, a22, a10, a20, a21;
+		float b0, b1, b2;
+		float c;
+		float w;
+
+		void addPlane(Float3 n, float d, float weight)
+		{
+			a00 += weight * n.x * n.x;
+			a11 += weight * n.y * n.y;
+			a22 += weight * n.z * n.z;
+			a10 += weight * n.y * n.x;
+			a20 += weight * n.z * n.x;
+			a21 += weight * n.z * n.y;
+			b0 += weight * n.x * d;
+			b1 += weight * n.y * d;
+			b2 += weight * n.z * d;
+			c += weight * d * d;
+			w += weight;
+		}
+
+		void add(const Quadric& q)
+		{
+			a00 += q.a00; a11 += q.a11; a22 += q.a22;
+			a10 += q.a10; a20 += q.a20; a21 += q.a21;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			w += q.w;
+		}
+
+		float error(Float3 p) const
+		{
+			float rx = a00 * p.x + a10 * p.y + a20 * p.z + 2.0f * b0;
+			float ry = a10 * p.x + a11 * p.y + a21 * p.z + 2.0f * b1;
+			float rz = a20 * p.x + a21 * p.y + a22 * p.z + 2.0f * b2;
+			float e = rx * p.x + ry * p.y + rz * p.z + c;
+			return w > 0.0f ? std::fabs(e) / w : 0.0f;
+		}
+	};
+
+	struct Collapse
+	{
+		UINT v0;
+		UINT v1;
+		float error;
+	};
+
+	// Outgoing half-edges of every vertex in CSR form, each with the third corner of its triangle
+	struct EdgeAdjacency
+	{
+		std::vector<UINT> offsets;
+		std::vector<UINT> targets;
+		std::vector<UINT> nexts;
+
+		void build(const UINT* indices, UINT index_count, UINT vertex_count)
+		{
+			offsets.assign(vertex_count + 1, 0);
+			for (UINT i = 0; i < index_count; i++)
+			{
+				offsets[indices[i] + 1]++;
+			}
+			for (UINT v = 0; v < vertex_count; v++)
+			{
+				offsets[v + 1] += offsets[v];
+			}
+			targets.resize(index_count);
+			nexts.resize(index_count);
+			std::vector<UINT> fill(offsets.begin(), offsets.end() - 1);
+			for (UINT i = 0; i < index_count; i += 3)
+			{
+				for (UINT c = 0; c < 3; c++)
+				{
+					UINT a = indices[i + c], b = indices[i + (c + 1) % 3], n = indices[i + (c + 2) % 3];
+					targets[fill[a]] = b;
+					nexts[fill[a]] = n;
+					fill[a]++;
+				}
+			}
+		}
+
+		bool hasEdge(UINT a, UINT b) const
+		{
+			for (UINT e = offsets[a]; e < offsets[a + 1]; e++)
+			{
+				if (targets[e] == b) return true;
+			}
+			return false;
+		}
+	};
+}
+
+// Moving v0 onto v1 must not turn any remaining triangle of v0 around
+static bool has_triangle_flips(const EdgeAdjacency& adjacency, const std::vector<Float3>& positions, UINT v0, UINT v1)
+{
+	Float3 p0 = positions[v0];
+	Float3 p1 = positions[v1];
+	for (UINT e = adjacency.offsets[v0]; e < adjacency.offsets[v0 + 1]; e++)
+	{
+		UINT a = adjacency.targets[e];
+		UINT b = adjacency.nexts[e];
+		if (a == v1 || b == v1)
+		{
+			continue;
+		}
+		Float3 pa = positions[a];
+		Float3 pb = positions[b];
+		Float3 before = cross(sub(pa, p0), sub(pb, p0));
+		Float3 after = cross(sub(pa, p1), sub(pb, p1));
+		// Degenerate triangles have no facing to lose
+		if (dot(before, after) <= 0.0f && dot(before, before) > 0.0f)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static float attribute_distance(const Vertex& a, const Vertex& b)
+{
+	float dnx = a.normal.x - b.normal.x, dny = a.normal.y - b.normal.y, dnz = a.normal.z - b.normal.z;
+	float du = a.uvs.x - b.uvs.x, dv = a.uvs.y - b.uvs.y;
+	return dnx * dnx + dny * dny + dnz * dnz + du * du + dv * dv;
+}
+
+UINT simplify_mesh(const Vertex* vertices, UINT vertex_count, const UINT* indices, UINT index_count, UINT target_index_count, UINT* destination, float& result_error)
+{
+	result_error = 0.0f;
+	index_count -= index_count % 3;
+	std::copy(indices, indices + index_count, destination);
+	if (index_count <= target_index_count || vertex_count == 0)
+	{
+		return index_count;
+	}
+
+	// Work in a unit cube so the quadrics keep their precision on any model scale
+	Float3 bounds_min = { FLT_MAX, FLT_MAX, FLT_MAX };
+	Float3 bounds_max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		const DirectX::XMFLOAT3& p = vertices[v].position;
+		bounds_min = { std::min(bounds_min.x, p.x), std::min(bounds_min.y, p.y), std::min(bounds_min.z, p.z) };
+		bounds_max = { std::max(bounds_max.x, p.x), std::max(bounds_max.y, p.y), std::max(bounds_max.z, p.z) };
+	}
+	float extent = std::max({ bounds_max.x - bounds_min.x, bounds_max.y - bounds_min.y, bounds_max.z - bounds_min.z });
+	float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+	std::vector<Float3> positions(vertex_count);
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		const DirectX::XMFLOAT3& p = vertices[v].position;
+		positions[v] = { (p.x - bounds_min.x) * scale, (p.y - bounds_min.y) * scale, (p.z - bounds_min.z) * scale };
+	}
+
+	// Vertices at the same position share remap (the first of them) and are linked in a ring through wedge
+	std::vector<UINT> remap(vertex_count);
+	std::vector<UINT> wedge(vertex_count);
+	{
+		struct PositionHash
+		{
+			size_t operator()(const DirectX::XMFLOAT3& p) const
+			{
+				uint32_t bits[3];
+				std::memcpy(bits, &p, sizeof(bits));
+				return size_t((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+			}
+		};
+		struct PositionEqual
+		{
+			bool operator()(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+		};
+		std::unordered_map<DirectX::XMFLOAT3, UINT, PositionHash, PositionEqual> first_vertex;
+		first_vertex.reserve(vertex_count);
+		for (UINT v = 0; v < vertex_count; v++)
+		{
+			UINT& first = first_vertex.emplace(vertices[v].position, v).first->second;
+			remap[v] = first;
+			wedge[v] = v;
+			if (first != v)
+			{
+				wedge[v] = wedge[first];
+				wedge[first] = v;
+			}
+		}
+	}
+
+	EdgeAdjacency adjacency;
+	adjacency.build(destination, index_count, vertex_count);
+
+	// Open half-edges have no twin with the same vertices, they run along borders and both sides of seams.
+	// A vertex with more than one open edge in the same direction gets itself as a marker.
+	std::vector<UINT> open_out(vertex_count, invalid_vertex);
+	std::vector<UINT> open_in(vertex_count, invalid_vertex);
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		for (UINT e = adjacency.offsets[v]; e < adjacency.offsets[v + 1]; e++)
+		{
+			UINT target = adjacency.targets[e];
+			if (!adjacency.hasEdge(target, v))
+			{
+				open_out[v] = open_out[v] == invalid_vertex ? target : v;
+				open_in[target] = open_in[target] == invalid_vertex ? v : target;
+			}
+		}
+	}
+
+	std::vector<unsigned char> kinds(vertex_count);
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		UINT in = open_in[v], out = open_out[v];
+		bool single_edges = in != invalid_vertex && out != invalid_vertex && in != v && out != v;
+		if (wedge[v] == v)
+		{
+			if (in == invalid_vertex && out == invalid_vertex) kinds[v] = Manifold;
+			else kinds[v] = single_edges ? Border : Locked;
+		}
+		else if (wedge[wedge[v]] == v)
+		{
+			// Both sides of a seam need one open edge each way, meeting at the same positions
+			UINT w = wedge[v];
+			UINT w_in = open_in[w], w_out = open_out[w];
+			bool w_single_edges = w_in != invalid_vertex && w_out != invalid_vertex && w_in != w && w_out != w;
+			kinds[v] = single_edges && w_single_edges && remap[in] == remap[w_out] && remap[out] == remap[w_in] ? Seam : Locked;
+		}
+		else
+		{
+			kinds[v] = Locked;
+		}
+	}
+	std::vector<UINT> loop(vertex_count, invalid_vertex);
+	std::vector<UINT> loopback(vertex_count, invalid_vertex);
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		if (kinds[v] == Border || kinds[v] == Seam)
+		{
+			loop[v] = open_out[v];
+			loopback[v] = open_in[v];
+		}
+	}
+
+	// Area weighted triangle planes and border planes, accumulated per position
+	std::vector<Quadric> quadrics(vertex_count, Quadric());
+	for (UINT i = 0; i < index_count; i += 3)
+	{
+		UINT a = destination[i], b = destination[i + 1], c = destination[i + 2];
+		Float3 n = cross(sub(positions[b], positions[a]), sub(positions[c], positions[a]));
+		float area = std::sqrt(dot(n, n));
+		if (area == 0.0f)
+		{
+			continue;
+		}
+		n = { n.x / area, n.y / area, n.z / area };
+		float d = -dot(n, positions[a]);
+		quadrics[remap[a]].addPlane(n, d, area);
+		quadrics[remap[b]].addPlane(n, d, area);
+		quadrics[remap[c]].addPlane(n, d, area);
+
+		for (UINT e = 0; e < 3; e++)
+		{
+			UINT v0 = destination[i + e], v1 = destination[i + (e + 1) % 3];
+			if (kinds[v0] != Border || loop[v0] != v1)
+			{
+				continue;
+			}
+			Float3 edge = sub(positions[v1], positions[v0]);
+			Float3 edge_normal = cross(edge, n);
+			float length = std::sqrt(dot(edge_normal, edge_normal));
+			if (length == 0.0f)
+			{
+				continue;
+			}
+			edge_normal = { edge_normal.x / length, edge_normal.y / length, edge_normal.z / length };
+			float edge_d = -dot(edge_normal, positions[v0]);
+			float weight = dot(edge, edge) * border_weight;
+			quadrics[remap[v0]].addPlane(edge_normal, edge_d, weight);
+			quadrics[remap[v1]].addPlane(edge_normal, edge_d, weight);
+		}
+	}
+
+	std::vector<Collapse> collapses;
+	std::vector<UINT> collapse_remap(vertex_count);
+	std::vector<bool> collapse_locked(vertex_count);
+	float max_error = 0.0f;
+
+	auto collapse_error = [&](UINT v0, UINT v1)
+	{
+		Float3 edge = sub(positions[v1], positions[v0]);
+		return quadrics[remap[v0]].error(positions[v1]) + attribute_distance(vertices[v0], vertices[v1]) * dot(edge, edge) * attribute_weight;
+	};
+	auto is_valid_direction = [&](UINT v0, UINT v1)
+	{
+		if (!can_collapse[kinds[v0]][kinds[v1]])
+		{
+			return false;
+		}
+		// Border and seam vertices only move along their own loop
+		if ((kinds[v0] == Border || kinds[v0] == Seam) && loop[v0] != v1 && loopback[v0] != v1)
+		{
+			return false;
+		}
+		// The other side of a seam has to have the matching edge as well
+		if (kinds[v0] == Seam)
+		{
+			UINT s0 = wedge[v0], s1 = wedge[v1];
+			if (!adjacency.hasEdge(s0, s1) && !adjacency.hasEdge(s1, s0))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	while (index_count > target_index_count)
+	{
+		adjacency.build(destination, index_count, vertex_count);
+
+		// Cheapest valid direction of every triangle edge
+		collapses.clear();
+		for (UINT i = 0; i < index_count; i += 3)
+		{
+			for (UINT e = 0; e < 3; e++)
+			{
+				UINT v0 = destination[i + e], v1 = destination[i + (e + 1) % 3];
+				if (remap[v0] == remap[v1])
+				{
+					continue;
+				}
+				// Interior edges show up in both triangles, consider them once
+				if (v0 > v1 && adjacency.hasEdge(v1, v0))
+				{
+					continue;
+				}
+				bool forward = is_valid_direction(v0, v1);
+				bool backward = is_valid_direction(v1, v0);
+				if (!forward && !backward)
+				{
+					continue;
+				}
+				float forward_error = forward ? collapse_error(v0, v1) : FLT_MAX;
+				float backward_error = backward ? collapse_error(v1, v0) : FLT_MAX;
+				if (forward_error <= backward_error) collapses.push_back({ v0, v1, forward_error });
+				else collapses.push_back({ v1, v0, backward_error });
+			}
+		}
+		if (collapses.empty())
+		{
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		// A collapse removes two triangles, one on a border. Many candidates get locked by a neighbour in the same pass,
+		// so accept somewhat more error than the cheapest collapses that would reach the goal.
+		UINT triangle_goal = (index_count - target_index_count) / 3;
+		size_t goal_collapse = std::min(collapses.size() - 1, size_t(triangle_goal / 2));
+		float error_goal = collapses[goal_collapse].error * 1.5f;
+
+		for (UINT v = 0; v < vertex_count; v++)
+		{
+			collapse_remap[v] = v;
+		}
+		std::fill(collapse_locked.begin(), collapse_locked.end(), false);
+
+		UINT triangle_collapses = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			// Go past the error goal while the pass did too little, otherwise a few cheap rejected candidates
+			// at the front of the list would throttle every following pass
+			if ((collapse.error > error_goal && triangle_collapses >= std::max(triangle_goal / 8, 1u)) || triangle_collapses >= triangle_goal)
+			{
+				break;
+			}
+			UINT v0 = collapse.v0, v1 = collapse.v1;
+			if (collapse_locked[remap[v0]] || collapse_locked[remap[v1]])
+			{
+				continue;
+			}
+			if (has_triangle_flips(adjacency, positions, v0, v1))
+			{
+				continue;
+			}
+
+			if (kinds[v0] == Seam)
+			{
+				UINT s0 = wedge[v0], s1 = wedge[v1];
+				if (has_triangle_flips(adjacency, positions, s0, s1))
+				{
+					continue;
+				}
+				collapse_remap[s0] = s1;
+			}
+			collapse_remap[v0] = v1;
+
+			quadrics[remap[v1]].add(quadrics[remap[v0]]);
+			collapse_locked[remap[v0]] = true;
+			collapse_locked[remap[v1]] = true;
+			triangle_collapses += kinds[v0] == Border ? 1 : 2;
+			max_error = std::max(max_error, collapse.error);
+		}
+		if (triangle_collapses == 0)
+		{
+			break;
+		}
+
+		// Loops skip the collapsed vertices, when a loop edge collapsed backwards the loop continues past it
+		for (std::vector<UINT>* loops : { &loop, &loopback })
+		{
+			std::vector<UINT>& l = *loops;
+			for (UINT v = 0; v < vertex_count; v++)
+			{
+				if (l[v] != invalid_vertex)
+				{
+					UINT target = l[v];
+					UINT remapped = collapse_remap[target];
+					l[v] = remapped == v ? l[target] : remapped;
+				}
+			}
+		}
+
+		// Remap and drop the triangles that became degenerate
+		UINT write = 0;
+		for (UINT i = 0; i < index_count; i += 3)
+		{
+			UINT a = collapse_remap[destination[i]];
+			UINT b = collapse_remap[destination[i + 1]];
+			UINT c = collapse_remap[destination[i + 2]];
+			if (a != b && b != c && c != a)
+			{
+				destination[write++] = a;
+				destination[write++] = b;
+				destination[write++] = c;
+			}
+		}
+		index_count = write;
+	}
+
+	result_error = std::sqrt(max_error) * extent;
+	return index_count;
+}
+
+void generate_lods(MeshData& mesh_data, UINT level_count)
+{
+	size_t submesh_count = mesh_data.submeshes.size();
+	mesh_data.lods.clear();
+	mesh_data.lodSubmeshes = mesh_data.submeshes;
+	MeshLod base_lod = {};
+	base_lod.indexCount = (UINT)mesh_data.indices.size();
+	mesh_data.lods.push_back(base_lod);
+	if (submesh_count == 0 || level_count < 2)
+	{
+		return;
+	}
+
+	// Every submesh builds its whole chain on its own, each level simplifying the previous one
+	std::vector<std::vector<std::vector<UINT>>> levels(submesh_count);
+	std::vector<std::vector<float>> errors(submesh_count);
+	parallel_for(submesh_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t s = begin; s < end; s++)
+		{
+			const Submesh& submesh = mesh_data.submeshes[s];
+			const Vertex* vertices = mesh_data.vertices.data() + submesh.baseVertex;
+			const UINT* source = mesh_data.indices.data() + submesh.firstIndex;
+			UINT source_count = submesh.indexCount;
+			float error = 0.0f;
+			for (UINT level = 1; level < level_count; level++)
+			{
+				std::vector<UINT> lod_indices(source_count);
+				UINT target = (source_count / 2) / 3 * 3;
+				float level_error = 0.0f;
+				UINT count = simplify_mesh(vertices, submesh.vertexCount, source, source_count, target, lod_indices.data(), level_error);
+				lod_indices.resize(count);
+				optimize_vertex_cache(lod_indices.data(), count, submesh.vertexCount);
+				error = std::max(error, level_error);
+				levels[s].push_back(std::move(lod_indices));
+				errors[s].push_back(error);
+				source = levels[s].back().data();
+				source_count = count;
+			}
+		}
+	});
+
+	// Append the levels to the arena, a level is kept while it removes at least a tenth of the previous one
+	UINT previous_count = base_lod.indexCount;
+	for (UINT level = 1; level < level_count; level++)
+	{
+		MeshLod lod = {};
+		lod.firstSubmesh = (UINT)mesh_data.lodSubmeshes.size();
+		for (size_t s = 0; s < submesh_count; s++)
+		{
+			lod.indexCount += (UINT)levels[s][level - 1].size();
+		}
+		if (lod.indexCount == 0 || lod.indexCount > previous_count * 9 / 10)
+		{
+			break;
+		}
+		for (size_t s = 0; s < submesh_count; s++)
+		{
+			const std::vector<UINT>& lod_indices = levels[s][level - 1];
+			Submesh range = mesh_data.submeshes[s];
+			range.firstIndex = (UINT)mesh_data.indices.size();
+			range.indexCount = (UINT)lod_indices.size();
+			mesh_data.indices.insert(mesh_data.indices.end(), lod_indices.begin(), lod_indices.end());
+			mesh_data.lodSubmeshes.push_back(range);
+			lod.error = std::max(lod.error, errors[s][level - 1]);
+		}
+		mesh_data.lods.push_back(lod);
+		previous_count = lod.indexCount;
+	}
+}
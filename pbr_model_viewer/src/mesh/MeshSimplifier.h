@@ -0,0 +1,18 @@
+#pragma once
+
+#include <mesh/MeshData.h>
+
+static const UINT max_lod_count = 6;
+
+// Quadric error edge collapse simplification (Garland and Heckbert 1997) that only collapses onto existing vertices,
+// so the result indexes the same vertex array. Vertices on open borders and on UV or normal seams (same position,
+// different attributes) only slide along their border or seam, seams collapse both sides at once and anything more
+// complex stays locked. Collapses that change normals or uvs a lot cost more than purely geometric ones.
+// Writes at most index_count indices to destination and returns how many, result_error receives the largest
+// collapse error as a distance in model units.
+UINT simplify_mesh(const Vertex* vertices, UINT vertex_count, const UINT* indices, UINT index_count, UINT target_index_count, UINT* destination, float& result_error);
+
+// Builds up to level_count levels, each halving the triangles of the previous one, submeshes in parallel.
+// Level 0 is the mesh itself, coarser levels are appended to the index arena. Stops early when the simplifier
+// can't remove enough triangles anymore.
+void generate_lods(MeshData& mesh_data, UINT level_count = max_lod_count);
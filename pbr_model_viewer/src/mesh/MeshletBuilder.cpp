@@ -0,0 +1,199 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <Parallel.h>
+
+// Bounding sphere and normal cone of the triangles in [first_index, first_index + index_count)
+static void compute_meshlet_bounds(const Vertex* vertices, const UINT* indices, Meshlet& meshlet)
+{
+	const UINT* meshlet_indices = indices + meshlet.firstIndex;
+
+	// Sphere around the box of the referenced vertices, cheap and tight enough for small clusters
+	float bounds_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float bounds_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (UINT i = 0; i < meshlet.indexCount; i++)
+	{
+		const DirectX::XMFLOAT3& p = vertices[meshlet_indices[i]].position;
+		const float position[3] = { p.x, p.y, p.z };
+		for (int k = 0; k < 3; k++)
+		{
+			bounds_min[k] = std::min(bounds_min[k], position[k]);
+			bounds_max[k] = std::max(bounds_max[k], position[k]);
+		}
+	}
+	meshlet.center = { (bounds_min[0] + bounds_max[0]) * 0.5f, (bounds_min[1] + bounds_max[1]) * 0.5f, (bounds_min[2] + bounds_max[2]) * 0.5f };
+	float radius_squared = 0.0f;
+	for (UINT i = 0; i < meshlet.indexCount; i++)
+	{
+		const DirectX::XMFLOAT3& p = vertices[meshlet_indices[i]].position;
+		float dx = p.x - meshlet.center.x, dy = p.y - meshlet.center.y, dz = p.z - meshlet.center.z;
+		radius_squared = std::max(radius_squared, dx * dx + dy * dy + dz * dz);
+	}
+	meshlet.radius = std::sqrt(radius_squared);
+
+	// Geometric triangle normals, counter clockwise is front facing like the rasterizer state
+	UINT triangle_count = meshlet.indexCount / 3;
+	std::vector<DirectX::XMFLOAT3> normals;
+	normals.reserve(triangle_count);
+	float axis[3] = {};
+	for (UINT t = 0; t < triangle_count; t++)
+	{
+		const DirectX::XMFLOAT3& a = vertices[meshlet_indices[t * 3 + 0]].position;
+		const DirectX::XMFLOAT3& b = vertices[meshlet_indices[t * 3 + 1]].position;
+		const DirectX::XMFLOAT3& c = vertices[meshlet_indices[t * 3 + 2]].position;
+		float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+		float e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+		float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		// Degenerate triangles are never rasterized, they don't constrain the cone
+		if (length == 0.0f)
+		{
+			continue;
+		}
+		normals.push_back({ n[0] / length, n[1] / length, n[2] / length });
+		axis[0] += n[0] / length;
+		axis[1] += n[1] / length;
+		axis[2] += n[2] / length;
+	}
+
+	meshlet.coneAxis = { 0.0f, 0.0f, 0.0f };
+	meshlet.coneCutoff = 1.0f;
+	float axis_length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	if (normals.empty() || axis_length == 0.0f)
+	{
+		return;
+	}
+	meshlet.coneAxis = { axis[0] / axis_length, axis[1] / axis_length, axis[2] / axis_length };
+
+	float min_dot = 1.0f;
+	for (const DirectX::XMFLOAT3& n : normals)
+	{
+		min_dot = std::min(min_dot, n.x * meshlet.coneAxis.x + n.y * meshlet.coneAxis.y + n.z * meshlet.coneAxis.z);
+	}
+	// A cone wider than ~85 degrees culls too rarely to be worth the test
+	if (min_dot > 0.1f)
+	{
+		meshlet.coneCutoff = std::sqrt(1.0f - min_dot * min_dot);
+	}
+}
+
+static void build_submesh_meshlets(const MeshData& mesh_data, const Submesh& submesh, std::vector<Meshlet>& meshlets)
+{
+	const Vertex* vertices = mesh_data.vertices.data() + submesh.baseVertex;
+	const UINT* indices = mesh_data.indices.data();
+
+	// Marks the vertices already in the current meshlet with its number, so no clearing is needed between meshlets
+	std::vector<UINT> used(submesh.vertexCount, UINT(-1));
+	UINT meshlet_id = 0;
+
+	Meshlet meshlet = {};
+	meshlet.baseVertex = submesh.baseVertex;
+	meshlet.firstIndex = submesh.firstIndex;
+	auto flush = [&](UINT next_index)
+	{
+		compute_meshlet_bounds(vertices, indices, meshlet);
+		meshlets.push_back(meshlet);
+		meshlet.firstIndex = next_index;
+		meshlet.indexCount = 0;
+		meshlet.vertexCount = 0;
+		meshlet_id++;
+	};
+
+	for (UINT i = submesh.firstIndex; i + 2 < submesh.firstIndex + submesh.indexCount; i += 3)
+	{
+		UINT new_vertices = 0;
+		for (UINT c = 0; c < 3; c++)
+		{
+			new_vertices += used[indices[i + c]] != meshlet_id ? 1 : 0;
+		}
+		// Corners repeated inside the triangle are counted twice, which only makes the limit slightly stricter
+		if (meshlet.vertexCount + new_vertices > meshlet_max_vertices || meshlet.indexCount / 3 >= meshlet_max_triangles)
+		{
+			flush(i);
+		}
+		for (UINT c = 0; c < 3; c++)
+		{
+			UINT& mark = used[indices[i + c]];
+			if (mark != meshlet_id)
+			{
+				mark = meshlet_id;
+				meshlet.vertexCount++;
+			}
+		}
+		meshlet.indexCount += 3;
+	}
+	if (meshlet.indexCount > 0)
+	{
+		flush(0);
+	}
+}
+
+void build_meshlets(MeshData& mesh_data)
+{
+	// Ranges of all levels are ordered by level, so the meshlets of a level come out contiguous
+	size_t range_count = mesh_data.lodSubmeshes.size();
+	std::vector<std::vector<Meshlet>> range_meshlets(range_count);
+	parallel_for(range_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t r = begin; r < end; r++)
+		{
+			build_submesh_meshlets(mesh_data, mesh_data.lodSubmeshes[r], range_meshlets[r]);
+		}
+	});
+
+	mesh_data.meshlets.clear();
+	size_t submesh_count = mesh_data.submeshes.size();
+	for (MeshLod& lod : mesh_data.lods)
+	{
+		lod.firstMeshlet = (UINT)mesh_data.meshlets.size();
+		for (size_t r = lod.firstSubmesh; r < lod.firstSubmesh + submesh_count; r++)
+		{
+			mesh_data.meshlets.insert(mesh_data.meshlets.end(), range_meshlets[r].begin(), range_meshlets[r].end());
+		}
+		lod.meshletCount = (UINT)mesh_data.meshlets.size() - lod.firstMeshlet;
+	}
+}
+
+void extract_frustum_planes(const DirectX::XMMATRIX& transposed_view_proj, DirectX::XMFLOAT4 planes[6])
+{
+	// Rows of the transposed matrix produce the clip coordinates directly, clip z is in [0, w]
+	DirectX::XMVECTOR x = transposed_view_proj.r[0];
+	DirectX::XMVECTOR y = transposed_view_proj.r[1];
+	DirectX::XMVECTOR z = transposed_view_proj.r[2];
+	DirectX::XMVECTOR w = transposed_view_proj.r[3];
+	DirectX::XMVECTOR clip_planes[6] = {
+		DirectX::XMVectorAdd(w, x),
+		DirectX::XMVectorSubtract(w, x),
+		DirectX::XMVectorAdd(w, y),
+		DirectX::XMVectorSubtract(w, y),
+		z,
+		DirectX::XMVectorSubtract(w, z),
+	};
+	for (int p = 0; p < 6; p++)
+	{
+		DirectX::XMStoreFloat4(&planes[p], DirectX::XMPlaneNormalize(clip_planes[p]));
+	}
+}
+
+bool is_meshlet_visible(const Meshlet& meshlet, const DirectX::XMFLOAT4 planes[6], const DirectX::XMFLOAT3& camera_position)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		const DirectX::XMFLOAT4& plane = planes[p];
+		if (plane.x * meshlet.center.x + plane.y * meshlet.center.y + plane.z * meshlet.center.z + plane.w < -meshlet.radius)
+		{
+			return false;
+		}
+	}
+
+	// Backfacing if the whole sphere sees the cone from behind
+	float dx = meshlet.center.x - camera_position.x;
+	float dy = meshlet.center.y - camera_position.y;
+	float dz = meshlet.center.z - camera_position.z;
+	float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+	float along_axis = dx * meshlet.coneAxis.x + dy * meshlet.coneAxis.y + dz * meshlet.coneAxis.z;
+	return along_axis < meshlet.coneCutoff * distance + meshlet.radius;
+}
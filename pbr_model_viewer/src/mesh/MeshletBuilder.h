@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include <directxmath.h>
+
+#include <mesh/MeshData.h>
+
+static const UINT meshlet_max_vertices = 64;
+static const UINT meshlet_max_triangles = 124;
+
+// Splits the submesh ranges of every level of detail into meshlets following the current triangle order, so the
+// triangles of a meshlet stay a contiguous index range and the vertex cache order is kept. Ranges are processed in parallel.
+void build_meshlets(MeshData& mesh_data);
+
+// Normalized frustum planes (xyz normal pointing inside, w distance) of a view projection matrix in the
+// transposed layout the camera uploads to the shaders
+void extract_frustum_planes(const DirectX::XMMATRIX& transposed_view_proj, DirectX::XMFLOAT4 planes[6]);
+
+// Conservative test, false only if the meshlet is fully outside the frustum or every triangle faces away from the camera
+bool is_meshlet_visible(const Meshlet& meshlet, const DirectX::XMFLOAT4 planes[6], const DirectX::XMFLOAT3& camera_position);
@@ -0,0 +1,295 @@
+#include "NormalGenerator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <Parallel.h>
+
+// Below this many triangles or vertices spawning threads costs more than the work itself
+static const size_t min_normal_items_per_thread = 16384;
+
+namespace
+{
+	using DirectX::XMFLOAT3;
+
+	XMFLOAT3 sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	float dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	XMFLOAT3 normalize_safe(const XMFLOAT3& a)
+	{
+		float length = std::sqrt(dot(a, a));
+		return length > FLT_MIN ? XMFLOAT3(a.x / length, a.y / length, a.z / length) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+
+	bool same_normal(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+	// Integer cell of the spatial hash grid
+	struct Cell
+	{
+		int64_t x, y, z;
+
+		bool operator==(const Cell& other) const { return x == other.x && y == other.y && z == other.z; }
+	};
+
+	size_t hash_cell(const Cell& cell)
+	{
+		uint64_t h = uint64_t(cell.x) * 0x9E3779B185EBCA87ull;
+		h ^= uint64_t(cell.y) * 0xC2B2AE3D27D4EB4Full;
+		h ^= uint64_t(cell.z) * 0x165667B19E3779F9ull;
+		return size_t(h ^ (h >> 31));
+	}
+
+	// Items 0..item_count grouped by their key, in ascending order inside every group
+	struct Buckets
+	{
+		std::vector<UINT> offsets;
+		std::vector<UINT> items;
+
+		void build(UINT key_count, UINT item_count, const UINT* keys)
+		{
+			offsets.assign(key_count + 1, 0);
+			for (UINT i = 0; i < item_count; i++) offsets[keys[i] + 1]++;
+			for (UINT k = 0; k < key_count; k++) offsets[k + 1] += offsets[k];
+			items.resize(item_count);
+			std::vector<UINT> next(offsets.begin(), offsets.end() - 1);
+			for (UINT i = 0; i < item_count; i++) items[next[keys[i]]++] = i;
+		}
+	};
+}
+
+// Representative of every vertex, the lowest vertex whose position is within tolerance of it
+static std::vector<UINT> find_coincident_positions(const Vertex* vertices, UINT vertex_count, size_t thread_count)
+{
+	XMFLOAT3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		const XMFLOAT3& p = vertices[v].position;
+		bounds_min = { std::min(bounds_min.x, p.x), std::min(bounds_min.y, p.y), std::min(bounds_min.z, p.z) };
+		bounds_max = { std::max(bounds_max.x, p.x), std::max(bounds_max.y, p.y), std::max(bounds_max.z, p.z) };
+	}
+	XMFLOAT3 diagonal = sub(bounds_max, bounds_min);
+	double tolerance = std::max(double(std::sqrt(dot(diagonal, diagonal))) * coincident_position_tolerance, double(FLT_MIN));
+	double inverse_cell = 1.0 / tolerance;
+	float tolerance_squared = float(tolerance * tolerance);
+
+	// Cells are as large as the tolerance, so coincident positions are always in the same or a neighbouring cell
+	std::vector<Cell> cells(vertex_count);
+	size_t table_size = 1;
+	while (table_size < size_t(vertex_count) * 2) table_size <<= 1;
+	std::vector<UINT> buckets(vertex_count);
+	parallel_for_workers(thread_count, vertex_count, min_normal_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			const XMFLOAT3& p = vertices[v].position;
+			cells[v] = { int64_t(std::floor(p.x * inverse_cell)), int64_t(std::floor(p.y * inverse_cell)), int64_t(std::floor(p.z * inverse_cell)) };
+			buckets[v] = UINT(hash_cell(cells[v]) & (table_size - 1));
+		}
+	});
+	Buckets grid;
+	grid.build(UINT(table_size), vertex_count, buckets.data());
+	buckets = std::vector<UINT>();
+
+	std::vector<UINT> representative(vertex_count);
+	parallel_for_workers(thread_count, vertex_count, min_normal_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			const XMFLOAT3& p = vertices[v].position;
+			UINT lowest = UINT(v);
+			for (int64_t dz = -1; dz <= 1; dz++)
+			{
+				for (int64_t dy = -1; dy <= 1; dy++)
+				{
+					for (int64_t dx = -1; dx <= 1; dx++)
+					{
+						Cell cell = { cells[v].x + dx, cells[v].y + dy, cells[v].z + dz };
+						size_t bucket = hash_cell(cell) & (table_size - 1);
+						for (UINT i = grid.offsets[bucket]; i < grid.offsets[bucket + 1]; i++)
+						{
+							UINT other = grid.items[i];
+							if (other >= lowest || !(cells[other] == cell))
+							{
+								continue;
+							}
+							XMFLOAT3 d = sub(vertices[other].position, p);
+							if (dot(d, d) <= tolerance_squared)
+							{
+								lowest = other;
+							}
+						}
+					}
+				}
+			}
+			representative[v] = lowest;
+		}
+	});
+	return representative;
+}
+
+// Normals of one submesh. Corners whose normal differs from the first corner of their vertex get their index
+// redirected to a copy of the vertex appended to split_vertices, numbered from vertex_count on.
+static void generate_submesh_normals(Vertex* vertices, UINT vertex_count, UINT* indices, UINT index_count, float crease_cos,
+	std::vector<Vertex>& split_vertices, size_t thread_count)
+{
+	UINT triangle_count = index_count / 3;
+	UINT corner_count = triangle_count * 3;
+
+	// Unit face normals, counter clockwise front faces like the rasterizer state, and the angle of every corner
+	std::vector<XMFLOAT3> face_normals(triangle_count);
+	std::vector<float> corner_angles(corner_count);
+	parallel_for_workers(thread_count, triangle_count, min_normal_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t f = begin; f < end; f++)
+		{
+			const XMFLOAT3* p[3] = { &vertices[indices[f * 3]].position, &vertices[indices[f * 3 + 1]].position, &vertices[indices[f * 3 + 2]].position };
+			face_normals[f] = normalize_safe(cross(sub(*p[1], *p[0]), sub(*p[2], *p[0])));
+			for (int k = 0; k < 3; k++)
+			{
+				XMFLOAT3 e1 = normalize_safe(sub(*p[(k + 1) % 3], *p[k]));
+				XMFLOAT3 e2 = normalize_safe(sub(*p[(k + 2) % 3], *p[k]));
+				corner_angles[f * 3 + k] = std::acos(std::max(-1.0f, std::min(1.0f, dot(e1, e2))));
+			}
+		}
+	});
+
+	std::vector<UINT> representative = find_coincident_positions(vertices, vertex_count, thread_count);
+	std::vector<UINT> corner_positions(corner_count);
+	parallel_for_workers(thread_count, corner_count, min_normal_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++) corner_positions[c] = representative[indices[c]];
+	});
+	Buckets positions;
+	positions.build(vertex_count, corner_count, corner_positions.data());
+	corner_positions = std::vector<UINT>();
+
+	// Every corner sums the faces around its position that are within the crease angle of its own face.
+	// Corners of degenerate faces have no face to compare against and take all of them.
+	std::vector<XMFLOAT3> corner_normals(corner_count);
+	parallel_for_workers(thread_count, vertex_count, min_normal_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t position = begin; position < end; position++)
+		{
+			for (UINT i = positions.offsets[position]; i < positions.offsets[position + 1]; i++)
+			{
+				UINT corner = positions.items[i];
+				const XMFLOAT3& face_normal = face_normals[corner / 3];
+				bool degenerate = dot(face_normal, face_normal) == 0.0f;
+				XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+				for (UINT j = positions.offsets[position]; j < positions.offsets[position + 1]; j++)
+				{
+					UINT other = positions.items[j];
+					const XMFLOAT3& other_normal = face_normals[other / 3];
+					if (degenerate || dot(face_normal, other_normal) >= crease_cos)
+					{
+						float angle = corner_angles[other];
+						sum = { sum.x + other_normal.x * angle, sum.y + other_normal.y * angle, sum.z + other_normal.z * angle };
+					}
+				}
+				XMFLOAT3 normal = normalize_safe(sum);
+				corner_normals[corner] = dot(normal, normal) > 0.0f ? normal : face_normal;
+			}
+		}
+	});
+
+	// Distinct normals per vertex, the first one stays on the vertex and every other one gets a copy
+	Buckets vertex_corners;
+	vertex_corners.build(vertex_count, corner_count, indices);
+	auto distinct_normals = [&](UINT v, std::vector<XMFLOAT3>& normals)
+	{
+		normals.clear();
+		for (UINT i = vertex_corners.offsets[v]; i < vertex_corners.offsets[v + 1]; i++)
+		{
+			const XMFLOAT3& normal = corner_normals[vertex_corners.items[i]];
+			if (std::none_of(normals.begin(), normals.end(), [&](const XMFLOAT3& n) { return same_normal(n, normal); }))
+			{
+				normals.push_back(normal);
+			}
+		}
+	};
+	std::vector<UINT> first_split(vertex_count + 1, 0);
+	parallel_for_workers(thread_count, vertex_count, min_normal_items_per_thread, [&](size_t begin, size_t end)
+	{
+		std::vector<XMFLOAT3> normals;
+		for (size_t v = begin; v < end; v++)
+		{
+			distinct_normals(UINT(v), normals);
+			first_split[v + 1] = normals.empty() ? 0 : UINT(normals.size() - 1);
+		}
+	});
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		first_split[v + 1] += first_split[v];
+	}
+	split_vertices.resize(first_split[vertex_count]);
+
+	// Every corner belongs to a single vertex, so the index redirects never race
+	parallel_for_workers(thread_count, vertex_count, min_normal_items_per_thread, [&](size_t begin, size_t end)
+	{
+		std::vector<XMFLOAT3> normals;
+		for (size_t v = begin; v < end; v++)
+		{
+			distinct_normals(UINT(v), normals);
+			if (normals.empty())
+			{
+				continue;
+			}
+			for (size_t k = 1; k < normals.size(); k++)
+			{
+				Vertex& copy = split_vertices[first_split[v] + k - 1];
+				copy = vertices[v];
+				copy.normal = normals[k];
+			}
+			for (UINT i = vertex_corners.offsets[v]; i < vertex_corners.offsets[v + 1]; i++)
+			{
+				UINT corner = vertex_corners.items[i];
+				size_t k = std::find_if(normals.begin(), normals.end(), [&](const XMFLOAT3& n) { return same_normal(n, corner_normals[corner]); }) - normals.begin();
+				if (k > 0)
+				{
+					indices[corner] = vertex_count + first_split[v] + UINT(k) - 1;
+				}
+			}
+			vertices[v].normal = normals[0];
+		}
+	});
+}
+
+UINT generate_normals(MeshData& mesh_data, float crease_angle, const std::vector<bool>& submesh_mask, size_t thread_count)
+{
+	float crease_cos = std::cos(crease_angle * 3.14159265f / 180.0f);
+	std::vector<std::vector<Vertex>> split_vertices(mesh_data.submeshes.size());
+	size_t split_count = 0;
+	for (size_t s = 0; s < mesh_data.submeshes.size(); s++)
+	{
+		if (s >= submesh_mask.size() || !submesh_mask[s])
+		{
+			continue;
+		}
+		const Submesh& submesh = mesh_data.submeshes[s];
+		generate_submesh_normals(mesh_data.vertices.data() + submesh.baseVertex, submesh.vertexCount,
+			mesh_data.indices.data() + submesh.firstIndex, submesh.indexCount, crease_cos, split_vertices[s], thread_count);
+		split_count += split_vertices[s].size();
+	}
+	if (split_count == 0)
+	{
+		return 0;
+	}
+
+	// Split copies go right after the vertices of their submesh, so the submesh ranges stay contiguous
+	std::vector<Vertex> vertices;
+	vertices.reserve(mesh_data.vertices.size() + split_count);
+	for (size_t s = 0; s < mesh_data.submeshes.size(); s++)
+	{
+		Submesh& submesh = mesh_data.submeshes[s];
+		const Vertex* first = mesh_data.vertices.data() + submesh.baseVertex;
+		submesh.baseVertex = UINT(vertices.size());
+		vertices.insert(vertices.end(), first, first + submesh.vertexCount);
+		vertices.insert(vertices.end(), split_vertices[s].begin(), split_vertices[s].end());
+		submesh.vertexCount += UINT(split_vertices[s].size());
+	}
+	mesh_data.vertices.swap(vertices);
+	return UINT(split_count);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include <mesh/MeshData.h>
+
+// Positions closer than this fraction of the submesh bounds diagonal count as the same point
+static const float coincident_position_tolerance = 1e-6f;
+
+// Smooth vertex normals for the submeshes flagged in submesh_mask. Coincident positions are found through a spatial hash
+// grid, so uv seams and unwelded corners don't break the shading. Every corner averages the face normals around its
+// position weighted by the corner angles, leaving out faces bent more than crease_angle degrees away from its own face.
+// A vertex whose corners end up with different normals is split, the copies are appended to its submesh.
+// Triangles, positions and vertices are processed in parallel on at most thread_count threads.
+// Returns the number of vertices added by splits.
+UINT generate_normals(MeshData& mesh_data, float crease_angle, const std::vector<bool>& submesh_mask,
+	size_t thread_count = std::thread::hardware_concurrency());
@@ -0,0 +1,492 @@
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <assimp/fast_atof.h>
+
+#include <MappedFile.h>
+#include <Parallel.h>
+
+// Chunks are small enough to balance the threads and large enough that the boundary search doesn't matter
+static const size_t obj_chunk_size = 1 << 20;
+
+namespace
+{
+	// One v/vt/vn triple, 0 based
+	struct Corner
+	{
+		int32_t position;
+		int32_t uv;
+		int32_t normal;
+	};
+
+	// Line aligned byte range of the file and what it contributes to the global arrays
+	struct ObjChunk
+	{
+		size_t begin;
+		size_t end;
+		size_t positionCount;
+		size_t uvCount;
+		size_t normalCount;
+		size_t triangleCount;
+		// Offsets of the chunk in the global arrays, prefix sums of the counts above
+		size_t firstPosition;
+		size_t firstUv;
+		size_t firstNormal;
+		size_t firstTriangle;
+		// Triangle numbers where an o, g or usemtl line starts a new submesh
+		std::vector<size_t> groupStarts;
+		bool failed;
+	};
+
+	bool is_space(char c) { return c == ' ' || c == '\t'; }
+
+	// Line without its terminator, last_line holds a null terminated copy of an unterminated last line
+	// so the float parser never reads past the mapping
+	struct LineReader
+	{
+		const char* data;
+		size_t position;
+		size_t end;
+		size_t fileSize;
+		std::string lastLine;
+
+		bool next(const char*& line, const char*& line_end)
+		{
+			if (position >= end)
+			{
+				return false;
+			}
+			const char* start = data + position;
+			const char* newline = static_cast<const char*>(std::memchr(start, '\n', end - position));
+			if (newline)
+			{
+				line = start;
+				line_end = newline;
+				position = size_t(newline - data) + 1;
+			}
+			else
+			{
+				lastLine.assign(start, data + end);
+				line = lastLine.c_str();
+				line_end = line + lastLine.size();
+				position = end;
+			}
+			if (line_end > line && line_end[-1] == '\r')
+			{
+				line_end--;
+			}
+			return true;
+		}
+	};
+
+	const char* skip_spaces(const char* c, const char* end)
+	{
+		while (c < end && is_space(*c)) c++;
+		return c;
+	}
+
+	bool is_keyword(const char* c, const char* end, const char* keyword, size_t length)
+	{
+		return size_t(end - c) > length && std::memcmp(c, keyword, length) == 0 && is_space(c[length]);
+	}
+
+	// OBJ indices are 1 based, negative ones count back from the last element defined so far
+	bool parse_index(const char*& c, const char* end, size_t defined, int32_t& out)
+	{
+		bool negative = c < end && *c == '-';
+		if (negative) c++;
+		if (c >= end || *c < '0' || *c > '9')
+		{
+			return false;
+		}
+		int64_t value = 0;
+		while (c < end && *c >= '0' && *c <= '9')
+		{
+			value = value * 10 + (*c++ - '0');
+		}
+		int64_t index = negative ? int64_t(defined) - value : value - 1;
+		if (index < 0 || index >= int64_t(defined))
+		{
+			return false;
+		}
+		out = int32_t(index);
+		return true;
+	}
+
+	const char* parse_floats(const char* c, const char* end, float* out, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			c = skip_spaces(c, end);
+			if (c >= end)
+			{
+				throw std::invalid_argument("Missing OBJ coordinate");
+			}
+			c = Assimp::fast_atoreal_move<float>(c, out[i], false);
+		}
+		return c;
+	}
+}
+
+// First pass, counts what every chunk defines so the second pass can write straight into the global arrays
+static void count_chunk(const char* data, size_t file_size, ObjChunk& chunk)
+{
+	LineReader reader = { data, chunk.begin, chunk.end, file_size };
+	const char* line;
+	const char* line_end;
+	while (reader.next(line, line_end))
+	{
+		const char* c = skip_spaces(line, line_end);
+		if (is_keyword(c, line_end, "v", 1)) chunk.positionCount++;
+		else if (is_keyword(c, line_end, "vt", 2)) chunk.uvCount++;
+		else if (is_keyword(c, line_end, "vn", 2)) chunk.normalCount++;
+		else if (is_keyword(c, line_end, "f", 1))
+		{
+			size_t corners = 0;
+			c += 1;
+			while (true)
+			{
+				c = skip_spaces(c, line_end);
+				if (c >= line_end) break;
+				corners++;
+				while (c < line_end && !is_space(*c)) c++;
+			}
+			chunk.triangleCount += corners >= 3 ? corners - 2 : 0;
+		}
+	}
+}
+
+// Second pass, parses the chunk into its ranges of the global arrays
+static void parse_chunk(const char* data, size_t file_size, ObjChunk& chunk, float* positions, float* uvs, float* normals, Corner* corners)
+{
+	size_t position_count = chunk.firstPosition;
+	size_t uv_count = chunk.firstUv;
+	size_t normal_count = chunk.firstNormal;
+	size_t triangle_count = chunk.firstTriangle;
+	std::vector<Corner> polygon;
+
+	LineReader reader = { data, chunk.begin, chunk.end, file_size };
+	const char* line;
+	const char* line_end;
+	while (reader.next(line, line_end))
+	{
+		const char* c = skip_spaces(line, line_end);
+		if (is_keyword(c, line_end, "v", 1))
+		{
+			parse_floats(c + 1, line_end, positions + position_count * 3, 3);
+			position_count++;
+		}
+		else if (is_keyword(c, line_end, "vt", 2))
+		{
+			parse_floats(c + 2, line_end, uvs + uv_count * 2, 2);
+			uv_count++;
+		}
+		else if (is_keyword(c, line_end, "vn", 2))
+		{
+			parse_floats(c + 2, line_end, normals + normal_count * 3, 3);
+			normal_count++;
+		}
+		else if (is_keyword(c, line_end, "f", 1))
+		{
+			// Every corner needs all three indices, v, v/vt and v//vn faces go to assimp
+			polygon.clear();
+			c += 1;
+			while (true)
+			{
+				c = skip_spaces(c, line_end);
+				if (c >= line_end) break;
+				Corner corner;
+				if (!parse_index(c, line_end, position_count, corner.position) ||
+					c >= line_end || *c++ != '/' ||
+					!parse_index(c, line_end, uv_count, corner.uv) ||
+					c >= line_end || *c++ != '/' ||
+					!parse_index(c, line_end, normal_count, corner.normal))
+				{
+					chunk.failed = true;
+					return;
+				}
+				polygon.push_back(corner);
+			}
+			for (size_t i = 2; i < polygon.size(); i++)
+			{
+				corners[triangle_count * 3 + 0] = polygon[0];
+				corners[triangle_count * 3 + 1] = polygon[i - 1];
+				corners[triangle_count * 3 + 2] = polygon[i];
+				triangle_count++;
+			}
+		}
+		else if (is_keyword(c, line_end, "o", 1) || is_keyword(c, line_end, "g", 1) || is_keyword(c, line_end, "usemtl", 6))
+		{
+			chunk.groupStarts.push_back(triangle_count);
+		}
+	}
+}
+
+static uint64_t hash_corner(const Corner& corner, uint32_t group)
+{
+	uint64_t h = uint64_t(uint32_t(corner.position)) * 0x9E3779B97F4A7C15ull;
+	h ^= (uint64_t(uint32_t(corner.uv)) + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2)) * 0xC2B2AE3D27D4EB4Full;
+	h ^= (uint64_t(uint32_t(corner.normal)) + 0x165667B19E3779F9ull + (h << 6) + (h >> 2)) * 0x9E3779B97F4A7C15ull;
+	h ^= uint64_t(group) * 0xD6E8FEB86659FD93ull;
+	return h ^ (h >> 29);
+}
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool parse_obj(const std::string& filename, MeshData& mesh_data, ObjParseStats& stats, LoadProgress& progress)
+{
+	stats = ObjParseStats();
+	auto start = std::chrono::high_resolution_clock::now();
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+	const char* data = reinterpret_cast<const char*>(file.getData());
+	size_t file_size = file.getSize();
+
+	// Line aligned chunks, each boundary moves past the next newline
+	std::vector<ObjChunk> chunks;
+	size_t chunk_begin = 0;
+	while (chunk_begin < file_size)
+	{
+		size_t chunk_end = std::min(file_size, chunk_begin + obj_chunk_size);
+		const char* newline = static_cast<const char*>(std::memchr(data + chunk_end - 1, '\n', file_size - chunk_end + 1));
+		chunk_end = newline ? size_t(newline - data) + 1 : file_size;
+		ObjChunk chunk = {};
+		chunk.begin = chunk_begin;
+		chunk.end = chunk_end;
+		chunks.push_back(chunk);
+		chunk_begin = chunk_end;
+	}
+
+	parallel_for(chunks.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			count_chunk(data, file_size, chunks[i]);
+		}
+	});
+	size_t position_count = 0, uv_count = 0, normal_count = 0, triangle_count = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		chunk.firstPosition = position_count;
+		chunk.firstUv = uv_count;
+		chunk.firstNormal = normal_count;
+		chunk.firstTriangle = triangle_count;
+		position_count += chunk.positionCount;
+		uv_count += chunk.uvCount;
+		normal_count += chunk.normalCount;
+		triangle_count += chunk.triangleCount;
+	}
+	size_t corner_count = triangle_count * 3;
+	if (triangle_count == 0 || uv_count == 0 || normal_count == 0 || corner_count >= size_t(INT32_MAX))
+	{
+		return false;
+	}
+	progress.setProgress(0.1f);
+
+	std::vector<float> positions(position_count * 3);
+	std::vector<float> uvs(uv_count * 2);
+	std::vector<float> normals(normal_count * 3);
+	std::vector<Corner> corners(corner_count);
+	std::atomic<bool> failed(false);
+	parallel_for(chunks.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end && !failed; i++)
+		{
+			try
+			{
+				parse_chunk(data, file_size, chunks[i], positions.data(), uvs.data(), normals.data(), corners.data());
+			}
+			catch (const std::exception&)
+			{
+				chunks[i].failed = true;
+			}
+			if (chunks[i].failed)
+			{
+				failed = true;
+			}
+		}
+	});
+	file.close();
+	if (failed || progress.isCancelRequested())
+	{
+		return false;
+	}
+
+	// Submesh boundaries in triangles, empty groups dropped
+	std::vector<size_t> group_starts(1, 0);
+	for (const ObjChunk& chunk : chunks)
+	{
+		for (size_t triangle : chunk.groupStarts)
+		{
+			if (triangle > group_starts.back() && triangle < triangle_count)
+			{
+				group_starts.push_back(triangle);
+			}
+		}
+	}
+	group_starts.push_back(triangle_count);
+	size_t group_count = group_starts.size() - 1;
+	std::vector<uint32_t> corner_groups(corner_count);
+	parallel_for(group_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t g = begin; g < end; g++)
+		{
+			std::fill(corner_groups.begin() + group_starts[g] * 3, corner_groups.begin() + group_starts[g + 1] * 3, uint32_t(g));
+		}
+	});
+	stats.parseMs = elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+	progress.setProgress(0.5f);
+
+	// Weld identical triples inside a group. Slots hold corner + 1 and only ever decrease once set, so whatever the
+	// thread interleaving every slot ends up with the lowest corner of its triple and the result is deterministic.
+	size_t table_size = 1;
+	while (table_size < corner_count * 2) table_size <<= 1;
+	std::vector<std::atomic<uint32_t>> table(table_size);
+	parallel_for(table_size, 1 << 16, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) table[i].store(0, std::memory_order_relaxed);
+	});
+	auto same_key = [&](uint32_t a, uint32_t b)
+	{
+		return corners[a].position == corners[b].position && corners[a].uv == corners[b].uv &&
+			corners[a].normal == corners[b].normal && corner_groups[a] == corner_groups[b];
+	};
+	parallel_for(corner_count, 1 << 14, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+		{
+			uint32_t corner = uint32_t(c);
+			size_t slot = size_t(hash_corner(corners[c], corner_groups[c])) & (table_size - 1);
+			while (true)
+			{
+				uint32_t current = table[slot].load(std::memory_order_relaxed);
+				if (current == 0)
+				{
+					if (table[slot].compare_exchange_weak(current, corner + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+					continue;
+				}
+				if (same_key(current - 1, corner))
+				{
+					while (corner + 1 < current && !table[slot].compare_exchange_weak(current, corner + 1, std::memory_order_relaxed))
+					{
+					}
+					break;
+				}
+				slot = (slot + 1) & (table_size - 1);
+			}
+		}
+	});
+
+	// Representative of every corner, vertices are numbered in order of their first corner
+	std::vector<uint32_t> representative(corner_count);
+	const size_t ranges = std::max<size_t>(1, std::min<size_t>(256, corner_count / (1 << 14)));
+	std::vector<uint32_t> range_vertices(ranges + 1, 0);
+	parallel_for(ranges, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t r = begin; r < end; r++)
+		{
+			size_t first = corner_count * r / ranges, last = corner_count * (r + 1) / ranges;
+			uint32_t unique = 0;
+			for (size_t c = first; c < last; c++)
+			{
+				size_t slot = size_t(hash_corner(corners[c], corner_groups[c])) & (table_size - 1);
+				while (!same_key(table[slot].load(std::memory_order_relaxed) - 1, uint32_t(c)))
+				{
+					slot = (slot + 1) & (table_size - 1);
+				}
+				representative[c] = table[slot].load(std::memory_order_relaxed) - 1;
+				unique += representative[c] == c ? 1 : 0;
+			}
+			range_vertices[r + 1] = unique;
+		}
+	});
+	table = std::vector<std::atomic<uint32_t>>();
+	for (size_t r = 0; r < ranges; r++)
+	{
+		range_vertices[r + 1] += range_vertices[r];
+	}
+	size_t vertex_count = range_vertices[ranges];
+
+	// Vertex numbers of first corners, then every corner takes the number of its representative which always comes earlier
+	std::vector<uint32_t> vertex_ids(corner_count);
+	std::vector<uint32_t> first_corners(vertex_count);
+	parallel_for(ranges, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t r = begin; r < end; r++)
+		{
+			size_t first = corner_count * r / ranges, last = corner_count * (r + 1) / ranges;
+			uint32_t next = range_vertices[r];
+			for (size_t c = first; c < last; c++)
+			{
+				if (representative[c] == c)
+				{
+					first_corners[next] = uint32_t(c);
+					vertex_ids[c] = next++;
+				}
+			}
+		}
+	});
+	stats.weldMs = elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+	progress.setProgress(0.8f);
+
+	mesh_data.vertices.resize(vertex_count);
+	mesh_data.indices.resize(corner_count);
+	parallel_for(vertex_count, 1 << 14, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			const Corner& corner = corners[first_corners[v]];
+			Vertex vert = {};
+			vert.position = { positions[corner.position * 3], positions[corner.position * 3 + 1], positions[corner.position * 3 + 2] };
+			vert.normal = { normals[corner.normal * 3], normals[corner.normal * 3 + 1], normals[corner.normal * 3 + 2] };
+			vert.uvs = { uvs[corner.uv * 2], uvs[corner.uv * 2 + 1] };
+			mesh_data.vertices[v] = vert;
+		}
+	});
+
+	// Groups are contiguous in corner order so their vertices are contiguous as well, indices become group local
+	mesh_data.submeshes.resize(group_count);
+	for (size_t g = 0; g < group_count; g++)
+	{
+		size_t first_corner = group_starts[g] * 3;
+		size_t end_corner = group_starts[g + 1] * 3;
+		Submesh& submesh = mesh_data.submeshes[g];
+		submesh.baseVertex = vertex_ids[first_corner];
+		submesh.firstIndex = UINT(first_corner);
+		submesh.indexCount = UINT(end_corner - first_corner);
+		submesh.vertexCount = (g + 1 < group_count ? vertex_ids[end_corner] : UINT(vertex_count)) - submesh.baseVertex;
+	}
+	parallel_for(group_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t g = begin; g < end; g++)
+		{
+			Submesh& submesh = mesh_data.submeshes[g];
+			for (UINT i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++)
+			{
+				mesh_data.indices[i] = vertex_ids[representative[i]] - submesh.baseVertex;
+			}
+		}
+	});
+	stats.vertexMs = elapsed_ms(start);
+	progress.setProgress(1.0f);
+	return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+#include <mesh/LoadProgress.h>
+#include <mesh/MeshData.h>
+
+// Throughput the native parser should sustain on multi-hundred-MB files, parse and vertex build included.
+// The mesh info window compares every OBJ load against it, and against assimp when the parser is turned off.
+static const double obj_target_mb_per_second = 400.0;
+
+// Timings of the native OBJ import in milliseconds
+struct ObjParseStats
+{
+	double parseMs;
+	double weldMs;
+	double vertexMs;
+};
+
+// Reads a Wavefront OBJ straight into the arenas, without going through assimp. The mapped file is split into
+// line aligned chunks that are parsed in parallel, faces are fan triangulated and every distinct
+// position/uv/normal triple becomes one vertex through a lock-free hash table. Submeshes start at every
+// o, g and usemtl line like the assimp importer does. Tangents are left to generate_tangents.
+// Returns false if the file can't be read, is malformed or lacks normals or uvs on any corner;
+// the caller then falls back to assimp which can generate them.
+bool parse_obj(const std::string& filename, MeshData& mesh_data, ObjParseStats& stats, LoadProgress& progress);
@@ -0,0 +1,138 @@
+#include "OverdrawAnalyzer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include <Parallel.h>
+
+namespace
+{
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	Float3 sub(Float3 a, Float3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	float dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	Float3 cross(Float3 a, Float3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	Float3 normalize(Float3 a)
+	{
+		float length = std::sqrt(dot(a, a));
+		return { a.x / length, a.y / length, a.z / length };
+	}
+}
+
+// Draws one view and returns the shaded and covered pixel counts
+static void rasterize_view(const MeshData& mesh_data, Float3 center, float radius, Float3 back, UINT resolution, std::vector<float>& depth, size_t& shaded, size_t& covered)
+{
+	// Orthographic camera looking at the center along -back, right, up and back form a right handed basis
+	Float3 up_reference = std::fabs(back.y) > 0.99f ? Float3{ 1.0f, 0.0f, 0.0f } : Float3{ 0.0f, 1.0f, 0.0f };
+	Float3 right = normalize(cross(up_reference, back));
+	Float3 up = cross(back, right);
+	float scale = resolution * 0.5f / radius;
+
+	std::fill(depth.begin(), depth.end(), FLT_MAX);
+	shaded = 0;
+
+	std::vector<Float3> projected(mesh_data.vertices.size());
+	for (size_t v = 0; v < projected.size(); v++)
+	{
+		const DirectX::XMFLOAT3& p = mesh_data.vertices[v].position;
+		Float3 d = sub({ p.x, p.y, p.z }, center);
+		projected[v] = { dot(d, right) * scale + resolution * 0.5f, dot(d, up) * scale + resolution * 0.5f, -dot(d, back) };
+	}
+
+	for (const Submesh& submesh : mesh_data.submeshes)
+	{
+		const UINT* indices = mesh_data.indices.data() + submesh.firstIndex;
+		for (UINT i = 0; i + 2 < submesh.indexCount; i += 3)
+		{
+			Float3 a = projected[submesh.baseVertex + indices[i + 0]];
+			Float3 b = projected[submesh.baseVertex + indices[i + 1]];
+			Float3 c = projected[submesh.baseVertex + indices[i + 2]];
+
+			// Counter clockwise triangles are front facing, same as the rasterizer state in Graphics
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (area <= 0.0f)
+			{
+				continue;
+			}
+
+			int min_x = std::max(0, int(std::ceil(std::min({ a.x, b.x, c.x }) - 0.5f)));
+			int max_x = std::min(int(resolution) - 1, int(std::floor(std::max({ a.x, b.x, c.x }) - 0.5f)));
+			int min_y = std::max(0, int(std::ceil(std::min({ a.y, b.y, c.y }) - 0.5f)));
+			int max_y = std::min(int(resolution) - 1, int(std::floor(std::max({ a.y, b.y, c.y }) - 0.5f)));
+			float inverse_area = 1.0f / area;
+			for (int y = min_y; y <= max_y; y++)
+			{
+				float py = y + 0.5f;
+				for (int x = min_x; x <= max_x; x++)
+				{
+					float px = x + 0.5f;
+					float w0 = (c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x);
+					float w1 = (a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x);
+					float w2 = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+					{
+						continue;
+					}
+					float z = (w0 * a.z + w1 * b.z + w2 * c.z) * inverse_area;
+					float& stored = depth[size_t(y) * resolution + x];
+					if (z < stored)
+					{
+						stored = z;
+						shaded++;
+					}
+				}
+			}
+		}
+	}
+
+	covered = 0;
+	for (float z : depth)
+	{
+		if (z != FLT_MAX) covered++;
+	}
+}
+
+OverdrawStats measure_overdraw(const MeshData& mesh_data, UINT view_count, UINT resolution)
+{
+	OverdrawStats stats = {};
+	if (mesh_data.vertices.empty() || view_count == 0)
+	{
+		return stats;
+	}
+
+	Float3 bounds_min = { mesh_data.boundsMin.x, mesh_data.boundsMin.y, mesh_data.boundsMin.z };
+	Float3 bounds_max = { mesh_data.boundsMax.x, mesh_data.boundsMax.y, mesh_data.boundsMax.z };
+	Float3 center = { (bounds_min.x + bounds_max.x) * 0.5f, (bounds_min.y + bounds_max.y) * 0.5f, (bounds_min.z + bounds_max.z) * 0.5f };
+	Float3 half_size = sub(bounds_max, center);
+	float radius = std::max(std::sqrt(dot(half_size, half_size)), 1e-6f);
+
+	std::vector<size_t> shaded(view_count);
+	std::vector<size_t> covered(view_count);
+	parallel_for(view_count, 1, [&](size_t begin, size_t end)
+	{
+		std::vector<float> depth(size_t(resolution) * resolution);
+		for (size_t view = begin; view < end; view++)
+		{
+			// Fibonacci sphere, evenly spread directions
+			float y = 1.0f - 2.0f * (view + 0.5f) / view_count;
+			float ring = std::sqrt(std::max(0.0f, 1.0f - y * y));
+			float angle = view * 2.399963f;
+			Float3 back = { std::cos(angle) * ring, y, std::sin(angle) * ring };
+			rasterize_view(mesh_data, center, radius, back, resolution, depth, shaded[view], covered[view]);
+		}
+	});
+
+	for (UINT view = 0; view < view_count; view++)
+	{
+		stats.shadedPixels += float(shaded[view]);
+		stats.coveredPixels += float(covered[view]);
+	}
+	stats.shadedPixels /= view_count;
+	stats.coveredPixels /= view_count;
+	return stats;
+}
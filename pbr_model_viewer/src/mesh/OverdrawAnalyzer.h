@@ -0,0 +1,18 @@
+#pragma once
+
+#include <mesh/MeshData.h>
+
+// Average over all sampled views of a CPU depth-only rasterization in submission order
+struct OverdrawStats
+{
+	// Pixels that passed the depth test, so would have run the pixel shader
+	float shadedPixels;
+	// Pixels covered by the mesh once all triangles are drawn
+	float coveredPixels;
+
+	float getOverdraw() const { return coveredPixels > 0.0f ? shadedPixels / coveredPixels : 0.0f; }
+};
+
+// Rasterizes the mesh, back faces culled like the viewer does, from view_count directions spread evenly
+// over the sphere around the mesh, which is how the orbit camera sees it
+OverdrawStats measure_overdraw(const MeshData& mesh_data, UINT view_count = 16, UINT resolution = 256);
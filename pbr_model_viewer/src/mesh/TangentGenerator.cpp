@@ -0,0 +1,453 @@
+#include "TangentGenerator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <Parallel.h>
+
+// Below this many triangles or vertices spawning threads costs more than the work itself
+static const size_t min_tangent_items_per_thread = 16384;
+
+static const UINT no_index = UINT(-1);
+
+namespace
+{
+	using DirectX::XMFLOAT3;
+
+	XMFLOAT3 add(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	XMFLOAT3 sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	XMFLOAT3 scale(const XMFLOAT3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	float dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	XMFLOAT3 normalize_safe(const XMFLOAT3& a)
+	{
+		float length = std::sqrt(dot(a, a));
+		return length > FLT_MIN ? scale(a, 1.0f / length) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+
+	// Component of a in the plane perpendicular to the unit vector n
+	XMFLOAT3 project(const XMFLOAT3& a, const XMFLOAT3& n) { return sub(a, scale(n, dot(n, a))); }
+
+	bool same_position(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+	// MikkTSpace welds corners whose position, normal and uv compare equal
+	bool same_attributes(const Vertex& a, const Vertex& b)
+	{
+		return same_position(a.position, b.position) && same_position(a.normal, b.normal) && a.uvs.x == b.uvs.x && a.uvs.y == b.uvs.y;
+	}
+
+	size_t hash_attributes(const Vertex& vertex)
+	{
+		const float values[8] = { vertex.position.x, vertex.position.y, vertex.position.z,
+			vertex.normal.x, vertex.normal.y, vertex.normal.z, vertex.uvs.x, vertex.uvs.y };
+		uint64_t h = 0;
+		for (float value : values)
+		{
+			// -0 and 0 compare equal, so they hash the same
+			value = value == 0.0f ? 0.0f : value;
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			h = (h ^ bits) * 0x9E3779B185EBCA87ull;
+		}
+		return size_t(h ^ (h >> 31));
+	}
+
+	// Items 0..item_count grouped by their key, in ascending order inside every group
+	struct Buckets
+	{
+		std::vector<UINT> offsets;
+		std::vector<UINT> items;
+
+		void build(UINT key_count, UINT item_count, const UINT* keys)
+		{
+			offsets.assign(key_count + 1, 0);
+			for (UINT i = 0; i < item_count; i++) offsets[keys[i] + 1]++;
+			for (UINT k = 0; k < key_count; k++) offsets[k + 1] += offsets[k];
+			items.resize(item_count);
+			std::vector<UINT> next(offsets.begin(), offsets.end() - 1);
+			for (UINT i = 0; i < item_count; i++) items[next[keys[i]]++] = i;
+		}
+	};
+
+	// Uv gradient of a triangle as mikktspace.c evaluates it. Degenerate triangles have two corners at the same position
+	// and take their frames from other triangles. Triangles without a usable gradient (valid false) still join a fan
+	// but don't contribute to it.
+	struct FaceTangent
+	{
+		XMFLOAT3 tangent;
+		bool positive;
+		bool valid;
+		bool degenerate;
+	};
+
+	// Unit tangent for an accumulated direction, any vector perpendicular to the normal if nothing was accumulated
+	XMFLOAT3 finish_tangent(const XMFLOAT3& sum, const XMFLOAT3& normal)
+	{
+		XMFLOAT3 tangent = normalize_safe(project(sum, normal));
+		if (dot(tangent, tangent) > 0.0f)
+		{
+			return tangent;
+		}
+		XMFLOAT3 axis = std::fabs(normal.x) < 0.9f ? XMFLOAT3(1.0f, 0.0f, 0.0f) : XMFLOAT3(0.0f, 1.0f, 0.0f);
+		tangent = normalize_safe(project(axis, normal));
+		return dot(tangent, tangent) > 0.0f ? tangent : XMFLOAT3(1.0f, 0.0f, 0.0f);
+	}
+
+	void write_frame(Vertex& vertex, const XMFLOAT3& tangent, bool positive)
+	{
+		vertex.tangent = tangent;
+		vertex.bitangent = scale(cross(normalize_safe(vertex.normal), tangent), positive ? 1.0f : -1.0f);
+	}
+}
+
+// Representative of every vertex, the lowest vertex with exactly the same position, normal and uv
+static std::vector<UINT> find_identical_vertices(const Vertex* vertices, UINT vertex_count)
+{
+	size_t table_size = 1;
+	while (table_size < size_t(vertex_count) * 2) table_size <<= 1;
+	std::vector<UINT> buckets(vertex_count);
+	parallel_for(vertex_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			buckets[v] = UINT(hash_attributes(vertices[v]) & (table_size - 1));
+		}
+	});
+	Buckets table;
+	table.build(UINT(table_size), vertex_count, buckets.data());
+
+	std::vector<UINT> representative(vertex_count);
+	parallel_for(vertex_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			UINT bucket = buckets[v];
+			UINT lowest = UINT(v);
+			for (UINT i = table.offsets[bucket]; i < table.offsets[bucket + 1] && table.items[i] < lowest; i++)
+			{
+				if (same_attributes(vertices[table.items[i]], vertices[v]))
+				{
+					lowest = table.items[i];
+				}
+			}
+			representative[v] = lowest;
+		}
+	});
+	return representative;
+}
+
+// Tangents of one submesh. Corners are grouped into smoothing fans like mikktspace.c does: triangles around a welded
+// vertex that are connected through shared edges and have the same uv orientation. Every fan gets the angle weighted
+// average of the gradients of its triangles. Corners of a vertex in a different fan than its first corner get their
+// index redirected to a copy of the vertex appended to split_vertices, numbered from vertex_count on.
+static void generate_submesh_tangents(Vertex* vertices, UINT vertex_count, UINT* indices, UINT index_count, std::vector<Vertex>& split_vertices)
+{
+	UINT triangle_count = index_count / 3;
+	UINT corner_count = triangle_count * 3;
+	std::vector<UINT> weld = find_identical_vertices(vertices, vertex_count);
+	auto welded = [&](UINT corner) { return weld[indices[corner]]; };
+
+	std::vector<FaceTangent> faces(triangle_count);
+	parallel_for(triangle_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t f = begin; f < end; f++)
+		{
+			const Vertex& v0 = vertices[indices[f * 3 + 0]];
+			const Vertex& v1 = vertices[indices[f * 3 + 1]];
+			const Vertex& v2 = vertices[indices[f * 3 + 2]];
+			FaceTangent& face = faces[f];
+			face.degenerate = same_position(v0.position, v1.position) || same_position(v0.position, v2.position) || same_position(v1.position, v2.position);
+
+			// Position derivatives along u and v scaled by the signed uv area, the sign tells mirrored triangles apart
+			XMFLOAT3 d1 = sub(v1.position, v0.position);
+			XMFLOAT3 d2 = sub(v2.position, v0.position);
+			float t21x = v1.uvs.x - v0.uvs.x, t21y = v1.uvs.y - v0.uvs.y;
+			float t31x = v2.uvs.x - v0.uvs.x, t31y = v2.uvs.y - v0.uvs.y;
+			float signed_area = t21x * t31y - t21y * t31x;
+			XMFLOAT3 os = sub(scale(d1, t31y), scale(d2, t21y));
+			XMFLOAT3 ot = sub(scale(d2, t21x), scale(d1, t31x));
+			float os_length = std::sqrt(dot(os, os));
+			float ot_length = std::sqrt(dot(ot, ot));
+			float area = std::fabs(signed_area);
+			face.positive = signed_area > 0.0f;
+			face.valid = area > FLT_MIN && os_length / area > FLT_MIN && ot_length / area > FLT_MIN;
+			face.tangent = os_length > FLT_MIN ? scale(os, (face.positive ? 1.0f : -1.0f) / os_length) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+		}
+	});
+
+	// Edges of the triangles that aren't degenerate, grouped by their lower welded vertex. Degenerate ones go to an extra key.
+	std::vector<UINT> edge_keys(corner_count);
+	for (UINT corner = 0; corner < corner_count; corner++)
+	{
+		UINT next = corner - corner % 3 + (corner + 1) % 3;
+		edge_keys[corner] = faces[corner / 3].degenerate ? vertex_count : std::min(welded(corner), welded(next));
+	}
+	Buckets edges;
+	edges.build(vertex_count + 1, corner_count, edge_keys.data());
+	edge_keys = std::vector<UINT>();
+
+	// Neighbour across every edge. Like mikktspace.c, edges are visited sorted by their welded vertices and triangle,
+	// and each pairs with the first later edge running the other way whose own neighbour is still unknown.
+	// Every edge is in a single bucket, so the buckets pair in parallel.
+	std::vector<UINT> neighbors(corner_count, no_index);
+	parallel_for(vertex_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		std::vector<UINT> sorted;
+		for (size_t key = begin; key < end; key++)
+		{
+			sorted.assign(edges.items.begin() + edges.offsets[key], edges.items.begin() + edges.offsets[key + 1]);
+			auto far_end = [&](UINT corner) { return std::max(welded(corner), welded(corner - corner % 3 + (corner + 1) % 3)); };
+			std::sort(sorted.begin(), sorted.end(), [&](UINT a, UINT b) { return far_end(a) != far_end(b) ? far_end(a) < far_end(b) : a < b; });
+			for (size_t i = 0; i < sorted.size(); i++)
+			{
+				UINT a = sorted[i];
+				if (neighbors[a] != no_index)
+				{
+					continue;
+				}
+				UINT a_start = welded(a), a_end = welded(a - a % 3 + (a + 1) % 3);
+				for (size_t j = i + 1; j < sorted.size() && far_end(sorted[j]) == far_end(a); j++)
+				{
+					UINT b = sorted[j];
+					if (neighbors[b] == no_index && welded(b) == a_end && welded(b - b % 3 + (b + 1) % 3) == a_start)
+					{
+						neighbors[a] = b / 3;
+						neighbors[b] = a / 3;
+						break;
+					}
+				}
+			}
+		}
+	});
+
+	// Fans in the order mikktspace.c builds them, its depth first walk is reproduced with an explicit stack. A triangle
+	// without a usable gradient takes the orientation of the first fan reaching it, so this pass stays sequential.
+	std::vector<UINT> corner_group(corner_count, no_index);
+	std::vector<UINT> group_offsets(1, 0);
+	std::vector<UINT> group_corners;
+	std::vector<bool> group_positive;
+	std::vector<bool> positive(triangle_count);
+	for (UINT f = 0; f < triangle_count; f++)
+	{
+		positive[f] = faces[f].positive;
+	}
+	std::vector<UINT> stack;
+	for (UINT f = 0; f < triangle_count; f++)
+	{
+		if (faces[f].degenerate || !faces[f].valid)
+		{
+			continue;
+		}
+		for (UINT i = 0; i < 3; i++)
+		{
+			if (corner_group[f * 3 + i] != no_index)
+			{
+				continue;
+			}
+			UINT group = UINT(group_positive.size());
+			UINT vertex = welded(f * 3 + i);
+			bool group_is_positive = positive[f];
+			group_positive.push_back(group_is_positive);
+			corner_group[f * 3 + i] = group;
+			group_corners.push_back(f * 3 + i);
+
+			// Neighbours across the two edges at the corner, the one leaving it is visited first
+			auto push_neighbors = [&](UINT corner)
+			{
+				UINT first = corner - corner % 3;
+				if (neighbors[first + (corner + 2) % 3] != no_index) stack.push_back(neighbors[first + (corner + 2) % 3]);
+				if (neighbors[corner] != no_index) stack.push_back(neighbors[corner]);
+			};
+			push_neighbors(f * 3 + i);
+			while (!stack.empty())
+			{
+				UINT t = stack.back();
+				stack.pop_back();
+				UINT corner = t * 3;
+				while (welded(corner) != vertex) corner++;
+				if (corner_group[corner] != no_index)
+				{
+					continue;
+				}
+				if (!faces[t].valid && corner_group[t * 3] == no_index && corner_group[t * 3 + 1] == no_index && corner_group[t * 3 + 2] == no_index)
+				{
+					positive[t] = group_is_positive;
+				}
+				if (positive[t] != group_is_positive)
+				{
+					continue;
+				}
+				corner_group[corner] = group;
+				group_corners.push_back(corner);
+				push_neighbors(corner);
+			}
+			group_offsets.push_back(UINT(group_corners.size()));
+		}
+	}
+
+	// Sum of the fan's gradients projected on the normal and weighted by the corner angle in the tangent plane
+	UINT group_count = UINT(group_positive.size());
+	std::vector<XMFLOAT3> group_tangents(group_count);
+	parallel_for(group_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t g = begin; g < end; g++)
+		{
+			XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+			XMFLOAT3 normal = normalize_safe(vertices[indices[group_corners[group_offsets[g]]]].normal);
+			for (UINT c = group_offsets[g]; c < group_offsets[g + 1]; c++)
+			{
+				UINT corner = group_corners[c];
+				const FaceTangent& face = faces[corner / 3];
+				if (!face.valid)
+				{
+					continue;
+				}
+				UINT first = corner - corner % 3;
+				const XMFLOAT3& position = vertices[indices[corner]].position;
+				const XMFLOAT3& next_position = vertices[indices[first + (corner + 1) % 3]].position;
+				const XMFLOAT3& previous_position = vertices[indices[first + (corner + 2) % 3]].position;
+				XMFLOAT3 e1 = normalize_safe(project(sub(next_position, position), normal));
+				XMFLOAT3 e2 = normalize_safe(project(sub(previous_position, position), normal));
+				float angle = std::acos(std::max(-1.0f, std::min(1.0f, dot(e1, e2))));
+				sum = add(sum, scale(normalize_safe(project(face.tangent, normal)), angle));
+			}
+			group_tangents[g] = finish_tangent(sum, normal);
+		}
+	});
+
+	// Corners of degenerate triangles take the fan of the first other corner of the same welded vertex
+	Buckets welded_corners;
+	{
+		std::vector<UINT> keys(corner_count);
+		for (UINT corner = 0; corner < corner_count; corner++) keys[corner] = welded(corner);
+		welded_corners.build(vertex_count, corner_count, keys.data());
+	}
+	std::vector<UINT> corner_frames(corner_group);
+	parallel_for(corner_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t corner = begin; corner < end; corner++)
+		{
+			if (!faces[corner / 3].degenerate)
+			{
+				continue;
+			}
+			UINT vertex = welded(UINT(corner));
+			for (UINT i = welded_corners.offsets[vertex]; i < welded_corners.offsets[vertex + 1]; i++)
+			{
+				UINT other = welded_corners.items[i];
+				if (!faces[other / 3].degenerate)
+				{
+					corner_frames[corner] = corner_group[other];
+					break;
+				}
+			}
+		}
+	});
+	welded_corners = Buckets();
+
+	// Corners of every vertex in ascending order, the first fan keeps the vertex and every other fan gets a copy
+	Buckets corners;
+	corners.build(vertex_count, corner_count, indices);
+	auto same_frame = [&](UINT a, UINT b)
+	{
+		if (a == b) return true;
+		if (a == no_index || b == no_index) return false;
+		return same_position(group_tangents[a], group_tangents[b]) && group_positive[a] == group_positive[b];
+	};
+	// Frame of every corner of v numbered in order of first appearance, returns the number of distinct frames
+	auto number_frames = [&](UINT v, std::vector<UINT>& first_corners, std::vector<UINT>& slots)
+	{
+		first_corners.clear();
+		slots.clear();
+		for (UINT c = corners.offsets[v]; c < corners.offsets[v + 1]; c++)
+		{
+			UINT frame = corner_frames[corners.items[c]];
+			UINT slot = 0;
+			while (slot < first_corners.size() && !same_frame(corner_frames[first_corners[slot]], frame)) slot++;
+			if (slot == first_corners.size()) first_corners.push_back(corners.items[c]);
+			slots.push_back(slot);
+		}
+		return UINT(first_corners.size());
+	};
+
+	std::vector<UINT> split_offsets(vertex_count + 1, 0);
+	parallel_for(vertex_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		std::vector<UINT> first_corners, slots;
+		for (size_t v = begin; v < end; v++)
+		{
+			UINT frame_count = number_frames(UINT(v), first_corners, slots);
+			split_offsets[v + 1] = frame_count > 1 ? frame_count - 1 : 0;
+		}
+	});
+	for (UINT v = 0; v < vertex_count; v++)
+	{
+		split_offsets[v + 1] += split_offsets[v];
+	}
+	split_vertices.resize(split_offsets[vertex_count]);
+
+	// Every corner belongs to a single vertex, so the index redirects never race
+	parallel_for(vertex_count, min_tangent_items_per_thread, [&](size_t begin, size_t end)
+	{
+		std::vector<UINT> first_corners, slots;
+		for (size_t v = begin; v < end; v++)
+		{
+			UINT frame_count = number_frames(UINT(v), first_corners, slots);
+			XMFLOAT3 normal = normalize_safe(vertices[v].normal);
+			for (UINT slot = 0; slot < frame_count; slot++)
+			{
+				Vertex& target = slot == 0 ? vertices[v] : split_vertices[split_offsets[v] + slot - 1];
+				if (slot != 0) target = vertices[v];
+				// Corners outside any fan get a frame perpendicular to the normal, mirrored like mikktspace.c's default
+				UINT group = corner_frames[first_corners[slot]];
+				write_frame(target, group != no_index ? group_tangents[group] : finish_tangent(XMFLOAT3(0.0f, 0.0f, 0.0f), normal),
+					group != no_index && group_positive[group]);
+			}
+			for (UINT c = corners.offsets[v]; c < corners.offsets[v + 1]; c++)
+			{
+				UINT slot = slots[c - corners.offsets[v]];
+				if (slot != 0)
+				{
+					indices[corners.items[c]] = vertex_count + split_offsets[v] + slot - 1;
+				}
+			}
+		}
+	});
+}
+
+UINT generate_tangents(MeshData& mesh_data)
+{
+	std::vector<std::vector<Vertex>> split_vertices(mesh_data.submeshes.size());
+	size_t split_count = 0;
+	for (size_t s = 0; s < mesh_data.submeshes.size(); s++)
+	{
+		const Submesh& submesh = mesh_data.submeshes[s];
+		generate_submesh_tangents(mesh_data.vertices.data() + submesh.baseVertex, submesh.vertexCount,
+			mesh_data.indices.data() + submesh.firstIndex, submesh.indexCount, split_vertices[s]);
+		split_count += split_vertices[s].size();
+	}
+	if (split_count == 0)
+	{
+		return 0;
+	}
+
+	// Split copies go right after the vertices of their submesh, so the submesh ranges stay contiguous
+	std::vector<Vertex> vertices;
+	vertices.reserve(mesh_data.vertices.size() + split_count);
+	for (size_t s = 0; s < mesh_data.submeshes.size(); s++)
+	{
+		Submesh& submesh = mesh_data.submeshes[s];
+		const Vertex* first = mesh_data.vertices.data() + submesh.baseVertex;
+		submesh.baseVertex = UINT(vertices.size());
+		vertices.insert(vertices.end(), first, first + submesh.vertexCount);
+		vertices.insert(vertices.end(), split_vertices[s].begin(), split_vertices[s].end());
+		submesh.vertexCount += UINT(split_vertices[s].size());
+	}
+	mesh_data.vertices.swap(vertices);
+	return UINT(split_count);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <mesh/MeshData.h>
+
+// Per vertex tangent frames matching MikkTSpace (Mikkelsen 2008), which Substance, Blender and xNormal bake normal maps
+// with. Like mikktspace.c, corners with equal position, normal and uv are welded, and the corners of every welded vertex
+// are grouped into smoothing fans: triangles connected through edges around the vertex with the same uv orientation.
+// Every fan gets the angle weighted average of the uv gradients of its triangles, projected on the normal, and corners
+// of degenerate triangles take the fan of another corner of their vertex. A vertex whose corners end up in fans with
+// different frames is split so every fan keeps its own. The frames only differ from mikktspace.c's where it has no
+// gradient to follow: fans whose gradients cancel out and corners outside any fan get a tangent perpendicular to the
+// normal instead of the x axis, and fans aren't split further by exactly opposite gradients.
+// tangent is unit length and orthogonal to the normal, bitangent is cross(normal, tangent) times the handedness sign,
+// which is all the shaders read from it.
+// Triangles, edges, fans and vertices are processed in parallel, split vertices are appended to their submesh.
+// Returns the number of vertices added by splits.
+UINT generate_tangents(MeshData& mesh_data);
@@ -0,0 +1,144 @@
+#include "VertexCompression.h"
+
+#include <DirectXPackedVector.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <Parallel.h>
+
+static const size_t min_vertices_per_thread = 16384;
+
+static int16_t to_snorm16(float value)
+{
+	value = std::min(1.0f, std::max(-1.0f, value));
+	return int16_t(std::lround(value * 32767.0f));
+}
+
+static float from_snorm16(int16_t value)
+{
+	return std::max(-1.0f, value / 32767.0f);
+}
+
+// Octahedral mapping of a unit vector to [-1, 1]^2
+static void encode_octahedral(DirectX::XMFLOAT3 v, int16_t out[2])
+{
+	float l1 = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+	if (l1 <= 0.0f)
+	{
+		out[0] = 0;
+		out[1] = 0;
+		return;
+	}
+	float x = v.x / l1;
+	float y = v.y / l1;
+	if (v.z < 0.0f)
+	{
+		float folded_x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float folded_y = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = folded_x;
+		y = folded_y;
+	}
+	out[0] = to_snorm16(x);
+	out[1] = to_snorm16(y);
+}
+
+static DirectX::XMFLOAT3 decode_octahedral(const int16_t in[2])
+{
+	float x = from_snorm16(in[0]);
+	float y = from_snorm16(in[1]);
+	float z = 1.0f - std::fabs(x) - std::fabs(y);
+	float t = std::max(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+	float length = std::sqrt(x * x + y * y + z * z);
+	return { x / length, y / length, z / length };
+}
+
+static DirectX::XMFLOAT3 normalized(DirectX::XMFLOAT3 v)
+{
+	float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	if (length <= 0.0f) return { 0.0f, 0.0f, 0.0f };
+	return { v.x / length, v.y / length, v.z / length };
+}
+
+static float angle_degrees(DirectX::XMFLOAT3 a, DirectX::XMFLOAT3 b)
+{
+	float cosine = a.x * b.x + a.y * b.y + a.z * b.z;
+	return std::acos(std::min(1.0f, std::max(-1.0f, cosine))) * 180.0f / DirectX::XM_PI;
+}
+
+MeshDequantization make_dequantization(const DirectX::XMFLOAT3& bounds_min, const DirectX::XMFLOAT3& bounds_max)
+{
+	// Keep the extent above zero so flat meshes still divide safely
+	MeshDequantization dequantization;
+	dequantization.boundsCenter = { (bounds_min.x + bounds_max.x) * 0.5f, (bounds_min.y + bounds_max.y) * 0.5f, (bounds_min.z + bounds_max.z) * 0.5f, 0.0f };
+	dequantization.boundsExtent = {
+		std::max((bounds_max.x - bounds_min.x) * 0.5f, 1e-6f),
+		std::max((bounds_max.y - bounds_min.y) * 0.5f, 1e-6f),
+		std::max((bounds_max.z - bounds_min.z) * 0.5f, 1e-6f),
+		0.0f };
+	return dequantization;
+}
+
+void compress_vertices(const Vertex* vertices, UINT count, const MeshDequantization& dequantization, CompactVertex* out)
+{
+	const DirectX::XMFLOAT4 center = dequantization.boundsCenter;
+	const DirectX::XMFLOAT4 extent = dequantization.boundsExtent;
+	parallel_for(count, min_vertices_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const Vertex& vert = vertices[i];
+			CompactVertex& compact = out[i];
+
+			// Handedness of the tangent frame, the shader rebuilds the bitangent as cross(normal, tangent) * sign
+			const DirectX::XMFLOAT3& n = vert.normal;
+			const DirectX::XMFLOAT3& t = vert.tangent;
+			const DirectX::XMFLOAT3& b = vert.bitangent;
+			float handedness = (n.y * t.z - n.z * t.y) * b.x + (n.z * t.x - n.x * t.z) * b.y + (n.x * t.y - n.y * t.x) * b.z;
+
+			compact.position[0] = to_snorm16((vert.position.x - center.x) / extent.x);
+			compact.position[1] = to_snorm16((vert.position.y - center.y) / extent.y);
+			compact.position[2] = to_snorm16((vert.position.z - center.z) / extent.z);
+			compact.position[3] = handedness < 0.0f ? -32767 : 32767;
+			encode_octahedral(normalized(vert.normal), compact.normal);
+			encode_octahedral(normalized(vert.tangent), compact.tangent);
+			compact.uvs[0] = DirectX::PackedVector::XMConvertFloatToHalf(vert.uvs.x);
+			compact.uvs[1] = DirectX::PackedVector::XMConvertFloatToHalf(vert.uvs.y);
+		}
+	});
+}
+
+VertexCompressionStats measure_compression_error(const Vertex* vertices, const CompactVertex* compressed, UINT count, const MeshDequantization& dequantization)
+{
+	VertexCompressionStats stats = {};
+	const DirectX::XMFLOAT4 center = dequantization.boundsCenter;
+	const DirectX::XMFLOAT4 extent = dequantization.boundsExtent;
+	for (UINT i = 0; i < count; i++)
+	{
+		const Vertex& vert = vertices[i];
+		const CompactVertex& compact = compressed[i];
+
+		float dx = center.x + from_snorm16(compact.position[0]) * extent.x - vert.position.x;
+		float dy = center.y + from_snorm16(compact.position[1]) * extent.y - vert.position.y;
+		float dz = center.z + from_snorm16(compact.position[2]) * extent.z - vert.position.z;
+		stats.maxPositionError = std::max(stats.maxPositionError, std::sqrt(dx * dx + dy * dy + dz * dz));
+
+		DirectX::XMFLOAT3 normal = normalized(vert.normal);
+		DirectX::XMFLOAT3 tangent = normalized(vert.tangent);
+		if (normal.x != 0.0f || normal.y != 0.0f || normal.z != 0.0f)
+		{
+			stats.maxNormalError = std::max(stats.maxNormalError, angle_degrees(normal, decode_octahedral(compact.normal)));
+		}
+		if (tangent.x != 0.0f || tangent.y != 0.0f || tangent.z != 0.0f)
+		{
+			stats.maxTangentError = std::max(stats.maxTangentError, angle_degrees(tangent, decode_octahedral(compact.tangent)));
+		}
+
+		float du = DirectX::PackedVector::XMConvertHalfToFloat(compact.uvs[0]) - vert.uvs.x;
+		float dv = DirectX::PackedVector::XMConvertHalfToFloat(compact.uvs[1]) - vert.uvs.y;
+		stats.maxUvError = std::max(stats.maxUvError, std::max(std::fabs(du), std::fabs(dv)));
+	}
+	return stats;
+}
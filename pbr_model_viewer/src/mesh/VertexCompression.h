@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Vertex.h>
+#include <mesh/MeshData.h>
+
+// Largest round trip error of a compression, positions in object space units and directions in degrees
+struct VertexCompressionStats
+{
+	float maxPositionError;
+	float maxNormalError;
+	float maxTangentError;
+	float maxUvError;
+};
+
+MeshDequantization make_dequantization(const DirectX::XMFLOAT3& bounds_min, const DirectX::XMFLOAT3& bounds_max);
+
+// Encodes the vertices in parallel, out must hold count elements
+void compress_vertices(const Vertex* vertices, UINT count, const MeshDequantization& dequantization, CompactVertex* out);
+
+// Decodes the compressed vertices the same way mesh_compact_vs.hlsl does and compares them against the originals
+VertexCompressionStats measure_compression_error(const Vertex* vertices, const CompactVertex* compressed, UINT count, const MeshDequantization& dequantization);
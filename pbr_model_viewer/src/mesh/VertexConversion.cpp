@@ -0,0 +1,171 @@
+#include "VertexConversion.h"
+
+#include <cstdint>
+
+#include <emmintrin.h>
+
+#include <Parallel.h>
+
+static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "SSE conversion expects single precision assimp vectors");
+static_assert(sizeof(Vertex) == 18 * sizeof(float), "SSE conversion expects the 72 byte Vertex layout");
+
+// Below this many vertices spawning threads costs more than the conversion itself
+static const size_t min_vertices_per_thread = 16384;
+
+void convert_vertices_scalar(const aiMesh* mesh, Vertex* out, unsigned int begin, unsigned int end)
+{
+	for (unsigned int i = begin; i < end; i++)
+	{
+		Vertex vert = {};
+		vert.position.x = mesh->mVertices[i].x;
+		vert.position.y = mesh->mVertices[i].y;
+		vert.position.z = mesh->mVertices[i].z;
+
+		if (mesh->HasNormals())
+		{
+			vert.normal.x = mesh->mNormals[i].x;
+			vert.normal.y = mesh->mNormals[i].y;
+			vert.normal.z = mesh->mNormals[i].z;
+		}
+
+		if (mesh->HasTextureCoords(0))
+		{
+			vert.uvs.x = mesh->mTextureCoords[0][i].x;
+			vert.uvs.y = mesh->mTextureCoords[0][i].y;
+		}
+
+		if (mesh->HasTangentsAndBitangents())
+		{
+			vert.tangent.x = mesh->mTangents[i].x;
+			vert.tangent.y = mesh->mTangents[i].y;
+			vert.tangent.z = mesh->mTangents[i].z;
+
+			vert.bitangent.x = mesh->mBitangents[i].x;
+			vert.bitangent.y = mesh->mBitangents[i].y;
+			vert.bitangent.z = mesh->mBitangents[i].z;
+		}
+
+		out[i] = vert;
+	}
+}
+
+// Packs [begin, end) four vertices at a time, begin and end multiples of 4. The 12 floats of each attribute of a group
+// are read with 3 loads and transposed by shuffles into the 18 vectors of the 4 output vertices, 288 bytes written in
+// order, so a group never reads or writes past its own vertices. With out 16 byte aligned the group goes through
+// streaming stores, which skip reading the destination into the cache first.
+// Vertex float layout: position 0-2, color 3-6, normal 7-9, uvs 10-11, tangent 12-14, bitangent 15-17.
+// Meshes imported without tangents get a zero tangent frame, filled in later by generate_tangents.
+template<bool has_tangents, bool aligned>
+static void convert_vertices_sse(const aiMesh* mesh, Vertex* out, unsigned int begin, unsigned int end)
+{
+	const float* positions = &mesh->mVertices[0].x;
+	const float* normals = &mesh->mNormals[0].x;
+	const float* uvs = &mesh->mTextureCoords[0][0].x;
+	const float* tangents = has_tangents ? &mesh->mTangents[0].x : nullptr;
+	const float* bitangents = has_tangents ? &mesh->mBitangents[0].x : nullptr;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 mask_x = _mm_castsi128_ps(_mm_setr_epi32(-1, 0, 0, 0));
+	const __m128 mask_xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	const __m128 mask_yzw = _mm_castsi128_ps(_mm_setr_epi32(0, -1, -1, -1));
+	const __m128 mask_w = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+	for (unsigned int i = begin; i < end; i += 4)
+	{
+		// Attribute k of vertex v is float 3 * v + k of the group, spread over 3 vectors
+		const float* p = positions + i * 3;
+		const float* n = normals + i * 3;
+		const float* u = uvs + i * 3;
+		__m128 p0 = _mm_loadu_ps(p), p1 = _mm_loadu_ps(p + 4), p2 = _mm_loadu_ps(p + 8);
+		__m128 n0 = _mm_loadu_ps(n), n1 = _mm_loadu_ps(n + 4), n2 = _mm_loadu_ps(n + 8);
+		__m128 u0 = _mm_loadu_ps(u), u1 = _mm_loadu_ps(u + 4), u2 = _mm_loadu_ps(u + 8);
+		__m128 t0 = zero, t1 = zero, t2 = zero;
+		__m128 b0 = zero, b1 = zero, b2 = zero;
+		if (has_tangents)
+		{
+			const float* t = tangents + i * 3;
+			const float* b = bitangents + i * 3;
+			t0 = _mm_loadu_ps(t), t1 = _mm_loadu_ps(t + 4), t2 = _mm_loadu_ps(t + 8);
+			b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4), b2 = _mm_loadu_ps(b + 8);
+		}
+
+		__m128 o[18];
+		// Vertex 0, floats 0-17
+		o[0] = _mm_and_ps(p0, mask_xyz);
+		o[1] = _mm_and_ps(_mm_shuffle_ps(n0, n0, _MM_SHUFFLE(0, 0, 0, 0)), mask_w);
+		o[2] = _mm_shuffle_ps(n0, u0, _MM_SHUFFLE(1, 0, 2, 1));
+		o[3] = _mm_shuffle_ps(t0, _mm_shuffle_ps(t0, b0, _MM_SHUFFLE(0, 0, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+		// Vertex 1, floats 18-35
+		o[4] = _mm_shuffle_ps(b0, _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 3, 3)), _MM_SHUFFLE(2, 0, 2, 1));
+		o[5] = _mm_and_ps(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(1, 1, 1, 1)), mask_x);
+		o[6] = _mm_and_ps(_mm_shuffle_ps(n0, n1, _MM_SHUFFLE(1, 0, 3, 3)), mask_yzw);
+		o[7] = _mm_shuffle_ps(_mm_shuffle_ps(u0, u1, _MM_SHUFFLE(0, 0, 3, 3)), _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(0, 0, 3, 3)),
+							  _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 b1_xyz = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(1, 0, 3, 3));
+		o[8] = _mm_shuffle_ps(_mm_shuffle_ps(t1, b1_xyz, _MM_SHUFFLE(0, 0, 1, 1)), b1_xyz, _MM_SHUFFLE(3, 2, 2, 0));
+		// Vertex 2, floats 36-53
+		o[9] = _mm_and_ps(_mm_shuffle_ps(p1, p2, _MM_SHUFFLE(0, 0, 3, 2)), mask_xyz);
+		o[10] = _mm_and_ps(_mm_shuffle_ps(n1, n1, _MM_SHUFFLE(2, 2, 2, 2)), mask_w);
+		o[11] = _mm_shuffle_ps(_mm_shuffle_ps(n1, n2, _MM_SHUFFLE(0, 0, 3, 3)), u1, _MM_SHUFFLE(3, 2, 2, 0));
+		o[12] = _mm_shuffle_ps(t1, _mm_shuffle_ps(t2, b1, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 0, 3, 2));
+		// Vertex 3, floats 54-71
+		o[13] = _mm_shuffle_ps(_mm_shuffle_ps(b1, b2, _MM_SHUFFLE(0, 0, 3, 3)), p2, _MM_SHUFFLE(2, 1, 2, 0));
+		o[14] = _mm_and_ps(_mm_shuffle_ps(p2, p2, _MM_SHUFFLE(3, 3, 3, 3)), mask_x);
+		o[15] = _mm_and_ps(n2, mask_yzw);
+		o[16] = _mm_shuffle_ps(u2, t2, _MM_SHUFFLE(2, 1, 2, 1));
+		o[17] = _mm_shuffle_ps(_mm_shuffle_ps(t2, b2, _MM_SHUFFLE(1, 1, 3, 3)), b2, _MM_SHUFFLE(3, 2, 2, 0));
+
+		float* dst = reinterpret_cast<float*>(out + i);
+		for (int j = 0; j < 18; j++)
+		{
+			if (aligned) _mm_stream_ps(dst + j * 4, o[j]);
+			else _mm_storeu_ps(dst + j * 4, o[j]);
+		}
+	}
+	if (aligned) _mm_sfence();
+}
+
+void convert_vertices(const aiMesh* mesh, Vertex* out)
+{
+	unsigned int count = mesh->mNumVertices;
+	bool packable = mesh->HasNormals() && mesh->HasTextureCoords(0);
+	bool has_tangents = mesh->HasTangentsAndBitangents();
+	bool aligned = (reinterpret_cast<uintptr_t>(out) & 15) == 0;
+	parallel_for(count, min_vertices_per_thread, [=](size_t begin, size_t end)
+	{
+		// Whole groups of 4 in the middle, the vertices around them one at a time
+		UINT range_begin = (UINT)begin;
+		UINT range_end = (UINT)end;
+		UINT group_begin = packable ? std::min((range_begin + 3) & ~3u, range_end) : range_end;
+		UINT group_end = packable ? std::max(range_end & ~3u, group_begin) : range_end;
+		convert_vertices_scalar(mesh, out, range_begin, group_begin);
+		if (group_end > group_begin)
+		{
+			if (has_tangents && aligned) convert_vertices_sse<true, true>(mesh, out, group_begin, group_end);
+			else if (has_tangents) convert_vertices_sse<true, false>(mesh, out, group_begin, group_end);
+			else if (aligned) convert_vertices_sse<false, true>(mesh, out, group_begin, group_end);
+			else convert_vertices_sse<false, false>(mesh, out, group_begin, group_end);
+		}
+		convert_vertices_scalar(mesh, out, group_end, range_end);
+	});
+}
+
+void transform_vertices(Vertex* vertices, unsigned int count, const aiMatrix4x4& transform)
+{
+	aiMatrix3x3 direction_transform(transform);
+	aiMatrix3x3 normal_transform = aiMatrix3x3(direction_transform).Inverse().Transpose();
+	parallel_for(count, min_vertices_per_thread, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			Vertex& vert = vertices[i];
+			aiVector3D position = transform * aiVector3D(vert.position.x, vert.position.y, vert.position.z);
+			aiVector3D normal = (normal_transform * aiVector3D(vert.normal.x, vert.normal.y, vert.normal.z)).NormalizeSafe();
+			aiVector3D tangent = (direction_transform * aiVector3D(vert.tangent.x, vert.tangent.y, vert.tangent.z)).NormalizeSafe();
+			aiVector3D bitangent = (direction_transform * aiVector3D(vert.bitangent.x, vert.bitangent.y, vert.bitangent.z)).NormalizeSafe();
+			vert.position = { position.x, position.y, position.z };
+			vert.normal = { normal.x, normal.y, normal.z };
+			vert.tangent = { tangent.x, tangent.y, tangent.z };
+			vert.bitangent = { bitangent.x, bitangent.y, bitangent.z };
+		}
+	});
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <assimp/mesh.h>
+
+#include <Vertex.h>
+
+// Reference conversion, copies every attribute one element at a time
+void convert_vertices_scalar(const aiMesh* mesh, Vertex* out, unsigned int begin, unsigned int end);
+
+// Same result as convert_vertices_scalar for the whole mesh, but the vertex range is split across
+// cores and groups of 4 vertices are transposed from the assimp attribute streams with SSE shuffles
+void convert_vertices(const aiMesh* mesh, Vertex* out);
+
+// Bakes a node transform into already converted vertices
+void transform_vertices(Vertex* vertices, unsigned int count, const aiMatrix4x4& transform);
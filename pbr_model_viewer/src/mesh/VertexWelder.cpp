@@ -0,0 +1,232 @@
+#include "VertexWelder.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <Hash.h>
+#include <Parallel.h>
+
+static_assert(sizeof(Vertex) % sizeof(uint32_t) == 0, "Welding compares vertices one 32 bit word at a time");
+static const size_t vertex_words = sizeof(Vertex) / sizeof(uint32_t);
+
+// Shards are picked by the top bits of the hash, the table slot inside a shard by the low bits
+static const size_t weld_shard_bits = 8;
+static const size_t weld_shard_count = size_t(1) << weld_shard_bits;
+// Fixed block size for the counting sort, so the order of the vertices inside a shard doesn't depend on the thread count
+static const size_t weld_block_size = 1 << 14;
+
+namespace
+{
+	// What two vertices are compared by: the Vertex words or their quantized copy, plus the submesh they belong to
+	struct WeldKeys
+	{
+		const uint32_t* words;
+		const UINT* submeshIds;
+
+		const uint32_t* get(size_t v) const { return words + v * vertex_words; }
+		bool equal(size_t a, size_t b) const
+		{
+			return submeshIds[a] == submeshIds[b] && std::memcmp(get(a), get(b), sizeof(Vertex)) == 0;
+		}
+	};
+
+	uint32_t quantize(float value, double inverse_epsilon)
+	{
+		double q = std::floor(double(value) * inverse_epsilon + 0.5);
+		if (!(q == q)) return 0;
+		q = std::max<double>(INT32_MIN, std::min<double>(INT32_MAX, q));
+		return uint32_t(int32_t(q));
+	}
+}
+
+UINT weld_vertices(MeshData& mesh_data, float epsilon, size_t thread_count)
+{
+	size_t vertex_count = mesh_data.vertices.size();
+	if (vertex_count == 0)
+	{
+		return 0;
+	}
+	size_t block_count = (vertex_count + weld_block_size - 1) / weld_block_size;
+
+	// Submesh of every vertex, indices are submesh local so vertices never merge across submeshes
+	std::vector<UINT> submesh_ids(vertex_count, 0);
+	for (size_t s = 0; s < mesh_data.submeshes.size(); s++)
+	{
+		const Submesh& submesh = mesh_data.submeshes[s];
+		std::fill(submesh_ids.begin() + submesh.baseVertex, submesh_ids.begin() + submesh.baseVertex + submesh.vertexCount, UINT(s));
+	}
+
+	WeldKeys keys = { reinterpret_cast<const uint32_t*>(mesh_data.vertices.data()), submesh_ids.data() };
+	std::vector<uint32_t> quantized;
+	if (epsilon > 0.0f)
+	{
+		quantized.resize(vertex_count * vertex_words);
+		const float* components = reinterpret_cast<const float*>(mesh_data.vertices.data());
+		double inverse_epsilon = 1.0 / double(epsilon);
+		parallel_for_workers(thread_count, quantized.size(), weld_block_size * vertex_words, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				quantized[i] = quantize(components[i], inverse_epsilon);
+			}
+		});
+		keys.words = quantized.data();
+	}
+
+	std::vector<uint64_t> hashes(vertex_count);
+	parallel_for_workers(thread_count, vertex_count, weld_block_size, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			hashes[v] = hash_bytes(keys.get(v), sizeof(Vertex), submesh_ids[v]);
+		}
+	});
+	auto shard_of = [&](size_t v) { return size_t(hashes[v] >> (64 - weld_shard_bits)); };
+
+	// Counting sort of the vertices by shard. offsets[block * shard_count + shard] is where the block writes its first vertex of the shard.
+	std::vector<UINT> offsets(block_count * weld_shard_count, 0);
+	parallel_for_workers(thread_count, block_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t b = begin; b < end; b++)
+		{
+			UINT* counts = offsets.data() + b * weld_shard_count;
+			for (size_t v = b * weld_block_size; v < std::min(vertex_count, (b + 1) * weld_block_size); v++)
+			{
+				counts[shard_of(v)]++;
+			}
+		}
+	});
+	std::vector<UINT> shard_begin(weld_shard_count + 1);
+	UINT total = 0;
+	for (size_t shard = 0; shard < weld_shard_count; shard++)
+	{
+		shard_begin[shard] = total;
+		for (size_t b = 0; b < block_count; b++)
+		{
+			UINT count = offsets[b * weld_shard_count + shard];
+			offsets[b * weld_shard_count + shard] = total;
+			total += count;
+		}
+	}
+	shard_begin[weld_shard_count] = total;
+	std::vector<UINT> sorted(vertex_count);
+	parallel_for_workers(thread_count, block_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t b = begin; b < end; b++)
+		{
+			UINT* next = offsets.data() + b * weld_shard_count;
+			for (size_t v = b * weld_block_size; v < std::min(vertex_count, (b + 1) * weld_block_size); v++)
+			{
+				sorted[next[shard_of(v)]++] = UINT(v);
+			}
+		}
+	});
+
+	// Every shard welds on its own. Its vertices are inserted in ascending order, so each one maps to the first
+	// occurrence of its key whatever thread handles the shard.
+	std::vector<UINT> representative(vertex_count);
+	parallel_for_workers(thread_count, weld_shard_count, 1, [&](size_t begin, size_t end)
+	{
+		std::vector<UINT> table;
+		for (size_t shard = begin; shard < end; shard++)
+		{
+			size_t first = shard_begin[shard], last = shard_begin[shard + 1];
+			if (first == last)
+			{
+				continue;
+			}
+			size_t table_size = 1;
+			while (table_size < (last - first) * 2) table_size <<= 1;
+			table.assign(table_size, UINT_MAX);
+			for (size_t i = first; i < last; i++)
+			{
+				UINT v = sorted[i];
+				size_t slot = size_t(hashes[v]) & (table_size - 1);
+				while (true)
+				{
+					UINT current = table[slot];
+					if (current == UINT_MAX)
+					{
+						table[slot] = v;
+						representative[v] = v;
+						break;
+					}
+					if (hashes[current] == hashes[v] && keys.equal(current, v))
+					{
+						representative[v] = current;
+						break;
+					}
+					slot = (slot + 1) & (table_size - 1);
+				}
+			}
+		}
+	});
+	quantized = std::vector<uint32_t>();
+	hashes = std::vector<uint64_t>();
+	sorted = std::vector<UINT>();
+
+	// Exclusive prefix count of the surviving vertices, which is also the new index of every survivor
+	std::vector<UINT> block_survivors(block_count + 1, 0);
+	parallel_for_workers(thread_count, block_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t b = begin; b < end; b++)
+		{
+			UINT survivors = 0;
+			for (size_t v = b * weld_block_size; v < std::min(vertex_count, (b + 1) * weld_block_size); v++)
+			{
+				survivors += representative[v] == v ? 1 : 0;
+			}
+			block_survivors[b + 1] = survivors;
+		}
+	});
+	for (size_t b = 0; b < block_count; b++)
+	{
+		block_survivors[b + 1] += block_survivors[b];
+	}
+	UINT survivor_count = block_survivors[block_count];
+	if (survivor_count == vertex_count)
+	{
+		return 0;
+	}
+	std::vector<UINT> new_index(vertex_count + 1);
+	new_index[vertex_count] = survivor_count;
+	std::vector<Vertex> vertices(survivor_count);
+	parallel_for_workers(thread_count, block_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t b = begin; b < end; b++)
+		{
+			UINT next = block_survivors[b];
+			for (size_t v = b * weld_block_size; v < std::min(vertex_count, (b + 1) * weld_block_size); v++)
+			{
+				new_index[v] = next;
+				if (representative[v] == v)
+				{
+					vertices[next++] = mesh_data.vertices[v];
+				}
+			}
+		}
+	});
+
+	// Submesh ranges shrink in place and their indices follow the survivors
+	parallel_for_workers(thread_count, mesh_data.submeshes.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t s = begin; s < end; s++)
+		{
+			Submesh& submesh = mesh_data.submeshes[s];
+			UINT old_base = submesh.baseVertex;
+			UINT new_base = new_index[old_base];
+			for (UINT i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++)
+			{
+				UINT& index = mesh_data.indices[i];
+				index = new_index[representative[old_base + index]] - new_base;
+			}
+			submesh.vertexCount = new_index[old_base + submesh.vertexCount] - new_base;
+			submesh.baseVertex = new_base;
+		}
+	});
+	mesh_data.vertices.swap(vertices);
+	return UINT(vertex_count - survivor_count);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <thread>
+
+#include <mesh/MeshData.h>
+
+// Merges the identical vertices of every submesh and compacts the vertex arena, keeping the first occurrence of each
+// vertex and the relative order of the survivors. Vertices are compared by the bit pattern of the whole Vertex, or with
+// a positive epsilon by every component rounded to a grid of that size. Values closer than epsilon that straddle a grid
+// line stay apart, which only costs a duplicate vertex.
+// The work is sharded by hash prefix across at most thread_count threads, the result doesn't depend on the thread count.
+// Returns the number of vertices removed.
+UINT weld_vertices(MeshData& mesh_data, float epsilon, size_t thread_count = std::thread::hardware_concurrency());
@@ -0,0 +1,805 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <emmintrin.h>
+
+#include <Parallel.h>
+
+// Rows of blocks per job, a row of a 4K texture is 1024 blocks
+static const size_t min_block_rows_per_thread = 4;
+// Rounds of least squares endpoint refinement after the principal axis fit
+static const UINT endpoint_refinements = 2;
+
+// Interpolation weights of the 4 bit BC7 indices, out of 64
+static const int bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Pixels of a block channel major, so the SSE kernels work on four pixels at once
+struct alignas(16) BlockPixels
+{
+	float channels[4][16];
+};
+
+// Colors a block can pick from, at most the 16 of BC7
+struct BlockPalette
+{
+	float colors[16][4];
+	UINT count;
+};
+
+// Little endian bit stream of a 128 bit BC7 block
+class BlockBits
+{
+public:
+	explicit BlockBits(unsigned char* block) : m_block(block), m_position(0) { memset(block, 0, 16); }
+
+	void write(UINT value, UINT bits)
+	{
+		for (UINT bit = 0; bit < bits; bit++, m_position++)
+		{
+			m_block[m_position / 8] |= (unsigned char)((value >> bit) & 1) << (m_position % 8);
+		}
+	}
+
+private:
+	unsigned char* m_block;
+	UINT m_position;
+};
+
+class BlockBitReader
+{
+public:
+	explicit BlockBitReader(const unsigned char* block) : m_block(block), m_position(0) {}
+
+	UINT read(UINT bits)
+	{
+		UINT value = 0;
+		for (UINT bit = 0; bit < bits; bit++, m_position++)
+		{
+			value |= UINT((m_block[m_position / 8] >> (m_position % 8)) & 1) << bit;
+		}
+		return value;
+	}
+
+private:
+	const unsigned char* m_block;
+	UINT m_position;
+};
+
+static void load_block(const unsigned char* pixels, BlockPixels& block)
+{
+	for (UINT i = 0; i < 16; i++)
+	{
+		for (UINT channel = 0; channel < 4; channel++)
+		{
+			block.channels[channel][i] = float(pixels[i * 4 + channel]);
+		}
+	}
+}
+
+// Picks the closest palette color of every pixel over the given channels, palette colors hold them in the same order.
+// Returns the summed squared error.
+static float select_indices(const BlockPixels& block, const UINT* channels, UINT channel_count, const BlockPalette& palette, UINT* indices)
+{
+	float error = 0.0f;
+	for (UINT group = 0; group < 16; group += 4)
+	{
+		__m128 best_distance = _mm_set1_ps(FLT_MAX);
+		__m128i best_index = _mm_setzero_si128();
+		for (UINT entry = 0; entry < palette.count; entry++)
+		{
+			__m128 distance = _mm_setzero_ps();
+			for (UINT channel = 0; channel < channel_count; channel++)
+			{
+				__m128 delta = _mm_sub_ps(_mm_load_ps(block.channels[channels[channel]] + group), _mm_set1_ps(palette.colors[entry][channel]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(delta, delta));
+			}
+			__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best_distance));
+			best_distance = _mm_min_ps(distance, best_distance);
+			best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(int(entry))), _mm_andnot_si128(closer, best_index));
+		}
+
+		alignas(16) int group_indices[4];
+		alignas(16) float group_distances[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(group_indices), best_index);
+		_mm_store_ps(group_distances, best_distance);
+		for (UINT i = 0; i < 4; i++)
+		{
+			indices[group + i] = UINT(group_indices[i]);
+			error += group_distances[i];
+		}
+	}
+	return error;
+}
+
+// Endpoints through the block mean along the principal axis of its colors, spanning the projected extremes
+static void fit_principal_axis(const BlockPixels& block, const UINT* channels, UINT channel_count, float* e0, float* e1)
+{
+	float mean[4] = {};
+	float minimum[4], maximum[4];
+	for (UINT c = 0; c < channel_count; c++)
+	{
+		const float* values = block.channels[channels[c]];
+		minimum[c] = maximum[c] = values[0];
+		for (UINT i = 0; i < 16; i++)
+		{
+			mean[c] += values[i];
+			minimum[c] = std::min(minimum[c], values[i]);
+			maximum[c] = std::max(maximum[c], values[i]);
+		}
+		mean[c] /= 16.0f;
+	}
+
+	float covariance[4][4] = {};
+	for (UINT i = 0; i < 16; i++)
+	{
+		for (UINT a = 0; a < channel_count; a++)
+		{
+			float da = block.channels[channels[a]][i] - mean[a];
+			for (UINT b = 0; b < channel_count; b++)
+			{
+				covariance[a][b] += da * (block.channels[channels[b]][i] - mean[b]);
+			}
+		}
+	}
+
+	// Power iteration from the bounding box diagonal
+	float axis[4] = {};
+	for (UINT c = 0; c < channel_count; c++)
+	{
+		axis[c] = maximum[c] - minimum[c];
+	}
+	for (UINT iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = {};
+		float largest = 0.0f;
+		for (UINT a = 0; a < channel_count; a++)
+		{
+			for (UINT b = 0; b < channel_count; b++)
+			{
+				next[a] += covariance[a][b] * axis[b];
+			}
+			largest = std::max(largest, fabsf(next[a]));
+		}
+		if (largest <= 0.0f)
+		{
+			break;
+		}
+		for (UINT c = 0; c < channel_count; c++)
+		{
+			axis[c] = next[c] / largest;
+		}
+	}
+
+	float length = 0.0f;
+	for (UINT c = 0; c < channel_count; c++)
+	{
+		length += axis[c] * axis[c];
+	}
+	if (length <= FLT_EPSILON)
+	{
+		for (UINT c = 0; c < channel_count; c++)
+		{
+			e0[c] = e1[c] = mean[c];
+		}
+		return;
+	}
+	length = sqrtf(length);
+
+	float low = FLT_MAX, high = -FLT_MAX;
+	for (UINT i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (UINT c = 0; c < channel_count; c++)
+		{
+			t += (block.channels[channels[c]][i] - mean[c]) * axis[c] / length;
+		}
+		low = std::min(low, t);
+		high = std::max(high, t);
+	}
+	for (UINT c = 0; c < channel_count; c++)
+	{
+		e0[c] = mean[c] + axis[c] / length * high;
+		e1[c] = mean[c] + axis[c] / length * low;
+	}
+}
+
+// Endpoints that minimize the squared error for the chosen indices, weights[index] is how far an index lies towards e1.
+// Returns false if the indices don't constrain both endpoints.
+static bool refine_endpoints(const BlockPixels& block, const UINT* channels, UINT channel_count, const UINT* indices, const float* weights,
+							 float* e0, float* e1)
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (UINT i = 0; i < 16; i++)
+	{
+		float b = weights[indices[i]];
+		float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (UINT c = 0; c < channel_count; c++)
+		{
+			ax[c] += a * block.channels[channels[c]][i];
+			bx[c] += b * block.channels[channels[c]][i];
+		}
+	}
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+	{
+		return false;
+	}
+	for (UINT c = 0; c < channel_count; c++)
+	{
+		e0[c] = std::min(255.0f, std::max(0.0f, (bb * ax[c] - ab * bx[c]) / determinant));
+		e1[c] = std::min(255.0f, std::max(0.0f, (aa * bx[c] - ab * ax[c]) / determinant));
+	}
+	return true;
+}
+
+static UINT quantize(float value, UINT max_value)
+{
+	float scaled = value * float(max_value) / 255.0f + 0.5f;
+	return UINT(std::min(float(max_value), std::max(0.0f, scaled)));
+}
+
+static UINT pack_565(const float* color)
+{
+	return (quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31);
+}
+
+static void unpack_565(UINT packed, float* color)
+{
+	UINT r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	color[0] = float((r << 3) | (r >> 2));
+	color[1] = float((g << 2) | (g >> 4));
+	color[2] = float((b << 3) | (b >> 2));
+}
+
+static void write_indices(const UINT* indices, UINT bits, unsigned char* out, UINT bytes)
+{
+	uint64_t packed = 0;
+	for (UINT i = 0; i < 16; i++)
+	{
+		packed |= uint64_t(indices[i]) << (i * bits);
+	}
+	memcpy(out, &packed, bytes);
+}
+
+static void encode_bc1_color(const BlockPixels& block, unsigned char* out)
+{
+	static const UINT channels[3] = { 0, 1, 2 };
+	static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	float e0[4], e1[4];
+	fit_principal_axis(block, channels, 3, e0, e1);
+
+	float best_error = FLT_MAX;
+	UINT best_c0 = 0, best_c1 = 0, best_indices[16] = {};
+	for (UINT iteration = 0; iteration <= endpoint_refinements; iteration++)
+	{
+		// Four color mode needs c0 > c1, equal endpoints make every index decode to c0 in either mode
+		UINT c0 = pack_565(e0), c1 = pack_565(e1);
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+		}
+
+		BlockPalette palette;
+		unpack_565(c0, palette.colors[0]);
+		unpack_565(c1, palette.colors[1]);
+		palette.count = c0 == c1 ? 1 : 4;
+		for (UINT c = 0; c < 3; c++)
+		{
+			palette.colors[2][c] = (2.0f * palette.colors[0][c] + palette.colors[1][c]) / 3.0f;
+			palette.colors[3][c] = (palette.colors[0][c] + 2.0f * palette.colors[1][c]) / 3.0f;
+		}
+
+		UINT indices[16];
+		float error = select_indices(block, channels, 3, palette, indices);
+		if (error < best_error)
+		{
+			best_error = error;
+			best_c0 = c0;
+			best_c1 = c1;
+			memcpy(best_indices, indices, sizeof(indices));
+		}
+		if (c0 == c1 || !refine_endpoints(block, channels, 3, indices, weights, e0, e1))
+		{
+			break;
+		}
+	}
+
+	out[0] = (unsigned char)(best_c0 & 0xFF);
+	out[1] = (unsigned char)(best_c0 >> 8);
+	out[2] = (unsigned char)(best_c1 & 0xFF);
+	out[3] = (unsigned char)(best_c1 >> 8);
+	write_indices(best_indices, 2, out + 4, 4);
+}
+
+static void encode_bc4_channel(const BlockPixels& block, UINT channel, unsigned char* out)
+{
+	static const float weights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+	float e0[4] = { block.channels[channel][0] }, e1[4] = { block.channels[channel][0] };
+	for (UINT i = 1; i < 16; i++)
+	{
+		e0[0] = std::max(e0[0], block.channels[channel][i]);
+		e1[0] = std::min(e1[0], block.channels[channel][i]);
+	}
+
+	float best_error = FLT_MAX;
+	UINT best_a0 = 0, best_a1 = 0, best_indices[16] = {};
+	for (UINT iteration = 0; iteration <= endpoint_refinements; iteration++)
+	{
+		// Eight value mode needs a0 > a1
+		UINT a0 = quantize(e0[0], 255), a1 = quantize(e1[0], 255);
+		if (a0 < a1)
+		{
+			std::swap(a0, a1);
+		}
+
+		BlockPalette palette;
+		palette.count = a0 == a1 ? 1 : 8;
+		palette.colors[0][0] = float(a0);
+		palette.colors[1][0] = float(a1);
+		for (UINT i = 2; i < 8; i++)
+		{
+			palette.colors[i][0] = (float(8 - i) * a0 + float(i - 1) * a1) / 7.0f;
+		}
+
+		UINT indices[16];
+		float error = select_indices(block, &channel, 1, palette, indices);
+		if (error < best_error)
+		{
+			best_error = error;
+			best_a0 = a0;
+			best_a1 = a1;
+			memcpy(best_indices, indices, sizeof(indices));
+		}
+		if (a0 == a1 || !refine_endpoints(block, &channel, 1, indices, weights, e0, e1))
+		{
+			break;
+		}
+	}
+
+	out[0] = (unsigned char)(best_a0);
+	out[1] = (unsigned char)(best_a1);
+	write_indices(best_indices, 3, out + 2, 6);
+}
+
+// Mode 6 endpoint, 7 bits per channel plus a p-bit shared by the four channels as their lowest bit
+static void quantize_bc7_endpoint(const float* endpoint, UINT* quantized, UINT& p_bit)
+{
+	float best_error = FLT_MAX;
+	for (UINT p = 0; p < 2; p++)
+	{
+		UINT candidate[4];
+		float error = 0.0f;
+		for (UINT c = 0; c < 4; c++)
+		{
+			float value = (endpoint[c] - float(p)) / 2.0f + 0.5f;
+			candidate[c] = UINT(std::min(127.0f, std::max(0.0f, value)));
+			float delta = float(candidate[c] * 2 + p) - endpoint[c];
+			error += delta * delta;
+		}
+		if (error < best_error)
+		{
+			best_error = error;
+			memcpy(quantized, candidate, sizeof(candidate));
+			p_bit = p;
+		}
+	}
+}
+
+static void encode_bc7_mode6(const BlockPixels& block, unsigned char* out)
+{
+	static const UINT channels[4] = { 0, 1, 2, 3 };
+	float weights[16];
+	for (UINT i = 0; i < 16; i++)
+	{
+		weights[i] = float(bc7_weights[i]) / 64.0f;
+	}
+
+	float e0[4], e1[4];
+	fit_principal_axis(block, channels, 4, e0, e1);
+
+	float best_error = FLT_MAX;
+	UINT best_q0[4] = {}, best_q1[4] = {}, best_p0 = 0, best_p1 = 0, best_indices[16] = {};
+	for (UINT iteration = 0; iteration <= endpoint_refinements; iteration++)
+	{
+		UINT q0[4], q1[4], p0, p1;
+		quantize_bc7_endpoint(e0, q0, p0);
+		quantize_bc7_endpoint(e1, q1, p1);
+
+		BlockPalette palette;
+		palette.count = 16;
+		for (UINT i = 0; i < 16; i++)
+		{
+			for (UINT c = 0; c < 4; c++)
+			{
+				int low = int(q0[c] * 2 + p0), high = int(q1[c] * 2 + p1);
+				palette.colors[i][c] = float(((64 - bc7_weights[i]) * low + bc7_weights[i] * high + 32) >> 6);
+			}
+		}
+
+		UINT indices[16];
+		float error = select_indices(block, channels, 4, palette, indices);
+		if (error < best_error)
+		{
+			best_error = error;
+			memcpy(best_q0, q0, sizeof(q0));
+			memcpy(best_q1, q1, sizeof(q1));
+			best_p0 = p0;
+			best_p1 = p1;
+			memcpy(best_indices, indices, sizeof(indices));
+		}
+		if (!refine_endpoints(block, channels, 4, indices, weights, e0, e1))
+		{
+			break;
+		}
+	}
+
+	// The first index is stored without its top bit, which must be 0
+	if (best_indices[0] & 8)
+	{
+		std::swap(best_q0, best_q1);
+		std::swap(best_p0, best_p1);
+		for (UINT& index : best_indices)
+		{
+			index = 15 - index;
+		}
+	}
+
+	BlockBits bits(out);
+	bits.write(1 << 6, 7);
+	for (UINT c = 0; c < 4; c++)
+	{
+		bits.write(best_q0[c], 7);
+		bits.write(best_q1[c], 7);
+	}
+	bits.write(best_p0, 1);
+	bits.write(best_p1, 1);
+	bits.write(best_indices[0], 3);
+	for (UINT i = 1; i < 16; i++)
+	{
+		bits.write(best_indices[i], 4);
+	}
+}
+
+void encode_bc1_block(const unsigned char* pixels, unsigned char* block)
+{
+	BlockPixels loaded;
+	load_block(pixels, loaded);
+	encode_bc1_color(loaded, block);
+}
+
+void encode_bc3_block(const unsigned char* pixels, unsigned char* block)
+{
+	BlockPixels loaded;
+	load_block(pixels, loaded);
+	encode_bc4_channel(loaded, 3, block);
+	encode_bc1_color(loaded, block + 8);
+}
+
+void encode_bc4_block(const unsigned char* pixels, UINT channel, unsigned char* block)
+{
+	BlockPixels loaded;
+	load_block(pixels, loaded);
+	encode_bc4_channel(loaded, channel, block);
+}
+
+void encode_bc5_block(const unsigned char* pixels, unsigned char* block)
+{
+	BlockPixels loaded;
+	load_block(pixels, loaded);
+	encode_bc4_channel(loaded, 0, block);
+	encode_bc4_channel(loaded, 1, block + 8);
+}
+
+void encode_bc7_block(const unsigned char* pixels, unsigned char* block)
+{
+	BlockPixels loaded;
+	load_block(pixels, loaded);
+	encode_bc7_mode6(loaded, block);
+}
+
+static void decode_bc1_color(const unsigned char* block, bool always_four_colors, unsigned char* pixels)
+{
+	UINT c0 = block[0] | (block[1] << 8);
+	UINT c1 = block[2] | (block[3] << 8);
+	float colors[4][4];
+	unpack_565(c0, colors[0]);
+	unpack_565(c1, colors[1]);
+	bool four_colors = always_four_colors || c0 > c1;
+	for (UINT c = 0; c < 3; c++)
+	{
+		if (four_colors)
+		{
+			colors[2][c] = (2.0f * colors[0][c] + colors[1][c]) / 3.0f;
+			colors[3][c] = (colors[0][c] + 2.0f * colors[1][c]) / 3.0f;
+		}
+		else
+		{
+			colors[2][c] = (colors[0][c] + colors[1][c]) / 2.0f;
+			colors[3][c] = 0.0f;
+		}
+	}
+	colors[0][3] = colors[1][3] = colors[2][3] = 255.0f;
+	colors[3][3] = four_colors ? 255.0f : 0.0f;
+
+	UINT indices = block[4] | (block[5] << 8) | (block[6] << 16) | (UINT(block[7]) << 24);
+	for (UINT i = 0; i < 16; i++)
+	{
+		UINT index = (indices >> (i * 2)) & 3;
+		for (UINT c = 0; c < 4; c++)
+		{
+			pixels[i * 4 + c] = (unsigned char)(colors[index][c] + 0.5f);
+		}
+	}
+}
+
+static void decode_bc4_channel(const unsigned char* block, UINT channel, unsigned char* pixels)
+{
+	float values[8];
+	values[0] = float(block[0]);
+	values[1] = float(block[1]);
+	if (block[0] > block[1])
+	{
+		for (UINT i = 2; i < 8; i++)
+		{
+			values[i] = (float(8 - i) * values[0] + float(i - 1) * values[1]) / 7.0f;
+		}
+	}
+	else
+	{
+		for (UINT i = 2; i < 6; i++)
+		{
+			values[i] = (float(6 - i) * values[0] + float(i - 1) * values[1]) / 5.0f;
+		}
+		values[6] = 0.0f;
+		values[7] = 255.0f;
+	}
+
+	uint64_t indices = 0;
+	memcpy(&indices, block + 2, 6);
+	for (UINT i = 0; i < 16; i++)
+	{
+		pixels[i * 4 + channel] = (unsigned char)(values[(indices >> (i * 3)) & 7] + 0.5f);
+	}
+}
+
+static bool decode_bc7_mode6(const unsigned char* block, unsigned char* pixels)
+{
+	BlockBitReader bits(block);
+	if (bits.read(7) != 1 << 6)
+	{
+		// Only mode 6 is known, flag anything else
+		for (UINT i = 0; i < 16; i++)
+		{
+			pixels[i * 4 + 0] = 255;
+			pixels[i * 4 + 1] = 0;
+			pixels[i * 4 + 2] = 255;
+			pixels[i * 4 + 3] = 255;
+		}
+		return false;
+	}
+	UINT endpoints[2][4];
+	for (UINT c = 0; c < 4; c++)
+	{
+		endpoints[0][c] = bits.read(7) << 1;
+		endpoints[1][c] = bits.read(7) << 1;
+	}
+	UINT p0 = bits.read(1), p1 = bits.read(1);
+	for (UINT c = 0; c < 4; c++)
+	{
+		endpoints[0][c] |= p0;
+		endpoints[1][c] |= p1;
+	}
+	for (UINT i = 0; i < 16; i++)
+	{
+		UINT index = bits.read(i == 0 ? 3 : 4);
+		for (UINT c = 0; c < 4; c++)
+		{
+			pixels[i * 4 + c] = (unsigned char)(((64 - bc7_weights[index]) * endpoints[0][c] + bc7_weights[index] * endpoints[1][c] + 32) >> 6);
+		}
+	}
+	return true;
+}
+
+bool decode_block(DXGI_FORMAT format, const unsigned char* block, unsigned char* pixels)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+		decode_bc1_color(block, false, pixels);
+		break;
+	case DXGI_FORMAT_BC3_UNORM:
+		decode_bc1_color(block + 8, true, pixels);
+		decode_bc4_channel(block, 3, pixels);
+		break;
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+		for (UINT i = 0; i < 16; i++)
+		{
+			pixels[i * 4 + 1] = 0;
+			pixels[i * 4 + 2] = 0;
+			pixels[i * 4 + 3] = 255;
+		}
+		decode_bc4_channel(block, 0, pixels);
+		if (format == DXGI_FORMAT_BC5_UNORM) decode_bc4_channel(block + 8, 1, pixels);
+		break;
+	case DXGI_FORMAT_BC7_UNORM:
+		return decode_bc7_mode6(block, pixels);
+	default:
+		memset(pixels, 0, 64);
+		return false;
+	}
+	return true;
+}
+
+static void encode_block(DXGI_FORMAT format, const unsigned char* pixels, unsigned char* block)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM: encode_bc1_block(pixels, block); break;
+	case DXGI_FORMAT_BC3_UNORM: encode_bc3_block(pixels, block); break;
+	case DXGI_FORMAT_BC4_UNORM: encode_bc4_block(pixels, 0, block); break;
+	case DXGI_FORMAT_BC5_UNORM: encode_bc5_block(pixels, block); break;
+	case DXGI_FORMAT_BC7_UNORM: encode_bc7_block(pixels, block); break;
+	default: break;
+	}
+}
+
+// Row of blocks of one mip of one face, the unit of work of the parallel loops
+struct BlockRow
+{
+	UINT face;
+	UINT mip;
+	UINT y;
+};
+
+static std::vector<BlockRow> get_block_rows(const TextureData& data)
+{
+	std::vector<BlockRow> rows;
+	for (UINT face = 0; face < data.faceCount; face++)
+	{
+		for (UINT mip = 0; mip < data.mipCount; mip++)
+		{
+			for (UINT y = 0; y < (data.getMipHeight(mip) + 3) / 4; y++)
+			{
+				rows.push_back({ face, mip, y });
+			}
+		}
+	}
+	return rows;
+}
+
+bool compress_texture(const TextureData& source, DXGI_FORMAT format, TextureData& compressed)
+{
+	UINT block_size = get_block_size(format);
+	if (source.format != DXGI_FORMAT_R8G8B8A8_UNORM || block_size == 0 || source.width % 4 != 0 || source.height % 4 != 0)
+	{
+		return false;
+	}
+
+	compressed.width = source.width;
+	compressed.height = source.height;
+	compressed.faceCount = source.faceCount;
+	compressed.mipCount = source.mipCount;
+	compressed.format = format;
+	compressed.pixels.resize(compressed.getFaceSize() * compressed.faceCount);
+
+	std::vector<BlockRow> rows = get_block_rows(source);
+	parallel_for(rows.size(), min_block_rows_per_thread, [&](size_t begin, size_t end)
+	{
+		unsigned char pixels[64];
+		for (size_t r = begin; r < end; r++)
+		{
+			const BlockRow& row = rows[r];
+			UINT width = source.getMipWidth(row.mip);
+			UINT height = source.getMipHeight(row.mip);
+			const unsigned char* src = source.pixels.data() + source.getMipOffset(row.face, row.mip);
+			unsigned char* dst = compressed.pixels.data() + compressed.getMipOffset(row.face, row.mip) + row.y * get_row_pitch(format, width);
+			for (UINT bx = 0; bx < (width + 3) / 4; bx++)
+			{
+				// Mips smaller than a block repeat their last row and column
+				for (UINT i = 0; i < 16; i++)
+				{
+					UINT x = std::min(bx * 4 + i % 4, width - 1);
+					UINT y = std::min(row.y * 4 + i / 4, height - 1);
+					memcpy(pixels + i * 4, src + (size_t(y) * width + x) * 4, 4);
+				}
+				encode_block(format, pixels, dst + bx * block_size);
+			}
+		}
+	});
+	return true;
+}
+
+bool decompress_texture(const TextureData& compressed, TextureData& decompressed)
+{
+	UINT block_size = get_block_size(compressed.format);
+	if (block_size == 0)
+	{
+		return false;
+	}
+
+	decompressed.width = compressed.width;
+	decompressed.height = compressed.height;
+	decompressed.faceCount = compressed.faceCount;
+	decompressed.mipCount = compressed.mipCount;
+	decompressed.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	decompressed.pixels.resize(decompressed.getFaceSize() * decompressed.faceCount);
+
+	std::vector<BlockRow> rows = get_block_rows(compressed);
+	std::atomic<bool> decoded(true);
+	parallel_for(rows.size(), min_block_rows_per_thread, [&](size_t begin, size_t end)
+	{
+		unsigned char pixels[64];
+		bool rows_decoded = true;
+		for (size_t r = begin; r < end; r++)
+		{
+			const BlockRow& row = rows[r];
+			UINT width = compressed.getMipWidth(row.mip);
+			UINT height = compressed.getMipHeight(row.mip);
+			const unsigned char* src = compressed.pixels.data() + compressed.getMipOffset(row.face, row.mip) + row.y * get_row_pitch(compressed.format, width);
+			unsigned char* dst = decompressed.pixels.data() + decompressed.getMipOffset(row.face, row.mip);
+			for (UINT bx = 0; bx < (width + 3) / 4; bx++)
+			{
+				rows_decoded &= decode_block(compressed.format, src + bx * block_size, pixels);
+				for (UINT i = 0; i < 16; i++)
+				{
+					UINT x = bx * 4 + i % 4;
+					UINT y = row.y * 4 + i / 4;
+					if (x < width && y < height)
+					{
+						memcpy(dst + (size_t(y) * width + x) * 4, pixels + i * 4, 4);
+					}
+				}
+			}
+		}
+		if (!rows_decoded) decoded = false;
+	});
+	return decoded;
+}
+
+double compute_psnr(const TextureData& source, const TextureData& compressed)
+{
+	TextureData decompressed;
+	if (!decompress_texture(compressed, decompressed) || decompressed.pixels.size() != source.pixels.size())
+	{
+		return 0.0;
+	}
+
+	UINT channel_count = 4;
+	switch (compressed.format)
+	{
+	case DXGI_FORMAT_BC1_UNORM: channel_count = 3; break;
+	case DXGI_FORMAT_BC4_UNORM: channel_count = 1; break;
+	case DXGI_FORMAT_BC5_UNORM: channel_count = 2; break;
+	default: break;
+	}
+
+	double squared_error = 0.0;
+	for (size_t i = 0; i < source.pixels.size(); i += 4)
+	{
+		for (UINT c = 0; c < channel_count; c++)
+		{
+			double delta = double(source.pixels[i + c]) - double(decompressed.pixels[i + c]);
+			squared_error += delta * delta;
+		}
+	}
+	double mse = squared_error / (double(source.pixels.size() / 4) * channel_count);
+	if (mse <= 0.0)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <resource/TextureData.h>
+
+// Encodes 4x4 blocks of RGBA8 pixels, 64 bytes row by row, into one block of the target format
+void encode_bc1_block(const unsigned char* pixels, unsigned char* block);
+void encode_bc3_block(const unsigned char* pixels, unsigned char* block);
+// Encodes the given channel, BC5 stores red and green
+void encode_bc4_block(const unsigned char* pixels, UINT channel, unsigned char* block);
+void encode_bc5_block(const unsigned char* pixels, unsigned char* block);
+// Always mode 6, a single subset with RGBA endpoints and 4 bit indices
+void encode_bc7_block(const unsigned char* pixels, unsigned char* block);
+
+// Decodes a block back to 4x4 RGBA8 pixels the way the GPU samples it. BC4 and BC5 fill the missing channels
+// with 0 and alpha with 255. BC7 only knows the mode 6 blocks encode_bc7_block writes, other modes come out magenta
+// and return false, so do other formats.
+bool decode_block(DXGI_FORMAT format, const unsigned char* block, unsigned char* pixels);
+
+// Block compresses every face and mip of an RGBA8 texture, spread over the JobSystem by rows of blocks.
+// Returns false if format isn't BC1, BC3, BC4, BC5 or BC7, or the size isn't a multiple of 4 as D3D11 requires.
+bool compress_texture(const TextureData& source, DXGI_FORMAT format, TextureData& compressed);
+// Decodes every block of a compressed texture to RGBA8, returns false if a block couldn't be decoded exactly
+bool decompress_texture(const TextureData& compressed, TextureData& decompressed);
+
+// Peak signal to noise ratio in dB between an RGBA8 texture and its compressed version, over the channels the format
+// keeps. Infinite when they are identical.
+double compute_psnr(const TextureData& source, const TextureData& compressed);
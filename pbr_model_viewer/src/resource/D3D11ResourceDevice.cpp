@@ -0,0 +1,171 @@
+#include "D3D11ResourceDevice.h"
+
+#include <vector>
+
+D3D11ResourceDevice::D3D11ResourceDevice(Graphics& gfx)
+	: m_gfx(gfx)
+{
+}
+
+GpuTexture D3D11ResourceDevice::createTexture(const TextureData& data)
+{
+	bool cube = data.faceCount == 6;
+	D3D11_TEXTURE2D_DESC texture_desc = {};
+	texture_desc.Width = data.width;
+	texture_desc.Height = data.height;
+	texture_desc.MipLevels = data.mipCount;
+	texture_desc.ArraySize = data.faceCount;
+	texture_desc.Format = data.format;
+	texture_desc.SampleDesc = { 1, 0 };
+	texture_desc.Usage = D3D11_USAGE_IMMUTABLE;
+	texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texture_desc.CPUAccessFlags = 0;
+	texture_desc.MiscFlags = cube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+	// Subresources go mip by mip within each face
+	std::vector<D3D11_SUBRESOURCE_DATA> subres_data(data.faceCount * data.mipCount);
+	for (UINT face = 0; face < data.faceCount; face++)
+	{
+		for (UINT mip = 0; mip < data.mipCount; mip++)
+		{
+			D3D11_SUBRESOURCE_DATA& subres = subres_data[face * data.mipCount + mip];
+			subres.pSysMem = data.pixels.data() + data.getMipOffset(face, mip);
+			subres.SysMemPitch = UINT(get_row_pitch(data.format, data.getMipWidth(mip)));
+			subres.SysMemSlicePitch = 0;
+		}
+	}
+
+	ID3D11Texture2D* texture = nullptr;
+	if (FAILED(m_gfx.d3d_device->CreateTexture2D(&texture_desc, subres_data.data(), &texture)))
+	{
+		return nullptr;
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+	srv_desc.Format = texture_desc.Format;
+	if (cube)
+	{
+		srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+		srv_desc.TextureCube = { 0, data.mipCount };
+	}
+	else
+	{
+		srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srv_desc.Texture2D = { 0, data.mipCount };
+	}
+
+	// The view keeps the texture alive
+	ID3D11ShaderResourceView* srv = nullptr;
+	m_gfx.d3d_device->CreateShaderResourceView(texture, &srv_desc, &srv);
+	texture->Release();
+	return srv;
+}
+
+GpuTexture D3D11ResourceDevice::createStreamingTexture(UINT width, UINT height, UINT mip_count, const TextureData& tail)
+{
+	D3D11_TEXTURE2D_DESC texture_desc = {};
+	texture_desc.Width = width;
+	texture_desc.Height = height;
+	texture_desc.MipLevels = mip_count;
+	texture_desc.ArraySize = 1;
+	texture_desc.Format = tail.format;
+	texture_desc.SampleDesc = { 1, 0 };
+	texture_desc.Usage = D3D11_USAGE_DEFAULT;
+	texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texture_desc.CPUAccessFlags = 0;
+	texture_desc.MiscFlags = 0;
+
+	ID3D11Texture2D* texture = nullptr;
+	if (FAILED(m_gfx.d3d_device->CreateTexture2D(&texture_desc, nullptr, &texture)))
+	{
+		return nullptr;
+	}
+
+	// Level 0 of the tail is the first level of the texture it fills
+	UINT first_mip = mip_count - tail.mipCount;
+	for (UINT mip = 0; mip < tail.mipCount; mip++)
+	{
+		m_gfx.d3d_context->UpdateSubresource(texture, first_mip + mip, nullptr, tail.pixels.data() + tail.getMipOffset(0, mip),
+											 UINT(get_row_pitch(tail.format, tail.getMipWidth(mip))), 0);
+	}
+
+	// The view keeps the texture alive
+	ID3D11ShaderResourceView* srv = createView(texture, first_mip);
+	texture->Release();
+	return srv;
+}
+
+GpuTexture D3D11ResourceDevice::streamTextureMip(GpuTexture texture, const TextureData& data, UINT mip)
+{
+	ID3D11ShaderResourceView* old_srv = static_cast<ID3D11ShaderResourceView*>(texture);
+	ID3D11Resource* resource = nullptr;
+	old_srv->GetResource(&resource);
+	m_gfx.d3d_context->UpdateSubresource(resource, mip, nullptr, data.pixels.data() + data.getMipOffset(0, mip),
+										 UINT(get_row_pitch(data.format, data.getMipWidth(mip))), 0);
+
+	// Keep showing the coarser levels if the wider view can't be made
+	ID3D11ShaderResourceView* srv = createView(static_cast<ID3D11Texture2D*>(resource), mip);
+	resource->Release();
+	if (!srv)
+	{
+		return old_srv;
+	}
+	old_srv->Release();
+	return srv;
+}
+
+GpuTexture D3D11ResourceDevice::dropTextureMips(GpuTexture texture, UINT count)
+{
+	ID3D11ShaderResourceView* old_srv = static_cast<ID3D11ShaderResourceView*>(texture);
+	ID3D11Resource* resource = nullptr;
+	old_srv->GetResource(&resource);
+	ID3D11Texture2D* old_texture = static_cast<ID3D11Texture2D*>(resource);
+	D3D11_TEXTURE2D_DESC texture_desc;
+	old_texture->GetDesc(&texture_desc);
+	texture_desc.Width = texture_desc.Width >> count > 0 ? texture_desc.Width >> count : 1;
+	texture_desc.Height = texture_desc.Height >> count > 0 ? texture_desc.Height >> count : 1;
+	texture_desc.MipLevels -= count;
+	texture_desc.Usage = D3D11_USAGE_DEFAULT;
+
+	ID3D11Texture2D* new_texture = nullptr;
+	if (FAILED(m_gfx.d3d_device->CreateTexture2D(&texture_desc, nullptr, &new_texture)))
+	{
+		old_texture->Release();
+		return nullptr;
+	}
+	for (UINT mip = 0; mip < texture_desc.MipLevels; mip++)
+	{
+		m_gfx.d3d_context->CopySubresourceRegion(new_texture, mip, 0, 0, 0, old_texture, mip + count, nullptr);
+	}
+	old_texture->Release();
+
+	ID3D11ShaderResourceView* srv = createView(new_texture, 0);
+	new_texture->Release();
+	if (srv)
+	{
+		old_srv->Release();
+	}
+	return srv;
+}
+
+ID3D11ShaderResourceView* D3D11ResourceDevice::createView(ID3D11Texture2D* texture, UINT most_detailed_mip)
+{
+	D3D11_TEXTURE2D_DESC texture_desc;
+	texture->GetDesc(&texture_desc);
+	D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+	srv_desc.Format = texture_desc.Format;
+	srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srv_desc.Texture2D = { most_detailed_mip, texture_desc.MipLevels - most_detailed_mip };
+
+	ID3D11ShaderResourceView* srv = nullptr;
+	if (FAILED(m_gfx.d3d_device->CreateShaderResourceView(texture, &srv_desc, &srv)))
+	{
+		return nullptr;
+	}
+	return srv;
+}
+
+void D3D11ResourceDevice::releaseTexture(GpuTexture texture)
+{
+	if (texture) static_cast<ID3D11ShaderResourceView*>(texture)->Release();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <resource/IResourceDevice.h>
+#include <Graphics.h>
+
+// Creates the textures of the ResourceManager on the D3D11 device as immutable textures, every mip they come with
+// passed as initial data. Streaming textures are default usage instead, filled level by level through the immediate
+// context with a view whose most detailed mip follows the finest level filled. Dropping mips copies the levels kept
+// into a smaller texture on the GPU.
+class D3D11ResourceDevice : public IResourceDevice
+{
+public:
+	explicit D3D11ResourceDevice(Graphics& gfx);
+
+	virtual GpuTexture createTexture(const TextureData& data) override;
+	virtual GpuTexture createStreamingTexture(UINT width, UINT height, UINT mip_count, const TextureData& tail) override;
+	virtual GpuTexture streamTextureMip(GpuTexture texture, const TextureData& data, UINT mip) override;
+	virtual GpuTexture dropTextureMips(GpuTexture texture, UINT count) override;
+	virtual void releaseTexture(GpuTexture texture) override;
+
+private:
+	// 2D view of levels from most_detailed_mip down, nullptr if it can't be created
+	ID3D11ShaderResourceView* createView(ID3D11Texture2D* texture, UINT most_detailed_mip);
+
+	Graphics& m_gfx;
+};
@@ -0,0 +1,277 @@
+#include "DdsFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <MappedFile.h>
+
+static const uint32_t dds_magic = 0x20534444; // "DDS "
+static const uint32_t dds_fourcc_dx10 = 0x30315844; // "DX10"
+static const uint32_t dds_fourcc_dxt1 = 0x31545844; // "DXT1"
+static const uint32_t dds_fourcc_dxt5 = 0x35545844; // "DXT5"
+static const uint32_t dds_fourcc_ati1 = 0x31495441; // "ATI1"
+static const uint32_t dds_fourcc_bc4u = 0x55344342; // "BC4U"
+static const uint32_t dds_fourcc_ati2 = 0x32495441; // "ATI2"
+static const uint32_t dds_fourcc_bc5u = 0x55354342; // "BC5U"
+
+static const uint32_t ddsd_caps = 0x1;
+static const uint32_t ddsd_height = 0x2;
+static const uint32_t ddsd_width = 0x4;
+static const uint32_t ddsd_pitch = 0x8;
+static const uint32_t ddsd_pixelformat = 0x1000;
+static const uint32_t ddsd_mipmapcount = 0x20000;
+static const uint32_t ddsd_linearsize = 0x80000;
+static const uint32_t ddpf_alphapixels = 0x1;
+static const uint32_t ddpf_fourcc = 0x4;
+static const uint32_t ddpf_rgb = 0x40;
+static const uint32_t ddscaps_complex = 0x8;
+static const uint32_t ddscaps_texture = 0x1000;
+static const uint32_t ddscaps_mipmap = 0x400000;
+static const uint32_t ddscaps2_cubemap_all_faces = 0x200 | 0xFC00;
+static const uint32_t dx10_dimension_texture2d = 3;
+static const uint32_t dx10_misc_texturecube = 0x4;
+
+struct DdsPixelFormat
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t rBitMask;
+	uint32_t gBitMask;
+	uint32_t bBitMask;
+	uint32_t aBitMask;
+};
+
+struct DdsHeader
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DdsPixelFormat pixelFormat;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+struct DdsHeaderDx10
+{
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DdsHeader) == 124, "DDS header must match the file layout");
+static_assert(sizeof(DdsHeaderDx10) == 20, "DX10 header must match the file layout");
+
+// Formats TextureData knows the layout of. sRGB formats are read as their UNORM twin, the shader already treats every
+// texture as gamma encoded.
+static DXGI_FORMAT get_supported_format(uint32_t format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB: return DXGI_FORMAT_BC1_UNORM;
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB: return DXGI_FORMAT_BC3_UNORM;
+	case DXGI_FORMAT_BC4_UNORM: return DXGI_FORMAT_BC4_UNORM;
+	case DXGI_FORMAT_BC5_UNORM: return DXGI_FORMAT_BC5_UNORM;
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB: return DXGI_FORMAT_BC7_UNORM;
+	default: return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+// Format of a header without the DX10 extension, from its FourCC or its 32 bit RGBA masks.
+// swap_red_blue is set for BGRA pixels, which are read as RGBA.
+static DXGI_FORMAT get_legacy_format(const DdsPixelFormat& pixel_format, bool& swap_red_blue)
+{
+	swap_red_blue = false;
+	if (pixel_format.flags & ddpf_fourcc)
+	{
+		switch (pixel_format.fourCC)
+		{
+		case dds_fourcc_dxt1: return DXGI_FORMAT_BC1_UNORM;
+		case dds_fourcc_dxt5: return DXGI_FORMAT_BC3_UNORM;
+		case dds_fourcc_ati1:
+		case dds_fourcc_bc4u: return DXGI_FORMAT_BC4_UNORM;
+		case dds_fourcc_ati2:
+		case dds_fourcc_bc5u: return DXGI_FORMAT_BC5_UNORM;
+		default: return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+	if (!(pixel_format.flags & ddpf_rgb) || pixel_format.rgbBitCount != 32 || pixel_format.gBitMask != 0x0000FF00)
+	{
+		return DXGI_FORMAT_UNKNOWN;
+	}
+	// Without an alpha channel the fourth byte is padding, still read as alpha
+	bool alpha = (pixel_format.flags & ddpf_alphapixels) != 0;
+	if (alpha && pixel_format.aBitMask != 0xFF000000)
+	{
+		return DXGI_FORMAT_UNKNOWN;
+	}
+	if (pixel_format.rBitMask == 0x000000FF && pixel_format.bBitMask == 0x00FF0000)
+	{
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+	if (pixel_format.rBitMask == 0x00FF0000 && pixel_format.bBitMask == 0x000000FF)
+	{
+		swap_red_blue = true;
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+bool write_dds(const std::string& filename, const TextureData& data)
+{
+	DdsHeader header = {};
+	header.size = sizeof(DdsHeader);
+	header.flags = ddsd_caps | ddsd_height | ddsd_width | ddsd_pixelformat | ddsd_mipmapcount;
+	header.flags |= get_block_size(data.format) > 0 ? ddsd_linearsize : ddsd_pitch;
+	header.height = data.height;
+	header.width = data.width;
+	header.pitchOrLinearSize = uint32_t(get_block_size(data.format) > 0 ? data.getMipSize(0) : get_row_pitch(data.format, data.width));
+	header.depth = 1;
+	header.mipMapCount = data.mipCount;
+	header.pixelFormat.size = sizeof(DdsPixelFormat);
+	header.pixelFormat.flags = ddpf_fourcc;
+	header.pixelFormat.fourCC = dds_fourcc_dx10;
+	header.caps = ddscaps_texture | (data.mipCount > 1 ? ddscaps_mipmap | ddscaps_complex : 0);
+	header.caps2 = data.faceCount == 6 ? ddscaps2_cubemap_all_faces : 0;
+	if (data.faceCount == 6) header.caps |= ddscaps_complex;
+
+	DdsHeaderDx10 dx10 = {};
+	dx10.dxgiFormat = uint32_t(data.format);
+	dx10.resourceDimension = dx10_dimension_texture2d;
+	dx10.miscFlag = data.faceCount == 6 ? dx10_misc_texturecube : 0;
+	dx10.arraySize = 1;
+
+	// Concurrent loads may write the same file, every writer gets its own temporary
+	static std::atomic<uint32_t> temp_counter(0);
+	std::string temp_path = filename + "." + std::to_string(temp_counter.fetch_add(1)) + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&dds_magic), sizeof(dds_magic));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+		file.write(reinterpret_cast<const char*>(data.pixels.data()), std::streamsize(data.pixels.size()));
+		if (!file)
+		{
+			file.close();
+			std::remove(temp_path.c_str());
+			return false;
+		}
+	}
+	std::remove(filename.c_str());
+	if (std::rename(temp_path.c_str(), filename.c_str()) != 0)
+	{
+		std::remove(temp_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool read_dds(const std::string& filename, TextureData& data)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+	size_t header_size = sizeof(dds_magic) + sizeof(DdsHeader);
+	if (file.getSize() < header_size)
+	{
+		return false;
+	}
+
+	const unsigned char* bytes = file.getData();
+	uint32_t magic;
+	DdsHeader header;
+	memcpy(&magic, bytes, sizeof(magic));
+	memcpy(&header, bytes + sizeof(magic), sizeof(header));
+	// Bounding the size first keeps the mip and face size math below from overflowing
+	if (magic != dds_magic || header.size != sizeof(DdsHeader) || header.width == 0 || header.height == 0 ||
+		header.width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION || header.height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+	{
+		return false;
+	}
+
+	bool swap_red_blue = false;
+	UINT face_count = 1;
+	DXGI_FORMAT format;
+	if ((header.pixelFormat.flags & ddpf_fourcc) && header.pixelFormat.fourCC == dds_fourcc_dx10)
+	{
+		DdsHeaderDx10 dx10;
+		if (file.getSize() < header_size + sizeof(dx10))
+		{
+			return false;
+		}
+		memcpy(&dx10, bytes + header_size, sizeof(dx10));
+		header_size += sizeof(dx10);
+		if (dx10.resourceDimension != dx10_dimension_texture2d || dx10.arraySize != 1)
+		{
+			return false;
+		}
+		format = get_supported_format(dx10.dxgiFormat);
+		face_count = (dx10.miscFlag & dx10_misc_texturecube) ? 6 : 1;
+	}
+	else
+	{
+		format = get_legacy_format(header.pixelFormat, swap_red_blue);
+		if (header.caps2 & ddscaps2_cubemap_all_faces)
+		{
+			// Cubemaps missing faces have no D3D11 equivalent
+			if ((header.caps2 & ddscaps2_cubemap_all_faces) != ddscaps2_cubemap_all_faces)
+			{
+				return false;
+			}
+			face_count = 6;
+		}
+	}
+	if (format == DXGI_FORMAT_UNKNOWN)
+	{
+		return false;
+	}
+
+	data.width = header.width;
+	data.height = header.height;
+	data.faceCount = face_count;
+	data.mipCount = std::max(1u, header.mipMapCount);
+	data.format = format;
+	if (data.mipCount > get_full_mip_count(data.width, data.height))
+	{
+		return false;
+	}
+	size_t size = data.getFaceSize() * data.faceCount;
+	if (file.getSize() < header_size + size)
+	{
+		return false;
+	}
+	data.pixels.assign(bytes + header_size, bytes + header_size + size);
+	if (swap_red_blue)
+	{
+		for (size_t i = 0; i < data.pixels.size(); i += 4)
+		{
+			std::swap(data.pixels[i], data.pixels[i + 2]);
+		}
+	}
+	return true;
+}
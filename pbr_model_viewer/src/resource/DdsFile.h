@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+#include <resource/TextureData.h>
+
+// Writes a DDS file with a DX10 header, through a temporary file so a crash never leaves a half written one behind
+bool write_dds(const std::string& filename, const TextureData& data);
+// Reads a DDS file with every mip it stores, returns false if it can't be read, is truncated or holds anything
+// TextureData doesn't support. Besides DX10 headers this reads the DXT1, DXT5, ATI1/BC4U and ATI2/BC5U FourCCs and
+// 32 bit RGBA or BGRA pixels of older tools.
+bool read_dds(const std::string& filename, TextureData& data);
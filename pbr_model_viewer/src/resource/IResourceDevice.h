@@ -0,0 +1,27 @@
+#pragma once
+
+#include <resource/TextureData.h>
+
+// Opaque GPU texture made by an IResourceDevice, a shader resource view with the D3D11 device
+typedef void* GpuTexture;
+
+// GPU side of the ResourceManager. The app uploads through D3D11ResourceDevice, NullResourceDevice runs the manager
+// without a GPU.
+class IResourceDevice
+{
+public:
+	virtual ~IResourceDevice() = default;
+
+	// Render thread. Returns nullptr if the texture can't be created.
+	virtual GpuTexture createTexture(const TextureData& data) = 0;
+	// Render thread. Texture of mip_count levels of width x height whose levels arrive over several uploads, smallest
+	// first. tail holds the smallest levels, the only ones visible until streamTextureMip adds the next.
+	virtual GpuTexture createStreamingTexture(UINT width, UINT height, UINT mip_count, const TextureData& tail) = 0;
+	// Render thread. Uploads level mip of data, the one above the finest resident level, and widens the view to it.
+	// Returns the texture to use from now on, the one given is released.
+	virtual GpuTexture streamTextureMip(GpuTexture texture, const TextureData& data, UINT mip) = 0;
+	// Render thread. Copies the levels of a 2D texture but its count largest into a texture of their own, freeing the
+	// memory of the dropped ones. Returns the new texture and releases the one given, or nullptr keeping it if it can't.
+	virtual GpuTexture dropTextureMips(GpuTexture texture, UINT count) = 0;
+	virtual void releaseTexture(GpuTexture texture) = 0;
+};
@@ -0,0 +1,128 @@
+#include "KtxFile.h"
+
+#include <cstring>
+
+#include <MappedFile.h>
+
+static const unsigned char ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// VkFormat values of the formats TextureData supports
+static const uint32_t vk_format_r8g8b8a8_unorm = 37;
+static const uint32_t vk_format_r8g8b8a8_srgb = 43;
+static const uint32_t vk_format_bc1_rgb_unorm = 131;
+static const uint32_t vk_format_bc1_rgb_srgb = 132;
+static const uint32_t vk_format_bc1_rgba_unorm = 133;
+static const uint32_t vk_format_bc1_rgba_srgb = 134;
+static const uint32_t vk_format_bc3_unorm = 137;
+static const uint32_t vk_format_bc3_srgb = 138;
+static const uint32_t vk_format_bc4_unorm = 139;
+static const uint32_t vk_format_bc5_unorm = 141;
+static const uint32_t vk_format_bc7_unorm = 145;
+static const uint32_t vk_format_bc7_srgb = 146;
+
+struct Ktx2Header
+{
+	unsigned char identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+
+struct Ktx2Level
+{
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must match the file layout");
+static_assert(sizeof(Ktx2Level) == 24, "KTX2 level index must match the file layout");
+
+// sRGB formats are read as their UNORM twin like read_dds does
+static DXGI_FORMAT get_dxgi_format(uint32_t vk_format)
+{
+	switch (vk_format)
+	{
+	case vk_format_r8g8b8a8_unorm:
+	case vk_format_r8g8b8a8_srgb: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case vk_format_bc1_rgb_unorm:
+	case vk_format_bc1_rgb_srgb:
+	case vk_format_bc1_rgba_unorm:
+	case vk_format_bc1_rgba_srgb: return DXGI_FORMAT_BC1_UNORM;
+	case vk_format_bc3_unorm:
+	case vk_format_bc3_srgb: return DXGI_FORMAT_BC3_UNORM;
+	case vk_format_bc4_unorm: return DXGI_FORMAT_BC4_UNORM;
+	case vk_format_bc5_unorm: return DXGI_FORMAT_BC5_UNORM;
+	case vk_format_bc7_unorm:
+	case vk_format_bc7_srgb: return DXGI_FORMAT_BC7_UNORM;
+	default: return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+bool read_ktx2(const std::string& filename, TextureData& data)
+{
+	MappedFile file;
+	if (!file.open(filename) || file.getSize() < sizeof(Ktx2Header))
+	{
+		return false;
+	}
+
+	const unsigned char* bytes = file.getData();
+	Ktx2Header header;
+	memcpy(&header, bytes, sizeof(header));
+	// Bounding the size first keeps the mip and face size math below from overflowing
+	if (memcmp(header.identifier, ktx2_identifier, sizeof(ktx2_identifier)) != 0 || header.pixelWidth == 0 ||
+		header.pixelHeight == 0 || header.pixelWidth > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+		header.pixelHeight > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION || header.pixelDepth > 1 || header.layerCount > 1 || (header.faceCount != 1 && header.faceCount != 6) ||
+		header.supercompressionScheme != 0)
+	{
+		return false;
+	}
+
+	data.width = header.pixelWidth;
+	data.height = header.pixelHeight;
+	data.faceCount = header.faceCount;
+	// 0 asks the loader to generate the mips, which generate_mips does on the CPU for single mip RGBA8
+	data.mipCount = header.levelCount > 0 ? header.levelCount : 1;
+	data.format = get_dxgi_format(header.vkFormat);
+	if (data.format == DXGI_FORMAT_UNKNOWN || data.mipCount > get_full_mip_count(data.width, data.height))
+	{
+		return false;
+	}
+	size_t levels_size = sizeof(Ktx2Level) * data.mipCount;
+	if (file.getSize() < sizeof(Ktx2Header) + levels_size)
+	{
+		return false;
+	}
+
+	// Levels store every face of a mip together, TextureData every mip of a face
+	data.pixels.resize(data.getFaceSize() * data.faceCount);
+	for (UINT mip = 0; mip < data.mipCount; mip++)
+	{
+		Ktx2Level level;
+		memcpy(&level, bytes + sizeof(Ktx2Header) + mip * sizeof(Ktx2Level), sizeof(level));
+		size_t mip_size = data.getMipSize(mip);
+		if (level.byteLength < mip_size * data.faceCount || level.byteOffset > file.getSize() ||
+			file.getSize() - level.byteOffset < level.byteLength)
+		{
+			return false;
+		}
+		for (UINT face = 0; face < data.faceCount; face++)
+		{
+			memcpy(data.pixels.data() + data.getMipOffset(face, mip), bytes + level.byteOffset + face * mip_size, mip_size);
+		}
+	}
+	return true;
+}
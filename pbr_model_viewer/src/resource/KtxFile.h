@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+#include <resource/TextureData.h>
+
+// Reads a KTX2 file with every mip it stores, returns false if it can't be read, is truncated, is supercompressed or
+// holds anything TextureData doesn't support. 2D textures and cubemaps only, no arrays or 3D textures.
+bool read_ktx2(const std::string& filename, TextureData& data);
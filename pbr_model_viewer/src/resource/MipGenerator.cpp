@@ -0,0 +1,323 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <emmintrin.h>
+
+#include <Parallel.h>
+
+// Rows of a mip per job
+static const size_t min_mip_rows_per_thread = 16;
+// Half width of the Kaiser kernel in texels of the smaller mip, and the shape of its window
+static const float kaiser_radius = 3.0f;
+static const float kaiser_alpha = 4.0f;
+// Linear to sRGB goes through a table of this many steps, then exact thresholds fix the rounding
+static const UINT linear_to_srgb_steps = 4096;
+
+// The rgb of a texel for each byte value, alpha is always linear
+struct DecodeTable
+{
+	float rgb[256];
+};
+
+struct SrgbTables
+{
+	DecodeTable toLinear;
+	// Linear value halfway between each sRGB code and the next
+	float thresholds[255];
+	unsigned char fromLinear[linear_to_srgb_steps + 1];
+};
+
+static float srgb_to_linear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static const SrgbTables& get_srgb_tables()
+{
+	static const SrgbTables tables = []()
+	{
+		SrgbTables result;
+		for (UINT i = 0; i < 256; i++)
+		{
+			result.toLinear.rgb[i] = srgb_to_linear(i / 255.0f);
+		}
+		for (UINT i = 0; i < 255; i++)
+		{
+			result.thresholds[i] = srgb_to_linear((i + 0.5f) / 255.0f);
+		}
+		UINT code = 0;
+		for (UINT step = 0; step <= linear_to_srgb_steps; step++)
+		{
+			float value = float(step) / linear_to_srgb_steps;
+			while (code < 255 && value > result.thresholds[code]) code++;
+			result.fromLinear[step] = (unsigned char)code;
+		}
+		return result;
+	}();
+	return tables;
+}
+
+static const DecodeTable& get_decode_table(MipSettings::Content content)
+{
+	static const DecodeTable unorm = []()
+	{
+		DecodeTable table;
+		for (UINT i = 0; i < 256; i++) table.rgb[i] = i / 255.0f;
+		return table;
+	}();
+	static const DecodeTable snorm = []()
+	{
+		DecodeTable table;
+		for (UINT i = 0; i < 256; i++) table.rgb[i] = i / 127.5f - 1.0f;
+		return table;
+	}();
+	switch (content)
+	{
+	case MipSettings::Color: return get_srgb_tables().toLinear;
+	case MipSettings::Normal: return snorm;
+	default: return unorm;
+	}
+}
+
+static unsigned char encode_srgb(float value, const SrgbTables& tables)
+{
+	value = std::min(std::max(value, 0.0f), 1.0f);
+	UINT code = tables.fromLinear[UINT(value * linear_to_srgb_steps)];
+	while (code < 255 && value > tables.thresholds[code]) code++;
+	return (unsigned char)code;
+}
+
+// Modified Bessel function of the first kind, order 0
+static float bessel_i0(float x)
+{
+	float sum = 1.0f;
+	float term = 1.0f;
+	for (UINT k = 1; k < 32 && term > sum * 1e-7f; k++)
+	{
+		float half = x / (2.0f * k);
+		term *= half * half;
+		sum += term;
+	}
+	return sum;
+}
+
+static float kaiser_weight(float distance)
+{
+	float x = distance / kaiser_radius;
+	if (std::abs(x) >= 1.0f)
+	{
+		return 0.0f;
+	}
+	const float pi = 3.14159265358979f;
+	float sinc = distance == 0.0f ? 1.0f : std::sin(pi * distance) / (pi * distance);
+	return sinc * bessel_i0(kaiser_alpha * std::sqrt(1.0f - x * x)) / bessel_i0(kaiser_alpha);
+}
+
+// Source texels and weights of every texel along one axis of a mip. Every texel has the same number of taps,
+// padded with zero weights, and indices are clamped to the edge.
+struct FilterTaps
+{
+	UINT tapCount;
+	std::vector<UINT> indices;
+	std::vector<float> weights;
+};
+
+static float get_filter_weight(MipSettings::Filter filter, int src, float center, float radius, float scale)
+{
+	if (filter == MipSettings::Kaiser)
+	{
+		return kaiser_weight((src + 0.5f - center) / scale);
+	}
+	// Coverage of the source texel by the footprint of the destination texel
+	return std::max(0.0f, std::min(float(src + 1), center + radius) - std::max(float(src), center - radius));
+}
+
+static FilterTaps get_filter_taps(UINT src_size, UINT dst_size, MipSettings::Filter filter)
+{
+	float scale = float(src_size) / float(dst_size);
+	float radius = filter == MipSettings::Kaiser ? kaiser_radius * scale : 0.5f * scale;
+
+	// Source texels with a weight for each destination texel, centers in source texels
+	std::vector<int> firsts(dst_size);
+	UINT tap_count = 1;
+	for (UINT dst = 0; dst < dst_size; dst++)
+	{
+		float center = (dst + 0.5f) * scale;
+		int first = int(std::floor(center - radius));
+		int last = int(std::ceil(center + radius));
+		while (first < last && get_filter_weight(filter, first, center, radius, scale) == 0.0f) first++;
+		while (last > first && get_filter_weight(filter, last, center, radius, scale) == 0.0f) last--;
+		firsts[dst] = first;
+		tap_count = std::max(tap_count, UINT(last - first + 1));
+	}
+
+	FilterTaps taps;
+	taps.tapCount = tap_count;
+	taps.indices.resize(size_t(dst_size) * tap_count);
+	taps.weights.resize(size_t(dst_size) * tap_count);
+	for (UINT dst = 0; dst < dst_size; dst++)
+	{
+		float center = (dst + 0.5f) * scale;
+		float sum = 0.0f;
+		for (UINT tap = 0; tap < tap_count; tap++)
+		{
+			int src = firsts[dst] + int(tap);
+			float weight = get_filter_weight(filter, src, center, radius, scale);
+			taps.indices[dst * tap_count + tap] = UINT(std::min(std::max(src, 0), int(src_size) - 1));
+			taps.weights[dst * tap_count + tap] = weight;
+			sum += weight;
+		}
+		for (UINT tap = 0; tap < tap_count; tap++)
+		{
+			taps.weights[dst * tap_count + tap] /= sum;
+		}
+	}
+	return taps;
+}
+
+// Rows of linear texels are 4 floats per texel, 16 byte aligned like any heap allocation on x64
+static void decode_row(const unsigned char* src, UINT width, const DecodeTable& table, float* dst)
+{
+	for (UINT x = 0; x < width; x++)
+	{
+		const unsigned char* texel = src + x * 4;
+		_mm_store_ps(dst + x * 4, _mm_setr_ps(table.rgb[texel[0]], table.rgb[texel[1]], table.rgb[texel[2]], texel[3] / 255.0f));
+	}
+}
+
+static void encode_row(const float* src, UINT width, MipSettings::Content content, unsigned char* dst)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 unorm_scale = _mm_set1_ps(255.0f);
+	if (content == MipSettings::Color)
+	{
+		const SrgbTables& tables = get_srgb_tables();
+		for (UINT x = 0; x < width; x++)
+		{
+			const float* values = src + x * 4;
+			dst[x * 4 + 0] = encode_srgb(values[0], tables);
+			dst[x * 4 + 1] = encode_srgb(values[1], tables);
+			dst[x * 4 + 2] = encode_srgb(values[2], tables);
+			dst[x * 4 + 3] = (unsigned char)(std::min(std::max(values[3], 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+		return;
+	}
+
+	const __m128 rgb_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	for (UINT x = 0; x < width; x++)
+	{
+		__m128 texel = _mm_load_ps(src + x * 4);
+		if (content == MipSettings::Normal)
+		{
+			// Back to unit length, then from [-1, 1] to [0, 1]. Filtered out vectors stay zero.
+			__m128 xyz = _mm_and_ps(texel, rgb_mask);
+			__m128 squared = _mm_mul_ps(xyz, xyz);
+			__m128 pairs = _mm_add_ps(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128 length_squared = _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+			__m128 valid = _mm_cmpgt_ps(length_squared, _mm_set1_ps(1e-12f));
+			__m128 normalized = _mm_and_ps(_mm_div_ps(xyz, _mm_sqrt_ps(length_squared)), valid);
+			normalized = _mm_add_ps(_mm_mul_ps(normalized, half), half);
+			texel = _mm_or_ps(_mm_and_ps(rgb_mask, normalized), _mm_andnot_ps(rgb_mask, texel));
+		}
+		__m128 scaled = _mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(texel, zero), one), unorm_scale), half);
+		__m128i packed = _mm_cvttps_epi32(scaled);
+		packed = _mm_packs_epi32(packed, packed);
+		packed = _mm_packus_epi16(packed, packed);
+		int bytes = _mm_cvtsi128_si32(packed);
+		memcpy(dst + x * 4, &bytes, 4);
+	}
+}
+
+// Builds one mip from the one above it, both RGBA8
+static void filter_mip(const unsigned char* src, UINT src_width, UINT src_height, unsigned char* dst, UINT dst_width, UINT dst_height,
+					   const MipSettings& settings)
+{
+	FilterTaps taps_x = get_filter_taps(src_width, dst_width, settings.filter);
+	FilterTaps taps_y = get_filter_taps(src_height, dst_height, settings.filter);
+	const DecodeTable& table = get_decode_table(settings.content);
+
+	parallel_for(dst_height, min_mip_rows_per_thread, [&](size_t begin, size_t end)
+	{
+		// Decoded source rows, the rows of one destination row are consecutive so a ring of tapCount rows holds them
+		// without collisions and neighbouring destination rows reuse the overlap
+		UINT ring_size = taps_y.tapCount;
+		std::vector<float> ring(size_t(ring_size) * src_width * 4);
+		std::vector<UINT> ring_rows(ring_size, UINT(-1));
+		std::vector<float> column_sums(size_t(src_width) * 4);
+		std::vector<float> row(size_t(dst_width) * 4);
+		std::vector<const float*> tap_rows(taps_y.tapCount);
+
+		for (size_t y = begin; y < end; y++)
+		{
+			for (UINT tap = 0; tap < taps_y.tapCount; tap++)
+			{
+				UINT src_y = taps_y.indices[y * taps_y.tapCount + tap];
+				UINT slot = src_y % ring_size;
+				float* decoded = ring.data() + size_t(slot) * src_width * 4;
+				if (ring_rows[slot] != src_y)
+				{
+					decode_row(src + size_t(src_y) * src_width * 4, src_width, table, decoded);
+					ring_rows[slot] = src_y;
+				}
+				tap_rows[tap] = decoded;
+			}
+
+			// Vertical pass into one row of source width, then horizontal into the destination row
+			const float* weights_y = taps_y.weights.data() + y * taps_y.tapCount;
+			__m128 first_weight = _mm_set1_ps(weights_y[0]);
+			for (UINT x = 0; x < src_width; x++)
+			{
+				_mm_store_ps(&column_sums[x * 4], _mm_mul_ps(_mm_load_ps(tap_rows[0] + x * 4), first_weight));
+			}
+			for (UINT tap = 1; tap < taps_y.tapCount; tap++)
+			{
+				__m128 weight = _mm_set1_ps(weights_y[tap]);
+				const float* tap_row = tap_rows[tap];
+				for (UINT x = 0; x < src_width; x++)
+				{
+					__m128 sum = _mm_load_ps(&column_sums[x * 4]);
+					_mm_store_ps(&column_sums[x * 4], _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(tap_row + x * 4), weight)));
+				}
+			}
+			for (UINT x = 0; x < dst_width; x++)
+			{
+				const UINT* indices = taps_x.indices.data() + size_t(x) * taps_x.tapCount;
+				const float* weights = taps_x.weights.data() + size_t(x) * taps_x.tapCount;
+				__m128 sum = _mm_setzero_ps();
+				for (UINT tap = 0; tap < taps_x.tapCount; tap++)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(&column_sums[indices[tap] * 4]), _mm_set1_ps(weights[tap])));
+				}
+				_mm_store_ps(&row[x * 4], sum);
+			}
+			encode_row(row.data(), dst_width, settings.content, dst + y * dst_width * 4);
+		}
+	});
+}
+
+void generate_mips(TextureData& data, const MipSettings& settings)
+{
+	TextureData source = std::move(data);
+	data.width = source.width;
+	data.height = source.height;
+	data.faceCount = source.faceCount;
+	data.mipCount = get_full_mip_count(source.width, source.height);
+	data.format = source.format;
+	data.pixels.resize(data.getFaceSize() * data.faceCount);
+
+	for (UINT face = 0; face < data.faceCount; face++)
+	{
+		memcpy(data.pixels.data() + data.getMipOffset(face, 0), source.pixels.data() + source.getMipOffset(face, 0), data.getMipSize(0));
+		for (UINT mip = 1; mip < data.mipCount; mip++)
+		{
+			filter_mip(data.pixels.data() + data.getMipOffset(face, mip - 1), data.getMipWidth(mip - 1), data.getMipHeight(mip - 1),
+					   data.pixels.data() + data.getMipOffset(face, mip), data.getMipWidth(mip), data.getMipHeight(mip), settings);
+		}
+	}
+}
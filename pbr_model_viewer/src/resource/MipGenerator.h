@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Hash.h>
+#include <resource/TextureData.h>
+
+// How the mip chain of a texture is filtered, picked by the kind of map it is
+struct MipSettings
+{
+	enum Content
+	{
+		// sRGB color, filtered in linear space
+		Color,
+		// Tangent space vectors in rgb, renormalized after filtering
+		Normal,
+		// Scalar maps, filtered as stored
+		Linear,
+	};
+
+	enum Filter
+	{
+		// Averages the texels each mip texel covers
+		Box,
+		// Kaiser windowed sinc, sharper than the box at the cost of a wider footprint
+		Kaiser,
+	};
+
+	Content content = Color;
+	Filter filter = Box;
+
+	uint64_t getHash() const { return hash_combine(uint64_t(content), uint64_t(filter)); }
+};
+
+// Replaces the mips of an RGBA8 texture by a full chain filtered down from the first mip of every face.
+// Each level is built from the previous one and split over the JobSystem by rows.
+void generate_mips(TextureData& data, const MipSettings& settings);
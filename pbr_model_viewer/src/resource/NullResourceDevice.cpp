@@ -0,0 +1,37 @@
+#include "NullResourceDevice.h"
+
+NullResourceDevice::NullResourceDevice()
+	: m_nextTexture(0)
+	, m_liveTextures(0)
+	, m_createdBytes(0)
+{
+}
+
+GpuTexture NullResourceDevice::createTexture(const TextureData& data)
+{
+	m_liveTextures++;
+	m_createdBytes += data.pixels.size();
+	return reinterpret_cast<GpuTexture>(++m_nextTexture);
+}
+
+GpuTexture NullResourceDevice::createStreamingTexture(UINT, UINT, UINT, const TextureData& tail)
+{
+	return createTexture(tail);
+}
+
+GpuTexture NullResourceDevice::streamTextureMip(GpuTexture texture, const TextureData& data, UINT mip)
+{
+	// A new view of the same texture
+	m_createdBytes += data.getMipSize(mip);
+	return texture ? reinterpret_cast<GpuTexture>(++m_nextTexture) : nullptr;
+}
+
+GpuTexture NullResourceDevice::dropTextureMips(GpuTexture texture, UINT)
+{
+	return texture ? reinterpret_cast<GpuTexture>(++m_nextTexture) : nullptr;
+}
+
+void NullResourceDevice::releaseTexture(GpuTexture texture)
+{
+	if (texture) m_liveTextures--;
+}
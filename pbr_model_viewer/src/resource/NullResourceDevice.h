@@ -0,0 +1,25 @@
+#pragma once
+
+#include <resource/IResourceDevice.h>
+
+// Device without a GPU. Hands out dummy textures and counts them, so the queueing and budgeting of the
+// ResourceManager can be exercised headless.
+class NullResourceDevice : public IResourceDevice
+{
+public:
+	NullResourceDevice();
+
+	virtual GpuTexture createTexture(const TextureData& data) override;
+	virtual GpuTexture createStreamingTexture(UINT width, UINT height, UINT mip_count, const TextureData& tail) override;
+	virtual GpuTexture streamTextureMip(GpuTexture texture, const TextureData& data, UINT mip) override;
+	virtual GpuTexture dropTextureMips(GpuTexture texture, UINT count) override;
+	virtual void releaseTexture(GpuTexture texture) override;
+
+	size_t getLiveTextureCount() const { return m_liveTextures; }
+	size_t getCreatedBytes() const { return m_createdBytes; }
+
+private:
+	size_t m_nextTexture;
+	size_t m_liveTextures;
+	size_t m_createdBytes;
+};
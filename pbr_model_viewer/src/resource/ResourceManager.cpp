@@ -0,0 +1,804 @@
+#include "ResourceManager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+
+#include <Hash.h>
+#include <resource/BlockCompression.h>
+
+static const char* texture_cache_directory = "texture_cache";
+
+// Streamed textures first show the levels at most this wide and high
+static const UINT stream_tail_size = 128;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Windows paths differ in case and separators for the same file
+static std::string normalize_path(const std::string& path)
+{
+	std::string normalized = path;
+	for (char& c : normalized)
+	{
+		c = c == '/' ? '\\' : char(tolower((unsigned char)c));
+	}
+	return normalized;
+}
+
+// First level of the tail a texture streams from, 0 if it is small enough to upload whole
+static UINT get_stream_first_mip(UINT width, UINT height, UINT mip_count)
+{
+	for (UINT mip = 0; mip < mip_count; mip++)
+	{
+		if (std::max(width >> mip, height >> mip) <= stream_tail_size)
+		{
+			return mip;
+		}
+	}
+	return 0;
+}
+
+// Levels a texture can drop for the texture budget, down to its stream tail. Block compressed textures stop before a
+// level that isn't made of whole blocks, it can't be the top of one.
+static UINT get_max_dropped_mips(const TextureData& data)
+{
+	if (data.faceCount != 1)
+	{
+		return 0;
+	}
+	UINT max_mips = get_stream_first_mip(data.width, data.height, data.mipCount);
+	if (get_block_size(data.format) == 0)
+	{
+		return max_mips;
+	}
+	for (UINT mip = 1; mip <= max_mips; mip++)
+	{
+		if (data.getMipWidth(mip) % 4 != 0 || data.getMipHeight(mip) % 4 != 0)
+		{
+			return mip - 1;
+		}
+	}
+	return max_mips;
+}
+
+static size_t get_bytes_from(const std::vector<size_t>& mip_bytes, UINT first_mip)
+{
+	size_t bytes = 0;
+	for (UINT mip = first_mip; mip < mip_bytes.size(); mip++)
+	{
+		bytes += mip_bytes[mip];
+	}
+	return bytes;
+}
+
+ResourceManager::ResourceManager(IResourceDevice& device, size_t upload_budget_bytes, size_t unused_cache_bytes, size_t texture_budget_bytes)
+	: m_device(device)
+	, m_uploadBudget(upload_budget_bytes)
+	, m_unusedLimit(unused_cache_bytes)
+	, m_diskCache(texture_cache_directory)
+	, m_loadingCount(0)
+	, m_constantTolerance(-1)
+	, m_stats({})
+	, m_compressionStats({})
+	, m_streamingStats({})
+	, m_residency(texture_budget_bytes)
+	, m_nextResidencyId(0)
+	, m_frame(0)
+{
+}
+
+ResourceManager::~ResourceManager()
+{
+	// The jobs push into m_uploads, let them finish before it goes away. Their queued uploads never run.
+	JobSystem::get().wait(m_jobs);
+
+	// Dropping every handle with no room for unused textures frees all but the textures still decoding
+	m_unusedLimit = 0;
+	std::vector<bool> is_free(m_entries.size(), false);
+	for (UINT index : m_freeEntries)
+	{
+		is_free[index] = true;
+	}
+	for (UINT index = 0; index < m_entries.size(); index++)
+	{
+		if (!is_free[index]) release({ index, m_entries[index].generation });
+	}
+	for (auto& cached : m_cache)
+	{
+		if (cached.second->texture) m_device.releaseTexture(cached.second->texture);
+		delete cached.second;
+	}
+	for (auto& placeholder : m_placeholders)
+	{
+		m_device.releaseTexture(placeholder.second);
+	}
+}
+
+TextureHandle ResourceManager::loadTexture(const std::string& filename, UINT placeholder, DXGI_FORMAT format, const MipSettings& mips)
+{
+	// A texture collapsed under one tolerance isn't the one asked for under another
+	int tolerance = m_constantTolerance;
+	return load(placeholder, 1, format, hash_combine(mips.getHash(), uint64_t(tolerance)), filename,
+				[filename](uint64_t& hash) { return hash_file(filename, hash); },
+				[this, filename, format, mips, tolerance](uint64_t hash, TextureData& data, DecodeInfo& info)
+				{
+					return decodeTexture(filename, format, mips, tolerance, hash, data, info);
+				});
+}
+
+TextureHandle ResourceManager::loadPackedTexture(const PackedTextureSources& sources, DXGI_FORMAT format, const MipSettings& mips)
+{
+	// Cached under the list of its files, one per channel
+	std::string path = "packed";
+	for (const std::string& filename : sources.filenames)
+	{
+		path += "|" + filename;
+	}
+	int tolerance = m_constantTolerance;
+	return load(sources.fallback, 1, format, hash_combine(mips.getHash(), uint64_t(tolerance)), path,
+				[sources](uint64_t& hash) { return hash_packed_texture(sources, hash); },
+				[this, sources, format, mips, tolerance](uint64_t hash, TextureData& data, DecodeInfo& info)
+				{
+					return decodePackedTexture(sources, format, mips, tolerance, hash, data, info);
+				});
+}
+
+TextureHandle ResourceManager::loadTextureCube(const std::string& path, UINT placeholder)
+{
+	return load(placeholder, 6, DXGI_FORMAT_R8G8B8A8_UNORM, 0, path,
+				[path](uint64_t& hash) { return hash_texture_cube(path, hash); },
+				[path](uint64_t, TextureData& data, DecodeInfo&) { return decode_texture_cube(path, data); });
+}
+
+bool ResourceManager::decodeTexture(const std::string& filename, DXGI_FORMAT format, const MipSettings& mips, int tolerance,
+									uint64_t content_hash, TextureData& data, DecodeInfo& info) const
+{
+	// Prebuilt mips and formats are uploaded as they are, whatever format was asked for. Only a lone RGBA8 mip gets
+	// its chain generated.
+	if (is_texture_container(filename))
+	{
+		if (!read_texture_container(filename, data))
+		{
+			return false;
+		}
+		if (data.faceCount == 1)
+		{
+			collapseConstant(tolerance, data, info);
+		}
+		if (data.format == DXGI_FORMAT_R8G8B8A8_UNORM && data.mipCount == 1 && data.faceCount == 1 && !info.constant)
+		{
+			generate_mips(data, mips);
+		}
+		return true;
+	}
+
+	return buildTexture([&filename](TextureData& source) { return decode_texture(filename, source); }, format, mips, tolerance,
+						content_hash, data, info);
+}
+
+bool ResourceManager::decodePackedTexture(const PackedTextureSources& sources, DXGI_FORMAT format, const MipSettings& mips,
+										  int tolerance, uint64_t content_hash, TextureData& data, DecodeInfo& info) const
+{
+	if (!buildTexture([&sources](TextureData& packed) { return decode_packed_texture(sources, packed); }, format, mips, tolerance,
+					  content_hash, data, info))
+	{
+		return false;
+	}
+	if (info.constant)
+	{
+		return true;
+	}
+
+	DXGI_FORMAT separate_format = get_block_size(data.format) > 0 ? DXGI_FORMAT_BC4_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+	int64_t separate_bytes = 0;
+	for (UINT mip = 0; mip < data.mipCount; mip++)
+	{
+		separate_bytes += int64_t(get_image_size(separate_format, data.getMipWidth(mip), data.getMipHeight(mip)));
+	}
+	info.stats.packedTextures++;
+	info.stats.packedBytesSaved += separate_bytes * sources.getFileCount() - int64_t(data.pixels.size());
+	return true;
+}
+
+bool ResourceManager::buildTexture(const std::function<bool(TextureData&)>& decode, DXGI_FORMAT format, const MipSettings& mips,
+								   int tolerance, uint64_t content_hash, TextureData& data, DecodeInfo& info) const
+{
+	// The mip settings change the compressed output as much as the source does. Constant textures are never stored,
+	// so the tolerance doesn't.
+	TextureCompressionStats& stats = info.stats;
+	uint64_t output_hash = hash_combine(content_hash, mips.getHash());
+	if (format != DXGI_FORMAT_R8G8B8A8_UNORM && m_diskCache.load(output_hash, format, data))
+	{
+		stats.diskCacheHits++;
+		collapseConstant(tolerance, data, info);
+		return true;
+	}
+
+	TextureData source;
+	if (!decode(source))
+	{
+		return false;
+	}
+	collapseConstant(tolerance, source, info);
+	if (info.constant)
+	{
+		data = std::move(source);
+		return true;
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	generate_mips(source, mips);
+	stats.mipMs += elapsed_ms(start);
+	for (UINT mip = 1; mip < source.mipCount; mip++)
+	{
+		stats.mipMegapixels += double(source.getMipWidth(mip)) * source.getMipHeight(mip) / 1e6;
+	}
+	if (format == DXGI_FORMAT_R8G8B8A8_UNORM)
+	{
+		data = std::move(source);
+		return true;
+	}
+
+	// The tail encodes in no time and to the same blocks as within the whole chain, it can be seen long before the rest
+	UINT first_mip = get_stream_first_mip(source.width, source.height, source.mipCount);
+	if (first_mip > 0 && info.streamTail && source.width % 4 == 0 && source.height % 4 == 0)
+	{
+		TextureData tail;
+		TextureData compressed_tail;
+		extract_mips(source, first_mip, tail);
+		if (compress_texture(tail, format, compressed_tail))
+		{
+			info.streamTail(compressed_tail, source.width, source.height, source.mipCount);
+			info.tailStreamed = true;
+		}
+	}
+
+	start = std::chrono::high_resolution_clock::now();
+	if (!compress_texture(source, format, data))
+	{
+		data = std::move(source);
+		return true;
+	}
+	stats.compressedTextures++;
+	stats.encodeMs += elapsed_ms(start);
+	for (UINT mip = 0; mip < source.mipCount; mip++)
+	{
+		stats.encodedMegapixels += double(source.getMipWidth(mip)) * source.getMipHeight(mip) / 1e6;
+	}
+	double psnr = compute_psnr(source, data);
+	if (std::isfinite(psnr))
+	{
+		stats.psnrSum += psnr;
+		stats.psnrCount++;
+	}
+	m_diskCache.store(output_hash, data);
+	return true;
+}
+
+void ResourceManager::collapseConstant(int tolerance, TextureData& data, DecodeInfo& info)
+{
+	info.analyzed = analyze_texture(data, info.analysis);
+	if (!info.analyzed || tolerance < 0 || !info.analysis.isConstant(UINT(tolerance)))
+	{
+		return;
+	}
+	make_solid_texture(info.analysis.getMeanColor(), 1, data);
+	info.constant = true;
+	info.stats.constantTextures++;
+}
+
+TextureHandle ResourceManager::load(UINT placeholder, UINT face_count, DXGI_FORMAT format, uint64_t settings_hash, const std::string& path,
+									std::function<bool(uint64_t&)> hash, DecodeFunction decode)
+{
+	UINT index;
+	if (!m_freeEntries.empty())
+	{
+		index = m_freeEntries.back();
+		m_freeEntries.pop_back();
+	}
+	else
+	{
+		index = UINT(m_entries.size());
+		m_entries.emplace_back();
+		m_entries.back().generation = 0;
+	}
+
+	Entry& entry = m_entries[index];
+	entry.generation++;
+	entry.state = Loading;
+	entry.cached = nullptr;
+	entry.placeholder = getPlaceholder(placeholder, face_count);
+	entry.loadStart = std::chrono::high_resolution_clock::now();
+	entry.promise = std::promise<bool>();
+	entry.future = entry.promise.get_future().share();
+	m_loadingCount++;
+
+	// Hashing reads the whole file, so it runs as a job too and the cache lookup follows through the upload queue
+	TextureHandle handle = { index, entry.generation };
+	std::string normalized = normalize_path(path);
+	JobSystem::get().submit([this, handle, face_count, format, settings_hash, normalized, hash, decode]()
+	{
+		uint64_t content_hash = 0;
+		bool hashed = hash(content_hash);
+		CacheKey key(face_count, UINT(format), settings_hash, normalized, content_hash);
+		m_uploads.push(0, [this, handle, hashed, key, decode]() { resolve(handle, hashed, key, decode); });
+	}, &m_jobs);
+	return handle;
+}
+
+void ResourceManager::resolve(TextureHandle handle, bool hashed, const CacheKey& key, DecodeFunction decode)
+{
+	Entry* entry = find(handle);
+	if (!entry)
+	{
+		return;
+	}
+	if (!hashed)
+	{
+		complete(handle, Failed);
+		return;
+	}
+
+	auto found = m_cache.find(key);
+	if (found != m_cache.end())
+	{
+		CachedTexture* cached = found->second;
+		m_stats.hits++;
+		ref(cached);
+		entry->cached = cached;
+		if (cached->state == Ready)
+		{
+			complete(handle, Ready);
+		}
+		else
+		{
+			cached->waiting.push_back(handle);
+		}
+		return;
+	}
+
+	// Miss, the decode holds a reference of its own until its upload
+	m_stats.misses++;
+	CachedTexture* cached = new CachedTexture();
+	cached->key = key;
+	cached->state = Loading;
+	cached->texture = nullptr;
+	cached->bytes = 0;
+	cached->analyzed = false;
+	cached->constant = false;
+	cached->streaming = false;
+	cached->residentMip = 0;
+	cached->loadStart = entry->loadStart;
+	cached->residencyId = 0;
+	cached->decode = decode;
+	cached->restoring = false;
+	cached->restoreFailed = false;
+	cached->refs = 2;
+	cached->waiting.push_back(handle);
+	cached->isUnused = false;
+	m_cache[key] = cached;
+	entry->cached = cached;
+
+	uint64_t content_hash = std::get<4>(key);
+	JobSystem::get().submit([this, cached, content_hash, decode]()
+	{
+		std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+		DecodeInfo info = {};
+		info.streamTail = [this, cached](const TextureData& tail, UINT width, UINT height, UINT mip_count)
+		{
+			pushStreamTail(cached, tail, width, height, mip_count);
+		};
+		if (!decode(content_hash, *data, info))
+		{
+			data.reset();
+		}
+		info.streamTail = nullptr;
+
+		// Large 2D textures go up from their tail one level per upload, so each level counts against the budget alone
+		UINT first_mip = data && data->faceCount == 1 ? get_stream_first_mip(data->width, data->height, data->mipCount) : 0;
+		if (first_mip > 0)
+		{
+			if (!info.tailStreamed)
+			{
+				TextureData tail;
+				extract_mips(*data, first_mip, tail);
+				pushStreamTail(cached, tail, data->width, data->height, data->mipCount);
+			}
+			for (UINT mip = first_mip; mip-- > 0;)
+			{
+				m_uploads.push(data->getMipSize(mip), [this, cached, data, mip]() { streamMip(cached, *data, mip); });
+			}
+		}
+		size_t bytes = data && first_mip == 0 ? data->pixels.size() : 0;
+		m_uploads.push(bytes, [this, cached, data, info]() { finish(cached, data.get(), info); });
+	}, &m_jobs);
+}
+
+void ResourceManager::finish(CachedTexture* cached, const TextureData* data, const DecodeInfo& info)
+{
+	const TextureCompressionStats& stats = info.stats;
+	m_compressionStats.compressedTextures += stats.compressedTextures;
+	m_compressionStats.diskCacheHits += stats.diskCacheHits;
+	m_compressionStats.encodeMs += stats.encodeMs;
+	m_compressionStats.encodedMegapixels += stats.encodedMegapixels;
+	m_compressionStats.psnrSum += stats.psnrSum;
+	m_compressionStats.psnrCount += stats.psnrCount;
+	m_compressionStats.mipMs += stats.mipMs;
+	m_compressionStats.mipMegapixels += stats.mipMegapixels;
+	m_compressionStats.packedTextures += stats.packedTextures;
+	m_compressionStats.packedBytesSaved += stats.packedBytesSaved;
+	m_compressionStats.constantTextures += stats.constantTextures;
+
+	if (!cached->streaming)
+	{
+		cached->texture = data ? m_device.createTexture(*data) : nullptr;
+	}
+	else if (cached->texture)
+	{
+		double ms = elapsed_ms(cached->loadStart);
+		m_streamingStats.fullResolutionTextures++;
+		m_streamingStats.fullResolutionMs += ms;
+		m_streamingStats.lastFullResolutionMs = ms;
+	}
+	if (cached->texture)
+	{
+		cached->state = Ready;
+		cached->bytes = data->pixels.size();
+		cached->residentMip = 0;
+		cached->analysis = info.analysis;
+		cached->analyzed = info.analyzed;
+		cached->constant = info.constant;
+		m_stats.residentTextures++;
+		m_stats.residentBytes += cached->bytes;
+
+		UINT max_dropped_mips = get_max_dropped_mips(*data);
+		if (max_dropped_mips > 0)
+		{
+			for (UINT mip = 0; mip < data->mipCount; mip++)
+			{
+				cached->mipBytes.push_back(data->getMipSize(mip));
+			}
+			cached->residencyId = ++m_nextResidencyId;
+			m_residency.add(cached->residencyId, cached->mipBytes, max_dropped_mips, m_frame);
+			m_tracked[cached->residencyId] = cached;
+		}
+	}
+	else
+	{
+		// Out of the cache so the next load of the file tries again
+		cached->state = Failed;
+		m_cache.erase(cached->key);
+	}
+
+	for (TextureHandle handle : cached->waiting)
+	{
+		Entry* entry = find(handle);
+		if (entry && entry->cached == cached)
+		{
+			complete(handle, cached->state);
+		}
+	}
+	cached->waiting.clear();
+	unref(cached);
+}
+
+void ResourceManager::pushStreamTail(CachedTexture* cached, const TextureData& tail, UINT width, UINT height, UINT mip_count)
+{
+	std::shared_ptr<TextureData> levels = std::make_shared<TextureData>(tail);
+	m_uploads.push(levels->pixels.size(), [this, cached, levels, width, height, mip_count]()
+	{
+		beginStream(cached, *levels, width, height, mip_count);
+	});
+}
+
+void ResourceManager::beginStream(CachedTexture* cached, const TextureData& tail, UINT width, UINT height, UINT mip_count)
+{
+	// Failing here fails the whole load in finish
+	cached->streaming = true;
+	cached->texture = m_device.createStreamingTexture(width, height, mip_count, tail);
+	if (!cached->texture)
+	{
+		return;
+	}
+	cached->residentMip = mip_count - tail.mipCount;
+	double ms = elapsed_ms(cached->loadStart);
+	m_streamingStats.streamedTextures++;
+	m_streamingStats.firstTexelMs += ms;
+	m_streamingStats.lastFirstTexelMs = ms;
+}
+
+void ResourceManager::streamMip(CachedTexture* cached, const TextureData& data, UINT mip)
+{
+	if (!cached->texture)
+	{
+		return;
+	}
+	cached->texture = m_device.streamTextureMip(cached->texture, data, mip);
+	cached->residentMip = mip;
+}
+
+void ResourceManager::complete(TextureHandle handle, State state)
+{
+	Entry* entry = find(handle);
+	if (!entry || entry->state != Loading)
+	{
+		return;
+	}
+	entry->state = state;
+	entry->promise.set_value(state == Ready);
+	m_loadingCount--;
+}
+
+void ResourceManager::release(TextureHandle handle)
+{
+	Entry* entry = find(handle);
+	if (!entry)
+	{
+		return;
+	}
+	if (entry->state == Loading)
+	{
+		// Whatever is still queued for it gets dropped once it sees the new generation
+		entry->promise.set_value(false);
+		m_loadingCount--;
+	}
+	if (entry->cached)
+	{
+		unref(entry->cached);
+		entry->cached = nullptr;
+	}
+	entry->generation++;
+	m_freeEntries.push_back(handle.index);
+}
+
+void ResourceManager::ref(CachedTexture* cached)
+{
+	if (cached->isUnused)
+	{
+		m_unused.erase(cached->unused);
+		cached->isUnused = false;
+		m_stats.unusedTextures--;
+		m_stats.unusedBytes -= cached->bytes;
+	}
+	cached->refs++;
+}
+
+void ResourceManager::unref(CachedTexture* cached)
+{
+	if (--cached->refs > 0)
+	{
+		return;
+	}
+	if (cached->state == Ready)
+	{
+		cached->isUnused = true;
+		cached->unused = m_unused.insert(m_unused.end(), cached);
+		m_stats.unusedTextures++;
+		m_stats.unusedBytes += cached->bytes;
+		trimUnused();
+		return;
+	}
+	delete cached;
+}
+
+void ResourceManager::trimUnused()
+{
+	while (m_stats.unusedBytes > m_unusedLimit && !m_unused.empty())
+	{
+		CachedTexture* cached = m_unused.front();
+		m_unused.pop_front();
+		m_cache.erase(cached->key);
+		m_device.releaseTexture(cached->texture);
+		if (cached->residencyId)
+		{
+			m_residency.remove(cached->residencyId);
+			m_tracked.erase(cached->residencyId);
+		}
+		m_stats.unusedTextures--;
+		m_stats.unusedBytes -= cached->bytes;
+		m_stats.residentTextures--;
+		m_stats.residentBytes -= cached->bytes;
+		delete cached;
+	}
+}
+
+void ResourceManager::update()
+{
+	m_uploads.drain(m_uploadBudget);
+	applyResidency();
+	m_frame++;
+}
+
+void ResourceManager::markVisible(TextureHandle handle)
+{
+	const Entry* entry = find(handle);
+	if (entry && entry->state == Ready && entry->cached->residencyId)
+	{
+		m_residency.touch(entry->cached->residencyId, m_frame);
+	}
+}
+
+void ResourceManager::applyResidency()
+{
+	std::vector<TextureResidency::Change> changes;
+	m_residency.update(m_frame, changes);
+	for (const TextureResidency::Change& change : changes)
+	{
+		CachedTexture* cached = m_tracked[change.id];
+		if (change.firstMip > cached->residentMip)
+		{
+			// Dropping happens on the GPU right away
+			GpuTexture texture = m_device.dropTextureMips(cached->texture, change.firstMip - cached->residentMip);
+			if (!texture)
+			{
+				m_residency.setFirstMip(change.id, cached->residentMip);
+				continue;
+			}
+			m_stats.evictedLevels += change.firstMip - cached->residentMip;
+			cached->texture = texture;
+			cached->residentMip = change.firstMip;
+			setBytes(cached, get_bytes_from(cached->mipBytes, cached->residentMip));
+		}
+		else if (change.firstMip < cached->residentMip)
+		{
+			// A source that couldn't be decoded again keeps the levels left
+			if (cached->restoreFailed)
+			{
+				m_residency.setFirstMip(change.id, cached->residentMip);
+			}
+			else if (!cached->restoring)
+			{
+				restoreMips(cached);
+			}
+		}
+	}
+}
+
+void ResourceManager::restoreMips(CachedTexture* cached)
+{
+	// The job holds a reference, so the texture outlives it even if every handle goes
+	ref(cached);
+	cached->restoring = true;
+	DecodeFunction decode = cached->decode;
+	uint64_t content_hash = std::get<4>(cached->key);
+	JobSystem::get().submit([this, cached, decode, content_hash]()
+	{
+		std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+		DecodeInfo info = {};
+		if (!decode(content_hash, *data, info))
+		{
+			data.reset();
+		}
+		size_t bytes = data ? data->pixels.size() : 0;
+		m_uploads.push(bytes, [this, cached, data]() { finishRestore(cached, data.get()); });
+	}, &m_jobs);
+}
+
+void ResourceManager::finishRestore(CachedTexture* cached, const TextureData* data)
+{
+	cached->restoring = false;
+	if (!data || data->mipCount != cached->mipBytes.size())
+	{
+		cached->restoreFailed = true;
+	}
+
+	// Brings back what the budget allows by now, which may have changed since the restore started
+	UINT first_mip = m_residency.getFirstMip(cached->residencyId);
+	if (!cached->restoreFailed && first_mip < cached->residentMip)
+	{
+		TextureData levels;
+		extract_mips(*data, first_mip, levels);
+		GpuTexture texture = m_device.createTexture(levels);
+		if (texture)
+		{
+			m_device.releaseTexture(cached->texture);
+			m_stats.restoredLevels += cached->residentMip - first_mip;
+			cached->texture = texture;
+			cached->residentMip = first_mip;
+			setBytes(cached, get_bytes_from(cached->mipBytes, cached->residentMip));
+		}
+	}
+	if (first_mip < cached->residentMip)
+	{
+		m_residency.setFirstMip(cached->residencyId, cached->residentMip);
+	}
+	unref(cached);
+}
+
+void ResourceManager::setBytes(CachedTexture* cached, size_t bytes)
+{
+	m_stats.residentBytes = m_stats.residentBytes - cached->bytes + bytes;
+	if (cached->isUnused)
+	{
+		m_stats.unusedBytes = m_stats.unusedBytes - cached->bytes + bytes;
+	}
+	cached->bytes = bytes;
+}
+
+ResourceManager::Entry* ResourceManager::find(TextureHandle handle)
+{
+	if (!handle.isValid() || handle.index >= m_entries.size() || m_entries[handle.index].generation != handle.generation)
+	{
+		return nullptr;
+	}
+	return &m_entries[handle.index];
+}
+
+const ResourceManager::Entry* ResourceManager::find(TextureHandle handle) const
+{
+	return const_cast<ResourceManager*>(this)->find(handle);
+}
+
+ResourceManager::State ResourceManager::getState(TextureHandle handle) const
+{
+	const Entry* entry = find(handle);
+	return entry ? entry->state : Failed;
+}
+
+GpuTexture ResourceManager::getTexture(TextureHandle handle) const
+{
+	const Entry* entry = find(handle);
+	if (!entry)
+	{
+		return nullptr;
+	}
+	if (entry->state == Ready)
+	{
+		return entry->cached->texture;
+	}
+	// Streamed levels show as soon as they are up
+	if (entry->state == Loading && entry->cached && entry->cached->texture)
+	{
+		return entry->cached->texture;
+	}
+	return entry->placeholder;
+}
+
+std::shared_future<bool> ResourceManager::getFuture(TextureHandle handle) const
+{
+	const Entry* entry = find(handle);
+	return entry ? entry->future : std::shared_future<bool>();
+}
+
+UINT ResourceManager::getResidentMip(TextureHandle handle) const
+{
+	const Entry* entry = find(handle);
+	if (!entry || !entry->cached || entry->state == Failed)
+	{
+		return 0;
+	}
+	return entry->cached->residentMip;
+}
+
+const TextureAnalysis* ResourceManager::getAnalysis(TextureHandle handle) const
+{
+	const Entry* entry = find(handle);
+	if (!entry || entry->state != Ready || !entry->cached->analyzed)
+	{
+		return nullptr;
+	}
+	return &entry->cached->analysis;
+}
+
+bool ResourceManager::isConstant(TextureHandle handle) const
+{
+	const Entry* entry = find(handle);
+	return entry && entry->state == Ready && entry->cached->constant;
+}
+
+GpuTexture ResourceManager::getPlaceholder(UINT color, UINT face_count)
+{
+	auto found = m_placeholders.find({ color, face_count });
+	if (found != m_placeholders.end())
+	{
+		return found->second;
+	}
+	TextureData data;
+	make_solid_texture(color, face_count, data);
+	GpuTexture placeholder = m_device.createTexture(data);
+	m_placeholders[{ color, face_count }] = placeholder;
+	return placeholder;
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <JobSystem.h>
+#include <resource/IResourceDevice.h>
+#include <resource/MipGenerator.h>
+#include <resource/TextureAnalysis.h>
+#include <resource/TexturePacking.h>
+#include <resource/TextureDiskCache.h>
+#include <resource/TextureResidency.h>
+#include <resource/UploadQueue.h>
+
+// Texture of the ResourceManager. The generation tells a released entry apart from the one that reused its slot.
+struct TextureHandle
+{
+	UINT index;
+	UINT generation;
+
+	bool isValid() const { return generation != 0; }
+};
+
+// Counters of the texture cache since the ResourceManager was created
+struct TextureCacheStats
+{
+	// Loads served by a texture already resident or being decoded, and loads that had to decode
+	UINT hits;
+	UINT misses;
+	UINT residentTextures;
+	size_t residentBytes;
+	// Part of the resident textures no handle uses anymore, kept for a later load of the same file
+	UINT unusedTextures;
+	size_t unusedBytes;
+	// Levels the texture budget dropped, and the ones brought back for textures visible again
+	UINT evictedLevels;
+	UINT restoredLevels;
+
+	float getHitRate() const { return hits + misses > 0 ? float(hits) / float(hits + misses) : 0.0f; }
+};
+
+// Mip generation and block compression done by the texture loads since the ResourceManager was created
+struct TextureCompressionStats
+{
+	UINT compressedTextures;
+	// Compressed loads served by the disk cache instead
+	UINT diskCacheHits;
+	double encodeMs;
+	// Pixels of every mip that went through the encoders
+	double encodedMegapixels;
+	// Over the textures that weren't compressed losslessly
+	double psnrSum;
+	UINT psnrCount;
+
+	// CPU mip generation of every texture decoded from an image, megapixels of the mips it wrote
+	double mipMs;
+	double mipMegapixels;
+
+	// Packed loads, and the bytes they save against one texture per file in BC4 or RGBA8. Negative when packing a lone
+	// map costs more than it saves.
+	UINT packedTextures;
+	int64_t packedBytesSaved;
+
+	// Loads replaced by a 1x1 texture of their mean for staying within the constant tolerance
+	UINT constantTextures;
+
+	double getMegapixelsPerSecond() const { return encodeMs > 0.0 ? encodedMegapixels * 1000.0 / encodeMs : 0.0; }
+	double getMipMegapixelsPerSecond() const { return mipMs > 0.0 ? mipMegapixels * 1000.0 / mipMs : 0.0; }
+	double getAveragePsnr() const { return psnrCount > 0 ? psnrSum / psnrCount : 0.0; }
+};
+
+// How fast streamed loads became visible, from the load call to their first texels and to their full resolution
+struct TextureStreamingStats
+{
+	UINT streamedTextures;
+	double firstTexelMs;
+	double lastFirstTexelMs;
+	UINT fullResolutionTextures;
+	double fullResolutionMs;
+	double lastFullResolutionMs;
+
+	double getAverageFirstTexelMs() const { return streamedTextures > 0 ? firstTexelMs / streamedTextures : 0.0; }
+	double getAverageFullResolutionMs() const { return fullResolutionTextures > 0 ? fullResolutionMs / fullResolutionTextures : 0.0; }
+};
+
+// Loads textures without stalling the render thread. A load returns a handle at once and hashes the file on the JobSystem.
+// Textures are cached by path and content hash, so every handle to the same unchanged file shares one decode and one
+// GPU texture, which lives as long as a handle references it. Unreferenced textures stay cached up to a byte limit,
+// oldest first out. A miss decodes on the JobSystem and the payload then waits in an UploadQueue that update() drains
+// within a byte budget every frame. Decoded images get a mip chain generated on the CPU and can be block compressed on
+// the way, the compressed result is kept in a TextureDiskCache for the next run. The first mip of every 2D texture is
+// analyzed too, and one that barely varies is uploaded as a 1x1 texture of its mean instead. Large 2D textures stream in,
+// their smallest levels first and then one finer level per upload, each visible as soon as it is on the GPU. A decode
+// that has to encode uploads its encoded tail before the slow encode of the larger levels. Until its first upload
+// a texture resolves to a 1x1 placeholder of the color given at load, for good if the load fails.
+// The textures on the GPU are kept within a budget by a TextureResidency. Large 2D textures not drawn for the longest
+// give up their largest levels first, down to their stream tail, and get them back by decoding again once visible.
+// Everything but the hash and decode jobs runs on the render thread.
+class ResourceManager
+{
+public:
+	enum State
+	{
+		Loading,
+		Ready,
+		Failed,
+	};
+
+	ResourceManager(IResourceDevice& device, size_t upload_budget_bytes, size_t unused_cache_bytes, size_t texture_budget_bytes);
+	// Waits for the running jobs and releases every texture
+	~ResourceManager();
+
+	// placeholder is a color packed as 0xAABBGGRR. format is DXGI_FORMAT_R8G8B8A8_UNORM or the block compressed format
+	// to encode to, sizes that aren't a multiple of 4 stay uncompressed. DDS and KTX2 files keep their own format and mips.
+	// mips decides how the mip chain is filtered.
+	TextureHandle loadTexture(const std::string& filename, UINT placeholder, DXGI_FORMAT format, const MipSettings& mips);
+	// Packs the red channels of the files of sources into one texture, encoded and filtered like loadTexture does.
+	// The fallback of sources is the placeholder too.
+	TextureHandle loadPackedTexture(const PackedTextureSources& sources, DXGI_FORMAT format, const MipSettings& mips);
+	// Cubemap folder with the six faces as .png files, never analyzed
+	TextureHandle loadTextureCube(const std::string& path, UINT placeholder);
+	void release(TextureHandle handle);
+
+	// Once per frame before drawing, uploads the finished decodes that fit in the budget and applies the texture budget
+	// to what was drawn since the last call
+	void update();
+	// The texture is drawn this frame, which keeps its levels resident and brings back the dropped ones
+	void markVisible(TextureHandle handle);
+
+	State getState(TextureHandle handle) const;
+	// The uploaded texture or the levels of it streamed so far, the placeholder until then. nullptr for a released handle.
+	GpuTexture getTexture(TextureHandle handle) const;
+	// True once the texture is uploaded, false if the load failed. The render thread resolves it in update()
+	// and must never wait on it.
+	std::shared_future<bool> getFuture(TextureHandle handle) const;
+	// Finest level of the texture on the GPU, above 0 while it streams in or once the texture budget dropped levels
+	UINT getResidentMip(TextureHandle handle) const;
+	// Channel statistics of the first mip, nullptr unless the texture is ready and could be analyzed
+	const TextureAnalysis* getAnalysis(TextureHandle handle) const;
+	// True once the texture is ready if it was replaced by its mean
+	bool isConstant(TextureHandle handle) const;
+
+	// Textures whose channels all span at most tolerance steps out of 255 are replaced by their mean, negative keeps
+	// them all. Applies to the loads started afterwards.
+	int getConstantTolerance() const { return m_constantTolerance; }
+	void setConstantTolerance(int tolerance) { m_constantTolerance = tolerance; }
+
+	size_t getUploadBudget() const { return m_uploadBudget; }
+	void setUploadBudget(size_t budget_bytes) { m_uploadBudget = budget_bytes; }
+	size_t getPendingUploadBytes() const { return m_uploads.getPendingBytes(); }
+	UINT getLoadingCount() const { return m_loadingCount; }
+	const TextureCacheStats& getCacheStats() const { return m_stats; }
+	const TextureCompressionStats& getCompressionStats() const { return m_compressionStats; }
+	const TextureStreamingStats& getStreamingStats() const { return m_streamingStats; }
+	size_t getTextureBudget() const { return m_residency.getBudget(); }
+	void setTextureBudget(size_t budget_bytes) { m_residency.setBudget(budget_bytes); }
+	const TextureResidency& getResidency() const { return m_residency; }
+
+private:
+	// Face count, format, hash of the mip settings and constant tolerance, normalized path and content hash
+	typedef std::tuple<UINT, UINT, uint64_t, std::string, uint64_t> CacheKey;
+
+	// What a decode job learns about its texture besides the pixels
+	struct DecodeInfo
+	{
+		TextureCompressionStats stats;
+		TextureAnalysis analysis;
+		bool analyzed;
+		bool constant;
+		// Shows the smallest levels of a texture of width x height and mip_count levels ahead of the rest. The decode
+		// calls it with the tail of the chain in its final format before encoding the larger levels.
+		std::function<void(const TextureData& tail, UINT width, UINT height, UINT mip_count)> streamTail;
+		bool tailStreamed;
+	};
+
+	// Runs on a worker with the content hash of the source
+	typedef std::function<bool(uint64_t, TextureData&, DecodeInfo&)> DecodeFunction;
+
+	// GPU texture shared by every handle to the same file
+	struct CachedTexture
+	{
+		CacheKey key;
+		State state;
+		GpuTexture texture;
+		size_t bytes;
+		TextureAnalysis analysis;
+		bool analyzed;
+		bool constant;
+		// Uploaded level by level, finest first visible one
+		bool streaming;
+		UINT residentMip;
+		// Id in the TextureResidency, 0 for textures it doesn't track. Dropped levels come back by running decode again.
+		UINT residencyId;
+		std::vector<size_t> mipBytes;
+		DecodeFunction decode;
+		bool restoring;
+		bool restoreFailed;
+		std::chrono::high_resolution_clock::time_point loadStart;
+		// Handles using it, plus one while its decode is in flight
+		UINT refs;
+		std::vector<TextureHandle> waiting;
+		std::list<CachedTexture*>::iterator unused;
+		bool isUnused;
+	};
+
+	struct Entry
+	{
+		UINT generation;
+		State state;
+		CachedTexture* cached;
+		GpuTexture placeholder;
+		std::chrono::high_resolution_clock::time_point loadStart;
+		std::promise<bool> promise;
+		std::shared_future<bool> future;
+	};
+
+	ResourceManager(const ResourceManager&) = delete;
+	ResourceManager& operator=(const ResourceManager&) = delete;
+
+	TextureHandle load(UINT placeholder, UINT face_count, DXGI_FORMAT format, uint64_t settings_hash, const std::string& path,
+					   std::function<bool(uint64_t&)> hash, DecodeFunction decode);
+	bool decodeTexture(const std::string& filename, DXGI_FORMAT format, const MipSettings& mips, int tolerance, uint64_t content_hash,
+					   TextureData& data, DecodeInfo& info) const;
+	bool decodePackedTexture(const PackedTextureSources& sources, DXGI_FORMAT format, const MipSettings& mips, int tolerance,
+							 uint64_t content_hash, TextureData& data, DecodeInfo& info) const;
+	// Decodes with decode unless the disk cache has the result, then analyzes, generates the mips and compresses.
+	// A constant texture skips the last two.
+	bool buildTexture(const std::function<bool(TextureData&)>& decode, DXGI_FORMAT format, const MipSettings& mips, int tolerance,
+					  uint64_t content_hash, TextureData& data, DecodeInfo& info) const;
+	// Analyzes data and replaces it by a 1x1 texture of its mean if it stays within tolerance. Data that can't be
+	// analyzed is kept as it is.
+	static void collapseConstant(int tolerance, TextureData& data, DecodeInfo& info);
+	// Render thread steps of a load: look the hashed file up in the cache, then upload a decode that missed
+	void resolve(TextureHandle handle, bool hashed, const CacheKey& key, DecodeFunction decode);
+	void finish(CachedTexture* cached, const TextureData* data, const DecodeInfo& info);
+	// Any thread, queues the upload of the tail that starts streaming cached
+	void pushStreamTail(CachedTexture* cached, const TextureData& tail, UINT width, UINT height, UINT mip_count);
+	void beginStream(CachedTexture* cached, const TextureData& tail, UINT width, UINT height, UINT mip_count);
+	void streamMip(CachedTexture* cached, const TextureData& data, UINT mip);
+	void complete(TextureHandle handle, State state);
+	// Render thread steps of the texture budget: apply the changes it decided, then upload the levels a decode restored
+	void applyResidency();
+	void restoreMips(CachedTexture* cached);
+	void finishRestore(CachedTexture* cached, const TextureData* data);
+	void setBytes(CachedTexture* cached, size_t bytes);
+	void ref(CachedTexture* cached);
+	void unref(CachedTexture* cached);
+	void trimUnused();
+	Entry* find(TextureHandle handle);
+	const Entry* find(TextureHandle handle) const;
+	GpuTexture getPlaceholder(UINT color, UINT face_count);
+
+	IResourceDevice& m_device;
+	size_t m_uploadBudget;
+	size_t m_unusedLimit;
+	UploadQueue m_uploads;
+	TextureDiskCache m_diskCache;
+	JobCounter m_jobs;
+	std::vector<Entry> m_entries;
+	std::vector<UINT> m_freeEntries;
+	std::map<CacheKey, CachedTexture*> m_cache;
+	// Unreferenced cached textures, least recently released first
+	std::list<CachedTexture*> m_unused;
+	std::map<std::pair<UINT, UINT>, GpuTexture> m_placeholders;
+	UINT m_loadingCount;
+	int m_constantTolerance;
+	TextureCacheStats m_stats;
+	TextureCompressionStats m_compressionStats;
+	TextureStreamingStats m_streamingStats;
+	TextureResidency m_residency;
+	std::map<UINT, CachedTexture*> m_tracked;
+	UINT m_nextResidencyId;
+	// Frame the visible textures are marked with, update() moves to the next
+	uint64_t m_frame;
+};
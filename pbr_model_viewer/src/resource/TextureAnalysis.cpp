@@ -0,0 +1,100 @@
+#include "TextureAnalysis.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include <Parallel.h>
+#include <resource/BlockCompression.h>
+
+// Texels per job, each job fills histograms of its own before they are merged
+static const size_t min_analysis_texels_per_thread = 1 << 16;
+
+bool TextureAnalysis::isConstant(UINT tolerance) const
+{
+	for (UINT channel = 0; channel < 4; channel++)
+	{
+		if (getRange(channel) > tolerance)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+UINT TextureAnalysis::getMeanColor() const
+{
+	UINT color = 0;
+	for (UINT channel = 0; channel < 4; channel++)
+	{
+		color |= UINT(mean[channel] + 0.5f) << (channel * 8);
+	}
+	return color;
+}
+
+bool analyze_texture(const TextureData& data, TextureAnalysis& analysis)
+{
+	// Only the first mip of the first face is looked at, compressed ones go back to RGBA8 for it
+	TextureData first_mip;
+	first_mip.width = data.width;
+	first_mip.height = data.height;
+	first_mip.faceCount = 1;
+	first_mip.mipCount = 1;
+	first_mip.format = data.format;
+	const TextureData* source = &data;
+	if (data.format != DXGI_FORMAT_R8G8B8A8_UNORM)
+	{
+		TextureData compressed = first_mip;
+		compressed.pixels.assign(data.pixels.begin(), data.pixels.begin() + data.getMipSize(0));
+		if (!decompress_texture(compressed, first_mip))
+		{
+			return false;
+		}
+		source = &first_mip;
+	}
+
+	size_t texel_count = size_t(data.width) * data.height;
+	std::vector<UINT> histograms(4 * 256, 0);
+	std::mutex merge_mutex;
+	parallel_for(texel_count, min_analysis_texels_per_thread, [&](size_t begin, size_t end)
+	{
+		UINT local[4][256] = {};
+		const unsigned char* texels = source->pixels.data();
+		for (size_t texel = begin; texel < end; texel++)
+		{
+			local[0][texels[texel * 4 + 0]]++;
+			local[1][texels[texel * 4 + 1]]++;
+			local[2][texels[texel * 4 + 2]]++;
+			local[3][texels[texel * 4 + 3]]++;
+		}
+		std::lock_guard<std::mutex> lock(merge_mutex);
+		for (UINT channel = 0; channel < 4; channel++)
+		{
+			for (UINT value = 0; value < 256; value++)
+			{
+				histograms[channel * 256 + value] += local[channel][value];
+			}
+		}
+	});
+
+	for (UINT channel = 0; channel < 4; channel++)
+	{
+		const UINT* histogram = histograms.data() + channel * 256;
+		UINT minimum = 255;
+		UINT maximum = 0;
+		UINT most_common = 0;
+		double sum = 0.0;
+		for (UINT value = 0; value < 256; value++)
+		{
+			if (histogram[value] == 0) continue;
+			minimum = std::min(minimum, value);
+			maximum = value;
+			most_common = std::max(most_common, histogram[value]);
+			sum += double(value) * histogram[value];
+		}
+		analysis.minimum[channel] = (unsigned char)minimum;
+		analysis.maximum[channel] = (unsigned char)maximum;
+		analysis.mean[channel] = float(sum / double(texel_count));
+		analysis.uniformity[channel] = float(double(most_common) / double(texel_count));
+	}
+	return true;
+}
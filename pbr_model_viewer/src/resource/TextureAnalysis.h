@@ -0,0 +1,24 @@
+#pragma once
+
+#include <resource/TextureData.h>
+
+// Value distribution of every channel of the first mip of a texture
+struct TextureAnalysis
+{
+	unsigned char minimum[4];
+	unsigned char maximum[4];
+	float mean[4];
+	// Share of the texels holding the most common value of the channel
+	float uniformity[4];
+
+	UINT getRange(UINT channel) const { return UINT(maximum[channel] - minimum[channel]); }
+	// True if no channel spans more than tolerance steps
+	bool isConstant(UINT tolerance) const;
+	// Rounded mean of every channel packed as 0xAABBGGRR
+	UINT getMeanColor() const;
+};
+
+// Histograms every channel of the first mip of the first face over the JobSystem, block compressed textures are
+// decoded first. Returns false for formats it can't read and blocks decode_block can't decode exactly, like BC7 modes
+// other than 6, which would otherwise be analyzed as magenta.
+bool analyze_texture(const TextureData& data, TextureAnalysis& analysis);
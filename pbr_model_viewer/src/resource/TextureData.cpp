@@ -0,0 +1,205 @@
+#include "TextureData.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include <stb_image.h>
+
+#include <Hash.h>
+#include <Parallel.h>
+#include <resource/DdsFile.h>
+#include <resource/KtxFile.h>
+
+static const char* const cube_face_names[6] = { "px", "nx", "py", "ny", "pz", "nz" };
+
+static std::string get_extension(const std::string& filename)
+{
+	size_t dot = filename.find_last_of('.');
+	if (dot == std::string::npos)
+	{
+		return std::string();
+	}
+	std::string extension = filename.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower((unsigned char)c)); });
+	return extension;
+}
+
+size_t TextureData::getMipSize(UINT mip) const
+{
+	return get_image_size(format, getMipWidth(mip), getMipHeight(mip));
+}
+
+size_t TextureData::getFaceSize() const
+{
+	size_t size = 0;
+	for (UINT mip = 0; mip < mipCount; mip++)
+	{
+		size += getMipSize(mip);
+	}
+	return size;
+}
+
+size_t TextureData::getMipOffset(UINT face, UINT mip) const
+{
+	size_t offset = face * getFaceSize();
+	for (UINT level = 0; level < mip; level++)
+	{
+		offset += getMipSize(level);
+	}
+	return offset;
+}
+
+UINT get_block_size(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC4_UNORM:
+		return 8;
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC7_UNORM:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t get_row_pitch(DXGI_FORMAT format, UINT width)
+{
+	UINT block_size = get_block_size(format);
+	if (block_size > 0)
+	{
+		return size_t((width + 3) / 4) * block_size;
+	}
+	return size_t(width) * 4;
+}
+
+size_t get_image_size(DXGI_FORMAT format, UINT width, UINT height)
+{
+	UINT rows = get_block_size(format) > 0 ? (height + 3) / 4 : height;
+	return get_row_pitch(format, width) * rows;
+}
+
+UINT get_full_mip_count(UINT width, UINT height)
+{
+	UINT mip_count = 1;
+	while (width > 1 || height > 1)
+	{
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		mip_count++;
+	}
+	return mip_count;
+}
+
+bool decode_texture(const std::string& filename, TextureData& data)
+{
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		return false;
+	}
+	data.width = UINT(width);
+	data.height = UINT(height);
+	data.faceCount = 1;
+	data.mipCount = 1;
+	data.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	data.pixels.assign(pixels, pixels + data.getFaceSize());
+	stbi_image_free(pixels);
+	return true;
+}
+
+bool is_texture_container(const std::string& filename)
+{
+	std::string extension = get_extension(filename);
+	return extension == "dds" || extension == "ktx2";
+}
+
+bool read_texture_container(const std::string& filename, TextureData& data)
+{
+	std::string extension = get_extension(filename);
+	if (extension == "dds")
+	{
+		return read_dds(filename, data);
+	}
+	if (extension == "ktx2")
+	{
+		return read_ktx2(filename, data);
+	}
+	return false;
+}
+
+bool decode_texture_cube(const std::string& path, TextureData& data)
+{
+	TextureData faces[6];
+	bool decoded[6] = {};
+	parallel_for(6, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t face = begin; face < end; face++)
+		{
+			decoded[face] = decode_texture(path + "\\" + cube_face_names[face] + ".png", faces[face]);
+		}
+	});
+
+	for (UINT face = 0; face < 6; face++)
+	{
+		if (!decoded[face] || faces[face].width != faces[0].width || faces[face].height != faces[0].height)
+		{
+			return false;
+		}
+	}
+	data.width = faces[0].width;
+	data.height = faces[0].height;
+	data.faceCount = 6;
+	data.mipCount = 1;
+	data.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	data.pixels.resize(data.getFaceSize() * 6);
+	for (UINT face = 0; face < 6; face++)
+	{
+		memcpy(data.pixels.data() + data.getMipOffset(face, 0), faces[face].pixels.data(), data.getFaceSize());
+	}
+	return true;
+}
+
+bool hash_texture_cube(const std::string& path, uint64_t& hash)
+{
+	hash = 0;
+	for (const char* face_name : cube_face_names)
+	{
+		uint64_t face_hash;
+		if (!hash_file(path + "\\" + face_name + ".png", face_hash))
+		{
+			return false;
+		}
+		hash = hash_combine(hash, face_hash);
+	}
+	return true;
+}
+
+void make_solid_texture(UINT color, UINT face_count, TextureData& data)
+{
+	data.width = 1;
+	data.height = 1;
+	data.faceCount = face_count;
+	data.mipCount = 1;
+	data.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	data.pixels.resize(size_t(4) * face_count);
+	for (UINT face = 0; face < face_count; face++)
+	{
+		memcpy(data.pixels.data() + face * 4, &color, 4);
+	}
+}
+
+void extract_mips(const TextureData& data, UINT first_mip, TextureData& tail)
+{
+	tail.width = data.getMipWidth(first_mip);
+	tail.height = data.getMipHeight(first_mip);
+	tail.faceCount = 1;
+	tail.mipCount = data.mipCount - first_mip;
+	tail.format = data.format;
+	const unsigned char* begin = data.pixels.data() + data.getMipOffset(0, first_mip);
+	tail.pixels.assign(begin, begin + tail.getFaceSize());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <d3d11.h>
+
+// Texture waiting for upload. Every mip of the first face from the largest down, then the same for the next face.
+struct TextureData
+{
+	UINT width;
+	UINT height;
+	UINT faceCount;
+	UINT mipCount;
+	DXGI_FORMAT format;
+	std::vector<unsigned char> pixels;
+
+	UINT getMipWidth(UINT mip) const { return width >> mip > 0 ? width >> mip : 1; }
+	UINT getMipHeight(UINT mip) const { return height >> mip > 0 ? height >> mip : 1; }
+	size_t getMipSize(UINT mip) const;
+	// Bytes of a face with all its mips
+	size_t getFaceSize() const;
+	size_t getMipOffset(UINT face, UINT mip) const;
+};
+
+// Bytes of a 4x4 block of a block compressed format, 0 for the others
+UINT get_block_size(DXGI_FORMAT format);
+// Bytes of a row of pixels, or of blocks for block compressed formats
+size_t get_row_pitch(DXGI_FORMAT format, UINT width);
+size_t get_image_size(DXGI_FORMAT format, UINT width, UINT height);
+// Number of levels of a full mip chain down to 1x1
+UINT get_full_mip_count(UINT width, UINT height);
+
+// Decodes an image file to RGBA8, returns false if it can't be read
+bool decode_texture(const std::string& filename, TextureData& data);
+
+// True for .dds and .ktx2 files, which already hold the format and mips to upload
+bool is_texture_container(const std::string& filename);
+// Reads a .dds or .ktx2 file as stored, returns false if it can't be read or isn't supported
+bool read_texture_container(const std::string& filename, TextureData& data);
+
+// Decodes the px, nx, py, ny, pz and nz .png faces of a cubemap folder in parallel,
+// returns false if a face can't be read or the faces differ in size
+bool decode_texture_cube(const std::string& path, TextureData& data);
+
+// Combined content hash of the six face files of a cubemap folder, returns false if a face can't be read
+bool hash_texture_cube(const std::string& path, uint64_t& hash);
+
+// 1x1 texture of a single color packed as 0xAABBGGRR, with face_count identical faces
+void make_solid_texture(UINT color, UINT face_count, TextureData& data);
+
+// Levels of the first face from first_mip down, as a texture of their own
+void extract_mips(const TextureData& data, UINT first_mip, TextureData& tail);
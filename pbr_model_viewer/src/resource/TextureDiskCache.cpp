@@ -0,0 +1,35 @@
+#include "TextureDiskCache.h"
+
+#include <cstdio>
+
+#include <Windows.h>
+
+#include <Hash.h>
+#include <resource/DdsFile.h>
+
+// Bump whenever the encoders or the mip generation change their output
+static const uint64_t texture_cache_version = 2;
+
+TextureDiskCache::TextureDiskCache(const std::string& directory)
+	: m_directory(directory)
+{
+}
+
+bool TextureDiskCache::load(uint64_t content_hash, DXGI_FORMAT format, TextureData& data) const
+{
+	return read_dds(getPath(content_hash, format), data) && data.format == format;
+}
+
+bool TextureDiskCache::store(uint64_t content_hash, const TextureData& data) const
+{
+	CreateDirectoryA(m_directory.c_str(), nullptr);
+	return write_dds(getPath(content_hash, data.format), data);
+}
+
+std::string TextureDiskCache::getPath(uint64_t content_hash, DXGI_FORMAT format) const
+{
+	uint64_t key = hash_combine(hash_combine(content_hash, uint64_t(format)), texture_cache_version);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.dds", (unsigned long long)key);
+	return m_directory + "\\" + name;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <resource/TextureData.h>
+
+// On disk cache of block compressed textures. Entries are DDS files keyed by a hash of the source file content and
+// anything else that changes the output, and the target format, so later loads of the same image skip the
+// compression. Safe to use from any thread.
+class TextureDiskCache
+{
+public:
+	explicit TextureDiskCache(const std::string& directory);
+
+	bool load(uint64_t content_hash, DXGI_FORMAT format, TextureData& data) const;
+	bool store(uint64_t content_hash, const TextureData& data) const;
+
+private:
+	std::string getPath(uint64_t content_hash, DXGI_FORMAT format) const;
+
+	std::string m_directory;
+};
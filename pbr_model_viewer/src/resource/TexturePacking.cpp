@@ -0,0 +1,133 @@
+#include "TexturePacking.h"
+
+#include <cstring>
+
+#include <emmintrin.h>
+
+#include <Hash.h>
+#include <Parallel.h>
+
+// Pixels per job when packing
+static const size_t min_pack_pixels_per_thread = 1 << 16;
+
+UINT PackedTextureSources::getFileCount() const
+{
+	UINT count = 0;
+	for (const std::string& filename : filenames)
+	{
+		if (!filename.empty()) count++;
+	}
+	return count;
+}
+
+bool pack_channels(const TextureData* const sources[4], UINT fallback, TextureData& packed)
+{
+	const TextureData* first = nullptr;
+	for (UINT channel = 0; channel < 4; channel++)
+	{
+		const TextureData* source = sources[channel];
+		if (!source) continue;
+		if (source->format != DXGI_FORMAT_R8G8B8A8_UNORM || source->faceCount != 1 || source->mipCount != 1 ||
+			(first && (source->width != first->width || source->height != first->height)))
+		{
+			return false;
+		}
+		if (!first) first = source;
+	}
+	if (!first)
+	{
+		return false;
+	}
+
+	packed.width = first->width;
+	packed.height = first->height;
+	packed.faceCount = 1;
+	packed.mipCount = 1;
+	packed.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	packed.pixels.resize(packed.getFaceSize());
+
+	// The fallback bytes of the channels without a source, the others are filled from the red bytes of theirs
+	UINT constant = fallback;
+	for (UINT channel = 0; channel < 4; channel++)
+	{
+		if (sources[channel]) constant &= ~(0xFFu << (channel * 8));
+	}
+
+	size_t pixel_count = size_t(packed.width) * packed.height;
+	parallel_for(pixel_count, min_pack_pixels_per_thread, [&](size_t begin, size_t end)
+	{
+		const __m128i red_mask = _mm_set1_epi32(0xFF);
+		const __m128i constant_pixels = _mm_set1_epi32(int(constant));
+		size_t pixel = begin;
+		// Four pixels at a time, a source's red bytes masked out and shifted into place
+		for (; pixel + 4 <= end; pixel += 4)
+		{
+			__m128i result = constant_pixels;
+			for (UINT channel = 0; channel < 4; channel++)
+			{
+				if (!sources[channel]) continue;
+				__m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sources[channel]->pixels.data() + pixel * 4));
+				__m128i red = _mm_and_si128(source, red_mask);
+				switch (channel)
+				{
+				case 0: break;
+				case 1: red = _mm_slli_epi32(red, 8); break;
+				case 2: red = _mm_slli_epi32(red, 16); break;
+				default: red = _mm_slli_epi32(red, 24); break;
+				}
+				result = _mm_or_si128(result, red);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(packed.pixels.data() + pixel * 4), result);
+		}
+		for (; pixel < end; pixel++)
+		{
+			unsigned char* out = packed.pixels.data() + pixel * 4;
+			memcpy(out, &constant, 4);
+			for (UINT channel = 0; channel < 4; channel++)
+			{
+				if (sources[channel]) out[channel] = sources[channel]->pixels[pixel * 4];
+			}
+		}
+	});
+	return true;
+}
+
+bool decode_packed_texture(const PackedTextureSources& sources, TextureData& packed)
+{
+	TextureData decoded[4];
+	bool failed[4] = {};
+	parallel_for(4, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t channel = begin; channel < end; channel++)
+		{
+			const std::string& filename = sources.filenames[channel];
+			failed[channel] = !filename.empty() && !decode_texture(filename, decoded[channel]);
+		}
+	});
+
+	const TextureData* channels[4] = {};
+	for (UINT channel = 0; channel < 4; channel++)
+	{
+		if (failed[channel])
+		{
+			return false;
+		}
+		if (!sources.filenames[channel].empty()) channels[channel] = &decoded[channel];
+	}
+	return pack_channels(channels, sources.fallback, packed);
+}
+
+bool hash_packed_texture(const PackedTextureSources& sources, uint64_t& hash)
+{
+	hash = hash_combine(0, sources.fallback);
+	for (const std::string& filename : sources.filenames)
+	{
+		uint64_t file_hash = 0;
+		if (!filename.empty() && !hash_file(filename, file_hash))
+		{
+			return false;
+		}
+		hash = hash_combine(hash, file_hash);
+	}
+	return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <resource/TextureData.h>
+
+// Single channel maps packed into the channels of one texture, like occlusion, roughness and metallic into an ORM
+// texture. Each channel takes the red channel of its file, channels without a file keep the value of fallback,
+// a color packed as 0xAABBGGRR.
+struct PackedTextureSources
+{
+	std::string filenames[4];
+	UINT fallback;
+
+	UINT getFileCount() const;
+};
+
+// Copies the red channel of every source into its channel of packed, the others get the channel of fallback.
+// Sources are single mip RGBA8 textures of the same size, null for the fallback channels.
+// Returns false if no source is given or their sizes differ.
+bool pack_channels(const TextureData* const sources[4], UINT fallback, TextureData& packed);
+
+// Decodes the files of sources in parallel and packs them, returns false if a file can't be read or the sizes differ
+bool decode_packed_texture(const PackedTextureSources& sources, TextureData& packed);
+
+// Combined content hash of the files of sources and the fallback, returns false if a file can't be read
+bool hash_packed_texture(const PackedTextureSources& sources, uint64_t& hash);
@@ -0,0 +1,156 @@
+#include "TextureResidency.h"
+
+TextureResidency::TextureResidency(size_t budget_bytes)
+	: m_budget(budget_bytes)
+	, m_residentBytes(0)
+	, m_totalBytes(0)
+{
+}
+
+size_t TextureResidency::getBytesFrom(const Texture& texture, UINT first_mip)
+{
+	size_t bytes = 0;
+	for (UINT mip = first_mip; mip < texture.mipBytes.size(); mip++)
+	{
+		bytes += texture.mipBytes[mip];
+	}
+	return bytes;
+}
+
+void TextureResidency::add(UINT id, const std::vector<size_t>& mip_bytes, UINT max_first_mip, uint64_t frame)
+{
+	remove(id);
+	Texture& texture = m_textures[id];
+	texture.mipBytes = mip_bytes;
+	texture.firstMip = 0;
+	texture.maxFirstMip = max_first_mip;
+	texture.lastVisible = frame;
+	size_t bytes = getBytesFrom(texture, 0);
+	m_residentBytes += bytes;
+	m_totalBytes += bytes;
+}
+
+void TextureResidency::remove(UINT id)
+{
+	auto found = m_textures.find(id);
+	if (found == m_textures.end())
+	{
+		return;
+	}
+	m_residentBytes -= getBytesFrom(found->second, found->second.firstMip);
+	m_totalBytes -= getBytesFrom(found->second, 0);
+	m_textures.erase(found);
+}
+
+void TextureResidency::touch(UINT id, uint64_t frame)
+{
+	auto found = m_textures.find(id);
+	if (found != m_textures.end())
+	{
+		found->second.lastVisible = frame;
+	}
+}
+
+void TextureResidency::setFirstMip(UINT id, UINT first_mip)
+{
+	auto found = m_textures.find(id);
+	if (found == m_textures.end())
+	{
+		return;
+	}
+	Texture& texture = found->second;
+	m_residentBytes -= getBytesFrom(texture, texture.firstMip);
+	texture.firstMip = first_mip;
+	m_residentBytes += getBytesFrom(texture, texture.firstMip);
+}
+
+UINT TextureResidency::getFirstMip(UINT id) const
+{
+	auto found = m_textures.find(id);
+	return found != m_textures.end() ? found->second.firstMip : 0;
+}
+
+bool TextureResidency::evictOne(uint64_t before_frame, std::map<UINT, UINT>& original)
+{
+	// Ties go to the texture that has the most to give
+	Texture* victim = nullptr;
+	UINT victim_id = 0;
+	for (auto& it : m_textures)
+	{
+		Texture& texture = it.second;
+		if (texture.lastVisible >= before_frame || texture.firstMip >= texture.maxFirstMip)
+		{
+			continue;
+		}
+		if (!victim || texture.lastVisible < victim->lastVisible ||
+			(texture.lastVisible == victim->lastVisible && texture.mipBytes[texture.firstMip] > victim->mipBytes[victim->firstMip]))
+		{
+			victim = &texture;
+			victim_id = it.first;
+		}
+	}
+	if (!victim)
+	{
+		return false;
+	}
+	original.insert({ victim_id, victim->firstMip });
+	m_residentBytes -= victim->mipBytes[victim->firstMip];
+	victim->firstMip++;
+	return true;
+}
+
+size_t TextureResidency::getEvictableBytes(uint64_t before_frame) const
+{
+	size_t bytes = 0;
+	for (const auto& it : m_textures)
+	{
+		const Texture& texture = it.second;
+		if (texture.lastVisible < before_frame && texture.firstMip < texture.maxFirstMip)
+		{
+			bytes += getBytesFrom(texture, texture.firstMip) - getBytesFrom(texture, texture.maxFirstMip);
+		}
+	}
+	return bytes;
+}
+
+void TextureResidency::update(uint64_t frame, std::vector<Change>& changes)
+{
+	std::map<UINT, UINT> original;
+	while (m_residentBytes > m_budget && evictOne(frame + 1, original))
+	{
+	}
+
+	for (auto& it : m_textures)
+	{
+		Texture& texture = it.second;
+		if (texture.lastVisible != frame)
+		{
+			continue;
+		}
+		while (texture.firstMip > 0)
+		{
+			// Evicting only when it makes room, otherwise the levels would be dropped for nothing
+			size_t needed = texture.mipBytes[texture.firstMip - 1];
+			if (m_residentBytes + needed > m_budget + getEvictableBytes(frame))
+			{
+				break;
+			}
+			while (m_residentBytes + needed > m_budget && evictOne(frame, original))
+			{
+			}
+			original.insert({ it.first, texture.firstMip });
+			m_residentBytes += needed;
+			texture.firstMip--;
+		}
+	}
+
+	// A texture evicted then restored within the frame didn't change
+	for (auto& it : original)
+	{
+		UINT first_mip = m_textures[it.first].firstMip;
+		if (first_mip != it.second)
+		{
+			changes.push_back({ it.first, first_mip });
+		}
+	}
+}
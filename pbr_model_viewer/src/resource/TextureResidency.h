@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <d3d11.h>
+
+// Keeps textures within a byte budget by dropping their largest mips, from the least recently visible texture first, and
+// gives visible textures their mips back while they fit. Only decides, the owner applies the changes. Needs no GPU, so
+// it can be driven by a recorded or synthetic access trace.
+class TextureResidency
+{
+public:
+	// Texture whose resident levels changed, they now go from firstMip down
+	struct Change
+	{
+		UINT id;
+		UINT firstMip;
+	};
+
+	explicit TextureResidency(size_t budget_bytes);
+
+	// mip_bytes holds the bytes of every level from the largest down. Levels from max_first_mip down are never dropped.
+	// Starts fully resident and counts as visible in frame.
+	void add(UINT id, const std::vector<size_t>& mip_bytes, UINT max_first_mip, uint64_t frame);
+	void remove(UINT id);
+	// The texture was drawn in frame
+	void touch(UINT id, uint64_t frame);
+	// Puts the resident levels back to what the texture actually has, when applying a change failed
+	void setFirstMip(UINT id, UINT first_mip);
+
+	// Once per frame after its touches. Over budget the least recently visible textures lose their largest level until
+	// it fits, the ones visible in frame last. Then the textures visible in frame get back as many levels as fit by
+	// evicting the ones that weren't. Appends a change per texture whose levels moved.
+	void update(uint64_t frame, std::vector<Change>& changes);
+
+	UINT getFirstMip(UINT id) const;
+	size_t getBudget() const { return m_budget; }
+	void setBudget(size_t budget_bytes) { m_budget = budget_bytes; }
+	size_t getResidentBytes() const { return m_residentBytes; }
+	// Bytes the dropped levels would take back
+	size_t getEvictedBytes() const { return m_totalBytes - m_residentBytes; }
+	UINT getTextureCount() const { return UINT(m_textures.size()); }
+
+private:
+	struct Texture
+	{
+		std::vector<size_t> mipBytes;
+		UINT firstMip;
+		UINT maxFirstMip;
+		uint64_t lastVisible;
+	};
+
+	static size_t getBytesFrom(const Texture& texture, UINT first_mip);
+	// Drops the largest level of the least recently visible texture seen before frame that has one to drop, returns
+	// false if there is none. Textures first changed get their first mip recorded in original.
+	bool evictOne(uint64_t before_frame, std::map<UINT, UINT>& original);
+	// Bytes evictOne could still drop from the textures seen before frame
+	size_t getEvictableBytes(uint64_t before_frame) const;
+
+	std::map<UINT, Texture> m_textures;
+	size_t m_budget;
+	size_t m_residentBytes;
+	size_t m_totalBytes;
+};
@@ -0,0 +1,48 @@
+#include "UploadQueue.h"
+
+UploadQueue::UploadQueue()
+	: m_pendingBytes(0)
+{
+}
+
+void UploadQueue::push(size_t bytes, UploadFunction upload)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_uploads.push_back({ bytes, std::move(upload) });
+	m_pendingBytes += bytes;
+}
+
+size_t UploadQueue::drain(size_t budget_bytes)
+{
+	size_t uploaded = 0;
+	while (true)
+	{
+		Upload next;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_uploads.empty() || (uploaded > 0 && uploaded + m_uploads.front().bytes > budget_bytes))
+			{
+				break;
+			}
+			next = std::move(m_uploads.front());
+			m_uploads.pop_front();
+			m_pendingBytes -= next.bytes;
+		}
+		// Run outside the lock, workers keep pushing while the GPU work happens
+		next.upload();
+		uploaded += next.bytes;
+	}
+	return uploaded;
+}
+
+size_t UploadQueue::getPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_uploads.size();
+}
+
+size_t UploadQueue::getPendingBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pendingBytes;
+}
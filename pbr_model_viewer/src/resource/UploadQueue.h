@@ -0,0 +1,38 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Finished CPU payloads waiting for the GPU. Worker threads push them, the render thread drains a byte budget per frame
+// so a burst of finished loads is spread over several frames instead of hitching one.
+class UploadQueue
+{
+public:
+	typedef std::function<void()> UploadFunction;
+
+	UploadQueue();
+
+	// Any thread. bytes is what running upload costs against the budget.
+	void push(size_t bytes, UploadFunction upload);
+	// Render thread. Runs the queued uploads in order until the next one would go over budget_bytes. The first one always
+	// runs, so a payload bigger than the whole budget still goes through on its own frame. Returns the bytes uploaded.
+	size_t drain(size_t budget_bytes);
+
+	size_t getPendingCount() const;
+	size_t getPendingBytes() const;
+
+private:
+	struct Upload
+	{
+		size_t bytes;
+		UploadFunction upload;
+	};
+
+	UploadQueue(const UploadQueue&) = delete;
+	UploadQueue& operator=(const UploadQueue&) = delete;
+
+	mutable std::mutex m_mutex;
+	std::deque<Upload> m_uploads;
+	size_t m_pendingBytes;
+};
@@ -0,0 +1,38 @@
+cbuffer perspective : register(b0) {
+	matrix projection;
+};
+
+cbuffer camera_position : register(b1) {
+	float4 cam_pos;
+};
+
+cbuffer dequantization : register(b2) {
+	float4 bounds_center;
+	float4 bounds_extent;
+};
+
+float3 decode_octahedral(float2 e)
+{
+    float3 v = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+
+// Same outputs as mesh_vs.hlsl, decoding the CompactVertex layout
+void main(float4 pos : POSITION, float2 normal : NORMAL, float2 tangent : TANGENT, float2 uvs : TEXCOORDS,
+			out float4 out_pos : SV_POSITION, out float3 out_cam_pos : POSITION0, out float3 out_world_pos : POSITION1, out float3 out_normal : NORMAL0, out float2 out_uvs : TEXCOORDS, out float3 out_tangent : TANGENT, out float3 out_bitangent : BITANGENT)
+{
+    float3 world_pos = bounds_center.xyz + pos.xyz * bounds_extent.xyz;
+    float3 N = decode_octahedral(normal);
+    float3 T = decode_octahedral(tangent);
+    float handedness = pos.w < 0.0f ? -1.0f : 1.0f;
+
+	out_pos = mul(float4(world_pos, 1.0f), projection);
+    out_cam_pos = cam_pos.xyz;
+    out_world_pos = world_pos;
+    out_normal = N;
+    out_uvs = uvs;
+    out_tangent = T;
+    out_bitangent = cross(N, T) * handedness;
+}
@@ -3,10 +3,20 @@ static const float PI = 3.14159265359;
 SamplerState tex_sampler : register(s0);
 Texture2D albedo_tex : register(t0);
 Texture2D normal_tex : register(t1);
-Texture2D metallic_tex : register(t2);
-Texture2D roughness_tex : register(t3);
+// Occlusion, roughness and metallic packed in rgb
+Texture2D orm_tex : register(t2);
 TextureCube cubemap_tex : register(t4);
 
+// A map that isn't loaded or is constant has no texture bound, its factor stands in for every texel
+cbuffer MaterialConstants : register(b0)
+{
+    float4 albedo_factor;
+    float4 normal_factor;
+    float4 orm_factor;
+    // Albedo, normal and ORM, non zero when the texture is sampled
+    uint4 use_texture;
+};
+
 float ggx(float3 N, float3 H, float roughness)
 {
     float a = roughness * roughness;
@@ -49,25 +59,34 @@ float3 fresnelSchlick(float cosTheta, float3 F0)
 float4 main(float4 pos : SV_POSITION, float3 cam_pos : POSITION0, float3 world_pos : POSITION1, float3 normal : NORMAL0, float2 uvs : TEXCOORDS, float3 tangent : TANGENT, float3 bitangent : BITANGENT) : SV_Target
 {
     float2 UV = float2(uvs.x, 1.0 - uvs.y);
-    float3 albedo = albedo_tex.Sample(tex_sampler, UV).rgb;
+    // Branches instead of ternaries, which would sample either way
+    float3 albedo = albedo_factor.rgb;
+    [branch] if (use_texture.x) albedo = albedo_tex.Sample(tex_sampler, UV).rgb;
     albedo = pow(albedo, 2);
-    float metallic = metallic_tex.Sample(tex_sampler, UV).r;
-    float roughness = roughness_tex.Sample(tex_sampler, UV).r;
+    float3 orm = orm_factor.rgb;
+    [branch] if (use_texture.z) orm = orm_tex.Sample(tex_sampler, UV).rgb;
+    float occlusion = orm.r;
+    float roughness = orm.g;
+    float metallic = orm.b;
     
     float3 lightColor = float3(1.0, 1.0, 1.0);
     float3 L = normalize(float3(1.0, 1.0, 1.0));
     float3 V = normalize(cam_pos - world_pos);
     float3 H = normalize(L + V);
-    float3 T = normalize(tangent);
-    float3 B = normalize(cross(normal, tangent));
+    // MikkTSpace frame as the baker decodes it: the bitangent is rebuilt per pixel from the interpolated normal and
+    // tangent, and none of the three is normalized before the sample is applied. The interpolated bitangent only
+    // carries the handedness.
+    float handedness = dot(cross(normal, tangent), bitangent) < 0.0 ? -1.0 : 1.0;
+    float3 B = handedness * cross(normal, tangent);
     float3 N = normalize(normal);
-    float3 sampled_N = normal_tex.Sample(tex_sampler, UV).xyz;
-    if ( length( sampled_N ) != 0.0 )
+    // Only xy is read so BC5 normal maps work, z is rebuilt. The black placeholder means no normal map.
+    float2 sampled_xy = normal_factor.xy;
+    [branch] if (use_texture.y) sampled_xy = normal_tex.Sample(tex_sampler, UV).xy;
+    if ( length( sampled_xy ) != 0.0 )
     {
-        float3x3 TBN = float3x3( T, B, N );
-        TBN = transpose( TBN ); // Transpose because float3x3() takes row vectors
-        sampled_N = normalize( sampled_N * 2.0 - 1.0 );
-        N = normalize( mul( TBN, sampled_N ) );
+        sampled_xy = sampled_xy * 2.0 - 1.0;
+        float3 sampled_N = float3( sampled_xy, sqrt( saturate( 1.0 - dot( sampled_xy, sampled_xy ) ) ) );
+        N = normalize( sampled_N.x * tangent + sampled_N.y * B + sampled_N.z * normal );
     }
     
     float NdotL = max(dot(N, L), 0.0);
@@ -94,7 +113,7 @@ float4 main(float4 pos : SV_POSITION, float3 cam_pos : POSITION0, float3 world_p
     float3 diffuse = albedo;
     
     float3 col = (kD * diffuse / PI + specular) * direct_light * NdotL;
-    float3 ambient = float3(0.03, 0.03, 0.03) * diffuse;
+    float3 ambient = float3(0.03, 0.03, 0.03) * diffuse * occlusion;
     col = ambient + col;
     col = col / (col + float3(1.0, 1.0, 1.0));
     col = sqrt(col);
@@ -0,0 +1,185 @@
+// Block compression quality and speed: PSNR floors per format on a smooth and a noisy image, exact blocks for solid
+// colors, decompress_texture agreeing with decode_block, BC7 modes it can't decode being reported, and the sizes and
+// formats compress_texture must reject.
+// Prints PSNR and MPix/s per format; pass an image size to benchmark.
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include <resource/BlockCompression.h>
+#include <resource/MipGenerator.h>
+
+#include "TestUtils.h"
+
+static TextureData make_image(UINT size, bool noisy)
+{
+	TextureData data;
+	data.width = size;
+	data.height = size;
+	data.faceCount = 1;
+	data.mipCount = 1;
+	data.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	data.pixels.resize(size * size * 4);
+	std::mt19937 rng(size);
+	for (UINT y = 0; y < size; y++)
+	{
+		for (UINT x = 0; x < size; x++)
+		{
+			unsigned char* p = &data.pixels[(y * size + x) * 4];
+			int noise = noisy ? int(rng() % 64) - 32 : 0;
+			auto clamp = [](int value) { return (unsigned char)std::max(0, std::min(255, value)); };
+			p[0] = clamp(int(128 + 100 * std::sin(x * 0.02)) + noise);
+			p[1] = clamp(int(128 + 90 * std::cos(y * 0.03 + x * 0.01)) + noise);
+			p[2] = clamp(int((x + y) * 255 / (2 * size)) + noise);
+			p[3] = clamp(int(x * 255 / size));
+		}
+	}
+	generate_mips(data, MipSettings());
+	return data;
+}
+
+struct FormatCase
+{
+	DXGI_FORMAT format;
+	const char* name;
+	double minSmoothPsnr;
+	double minNoisyPsnr;
+};
+
+static const FormatCase format_cases[] = {
+	{ DXGI_FORMAT_BC1_UNORM, "BC1", 37.0, 32.0 },
+	{ DXGI_FORMAT_BC3_UNORM, "BC3", 38.0, 33.0 },
+	{ DXGI_FORMAT_BC4_UNORM, "BC4", 55.0, 40.0 },
+	{ DXGI_FORMAT_BC5_UNORM, "BC5", 50.0, 40.0 },
+	{ DXGI_FORMAT_BC7_UNORM, "BC7", 40.0, 38.0 },
+};
+
+static void test_quality(UINT size)
+{
+	for (bool noisy : { false, true })
+	{
+		TextureData source = make_image(size, noisy);
+		double megapixels = 0.0;
+		for (UINT mip = 0; mip < source.mipCount; mip++)
+		{
+			megapixels += double(source.getMipWidth(mip)) * source.getMipHeight(mip) / 1e6;
+		}
+		for (const FormatCase& format_case : format_cases)
+		{
+			TextureData compressed;
+			Timer timer;
+			CHECK(compress_texture(source, format_case.format, compressed));
+			double ms = timer.elapsedMs();
+			CHECK(compressed.format == format_case.format);
+			CHECK(compressed.width == size && compressed.height == size && compressed.mipCount <= source.mipCount);
+
+			double psnr = compute_psnr(source, compressed);
+			std::printf("%s %s %ux%u: %.2f dB, %.1f MPix/s\n", format_case.name, noisy ? "noisy" : "smooth", size, size, psnr, megapixels * 1000.0 / ms);
+			CHECK(psnr >= (noisy ? format_case.minNoisyPsnr : format_case.minSmoothPsnr));
+
+			// decompress_texture is decode_block over every block
+			TextureData decompressed;
+			CHECK(decompress_texture(compressed, decompressed));
+			CHECK(decompressed.format == DXGI_FORMAT_R8G8B8A8_UNORM);
+			unsigned char pixels[64];
+			CHECK(decode_block(compressed.format, compressed.pixels.data(), pixels));
+			for (UINT row = 0; row < 4; row++)
+			{
+				CHECK(std::memcmp(pixels + row * 16, decompressed.pixels.data() + row * size * 4, 16) == 0);
+			}
+		}
+	}
+}
+
+// A solid block must come back exactly for the channels each format keeps, where the endpoint precision allows it
+static void test_solid_blocks()
+{
+	std::mt19937 rng(5);
+	for (int i = 0; i < 200; i++)
+	{
+		unsigned char color[4] = { (unsigned char)rng(), (unsigned char)rng(), (unsigned char)rng(), (unsigned char)rng() };
+		unsigned char pixels[64];
+		for (int p = 0; p < 16; p++)
+		{
+			std::memcpy(pixels + p * 4, color, 4);
+		}
+		unsigned char block[16];
+		unsigned char decoded[64];
+
+		encode_bc4_block(pixels, 0, block);
+		decode_block(DXGI_FORMAT_BC4_UNORM, block, decoded);
+		CHECK(decoded[0] == color[0] && decoded[15 * 4] == color[0]);
+
+		encode_bc5_block(pixels, block);
+		decode_block(DXGI_FORMAT_BC5_UNORM, block, decoded);
+		CHECK(decoded[0] == color[0] && decoded[1] == color[1]);
+
+		encode_bc3_block(pixels, block);
+		decode_block(DXGI_FORMAT_BC3_UNORM, block, decoded);
+		CHECK(decoded[3] == color[3]);
+
+		// 7 bit endpoints plus a shared bit and 4 bit weights, off by at most one step
+		encode_bc7_block(pixels, block);
+		decode_block(DXGI_FORMAT_BC7_UNORM, block, decoded);
+		for (int c = 0; c < 4; c++)
+		{
+			CHECK(std::abs(int(decoded[c]) - int(color[c])) <= 1);
+		}
+
+		// 565 endpoints, but interpolation reaches every 8 bit value within a few steps
+		encode_bc1_block(pixels, block);
+		decode_block(DXGI_FORMAT_BC1_UNORM, block, decoded);
+		for (int c = 0; c < 3; c++)
+		{
+			CHECK(std::abs(int(decoded[c]) - int(color[c])) <= 4);
+		}
+	}
+}
+
+// BC7 blocks of other modes than 6 can't be decoded exactly, which decode_block and decompress_texture report
+static void test_unknown_bc7_modes()
+{
+	unsigned char pixels[64];
+	for (int mode = 0; mode < 8; mode++)
+	{
+		unsigned char block[16] = { (unsigned char)(1 << mode) };
+		CHECK(decode_block(DXGI_FORMAT_BC7_UNORM, block, pixels) == (mode == 6));
+	}
+	unsigned char reserved[16] = {};
+	CHECK(!decode_block(DXGI_FORMAT_BC7_UNORM, reserved, pixels));
+	CHECK(!decode_block(DXGI_FORMAT_R8G8B8A8_UNORM, reserved, pixels));
+
+	TextureData source = make_image(16, false);
+	TextureData compressed;
+	CHECK(compress_texture(source, DXGI_FORMAT_BC7_UNORM, compressed));
+	TextureData decompressed;
+	CHECK(decompress_texture(compressed, decompressed));
+	// One mode 5 block in the last mip is enough
+	compressed.pixels[compressed.getMipOffset(0, compressed.mipCount - 1)] = 0x20;
+	CHECK(!decompress_texture(compressed, decompressed));
+	CHECK(compute_psnr(source, compressed) == 0.0);
+}
+
+static void test_rejected()
+{
+	TextureData odd = make_image(64, false);
+	TextureData compressed;
+	CHECK(!compress_texture(odd, DXGI_FORMAT_R8G8B8A8_UNORM, compressed));
+	CHECK(!compress_texture(odd, DXGI_FORMAT_BC2_UNORM, compressed));
+
+	odd.width = 6;
+	odd.height = 6;
+	odd.mipCount = 1;
+	odd.pixels.assign(6 * 6 * 4, 0);
+	CHECK(!compress_texture(odd, DXGI_FORMAT_BC1_UNORM, compressed));
+}
+
+int main(int argc, char** argv)
+{
+	test_quality((UINT)get_size_arg(argc, argv, 256));
+	test_solid_blocks();
+	test_unknown_bc7_modes();
+	test_rejected();
+	return 0;
+}
@@ -0,0 +1,62 @@
+// Boundary cases of the 16 bit index path: 65535 still fits, 65536 doesn't, wherever it sits
+// (SSE blocks or scalar tail), and narrowing keeps the values around the sign bit of the signed pack.
+
+#include <cstdint>
+#include <vector>
+
+#include <mesh/IndexNarrowing.h>
+
+#include "TestUtils.h"
+
+int main()
+{
+	CHECK(fits_16bit_indices(nullptr, 0));
+
+	for (size_t count = 1; count <= 33; count++)
+	{
+		for (size_t position = 0; position < count; position++)
+		{
+			std::vector<uint32_t> indices(count, 1);
+			indices[position] = 65535;
+			CHECK(fits_16bit_indices(indices.data(), count));
+			indices[position] = 65536;
+			CHECK(!fits_16bit_indices(indices.data(), count));
+			indices[position] = 0xFFFFFFFFu;
+			CHECK(!fits_16bit_indices(indices.data(), count));
+		}
+	}
+
+	// Values around 0x8000 and the ends of the range, in both the SSE blocks and the tail
+	const uint32_t edges[] = { 0, 1, 0x7FFE, 0x7FFF, 0x8000, 0x8001, 0xFFFE, 0xFFFF };
+	for (size_t count = 0; count <= 27; count++)
+	{
+		std::vector<uint32_t> indices(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			indices[i] = edges[(i * 5 + count) % 8];
+		}
+		// One extra element checks nothing is written past count
+		std::vector<uint16_t> narrowed(count + 1, 0xABCD);
+		narrow_indices(indices.data(), count, narrowed.data());
+		for (size_t i = 0; i < count; i++)
+		{
+			CHECK(narrowed[i] == indices[i]);
+		}
+		CHECK(narrowed[count] == 0xABCD);
+	}
+
+	// Full range round trip
+	std::vector<uint32_t> all(65536);
+	for (uint32_t i = 0; i < 65536; i++)
+	{
+		all[i] = 65535 - i;
+	}
+	CHECK(fits_16bit_indices(all.data(), all.size()));
+	std::vector<uint16_t> narrowed(all.size());
+	narrow_indices(all.data(), all.size(), narrowed.data());
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		CHECK(narrowed[i] == all[i]);
+	}
+	return 0;
+}
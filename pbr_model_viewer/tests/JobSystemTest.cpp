@@ -0,0 +1,182 @@
+// JobSystem correctness (nested parallel_for, job trees waiting on their children, deque overflow, submits and waits
+// from several outside threads), meant to be run under ThreadSanitizer as well (VIEWER_TESTS_TSAN).
+// Ends with a scaling run of a job tree on pools of 1 to N threads.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <JobSystem.h>
+#include <Parallel.h>
+
+#include "TestUtils.h"
+
+static void test_nested_parallel_for()
+{
+	std::atomic<long> total(0);
+	for (int iteration = 0; iteration < 20; iteration++)
+	{
+		parallel_for(100000, 1000, [&](size_t begin, size_t end)
+		{
+			parallel_for(end - begin, 10, [&](size_t inner_begin, size_t inner_end)
+			{
+				total += long(inner_end - inner_begin);
+			});
+		});
+	}
+	CHECK(total == 20L * 100000);
+
+	// Every element visited exactly once, ranges never overlap
+	std::vector<int> visits(12345, 0);
+	parallel_for_workers(7, visits.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) visits[i]++;
+	});
+	CHECK(std::all_of(visits.begin(), visits.end(), [](int count) { return count == 1; }));
+	parallel_for(0, 1, [](size_t, size_t) { CHECK(false); });
+}
+
+// Every job waits on its children, so waiting has to run other jobs instead of blocking
+static void tree(JobSystem& job_system, int depth, std::atomic<long>& leaves)
+{
+	if (depth == 0)
+	{
+		leaves++;
+		return;
+	}
+	JobCounter counter;
+	for (int i = 0; i < 4; i++)
+	{
+		job_system.submit([&job_system, depth, &leaves]() { tree(job_system, depth - 1, leaves); }, &counter);
+	}
+	job_system.wait(counter);
+}
+
+static void test_job_tree()
+{
+	for (size_t workers : { 0, 1, 3, 7 })
+	{
+		JobSystem job_system(workers);
+		std::atomic<long> leaves(0);
+		for (int run = 0; run < 5; run++)
+		{
+			tree(job_system, 5, leaves);
+		}
+		CHECK(leaves == 5L * 1024);
+	}
+}
+
+// More children than a worker deque holds, the rest has to go through the shared queue
+static void test_deque_overflow()
+{
+	JobSystem job_system(2);
+	std::atomic<int> done(0);
+	JobCounter parent;
+	job_system.submit([&]()
+	{
+		JobCounter children;
+		for (int i = 0; i < 10000; i++)
+		{
+			job_system.submit([&done]() { done++; }, &children);
+		}
+		job_system.wait(children);
+	}, &parent);
+	job_system.wait(parent);
+	CHECK(done == 10000);
+}
+
+// Outside threads submitting and waiting concurrently, like the loader and the render thread
+static void test_outside_threads()
+{
+	JobSystem job_system(3);
+	std::atomic<int> done(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			for (int batch = 0; batch < 50; batch++)
+			{
+				JobCounter counter;
+				for (int i = 0; i < 100; i++)
+				{
+					job_system.submit([&done]() { done++; }, &counter);
+				}
+				job_system.wait(counter);
+				CHECK(counter.isDone());
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	CHECK(done == 4 * 50 * 100);
+
+	// Jobs without a counter still run before the pool shuts down
+	std::atomic<int> detached(0);
+	{
+		JobSystem short_lived(2);
+		JobCounter counter;
+		for (int i = 0; i < 100; i++)
+		{
+			short_lived.submit([&detached]() { detached++; }, nullptr);
+		}
+		short_lived.submit([]() {}, &counter);
+		short_lived.wait(counter);
+		while (detached < 100) std::this_thread::yield();
+	}
+}
+
+static double busy_work(int iterations)
+{
+	double value = 0.0;
+	for (int i = 0; i < iterations; i++)
+	{
+		value += std::sqrt(double(i) + value);
+	}
+	return value;
+}
+
+static void bench(int leaf_iterations)
+{
+	size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+	double single_ms = 0.0;
+	for (size_t threads = 1; threads <= hardware; threads++)
+	{
+		JobSystem job_system(threads - 1);
+		std::atomic<long> leaves(0);
+		std::atomic<long> sink(0);
+		Timer timer;
+		JobCounter counter;
+		for (int i = 0; i < 256; i++)
+		{
+			job_system.submit([&]()
+			{
+				JobCounter children;
+				for (int k = 0; k < 16; k++)
+				{
+					job_system.submit([&]() { sink += long(busy_work(leaf_iterations)) & 1; leaves++; }, &children);
+				}
+				job_system.wait(children);
+			}, &counter);
+		}
+		job_system.wait(counter);
+		double ms = timer.elapsedMs();
+		CHECK(leaves == 256 * 16);
+		if (threads == 1) single_ms = ms;
+		std::printf("%zu threads: %.1f ms, %.2fx\n", threads, ms, single_ms / ms);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	test_nested_parallel_for();
+	test_job_tree();
+	test_deque_overflow();
+	test_outside_threads();
+	bench((int)get_size_arg(argc, argv, 2000));
+	return 0;
+}
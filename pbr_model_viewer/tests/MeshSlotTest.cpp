@@ -0,0 +1,95 @@
+// Loader thread publishing meshes while the render loop swaps them in, meant to be run under ThreadSanitizer as well
+// (VIEWER_TESTS_TSAN). The render thread must only ever see fully built meshes, replaced meshes must stay alive for
+// mesh_retire_frames frames, every mesh must be deleted exactly once and shared bindables never.
+
+#include <atomic>
+#include <deque>
+#include <thread>
+
+#include <drawable/MeshSlot.h>
+
+#include "TestUtils.h"
+
+std::atomic<int> IBindable::destroyed(0);
+
+int main(int argc, char** argv)
+{
+	int mesh_count = (int)get_size_arg(argc, argv, 20000);
+	MeshSlot slot;
+	IBindable* shared = new IBindable;
+	std::atomic<bool> loading(true);
+
+	std::thread loader([&]()
+	{
+		for (int i = 0; i < mesh_count; i++)
+		{
+			LoadedMesh* loaded = new LoadedMesh();
+			loaded->mesh = new Mesh;
+			loaded->mesh->bindables.push_back(new IBindable);
+			for (int& value : loaded->mesh->payload)
+			{
+				value = i;
+			}
+			loaded->indexCount = i;
+			slot.publish(loaded);
+			// Gives the render loop a chance on machines with few cores, every fourth mesh replaces a pending one
+			if (i % 4 != 0) std::this_thread::yield();
+		}
+		loading = false;
+	});
+
+	int swaps = 0;
+	int last_seen = -1;
+	// Meshes replaced in the last mesh_retire_frames frames, which the GPU may still be reading
+	std::deque<const Mesh*> in_flight;
+	auto frame = [&]()
+	{
+		const Mesh* previous = slot.getCurrent() ? slot.getCurrent()->mesh : nullptr;
+		if (slot.beginFrame({ shared }))
+		{
+			swaps++;
+			slot.getCurrent()->mesh->bindables.push_back(shared);
+			if (previous) in_flight.push_back(previous);
+		}
+		else
+		{
+			in_flight.push_back(nullptr);
+		}
+		if (in_flight.size() > mesh_retire_frames) in_flight.pop_front();
+
+		if (LoadedMesh* current = slot.getCurrent())
+		{
+			int id = (int)current->indexCount;
+			CHECK(id >= last_seen);
+			last_seen = id;
+			for (int value : current->mesh->payload)
+			{
+				CHECK(value == id);
+			}
+		}
+		for (const Mesh* mesh : in_flight)
+		{
+			CHECK(!mesh || Mesh::isAlive(mesh));
+		}
+		slot.endFrame();
+	};
+	while (loading)
+	{
+		frame();
+		// Stands in for present
+		std::this_thread::yield();
+	}
+	loader.join();
+	frame();
+	CHECK(last_seen == mesh_count - 1);
+
+	// Only the current mesh and the ones still retiring are left
+	CHECK(Mesh::getLiveCount() <= 1 + mesh_retire_frames);
+	slot.clear({ shared });
+	CHECK(Mesh::getLiveCount() == 0);
+	// One owned bindable per mesh, the shared one survives every swap
+	CHECK(IBindable::destroyed == mesh_count);
+	delete shared;
+	std::printf("%d meshes published, %d picked up by the render loop\n", mesh_count, swaps);
+	return 0;
+}
@@ -0,0 +1,228 @@
+// Meshlet culling must be conservative: for random camera poses, a meshlet rejected by is_meshlet_visible never
+// contains a triangle that faces the camera and has a point inside the frustum.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <mesh/MeshletBuilder.h>
+
+#include "TestUtils.h"
+
+struct Vec3
+{
+	float x, y, z;
+};
+
+static Vec3 sub(Vec3 a, Vec3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+static float dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static Vec3 cross(Vec3 a, Vec3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+static Vec3 normalize(Vec3 a)
+{
+	float length = std::sqrt(dot(a, a));
+	return { a.x / length, a.y / length, a.z / length };
+}
+static Vec3 to_vec3(const DirectX::XMFLOAT3& p) { return { p.x, p.y, p.z }; }
+
+static void add_vertex(MeshData& mesh_data, Vec3 p)
+{
+	Vertex vertex = {};
+	vertex.position = { p.x, p.y, p.z };
+	mesh_data.vertices.push_back(vertex);
+}
+
+// Slightly bumpy closed sphere with outward facing (counter clockwise) triangles, followed by clusters of random triangles
+static MeshData make_mesh(std::mt19937& rng)
+{
+	MeshData mesh_data;
+	std::uniform_real_distribution<float> bump(0.995f, 1.005f);
+	const int rings = 40;
+	const int segments = 80;
+	for (int r = 0; r <= rings; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			float theta = DirectX::XM_PI * r / rings;
+			float phi = 2.0f * DirectX::XM_PI * s / segments;
+			float radius = (r == 0 || r == rings) ? 1.0f : bump(rng);
+			add_vertex(mesh_data, { radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi) });
+		}
+	}
+	// Quads in 8x8 tiles so each meshlet covers a compact patch with a narrow normal cone
+	const int tile = 8;
+	for (int quad = 0; quad < rings * segments; quad++)
+	{
+		int tiles_per_row = segments / tile;
+		int tile_index = quad / (tile * tile);
+		int r = (tile_index / tiles_per_row) * tile + (quad % (tile * tile)) / tile;
+		int s = (tile_index % tiles_per_row) * tile + quad % tile;
+		{
+			UINT a = r * segments + s;
+			UINT b = r * segments + (s + 1) % segments;
+			UINT c = (r + 1) * segments + s;
+			UINT d = (r + 1) * segments + (s + 1) % segments;
+			for (UINT index : { a, b, c, b, d, c })
+			{
+				mesh_data.indices.push_back(index);
+			}
+		}
+	}
+
+	// Clusters of randomly oriented triangles, which only frustum culling can reject
+	std::uniform_real_distribution<float> position(-4.0f, 4.0f);
+	std::uniform_real_distribution<float> offset(-0.3f, 0.3f);
+	for (int cluster = 0; cluster < 40; cluster++)
+	{
+		Vec3 center = { position(rng), position(rng), position(rng) };
+		for (int t = 0; t < 100; t++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				add_vertex(mesh_data, { center.x + offset(rng), center.y + offset(rng), center.z + offset(rng) });
+				mesh_data.indices.push_back((UINT)mesh_data.vertices.size() - 1);
+			}
+		}
+	}
+
+	// Single submesh at base 0 so submesh indices equal vertex indices
+	UINT index_count = (UINT)mesh_data.indices.size();
+	mesh_data.submeshes.push_back({ 0, (UINT)mesh_data.vertices.size(), 0, index_count });
+	mesh_data.lodSubmeshes = mesh_data.submeshes;
+	mesh_data.lods.push_back({ 0.0f, index_count, 0, 0, 0 });
+	build_meshlets(mesh_data);
+	return mesh_data;
+}
+
+struct Camera
+{
+	Vec3 eye;
+	// Transposed view projection rows, clip = (dot(rows[i].xyz, p) + rows[i].w) for x, y, z, w
+	float rows[4][4];
+};
+
+// XMMatrixLookAtRH times XMMatrixPerspectiveFovRH, the conventions of the viewer camera: the view looks down -z and
+// clip z goes from 0 at the near plane to w at the far one
+static Camera make_camera(Vec3 eye, Vec3 target, float fov, float aspect, float near_z, float far_z)
+{
+	Camera camera;
+	camera.eye = eye;
+	Vec3 back = normalize(sub(eye, target));
+	Vec3 world_up = std::fabs(back.y) > 0.99f ? Vec3{ 1.0f, 0.0f, 0.0f } : Vec3{ 0.0f, 1.0f, 0.0f };
+	Vec3 right = normalize(cross(world_up, back));
+	Vec3 up = cross(back, right);
+	float y_scale = 1.0f / std::tan(fov * 0.5f);
+	float x_scale = y_scale / aspect;
+	float z_scale = far_z / (near_z - far_z);
+	// View space x, y and z scaled into clip x, y and z, then w is the distance along -z
+	Vec3 axes[4] = { right, up, back, back };
+	float scales[4] = { x_scale, y_scale, z_scale, -1.0f };
+	for (int i = 0; i < 4; i++)
+	{
+		camera.rows[i][0] = axes[i].x * scales[i];
+		camera.rows[i][1] = axes[i].y * scales[i];
+		camera.rows[i][2] = axes[i].z * scales[i];
+		camera.rows[i][3] = -dot(axes[i], eye) * scales[i];
+	}
+	camera.rows[2][3] += near_z * z_scale;
+	return camera;
+}
+
+// Inside the clip volume by a small margin, so rounding can't turn a boundary point into a failure
+static bool is_inside(const Camera& camera, Vec3 p)
+{
+	float clip[4];
+	for (int i = 0; i < 4; i++)
+	{
+		clip[i] = camera.rows[i][0] * p.x + camera.rows[i][1] * p.y + camera.rows[i][2] * p.z + camera.rows[i][3];
+	}
+	float margin = 1e-3f * clip[3];
+	return clip[3] > 0.0f && std::fabs(clip[0]) < clip[3] - margin && std::fabs(clip[1]) < clip[3] - margin &&
+		clip[2] > margin && clip[2] < clip[3] - margin;
+}
+
+// Sampled, so it may miss a visible triangle (that only weakens the test) but never calls a hidden one visible.
+// Degenerate triangles are never rasterized.
+static bool is_triangle_visible(const Camera& camera, Vec3 a, Vec3 b, Vec3 c)
+{
+	Vec3 normal = cross(sub(b, a), sub(c, a));
+	Vec3 view = sub(a, camera.eye);
+	if (dot(normal, view) >= -1e-4f * std::sqrt(dot(normal, normal) * dot(view, view)))
+	{
+		return false;
+	}
+	const int steps = 6;
+	for (int i = 0; i <= steps; i++)
+	{
+		for (int j = 0; i + j <= steps; j++)
+		{
+			float u = float(i) / steps;
+			float v = float(j) / steps;
+			float w = 1.0f - u - v;
+			Vec3 p = { a.x * w + b.x * u + c.x * v, a.y * w + b.y * u + c.y * v, a.z * w + b.z * u + c.z * v };
+			if (is_inside(camera, p))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	size_t pose_count = get_size_arg(argc, argv, 200);
+	std::mt19937 rng(7);
+	MeshData mesh_data = make_mesh(rng);
+	CHECK(mesh_data.meshlets.size() > 10);
+
+	std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+	std::uniform_real_distribution<float> target(-4.0f, 4.0f);
+	std::uniform_real_distribution<float> fov(0.3f, 2.0f);
+	std::uniform_real_distribution<float> aspect(0.5f, 2.5f);
+	size_t frustum_culled = 0;
+	size_t cone_culled = 0;
+	size_t tested = 0;
+	for (size_t pose = 0; pose < pose_count; pose++)
+	{
+		Vec3 eye = { position(rng), position(rng), position(rng) };
+		Camera camera = make_camera(eye, { target(rng), target(rng), target(rng) }, fov(rng), aspect(rng), 0.05f, 20.0f);
+
+		DirectX::XMMATRIX transposed_view_proj;
+		for (int i = 0; i < 4; i++)
+		{
+			transposed_view_proj.r[i] = DirectX::XMVectorSet(camera.rows[i][0], camera.rows[i][1], camera.rows[i][2], camera.rows[i][3]);
+		}
+		DirectX::XMFLOAT4 planes[6];
+		extract_frustum_planes(transposed_view_proj, planes);
+		DirectX::XMFLOAT3 camera_position = { eye.x, eye.y, eye.z };
+
+		for (const Meshlet& meshlet : mesh_data.meshlets)
+		{
+			tested++;
+			if (is_meshlet_visible(meshlet, planes, camera_position))
+			{
+				continue;
+			}
+			bool outside = false;
+			for (const DirectX::XMFLOAT4& plane : planes)
+			{
+				outside |= plane.x * meshlet.center.x + plane.y * meshlet.center.y + plane.z * meshlet.center.z + plane.w < -meshlet.radius;
+			}
+			(outside ? frustum_culled : cone_culled)++;
+			for (UINT i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+			{
+				const Vertex* vertices = mesh_data.vertices.data() + meshlet.baseVertex;
+				Vec3 a = to_vec3(vertices[mesh_data.indices[i + 0]].position);
+				Vec3 b = to_vec3(vertices[mesh_data.indices[i + 1]].position);
+				Vec3 c = to_vec3(vertices[mesh_data.indices[i + 2]].position);
+				CHECK(!is_triangle_visible(camera, a, b, c));
+			}
+		}
+	}
+	std::printf("%zu meshlets, %zu poses, frustum culled %.1f%%, cone culled %.1f%%\n", mesh_data.meshlets.size(), pose_count,
+		100.0 * frustum_culled / tested, 100.0 * cone_culled / tested);
+	// Both frustum and cone culling must actually reject something for the test to mean anything
+	CHECK(frustum_culled > 0);
+	CHECK(cone_culled > 0);
+	return 0;
+}
@@ -0,0 +1,270 @@
+// generate_mips against a direct double precision 2D filter of every level, for each content and filter on square,
+// odd and one texel wide faces, plus exact results on checkers and solid colors. Prints MPix/s per setting; pass an
+// image size to benchmark.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <resource/MipGenerator.h>
+
+#include "TestUtils.h"
+
+static double srgb_to_linear(double value)
+{
+	return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+static double linear_to_srgb(double value)
+{
+	return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+}
+
+static double bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 50; k++)
+	{
+		double half = x / (2.0 * k);
+		term *= half * half;
+		sum += term;
+	}
+	return sum;
+}
+
+static double kaiser_weight(double distance)
+{
+	double x = distance / 3.0;
+	if (std::abs(x) >= 1.0)
+	{
+		return 0.0;
+	}
+	const double pi = 3.14159265358979323846;
+	double sinc = distance == 0.0 ? 1.0 : std::sin(pi * distance) / (pi * distance);
+	return sinc * bessel_i0(4.0 * std::sqrt(1.0 - x * x)) / bessel_i0(4.0);
+}
+
+static double filter_weight(MipSettings::Filter filter, int src, double center, double scale)
+{
+	if (filter == MipSettings::Kaiser)
+	{
+		return kaiser_weight((src + 0.5 - center) / scale);
+	}
+	double radius = 0.5 * scale;
+	return std::max(0.0, std::min(src + 1.0, center + radius) - std::max(double(src), center - radius));
+}
+
+// One level from the one above it, every destination texel summed over its whole 2D footprint with clamped edges
+static void reference_mip(const unsigned char* src, int src_width, int src_height, unsigned char* dst, int dst_width, int dst_height,
+						  const MipSettings& settings)
+{
+	double scale_x = double(src_width) / dst_width;
+	double scale_y = double(src_height) / dst_height;
+	double footprint = settings.filter == MipSettings::Kaiser ? 3.0 : 0.5;
+	for (int y = 0; y < dst_height; y++)
+	{
+		for (int x = 0; x < dst_width; x++)
+		{
+			double center_x = (x + 0.5) * scale_x;
+			double center_y = (y + 0.5) * scale_y;
+			int first_x = int(std::floor(center_x - footprint * scale_x));
+			int last_x = int(std::ceil(center_x + footprint * scale_x));
+			int first_y = int(std::floor(center_y - footprint * scale_y));
+			int last_y = int(std::ceil(center_y + footprint * scale_y));
+			double sum_x = 0.0;
+			double sum_y = 0.0;
+			for (int i = first_x; i <= last_x; i++) sum_x += filter_weight(settings.filter, i, center_x, scale_x);
+			for (int j = first_y; j <= last_y; j++) sum_y += filter_weight(settings.filter, j, center_y, scale_y);
+
+			double sum[4] = {};
+			for (int j = first_y; j <= last_y; j++)
+			{
+				double weight_y = filter_weight(settings.filter, j, center_y, scale_y) / sum_y;
+				const unsigned char* row = src + size_t(std::min(std::max(j, 0), src_height - 1)) * src_width * 4;
+				for (int i = first_x; i <= last_x; i++)
+				{
+					double weight = weight_y * filter_weight(settings.filter, i, center_x, scale_x) / sum_x;
+					const unsigned char* texel = row + std::min(std::max(i, 0), src_width - 1) * 4;
+					for (int c = 0; c < 4; c++)
+					{
+						double value = texel[c] / 255.0;
+						if (c < 3 && settings.content == MipSettings::Color) value = srgb_to_linear(value);
+						if (c < 3 && settings.content == MipSettings::Normal) value = texel[c] / 127.5 - 1.0;
+						sum[c] += weight * value;
+					}
+				}
+			}
+
+			if (settings.content == MipSettings::Normal)
+			{
+				double length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+				for (int c = 0; c < 3; c++) sum[c] = length > 1e-6 ? sum[c] / length * 0.5 + 0.5 : 0.5;
+			}
+			unsigned char* texel = dst + (size_t(y) * dst_width + x) * 4;
+			for (int c = 0; c < 4; c++)
+			{
+				double value = std::min(std::max(sum[c], 0.0), 1.0);
+				if (c < 3 && settings.content == MipSettings::Color) value = linear_to_srgb(value);
+				texel[c] = (unsigned char)std::floor(value * 255.0 + 0.5);
+			}
+		}
+	}
+}
+
+static TextureData make_texture(UINT width, UINT height, UINT face_count, std::mt19937& rng)
+{
+	TextureData data;
+	data.width = width;
+	data.height = height;
+	data.faceCount = face_count;
+	data.mipCount = 1;
+	data.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	data.pixels.resize(size_t(width) * height * 4 * face_count);
+	for (unsigned char& value : data.pixels)
+	{
+		value = (unsigned char)rng();
+	}
+	return data;
+}
+
+static MipSettings make_settings(int content, int filter)
+{
+	MipSettings settings;
+	settings.content = MipSettings::Content(content);
+	settings.filter = MipSettings::Filter(filter);
+	return settings;
+}
+
+// Every level is filtered from the generated one above it, the float path may round one step differently
+static void test_against_reference()
+{
+	std::mt19937 rng(1);
+	const UINT sizes[][2] = { { 64, 64 }, { 37, 19 }, { 1, 9 }, { 128, 2 } };
+	for (const auto& size : sizes)
+	{
+		for (int content = 0; content < 3; content++)
+		{
+			for (int filter = 0; filter < 2; filter++)
+			{
+				MipSettings settings = make_settings(content, filter);
+				TextureData source = make_texture(size[0], size[1], 2, rng);
+				TextureData data = source;
+				generate_mips(data, settings);
+				CHECK(data.mipCount == get_full_mip_count(size[0], size[1]));
+				CHECK(data.pixels.size() == data.getFaceSize() * 2);
+
+				int max_difference = 0;
+				for (UINT face = 0; face < 2; face++)
+				{
+					CHECK(std::memcmp(data.pixels.data() + data.getMipOffset(face, 0), source.pixels.data() + source.getMipOffset(face, 0),
+									  data.getMipSize(0)) == 0);
+					for (UINT mip = 1; mip < data.mipCount; mip++)
+					{
+						std::vector<unsigned char> expected(data.getMipSize(mip));
+						reference_mip(data.pixels.data() + data.getMipOffset(face, mip - 1), data.getMipWidth(mip - 1), data.getMipHeight(mip - 1),
+									  expected.data(), data.getMipWidth(mip), data.getMipHeight(mip), settings);
+						const unsigned char* generated = data.pixels.data() + data.getMipOffset(face, mip);
+						for (size_t i = 0; i < expected.size(); i++)
+						{
+							max_difference = std::max(max_difference, std::abs(int(expected[i]) - int(generated[i])));
+						}
+					}
+				}
+				CHECK(max_difference <= 1);
+			}
+		}
+	}
+}
+
+static void test_exact()
+{
+	// A black and white checker averages to half the light, which is 188 in sRGB and 128 as stored
+	TextureData checker;
+	checker.width = 4;
+	checker.height = 4;
+	checker.faceCount = 1;
+	checker.mipCount = 1;
+	checker.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	checker.pixels.resize(64);
+	for (int i = 0; i < 16; i++)
+	{
+		std::memset(&checker.pixels[i * 4], ((i % 4) + (i / 4)) % 2 ? 255 : 0, 3);
+		checker.pixels[i * 4 + 3] = 255;
+	}
+	TextureData color = checker;
+	generate_mips(color, make_settings(MipSettings::Color, MipSettings::Box));
+	TextureData linear = checker;
+	generate_mips(linear, make_settings(MipSettings::Linear, MipSettings::Box));
+	for (UINT mip = 1; mip < 3; mip++)
+	{
+		CHECK(color.pixels[color.getMipOffset(0, mip)] == 188 && color.pixels[color.getMipOffset(0, mip) + 3] == 255);
+		CHECK(linear.pixels[linear.getMipOffset(0, mip)] == 128);
+	}
+
+	// Solid colors stay exact through every level, content and filter, the Kaiser weights summing to one
+	std::mt19937 rng(2);
+	for (int i = 0; i < 50; i++)
+	{
+		unsigned char texel[4] = { (unsigned char)rng(), (unsigned char)rng(), (unsigned char)rng(), (unsigned char)rng() };
+		for (int content = 0; content < 3; content++)
+		{
+			for (int filter = 0; filter < 2; filter++)
+			{
+				if (content == MipSettings::Normal)
+				{
+					// A unit vector, which renormalizing leaves alone
+					texel[0] = 128;
+					texel[1] = 128;
+					texel[2] = 255;
+				}
+				TextureData solid = make_texture(24, 10, 1, rng);
+				for (size_t p = 0; p < solid.pixels.size(); p += 4) std::memcpy(&solid.pixels[p], texel, 4);
+				generate_mips(solid, make_settings(content, filter));
+				for (size_t p = 0; p < solid.pixels.size(); p += 4)
+				{
+					CHECK(std::memcmp(&solid.pixels[p], texel, 4) == 0);
+				}
+			}
+		}
+	}
+
+	// Existing mips are replaced, not kept
+	TextureData prebuilt = make_texture(8, 8, 1, rng);
+	prebuilt.mipCount = 2;
+	prebuilt.pixels.resize(prebuilt.getFaceSize(), 7);
+	generate_mips(prebuilt, MipSettings());
+	CHECK(prebuilt.mipCount == 4 && prebuilt.pixels.size() == prebuilt.getFaceSize());
+}
+
+static void bench(UINT size)
+{
+	std::mt19937 rng(3);
+	for (int content = 0; content < 3; content++)
+	{
+		for (int filter = 0; filter < 2; filter++)
+		{
+			TextureData data = make_texture(size, size, 1, rng);
+			Timer timer;
+			generate_mips(data, make_settings(content, filter));
+			double ms = timer.elapsedMs();
+			double megapixels = 0.0;
+			for (UINT mip = 0; mip + 1 < data.mipCount; mip++)
+			{
+				megapixels += double(data.getMipWidth(mip)) * data.getMipHeight(mip) / 1e6;
+			}
+			std::printf("%s %s %ux%u: %.1f ms, %.1f MPix/s filtered\n", content == 0 ? "color" : content == 1 ? "normal" : "linear",
+						filter == 0 ? "box" : "kaiser", size, size, ms, megapixels * 1000.0 / ms);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	test_against_reference();
+	test_exact();
+	bench((UINT)get_size_arg(argc, argv, 512));
+	return 0;
+}
@@ -0,0 +1,182 @@
+// generate_normals on shapes with known normals: hard cube edges below the crease angle, smoothed corners above it,
+// a uv sphere whose seam and pole vertices are duplicated, and submeshes left out by the mask.
+// Prints the throughput and speedup for 1 to all threads, pass 10000000 for a 10M triangle sphere.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <JobSystem.h>
+#include <mesh/NormalGenerator.h>
+
+#include "TestUtils.h"
+
+static bool near(float a, float b, float tolerance = 1e-4f)
+{
+	return std::fabs(a - b) <= tolerance;
+}
+
+// 8 shared corners, 12 counter clockwise outward triangles
+static void add_cube(MeshData& mesh_data, float offset)
+{
+	Submesh submesh = { (UINT)mesh_data.vertices.size(), 8, (UINT)mesh_data.indices.size(), 36 };
+	for (int i = 0; i < 8; i++)
+	{
+		Vertex vertex = {};
+		vertex.position = { float(i & 1) + offset, float((i >> 1) & 1), float((i >> 2) & 1) };
+		vertex.normal = { 7.0f, 7.0f, 7.0f };
+		mesh_data.vertices.push_back(vertex);
+	}
+	const UINT faces[12][3] = { { 0, 2, 1 }, { 1, 2, 3 }, { 4, 5, 6 }, { 5, 7, 6 }, { 0, 1, 4 }, { 1, 5, 4 },
+		{ 2, 6, 3 }, { 3, 6, 7 }, { 0, 4, 2 }, { 2, 4, 6 }, { 1, 3, 5 }, { 3, 7, 5 } };
+	for (const auto& face : faces)
+	{
+		for (UINT index : face)
+		{
+			mesh_data.indices.push_back(index);
+		}
+	}
+	mesh_data.submeshes.push_back(submesh);
+}
+
+// Unit uv sphere, the seam column and the pole rows are separate vertices like an unwelded import
+static MeshData make_sphere(int rings, int segments)
+{
+	MeshData mesh_data;
+	const float pi = 3.14159265f;
+	for (int r = 0; r <= rings; r++)
+	{
+		for (int s = 0; s <= segments; s++)
+		{
+			float theta = pi * r / rings;
+			float phi = 2.0f * pi * s / segments;
+			Vertex vertex = {};
+			// Exact poles, their triangles are degenerate rather than slivers with an arbitrary normal
+			float ring_radius = (r == 0 || r == rings) ? 0.0f : std::sin(theta);
+			vertex.position = { ring_radius * std::cos(phi), std::cos(theta), ring_radius * std::sin(phi) };
+			vertex.uvs = { float(s) / segments, float(r) / rings };
+			mesh_data.vertices.push_back(vertex);
+		}
+	}
+	UINT row = segments + 1;
+	for (int r = 0; r < rings; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			UINT a = r * row + s, b = a + 1, c = a + row, d = c + 1;
+			for (UINT index : { a, b, c, b, d, c })
+			{
+				mesh_data.indices.push_back(index);
+			}
+		}
+	}
+	mesh_data.submeshes.push_back({ 0, (UINT)mesh_data.vertices.size(), 0, (UINT)mesh_data.indices.size() });
+	return mesh_data;
+}
+
+static void test_cube()
+{
+	// Below 90 degrees every cube corner splits into its 3 face normals
+	MeshData hard;
+	add_cube(hard, 0.0f);
+	CHECK(generate_normals(hard, 60.0f, { true }) == 16);
+	CHECK(hard.vertices.size() == 24 && hard.submeshes[0].vertexCount == 24);
+	for (size_t i = 0; i < hard.indices.size(); i++)
+	{
+		const Vertex& vertex = hard.vertices[hard.indices[i]];
+		const Vertex& a = hard.vertices[hard.indices[i - i % 3]];
+		const Vertex& b = hard.vertices[hard.indices[i - i % 3 + 1]];
+		const Vertex& c = hard.vertices[hard.indices[i - i % 3 + 2]];
+		// Face normal from the winding
+		float e1[3] = { b.position.x - a.position.x, b.position.y - a.position.y, b.position.z - a.position.z };
+		float e2[3] = { c.position.x - a.position.x, c.position.y - a.position.y, c.position.z - a.position.z };
+		float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		CHECK(near(vertex.normal.x, n[0]) && near(vertex.normal.y, n[1]) && near(vertex.normal.z, n[2]));
+	}
+
+	// Above it the corners stay shared and point along the diagonals
+	MeshData smooth;
+	add_cube(smooth, 0.0f);
+	CHECK(generate_normals(smooth, 180.0f, { true }) == 0);
+	const float diagonal = 1.0f / std::sqrt(3.0f);
+	for (const Vertex& vertex : smooth.vertices)
+	{
+		CHECK(near(vertex.normal.x, (vertex.position.x * 2.0f - 1.0f) * diagonal));
+		CHECK(near(vertex.normal.y, (vertex.position.y * 2.0f - 1.0f) * diagonal));
+		CHECK(near(vertex.normal.z, (vertex.position.z * 2.0f - 1.0f) * diagonal));
+	}
+}
+
+static void test_mask()
+{
+	MeshData mesh_data;
+	add_cube(mesh_data, 0.0f);
+	add_cube(mesh_data, 3.0f);
+	CHECK(generate_normals(mesh_data, 60.0f, { false, true }) == 16);
+	CHECK(mesh_data.submeshes[0].vertexCount == 8 && mesh_data.submeshes[1].baseVertex == 8);
+	CHECK(mesh_data.submeshes[1].vertexCount == 24 && mesh_data.vertices.size() == 32);
+	for (UINT v = 0; v < 8; v++)
+	{
+		CHECK(mesh_data.vertices[v].normal.x == 7.0f);
+	}
+}
+
+static void test_sphere()
+{
+	MeshData mesh_data = make_sphere(24, 48);
+	CHECK(generate_normals(mesh_data, 60.0f, { true }) == 0);
+	// Coincident seam and pole vertices get the same normal, which is the position on a unit sphere
+	for (const Vertex& vertex : mesh_data.vertices)
+	{
+		float length = std::sqrt(vertex.normal.x * vertex.normal.x + vertex.normal.y * vertex.normal.y + vertex.normal.z * vertex.normal.z);
+		CHECK(near(length, 1.0f));
+		CHECK(vertex.normal.x * vertex.position.x + vertex.normal.y * vertex.position.y + vertex.normal.z * vertex.position.z > 0.995f);
+	}
+	UINT row = 49;
+	for (UINT r = 0; r <= 24; r++)
+	{
+		const Vertex& first = mesh_data.vertices[r * row];
+		const Vertex& last = mesh_data.vertices[r * row + 48];
+		CHECK(std::memcmp(&first.normal, &last.normal, sizeof(first.normal)) == 0);
+	}
+}
+
+// The same sphere with 1 to all threads of the JobSystem, the speedup is against 1 thread and the normals must not
+// depend on the thread count
+static void bench(size_t triangles)
+{
+	int rings = std::max(2, int(std::sqrt(double(triangles) / 4.0)));
+	const MeshData sphere = make_sphere(rings, rings * 2);
+	size_t triangle_count = sphere.indices.size() / 3;
+	MeshData single;
+	double single_ms = 0.0;
+	for (size_t threads = 1; threads <= JobSystem::get().getThreadCount(); threads++)
+	{
+		MeshData mesh_data = sphere;
+		Timer timer;
+		generate_normals(mesh_data, 60.0f, { true }, threads);
+		double ms = timer.elapsedMs();
+		if (threads == 1)
+		{
+			single = std::move(mesh_data);
+			single_ms = ms;
+		}
+		else
+		{
+			CHECK(mesh_data.vertices.size() == single.vertices.size());
+			CHECK(std::memcmp(mesh_data.vertices.data(), single.vertices.data(), single.vertices.size() * sizeof(Vertex)) == 0);
+		}
+		std::printf("%zu triangles, %zu threads: %.1f ms, %.2f Mtriangles/s, %.2fx\n", triangle_count, threads, ms,
+			triangle_count / (ms * 1000.0), single_ms / ms);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	test_cube();
+	test_mask();
+	test_sphere();
+	bench(get_size_arg(argc, argv, 100000));
+	return 0;
+}
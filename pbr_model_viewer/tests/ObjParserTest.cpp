@@ -0,0 +1,253 @@
+// parse_obj against a straightforward reference reader: fan triangulation, negative indices, submesh splits on
+// o/g/usemtl, welding of identical v/vt/vn triples per submesh, chunk boundaries and the inputs it must reject
+// so the loader falls back to assimp. Prints the parse throughput.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <mesh/ObjParser.h>
+
+#include "TestUtils.h"
+
+struct ReferenceCorner
+{
+	int position, uv, normal;
+};
+
+// Reference reader for the subset the tests write: v, vt, vn, f with v/vt/vn corners, o, g and usemtl
+struct ReferenceObj
+{
+	std::vector<float> positions, uvs, normals;
+	// Triangles of every non empty group
+	std::vector<std::vector<ReferenceCorner>> groups;
+
+	explicit ReferenceObj(const std::string& text)
+	{
+		groups.emplace_back();
+		size_t line_start = 0;
+		while (line_start < text.size())
+		{
+			size_t line_end = text.find('\n', line_start);
+			if (line_end == std::string::npos) line_end = text.size();
+			std::string line = text.substr(line_start, line_end - line_start);
+			line_start = line_end + 1;
+
+			char* c = &line[0];
+			if (line.compare(0, 2, "v ") == 0) read_floats(c + 2, 3, positions);
+			else if (line.compare(0, 3, "vt ") == 0) read_floats(c + 3, 2, uvs);
+			else if (line.compare(0, 3, "vn ") == 0) read_floats(c + 3, 3, normals);
+			else if (line.compare(0, 2, "o ") == 0 || line.compare(0, 2, "g ") == 0 || line.compare(0, 7, "usemtl ") == 0)
+			{
+				if (!groups.back().empty()) groups.emplace_back();
+			}
+			else if (line.compare(0, 2, "f ") == 0)
+			{
+				std::vector<ReferenceCorner> face;
+				c += 2;
+				while (*c)
+				{
+					ReferenceCorner corner;
+					corner.position = read_index(c, positions.size() / 3);
+					corner.uv = read_index(++c, uvs.size() / 2);
+					corner.normal = read_index(++c, normals.size() / 3);
+					face.push_back(corner);
+					while (*c == ' ') c++;
+				}
+				for (size_t i = 2; i < face.size(); i++)
+				{
+					groups.back().push_back(face[0]);
+					groups.back().push_back(face[i - 1]);
+					groups.back().push_back(face[i]);
+				}
+			}
+		}
+		if (groups.back().empty()) groups.pop_back();
+	}
+
+	static void read_floats(char* c, int count, std::vector<float>& out)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			out.push_back(std::strtof(c, &c));
+		}
+	}
+
+	static int read_index(char*& c, size_t defined)
+	{
+		long value = std::strtol(c, &c, 10);
+		return value < 0 ? int(defined + value) : int(value - 1);
+	}
+};
+
+static std::string write_file(const std::string& name, const std::string& text)
+{
+	std::ofstream file(name, std::ios::binary);
+	file << text;
+	return name;
+}
+
+static bool parse(const std::string& filename, MeshData& mesh_data)
+{
+	ObjParseStats stats;
+	LoadProgress progress;
+	return parse_obj(filename, mesh_data, stats, progress);
+}
+
+// fast_atof, like in assimp, can be one ulp away from the correctly rounded strtof
+static bool near(float a, float b)
+{
+	return std::fabs(a - b) <= 1e-6f * std::max(1.0f, std::fabs(b));
+}
+
+static void check_against_reference(const std::string& text, const MeshData& mesh_data)
+{
+	ReferenceObj reference(text);
+	CHECK(mesh_data.submeshes.size() == reference.groups.size());
+	UINT next_index = 0;
+	UINT next_vertex = 0;
+	for (size_t g = 0; g < reference.groups.size(); g++)
+	{
+		const Submesh& submesh = mesh_data.submeshes[g];
+		const std::vector<ReferenceCorner>& corners = reference.groups[g];
+		CHECK(submesh.firstIndex == next_index);
+		CHECK(submesh.baseVertex == next_vertex);
+		CHECK(submesh.indexCount == corners.size());
+		next_index += submesh.indexCount;
+		next_vertex += submesh.vertexCount;
+
+		std::set<std::tuple<int, int, int>> triples;
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			const ReferenceCorner& corner = corners[i];
+			triples.insert(std::make_tuple(corner.position, corner.uv, corner.normal));
+			UINT index = mesh_data.indices[submesh.firstIndex + i];
+			CHECK(index < submesh.vertexCount);
+			const Vertex& vertex = mesh_data.vertices[submesh.baseVertex + index];
+			const float* p = &reference.positions[corner.position * 3];
+			const float* t = &reference.uvs[corner.uv * 2];
+			const float* n = &reference.normals[corner.normal * 3];
+			CHECK(near(vertex.position.x, p[0]) && near(vertex.position.y, p[1]) && near(vertex.position.z, p[2]));
+			CHECK(near(vertex.uvs.x, t[0]) && near(vertex.uvs.y, t[1]));
+			CHECK(near(vertex.normal.x, n[0]) && near(vertex.normal.y, n[1]) && near(vertex.normal.z, n[2]));
+		}
+		// Fully welded: one vertex per distinct triple
+		CHECK(submesh.vertexCount == triples.size());
+	}
+	CHECK(next_index == mesh_data.indices.size());
+	CHECK(next_vertex == mesh_data.vertices.size());
+}
+
+static void test_small()
+{
+	const std::string text =
+		"# quad and a pentagon, then a group using negative indices\n"
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0.5 1.5 0\n"
+		"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+		"vn 0 0 1\n"
+		"o first\n"
+		"f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+		"f 1/1/1 2/2/1 3/3/1 5/4/1 4/4/1\n"
+		"g empty\n"
+		"usemtl second\n"
+		"f -5/-4/-1 -3/-2/-1 -2/-1/-1\n"
+		"f 1/1/1 2/2/1 3/3/1";
+	MeshData mesh_data;
+	CHECK(parse(write_file("small.obj", text), mesh_data));
+	CHECK(mesh_data.submeshes.size() == 2);
+	CHECK(mesh_data.indices.size() == (2 + 3 + 2) * 3);
+	// The quad and pentagon share 4 triples and add 1, the second group welds its own 4
+	CHECK(mesh_data.submeshes[0].vertexCount == 5);
+	CHECK(mesh_data.submeshes[1].vertexCount == 4);
+	check_against_reference(text, mesh_data);
+}
+
+static void test_rejected()
+{
+	MeshData mesh_data;
+	CHECK(!parse("missing.obj", mesh_data));
+	CHECK(!parse(write_file("empty.obj", ""), mesh_data));
+	// Corners without uvs or normals are left to assimp, which can generate them
+	CHECK(!parse(write_file("no_uvs.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\n"), mesh_data));
+	CHECK(!parse(write_file("positions.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n"), mesh_data));
+	CHECK(!parse(write_file("out_of_range.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\nf 1/1/1 2/1/1 4/1/1\n"), mesh_data));
+	CHECK(!parse(write_file("zero_index.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\nf 0/1/1 2/1/1 3/1/1\n"), mesh_data));
+	CHECK(!parse(write_file("truncated.obj", "v 0 0 0\nv 1 0 0\nv 0 1\n"), mesh_data));
+}
+
+// Grid patches with shared corners, sized to span several parse chunks
+static std::string make_large(size_t triangle_count)
+{
+	std::mt19937 rng(3);
+	std::string text;
+	text.reserve(triangle_count * 80);
+	char line[256];
+	const int side = 32;
+	size_t written = 0;
+	for (int patch = 0; written < triangle_count; patch++)
+	{
+		std::snprintf(line, sizeof(line), patch % 3 == 0 ? "o patch%d\n" : patch % 3 == 1 ? "g patch%d\n" : "usemtl material%d\n", patch);
+		text += line;
+		for (int i = 0; i < side * side; i++)
+		{
+			std::snprintf(line, sizeof(line), "v %d.%03d %d.5 -%d.25\nvt 0.%04u %u.5\nvn 0 %d 1\n", patch, i, i / side, i % side,
+				unsigned(rng() % 10000), unsigned(rng() % 4), i % 7);
+			text += line;
+		}
+		for (int y = 0; y + 1 < side; y++)
+		{
+			for (int x = 0; x + 1 < side; x++)
+			{
+				int a = -(side * side) + y * side + x;
+				int b = a + 1;
+				int c = a + side + 1;
+				int d = a + side;
+				// Mix of negative and absolute indices, quads and triangles
+				if ((x + y) % 2)
+				{
+					std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+				}
+				else
+				{
+					int base = patch * side * side + side * side + 1;
+					std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n",
+						base + a, base + a, base + a, base + b, base + b, base + b, base + c, base + c, base + c,
+						base + a, base + a, base + a, base + c, base + c, base + c, base + d, base + d, base + d);
+				}
+				text += line;
+				written += 2;
+			}
+		}
+	}
+	return text;
+}
+
+static void test_large(size_t triangle_count)
+{
+	std::string text = make_large(triangle_count);
+	std::string filename = write_file("large.obj", text);
+	MeshData mesh_data;
+	ObjParseStats stats;
+	LoadProgress progress;
+	Timer timer;
+	CHECK(parse_obj(filename, mesh_data, stats, progress));
+	double ms = timer.elapsedMs();
+	check_against_reference(text, mesh_data);
+	std::printf("%.1f MB, %zu triangles: %.1f MB/s (parse %.1f ms, weld %.1f ms, vertices %.1f ms)\n", text.size() / 1e6,
+		mesh_data.indices.size() / 3, text.size() / 1e3 / ms, stats.parseMs, stats.weldMs, stats.vertexMs);
+}
+
+int main(int argc, char** argv)
+{
+	test_small();
+	test_rejected();
+	test_large(get_size_arg(argc, argv, 60000));
+	return 0;
+}
@@ -0,0 +1,370 @@
+// ResourceManager on the NullResourceDevice: placeholders until upload, futures, the per frame upload budget, shared
+// decodes and cache hits, failed loads, handle reuse, the unused texture cache, the texture budget, streamed loads,
+// constant containers and no texture leaked at the end.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <resource/BlockCompression.h>
+#include <resource/DdsFile.h>
+#include <resource/NullResourceDevice.h>
+#include <resource/ResourceManager.h>
+#include <resource/TextureResidency.h>
+
+#include "TestUtils.h"
+
+// Noise image, seed picks the content
+static std::string write_ppm(const std::string& filename, UINT width, UINT height, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	FILE* file = std::fopen(filename.c_str(), "wb");
+	CHECK(file);
+	std::fprintf(file, "P6\n%u %u\n255\n", width, height);
+	for (UINT i = 0; i < width * height * 3; i++)
+	{
+		std::fputc(int(rng() & 255), file);
+	}
+	std::fclose(file);
+	return filename;
+}
+
+// Runs frames until nothing is loading anymore, checking every frame stays within the upload budget
+static int pump(ResourceManager& resources, NullResourceDevice& device, size_t single_upload_bytes)
+{
+	int frames = 0;
+	Timer timer;
+	while (resources.getLoadingCount() > 0)
+	{
+		CHECK(timer.elapsedMs() < 30000.0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		size_t before = device.getCreatedBytes();
+		resources.update();
+		size_t uploaded = device.getCreatedBytes() - before;
+		CHECK(uploaded <= std::max(resources.getUploadBudget(), single_upload_bytes));
+		frames++;
+	}
+	return frames;
+}
+
+static const UINT gray = 0xFF808080;
+
+static void test_loads()
+{
+	NullResourceDevice device;
+	{
+		// 64x64 RGBA8 with mips is 21844 bytes, so the budget lets one texture through per frame
+		const size_t texture_bytes = (4096 + 1024 + 256 + 64 + 16 + 4 + 1) * 4;
+		ResourceManager resources(device, 16 << 10, 1 << 20, 256 << 20);
+		std::vector<TextureHandle> handles;
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			handles.push_back(resources.loadTexture(write_ppm("load" + std::to_string(i) + ".ppm", 64, 64, i), gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings()));
+		}
+		// Same file and settings share the decode of the first load
+		TextureHandle duplicate = resources.loadTexture("load0.ppm", gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		TextureHandle missing = resources.loadTexture("missing.ppm", 0xFF0000FF, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		TextureHandle missing_cube = resources.loadTextureCube("missing_cube", 0xFF000000);
+
+		// Placeholders at once, shared per color
+		GpuTexture placeholder = resources.getTexture(handles[0]);
+		CHECK(placeholder);
+		CHECK(resources.getTexture(handles[1]) == placeholder);
+		CHECK(resources.getTexture(missing) != placeholder);
+		CHECK(resources.getState(handles[0]) == ResourceManager::Loading);
+		CHECK(resources.getFuture(handles[0]).wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+		int frames = pump(resources, device, texture_bytes);
+		// 4 distinct textures, one per frame at most
+		CHECK(frames >= 4);
+
+		for (TextureHandle handle : handles)
+		{
+			CHECK(resources.getState(handle) == ResourceManager::Ready);
+			CHECK(resources.getFuture(handle).get());
+			CHECK(resources.getTexture(handle) != placeholder);
+			CHECK(resources.getResidentMip(handle) == 0);
+		}
+		CHECK(resources.getTexture(duplicate) == resources.getTexture(handles[0]));
+		CHECK(resources.getState(missing) == ResourceManager::Failed && !resources.getFuture(missing).get());
+		CHECK(resources.getState(missing_cube) == ResourceManager::Failed);
+		// A failed load keeps its placeholder for good
+		CHECK(resources.getTexture(missing) != nullptr);
+
+		// Missing files fail while hashing, before the cache lookup
+		const TextureCacheStats& stats = resources.getCacheStats();
+		CHECK(stats.misses == 4 && stats.hits == 1);
+		CHECK(stats.residentTextures == 4);
+		CHECK(stats.residentBytes == 4 * texture_bytes);
+
+		// Released handles resolve to nothing, a new load reuses the slot under a new generation
+		resources.release(handles[3]);
+		CHECK(resources.getTexture(handles[3]) == nullptr);
+		CHECK(resources.getState(handles[3]) == ResourceManager::Failed);
+		TextureHandle reused = resources.loadTexture("load3.ppm", gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		CHECK(reused.index == handles[3].index && reused.generation != handles[3].generation);
+		// The released texture waited in the unused cache, loading it again is a hit without a decode
+		size_t live = device.getLiveTextureCount();
+		pump(resources, device, texture_bytes);
+		CHECK(resources.getState(reused) == ResourceManager::Ready);
+		CHECK(device.getLiveTextureCount() == live);
+		CHECK(stats.hits == 2 && stats.misses == 4);
+
+		// Different content under the same name is a different texture
+		write_ppm("load0.ppm", 64, 64, 100);
+		TextureHandle changed = resources.loadTexture("load0.ppm", gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		pump(resources, device, texture_bytes);
+		CHECK(resources.getState(changed) == ResourceManager::Ready);
+		CHECK(resources.getTexture(changed) != resources.getTexture(handles[0]));
+		CHECK(stats.misses == 5);
+
+		// Released mid load: the handle is done at once and its upload is dropped
+		TextureHandle abandoned = resources.loadTexture(write_ppm("abandoned.ppm", 64, 64, 50), gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		std::shared_future<bool> future = resources.getFuture(abandoned);
+		resources.release(abandoned);
+		CHECK(!future.get());
+		CHECK(resources.getLoadingCount() == 0);
+	}
+	CHECK(device.getLiveTextureCount() == 0);
+}
+
+static void test_unused_limit()
+{
+	NullResourceDevice device;
+	{
+		// Room for a single unused 64x64 texture
+		ResourceManager resources(device, 1 << 20, 30 << 10, 256 << 20);
+		TextureHandle a = resources.loadTexture(write_ppm("unused0.ppm", 64, 64, 10), gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		TextureHandle b = resources.loadTexture(write_ppm("unused1.ppm", 64, 64, 11), gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		pump(resources, device, 0);
+		size_t live = device.getLiveTextureCount();
+
+		resources.release(a);
+		CHECK(resources.getCacheStats().unusedTextures == 1);
+		CHECK(device.getLiveTextureCount() == live);
+		// The second one pushes the oldest out
+		resources.release(b);
+		CHECK(resources.getCacheStats().unusedTextures == 1);
+		CHECK(resources.getCacheStats().residentTextures == 1);
+		CHECK(device.getLiveTextureCount() == live - 1);
+
+		// b is still cached, a has to decode again
+		TextureHandle b_again = resources.loadTexture("unused1.ppm", gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		TextureHandle a_again = resources.loadTexture("unused0.ppm", gray, DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		pump(resources, device, 0);
+		CHECK(resources.getState(a_again) == ResourceManager::Ready && resources.getState(b_again) == ResourceManager::Ready);
+		CHECK(resources.getCacheStats().hits == 1 && resources.getCacheStats().misses == 3);
+	}
+	CHECK(device.getLiveTextureCount() == 0);
+}
+
+// Runs frames with visible drawn until done returns true, restores decode on the JobSystem so they take a few frames
+template <typename Done>
+static void run_frames(ResourceManager& resources, TextureHandle visible, Done done)
+{
+	Timer timer;
+	while (!done())
+	{
+		CHECK(timer.elapsedMs() < 30000.0);
+		resources.markVisible(visible);
+		resources.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+// The texture budget through the ResourceManager: the visible texture gets its levels back from the others, and the
+// bytes it reports match what the policy decided
+static void test_residency()
+{
+	NullResourceDevice device;
+	{
+		// 512x512 RGBA8 with mips is 1398100 bytes, 87380 from the 128x128 tail down which always stays
+		const size_t texture_bytes = 1398100;
+		const size_t tail_bytes = 87380;
+		ResourceManager resources(device, 64 << 20, 0, 2 << 20);
+		TextureHandle handles[3];
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			handles[i] = resources.loadTexture(write_ppm("resident" + std::to_string(i) + ".ppm", 512, 512, 20 + i), gray,
+											   DXGI_FORMAT_R8G8B8A8_UNORM, MipSettings());
+		}
+		pump(resources, device, 0);
+		const TextureResidency& residency = resources.getResidency();
+		const TextureCacheStats& stats = resources.getCacheStats();
+
+		for (int visible : { 0, 2 })
+		{
+			run_frames(resources, handles[visible], [&]() { return resources.getResidentMip(handles[visible]) == 0; });
+			CHECK(residency.getResidentBytes() <= (2u << 20) && stats.residentBytes == residency.getResidentBytes());
+			for (int other = 0; other < 3; other++)
+			{
+				CHECK(other == visible || resources.getResidentMip(handles[other]) > 0);
+			}
+		}
+		CHECK(stats.evictedLevels > 0 && stats.restoredLevels > 0);
+
+		// Room for everything, what is drawn comes back whole
+		resources.setTextureBudget(64 << 20);
+		run_frames(resources, handles[1], [&]() { return resources.getResidentMip(handles[1]) == 0; });
+		CHECK(stats.residentBytes == residency.getResidentBytes());
+
+		// Down to the tails, and released while a restore is still decoding
+		resources.setTextureBudget(3 * tail_bytes);
+		run_frames(resources, handles[0], [&]() { return residency.getResidentBytes() == 3 * tail_bytes; });
+		CHECK(stats.residentBytes == 3 * tail_bytes);
+		resources.setTextureBudget(texture_bytes + 2 * tail_bytes);
+		resources.markVisible(handles[0]);
+		resources.update();
+		resources.release(handles[0]);
+		run_frames(resources, handles[2], [&]() { return resources.getResidentMip(handles[2]) == 0; });
+		CHECK(stats.residentBytes == residency.getResidentBytes());
+		resources.release(handles[1]);
+		resources.release(handles[2]);
+	}
+	CHECK(device.getLiveTextureCount() == 0);
+}
+
+// A 1024x1024 load of the image seed streams in through the upload queue: its 128x128 tail first, while the load is
+// still Loading, then one finer level per upload down to 0, every frame within the upload budget. A block compressed
+// load encodes its tail before the rest, or cuts it from the disk cache entry when cached.
+static void test_streaming(DXGI_FORMAT format, unsigned int seed, bool cached)
+{
+	const UINT size = 1024;
+	const UINT mip_count = 11;
+	const UINT tail_mip = 3;
+	size_t tail_bytes = 0;
+	for (UINT mip = tail_mip; mip < mip_count; mip++)
+	{
+		tail_bytes += get_image_size(format, size >> mip, size >> mip);
+	}
+	// Below every level and the tail with the next level, so each upload gets a frame of its own
+	const size_t budget = 16 << 10;
+
+	NullResourceDevice device;
+	{
+		ResourceManager resources(device, budget, 0, 256 << 20);
+		TextureHandle handle = resources.loadTexture(write_ppm("stream.ppm", size, size, seed), gray, format, MipSettings());
+		GpuTexture placeholder = resources.getTexture(handle);
+		UINT resident_mip = mip_count;
+		int frame = 0;
+		int first_texel_frame = -1;
+		Timer timer;
+		// The frame that finishes the load is checked too
+		for (bool loading = true; loading;)
+		{
+			CHECK(timer.elapsedMs() < 30000.0);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			size_t before = device.getCreatedBytes();
+			resources.update();
+			size_t uploaded = device.getCreatedBytes() - before;
+			loading = resources.getState(handle) == ResourceManager::Loading;
+			frame++;
+			if (resources.getTexture(handle) == placeholder)
+			{
+				CHECK(uploaded == 0);
+				continue;
+			}
+
+			UINT mip = resources.getResidentMip(handle);
+			if (first_texel_frame < 0)
+			{
+				// The tail alone, with the load still going
+				CHECK(mip == tail_mip && uploaded == tail_bytes && loading);
+				first_texel_frame = frame;
+			}
+			else if (mip < resident_mip)
+			{
+				// One level, over the budget only when it is bigger than the budget on its own
+				CHECK(mip == resident_mip - 1);
+				CHECK(uploaded == get_image_size(format, size >> mip, size >> mip));
+			}
+			else
+			{
+				CHECK(mip == resident_mip && uploaded == 0);
+			}
+			resident_mip = mip;
+		}
+
+		CHECK(resources.getState(handle) == ResourceManager::Ready && resources.getResidentMip(handle) == 0);
+		CHECK(first_texel_frame > 0 && frame >= first_texel_frame + int(tail_mip));
+		const TextureStreamingStats& stats = resources.getStreamingStats();
+		CHECK(stats.streamedTextures == 1 && stats.fullResolutionTextures == 1);
+		CHECK(stats.lastFirstTexelMs <= stats.lastFullResolutionMs);
+		CHECK(stats.getAverageFirstTexelMs() <= stats.getAverageFullResolutionMs());
+		if (format != DXGI_FORMAT_R8G8B8A8_UNORM)
+		{
+			const TextureCompressionStats& compression = resources.getCompressionStats();
+			CHECK(compression.diskCacheHits == (cached ? 1u : 0u) && compression.compressedTextures == (cached ? 0u : 1u));
+			// The encoded tail is up before the encode of the whole chain is done
+			CHECK(cached || stats.lastFirstTexelMs < stats.lastFullResolutionMs - compression.encodeMs);
+		}
+		std::printf("%s%s: first texels after %.1f ms, full resolution after %.1f ms\n", format == DXGI_FORMAT_BC1_UNORM ? "BC1" : "RGBA8",
+			cached ? " cached" : "", stats.lastFirstTexelMs, stats.lastFullResolutionMs);
+		resources.release(handle);
+	}
+	CHECK(device.getLiveTextureCount() == 0);
+}
+
+// 8x8 BC7 DDS file made of a single block repeated
+static std::string write_bc7_dds(const std::string& filename, const unsigned char* block)
+{
+	TextureData data;
+	data.width = 8;
+	data.height = 8;
+	data.faceCount = 1;
+	data.mipCount = 1;
+	data.format = DXGI_FORMAT_BC7_UNORM;
+	for (int i = 0; i < 4; i++)
+	{
+		data.pixels.insert(data.pixels.end(), block, block + 16);
+	}
+	CHECK(write_dds(filename, data));
+	return filename;
+}
+
+// Constant containers collapse to their mean, but only when every block decodes exactly: BC7 blocks of modes
+// decode_block doesn't know would all read as magenta and collapse to it
+static void test_constant_containers()
+{
+	NullResourceDevice device;
+	{
+		ResourceManager resources(device, 1 << 20, 1 << 20, 256 << 20);
+		resources.setConstantTolerance(2);
+
+		unsigned char pixels[64];
+		for (int i = 0; i < 64; i++)
+		{
+			pixels[i] = i % 4 == 3 ? 255 : 100;
+		}
+		unsigned char mode6[16];
+		encode_bc7_block(pixels, mode6);
+		// Mode 5 with every other bit zero
+		unsigned char mode5[16] = { 0x20 };
+
+		TextureHandle solid = resources.loadTexture(write_bc7_dds("solid.dds", mode6), gray, DXGI_FORMAT_BC7_UNORM, MipSettings());
+		TextureHandle unknown = resources.loadTexture(write_bc7_dds("unknown.dds", mode5), gray, DXGI_FORMAT_BC7_UNORM, MipSettings());
+		pump(resources, device, 0);
+
+		CHECK(resources.getState(solid) == ResourceManager::Ready && resources.isConstant(solid));
+		CHECK(resources.getAnalysis(solid) && resources.getAnalysis(solid)->getRange(0) == 0);
+		CHECK(resources.getState(unknown) == ResourceManager::Ready && !resources.isConstant(unknown));
+		CHECK(!resources.getAnalysis(unknown));
+	}
+	CHECK(device.getLiveTextureCount() == 0);
+}
+
+int main()
+{
+	test_loads();
+	test_unused_limit();
+	test_residency();
+	test_streaming(DXGI_FORMAT_R8G8B8A8_UNORM, 30, false);
+	// A new image every run, so the disk cache misses the first time
+	unsigned int seed = std::random_device()();
+	test_streaming(DXGI_FORMAT_BC1_UNORM, seed, false);
+	test_streaming(DXGI_FORMAT_BC1_UNORM, seed, true);
+	test_constant_containers();
+	return 0;
+}
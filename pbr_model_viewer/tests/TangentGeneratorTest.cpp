@@ -0,0 +1,331 @@
+// generate_tangents against the MikkTSpace reference implementation in mikktspace/ on seamed, mirrored, hard edged and
+// unwelded meshes, and its properties: unit frames orthogonal to the normal, tangent and bitangent following the uv
+// gradients of every triangle around the vertex, splits exactly at mirrored uv seams, corner attributes kept.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <mesh/TangentGenerator.h>
+
+#include "TestUtils.h"
+#include "mikktspace/mikktspace.h"
+
+using DirectX::XMFLOAT2;
+using DirectX::XMFLOAT3;
+
+static XMFLOAT3 sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+static XMFLOAT3 scale(const XMFLOAT3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+static float dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+static XMFLOAT3 normalize(const XMFLOAT3& a) { return scale(a, 1.0f / std::sqrt(dot(a, a))); }
+
+// Grid of (columns + 1) x (rows + 1) vertices over x in [-1, 1], y in [0, 1], bent around the y axis by bend.
+// uv_of_x maps x to u, v is y. Triangles are counter clockwise seen from +z.
+template<typename UvOfX>
+static MeshData make_grid(int columns, int rows, float bend, UvOfX uv_of_x)
+{
+	MeshData mesh_data;
+	for (int r = 0; r <= rows; r++)
+	{
+		for (int c = 0; c <= columns; c++)
+		{
+			float x = -1.0f + 2.0f * c / columns;
+			float y = float(r) / rows;
+			Vertex vertex = {};
+			vertex.position = { std::sin(x * bend) / (bend > 0.0f ? bend : 1.0f), y, bend > 0.0f ? (std::cos(x * bend) - 1.0f) / bend : 0.0f };
+			if (bend == 0.0f) vertex.position.x = x;
+			vertex.normal = { std::sin(x * bend), 0.0f, std::cos(x * bend) };
+			vertex.uvs = { uv_of_x(x), y };
+			mesh_data.vertices.push_back(vertex);
+		}
+	}
+	UINT row = columns + 1;
+	for (int r = 0; r < rows; r++)
+	{
+		for (int c = 0; c < columns; c++)
+		{
+			UINT a = r * row + c, b = a + 1, d = a + row, e = d + 1;
+			for (UINT index : { a, b, e, a, e, d })
+			{
+				mesh_data.indices.push_back(index);
+			}
+		}
+	}
+	mesh_data.submeshes.push_back({ 0, (UINT)mesh_data.vertices.size(), 0, (UINT)mesh_data.indices.size() });
+	return mesh_data;
+}
+
+// Cube with a vertex per face corner, hard edges between the faces. Every face has its own uv orientation.
+static MeshData make_cube()
+{
+	MeshData mesh_data;
+	const XMFLOAT3 normals[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	for (int face = 0; face < 6; face++)
+	{
+		XMFLOAT3 n = normals[face];
+		// Two axes of the face plane, so that s x t points along the normal
+		XMFLOAT3 s = std::fabs(n.y) > 0.0f ? XMFLOAT3(1, 0, 0) : XMFLOAT3(0, 1, 0);
+		XMFLOAT3 t = cross(n, s);
+		UINT base = (UINT)mesh_data.vertices.size();
+		for (int corner = 0; corner < 4; corner++)
+		{
+			float a = corner == 1 || corner == 2 ? 1.0f : -1.0f;
+			float b = corner >= 2 ? 1.0f : -1.0f;
+			Vertex vertex = {};
+			vertex.position = { n.x + a * s.x + b * t.x, n.y + a * s.y + b * t.y, n.z + a * s.z + b * t.z };
+			vertex.normal = n;
+			// Rotated and for odd faces mirrored uvs
+			float u = 0.5f + 0.5f * a, v = 0.5f + 0.5f * b;
+			vertex.uvs = face % 2 ? XMFLOAT2(v, u) : XMFLOAT2(1.0f - v, u);
+			mesh_data.vertices.push_back(vertex);
+		}
+		for (UINT index : { base, base + 1, base + 2, base, base + 2, base + 3 })
+		{
+			mesh_data.indices.push_back(index);
+		}
+	}
+	mesh_data.submeshes.push_back({ 0, (UINT)mesh_data.vertices.size(), 0, (UINT)mesh_data.indices.size() });
+	return mesh_data;
+}
+
+// Uv sphere with a seam where u wraps from 1 to 0 and a vertex per segment at the poles, whose quads have one
+// degenerate triangle
+static MeshData make_sphere(int segments, int rings)
+{
+	MeshData mesh_data;
+	for (int r = 0; r <= rings; r++)
+	{
+		for (int s = 0; s <= segments; s++)
+		{
+			float theta = 3.14159265f * r / rings;
+			float phi = 6.2831853f * (s % segments) / segments;
+			Vertex vertex = {};
+			vertex.position = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+			if (r == 0 || r == rings) vertex.position = { 0.0f, r == 0 ? 1.0f : -1.0f, 0.0f };
+			vertex.normal = vertex.position;
+			vertex.uvs = { float(s) / segments, float(r) / rings };
+			mesh_data.vertices.push_back(vertex);
+		}
+	}
+	UINT row = segments + 1;
+	for (int r = 0; r < rings; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			UINT a = r * row + s, b = a + 1, d = a + row, e = d + 1;
+			for (UINT index : { a, b, e, a, e, d })
+			{
+				mesh_data.indices.push_back(index);
+			}
+		}
+	}
+	mesh_data.submeshes.push_back({ 0, (UINT)mesh_data.vertices.size(), 0, (UINT)mesh_data.indices.size() });
+	return mesh_data;
+}
+
+// Two triangles touching at a single vertex with different uv gradients, so the vertex has two separate fans
+static MeshData make_bowtie()
+{
+	MeshData mesh_data;
+	const XMFLOAT3 positions[5] = { { 0, 0, 0 }, { 1, -0.5f, 0 }, { 1, 0.5f, 0 }, { -1, 0.5f, 0 }, { -1, -0.5f, 0 } };
+	const XMFLOAT2 uvs[5] = { { 0.5f, 0.5f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.3f, 0.0f }, { 0.0f, 0.6f } };
+	for (int i = 0; i < 5; i++)
+	{
+		Vertex vertex = {};
+		vertex.position = positions[i];
+		vertex.normal = { 0.0f, 0.0f, 1.0f };
+		vertex.uvs = uvs[i];
+		mesh_data.vertices.push_back(vertex);
+	}
+	mesh_data.indices = { 0, 1, 2, 0, 3, 4 };
+	mesh_data.submeshes.push_back({ 0, 5, 0, 6 });
+	return mesh_data;
+}
+
+// Every triangle with its own three vertices, which MikkTSpace welds back together
+static MeshData unweld(const MeshData& mesh_data)
+{
+	MeshData unwelded;
+	for (UINT index : mesh_data.indices)
+	{
+		unwelded.indices.push_back((UINT)unwelded.vertices.size());
+		unwelded.vertices.push_back(mesh_data.vertices[index]);
+	}
+	unwelded.submeshes.push_back({ 0, (UINT)unwelded.vertices.size(), 0, (UINT)unwelded.indices.size() });
+	return unwelded;
+}
+
+static bool near(float a, float b, float tolerance = 1e-4f)
+{
+	return std::fabs(a - b) <= tolerance;
+}
+
+// Runs generate_tangents and checks the frames against the uv gradients of every triangle. Returns the split count.
+static UINT check_tangents(MeshData mesh_data, float min_alignment)
+{
+	MeshData original = mesh_data;
+	UINT split = generate_tangents(mesh_data);
+	CHECK(mesh_data.vertices.size() == original.vertices.size() + split);
+	const Submesh& submesh = mesh_data.submeshes[0];
+	CHECK(submesh.vertexCount == mesh_data.vertices.size());
+	CHECK(submesh.indexCount == original.indices.size());
+
+	for (const Vertex& vertex : mesh_data.vertices)
+	{
+		XMFLOAT3 normal = normalize(vertex.normal);
+		CHECK(near(dot(vertex.tangent, vertex.tangent), 1.0f));
+		CHECK(near(dot(vertex.bitangent, vertex.bitangent), 1.0f));
+		CHECK(near(dot(vertex.tangent, normal), 0.0f));
+		// Bitangent is cross(normal, tangent) up to the handedness sign
+		CHECK(near(std::fabs(dot(vertex.bitangent, cross(normal, vertex.tangent))), 1.0f));
+	}
+
+	for (size_t i = 0; i < mesh_data.indices.size(); i += 3)
+	{
+		const Vertex* corners[3];
+		for (int c = 0; c < 3; c++)
+		{
+			UINT index = mesh_data.indices[i + c];
+			CHECK(index < submesh.vertexCount);
+			corners[c] = &mesh_data.vertices[index];
+			// Splits only copy vertices, every corner keeps its attributes
+			const Vertex& before = original.vertices[original.indices[i + c]];
+			CHECK(corners[c]->position.x == before.position.x && corners[c]->position.y == before.position.y && corners[c]->position.z == before.position.z);
+			CHECK(corners[c]->uvs.x == before.uvs.x && corners[c]->uvs.y == before.uvs.y);
+			CHECK(corners[c]->normal.x == before.normal.x && corners[c]->normal.z == before.normal.z);
+		}
+
+		// Position derivatives along u and v of the triangle
+		XMFLOAT3 d1 = sub(corners[1]->position, corners[0]->position);
+		XMFLOAT3 d2 = sub(corners[2]->position, corners[0]->position);
+		float t21x = corners[1]->uvs.x - corners[0]->uvs.x, t21y = corners[1]->uvs.y - corners[0]->uvs.y;
+		float t31x = corners[2]->uvs.x - corners[0]->uvs.x, t31y = corners[2]->uvs.y - corners[0]->uvs.y;
+		float signed_area = t21x * t31y - t21y * t31x;
+		XMFLOAT3 dpdu = normalize(scale(sub(scale(d1, t31y), scale(d2, t21y)), 1.0f / signed_area));
+		XMFLOAT3 dpdv = normalize(scale(sub(scale(d2, t21x), scale(d1, t31x)), 1.0f / signed_area));
+		for (const Vertex* corner : corners)
+		{
+			CHECK(dot(corner->tangent, dpdu) >= min_alignment);
+			CHECK(dot(corner->bitangent, dpdv) >= min_alignment);
+		}
+	}
+	return split;
+}
+
+// Corners of a single submesh mesh as MikkTSpace faces, with the tangent and sign it returns for every corner
+struct MikkTSpaceMesh
+{
+	const MeshData* meshData;
+	std::vector<XMFLOAT3> tangents;
+	std::vector<float> signs;
+
+	static const Vertex& corner(const SMikkTSpaceContext* context, int face, int vertex)
+	{
+		const MeshData& mesh_data = *static_cast<MikkTSpaceMesh*>(context->m_pUserData)->meshData;
+		return mesh_data.vertices[mesh_data.indices[face * 3 + vertex]];
+	}
+
+	static int get_num_faces(const SMikkTSpaceContext* context)
+	{
+		return (int)static_cast<MikkTSpaceMesh*>(context->m_pUserData)->meshData->indices.size() / 3;
+	}
+
+	static int get_num_vertices_of_face(const SMikkTSpaceContext*, const int) { return 3; }
+
+	static void get_position(const SMikkTSpaceContext* context, float position[], const int face, const int vertex)
+	{
+		const XMFLOAT3& p = corner(context, face, vertex).position;
+		position[0] = p.x; position[1] = p.y; position[2] = p.z;
+	}
+
+	static void get_normal(const SMikkTSpaceContext* context, float normal[], const int face, const int vertex)
+	{
+		const XMFLOAT3& n = corner(context, face, vertex).normal;
+		normal[0] = n.x; normal[1] = n.y; normal[2] = n.z;
+	}
+
+	static void get_tex_coord(const SMikkTSpaceContext* context, float uv[], const int face, const int vertex)
+	{
+		uv[0] = corner(context, face, vertex).uvs.x;
+		uv[1] = corner(context, face, vertex).uvs.y;
+	}
+
+	static void set_tspace_basic(const SMikkTSpaceContext* context, const float tangent[], const float sign, const int face, const int vertex)
+	{
+		MikkTSpaceMesh& mesh = *static_cast<MikkTSpaceMesh*>(context->m_pUserData);
+		mesh.tangents[face * 3 + vertex] = { tangent[0], tangent[1], tangent[2] };
+		mesh.signs[face * 3 + vertex] = sign;
+	}
+};
+
+// Frame of every corner after generate_tangents against genTangSpaceDefault. Returns the split count.
+static UINT compare_to_mikktspace(const MeshData& mesh_data)
+{
+	SMikkTSpaceInterface callbacks = {};
+	callbacks.m_getNumFaces = MikkTSpaceMesh::get_num_faces;
+	callbacks.m_getNumVerticesOfFace = MikkTSpaceMesh::get_num_vertices_of_face;
+	callbacks.m_getPosition = MikkTSpaceMesh::get_position;
+	callbacks.m_getNormal = MikkTSpaceMesh::get_normal;
+	callbacks.m_getTexCoord = MikkTSpaceMesh::get_tex_coord;
+	callbacks.m_setTSpaceBasic = MikkTSpaceMesh::set_tspace_basic;
+	MikkTSpaceMesh reference = { &mesh_data, std::vector<XMFLOAT3>(mesh_data.indices.size()), std::vector<float>(mesh_data.indices.size()) };
+	SMikkTSpaceContext context = { &callbacks, &reference };
+	CHECK(genTangSpaceDefault(&context));
+
+	MeshData generated = mesh_data;
+	UINT split = generate_tangents(generated);
+	for (size_t i = 0; i < generated.indices.size(); i++)
+	{
+		const Vertex& vertex = generated.vertices[generated.indices[i]];
+		const XMFLOAT3& tangent = reference.tangents[i];
+		CHECK(near(vertex.tangent.x, tangent.x) && near(vertex.tangent.y, tangent.y) && near(vertex.tangent.z, tangent.z));
+		float sign = dot(vertex.bitangent, cross(normalize(vertex.normal), vertex.tangent)) < 0.0f ? -1.0f : 1.0f;
+		CHECK(sign == reference.signs[i]);
+	}
+	return split;
+}
+
+int main()
+{
+	const int columns = 8;
+	const int rows = 4;
+
+	// Planar affine mapping: the frame is exactly the uv axes, also when u runs backwards
+	CHECK(check_tangents(make_grid(columns, rows, 0.0f, [](float x) { return x; }), 0.9999f) == 0);
+	CHECK(check_tangents(make_grid(columns, rows, 0.0f, [](float x) { return -x; }), 0.9999f) == 0);
+
+	// Mirrored at x = 0: the seam column is split, each side keeps the frame of its own triangles
+	CHECK(check_tangents(make_grid(columns, rows, 0.0f, [](float x) { return std::fabs(x); }), 0.9999f) == rows + 1);
+
+	// Curved surface, averaged frames still follow the gradients of the neighbouring triangles
+	CHECK(check_tangents(make_grid(columns, rows, 1.2f, [](float x) { return x; }), 0.9f) == 0);
+	CHECK(check_tangents(make_grid(columns, rows, 1.2f, [](float x) { return std::fabs(x); }), 0.9f) == rows + 1);
+
+	// Seams where u wraps around and poles with degenerate triangles
+	CHECK(compare_to_mikktspace(make_sphere(12, 6)) == 0);
+	// Large enough to be split across threads
+	CHECK(compare_to_mikktspace(make_sphere(256, 128)) == 0);
+	// Mirrored, flat and curved, each side of the seam column gets its own fan
+	CHECK(compare_to_mikktspace(make_grid(columns, rows, 0.0f, [](float x) { return std::fabs(x); })) == rows + 1);
+	CHECK(compare_to_mikktspace(make_grid(columns, rows, 1.2f, [](float x) { return std::fabs(x); })) == rows + 1);
+	CHECK(compare_to_mikktspace(make_grid(columns, rows, 1.2f, [](float x) { return x * x * x + x; })) == 0);
+	// Hard edges between faces, and a vertex whose triangles only meet at it
+	CHECK(compare_to_mikktspace(make_cube()) == 0);
+	CHECK(compare_to_mikktspace(make_bowtie()) == 1);
+	// Triangles without uv area join the fans around them, vertices only in such triangles get the default frame
+	CHECK(compare_to_mikktspace(make_grid(columns, rows, 0.0f, [](float x) { return std::max(-0.5f, std::min(0.5f, x)); })) == 0);
+	// Corners with equal attributes are welded before the fans are built
+	CHECK(compare_to_mikktspace(unweld(make_grid(columns, rows, 1.2f, [](float x) { return std::fabs(x); }))) == 0);
+	CHECK(compare_to_mikktspace(unweld(make_sphere(12, 6))) == 0);
+
+	// Triangles without uv area don't constrain the frame, which still comes out orthonormal
+	MeshData flat = make_grid(columns, rows, 0.0f, [](float) { return 0.5f; });
+	generate_tangents(flat);
+	for (const Vertex& vertex : flat.vertices)
+	{
+		CHECK(near(dot(vertex.tangent, vertex.tangent), 1.0f));
+		CHECK(near(dot(vertex.tangent, vertex.normal), 0.0f));
+	}
+	return 0;
+}
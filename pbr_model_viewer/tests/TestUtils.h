@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Aborts the test with the failed condition, ctest only looks at the exit code
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			std::exit(1); \
+		} \
+	} while (0)
+
+class Timer
+{
+public:
+	Timer() : m_start(std::chrono::steady_clock::now()) {}
+
+	double elapsedMs() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point m_start;
+};
+
+// Tests run with small sizes under ctest, the first argument scales them up for benchmarking
+inline size_t get_size_arg(int argc, char** argv, size_t default_size)
+{
+	return argc > 1 ? std::strtoull(argv[1], nullptr, 10) : default_size;
+}
@@ -0,0 +1,493 @@
+// DDS and KTX2 reading: legacy FourCC and RGB headers, DX10 headers, BGRA pixels swapped to RGBA, cubemaps, the
+// KTX2 level layout, write_dds round trips, and truncated, oversized or unsupported files being rejected.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <resource/DdsFile.h>
+#include <resource/KtxFile.h>
+#include <resource/TextureData.h>
+
+#include "TestUtils.h"
+
+static const uint32_t ddpf_alphapixels = 0x1;
+static const uint32_t ddpf_fourcc = 0x4;
+static const uint32_t ddpf_rgb = 0x40;
+static const uint32_t ddscaps2_cubemap = 0x200;
+static const uint32_t ddscaps2_all_faces = 0xFC00;
+
+static void put32(std::vector<unsigned char>& bytes, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		bytes.push_back((unsigned char)(value >> (i * 8)));
+	}
+}
+
+static void put64(std::vector<unsigned char>& bytes, uint64_t value)
+{
+	put32(bytes, uint32_t(value));
+	put32(bytes, uint32_t(value >> 32));
+}
+
+static void write_file(const std::string& filename, const std::vector<unsigned char>& bytes)
+{
+	FILE* file = std::fopen(filename.c_str(), "wb");
+	CHECK(file);
+	if (!bytes.empty())
+	{
+		std::fwrite(bytes.data(), 1, bytes.size(), file);
+	}
+	std::fclose(file);
+}
+
+struct DdsDesc
+{
+	uint32_t width = 4;
+	uint32_t height = 4;
+	uint32_t mipCount = 1;
+	uint32_t pixelFlags = ddpf_fourcc;
+	uint32_t fourCC = 0;
+	uint32_t rgbBitCount = 0;
+	uint32_t masks[4] = {};
+	uint32_t caps2 = 0;
+	// Only written for the DX10 FourCC
+	uint32_t dxgiFormat = 0;
+	uint32_t dimension = 3;
+	uint32_t miscFlag = 0;
+	uint32_t arraySize = 1;
+};
+
+static uint32_t fourcc(const char* code)
+{
+	return uint32_t(code[0]) | uint32_t(code[1]) << 8 | uint32_t(code[2]) << 16 | uint32_t(code[3]) << 24;
+}
+
+static std::vector<unsigned char> make_dds(const DdsDesc& desc, const std::vector<unsigned char>& pixels)
+{
+	std::vector<unsigned char> bytes;
+	put32(bytes, fourcc("DDS "));
+	put32(bytes, 124);
+	put32(bytes, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000);
+	put32(bytes, desc.height);
+	put32(bytes, desc.width);
+	put32(bytes, 0);
+	put32(bytes, 1);
+	put32(bytes, desc.mipCount);
+	for (int i = 0; i < 11; i++)
+	{
+		put32(bytes, 0);
+	}
+	put32(bytes, 32);
+	put32(bytes, desc.pixelFlags);
+	put32(bytes, desc.fourCC);
+	put32(bytes, desc.rgbBitCount);
+	for (uint32_t mask : desc.masks)
+	{
+		put32(bytes, mask);
+	}
+	put32(bytes, 0x1000);
+	put32(bytes, desc.caps2);
+	put32(bytes, 0);
+	put32(bytes, 0);
+	put32(bytes, 0);
+	if (desc.pixelFlags == ddpf_fourcc && desc.fourCC == fourcc("DX10"))
+	{
+		put32(bytes, desc.dxgiFormat);
+		put32(bytes, desc.dimension);
+		put32(bytes, desc.miscFlag);
+		put32(bytes, desc.arraySize);
+		put32(bytes, 0);
+	}
+	bytes.insert(bytes.end(), pixels.begin(), pixels.end());
+	return bytes;
+}
+
+static std::vector<unsigned char> make_pattern(size_t size, unsigned char seed)
+{
+	std::vector<unsigned char> pixels(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		pixels[i] = (unsigned char)(i * 7 + seed);
+	}
+	return pixels;
+}
+
+static bool read_bytes(const std::string& filename, const std::vector<unsigned char>& bytes, TextureData& data)
+{
+	write_file(filename, bytes);
+	bool read = read_texture_container(filename, data);
+	std::remove(filename.c_str());
+	return read;
+}
+
+static void test_dds_legacy()
+{
+	TextureData data;
+
+	// DXT1 with a full chain of 8x8, 4x4, 2x2 and 1x1, every level at least one 8 byte block
+	DdsDesc dxt1;
+	dxt1.width = 8;
+	dxt1.height = 8;
+	dxt1.mipCount = 4;
+	dxt1.fourCC = fourcc("DXT1");
+	std::vector<unsigned char> blocks = make_pattern(32 + 8 + 8 + 8, 1);
+	CHECK(read_bytes("legacy.dds", make_dds(dxt1, blocks), data));
+	CHECK(data.format == DXGI_FORMAT_BC1_UNORM && data.width == 8 && data.height == 8 && data.mipCount == 4 && data.faceCount == 1);
+	CHECK(data.pixels == blocks);
+
+	const char* codes[] = { "DXT5", "ATI1", "BC4U", "ATI2", "BC5U" };
+	const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC5_UNORM };
+	for (int i = 0; i < 5; i++)
+	{
+		DdsDesc desc;
+		desc.fourCC = fourcc(codes[i]);
+		CHECK(read_bytes("legacy.dds", make_dds(desc, make_pattern(16, 2)), data));
+		CHECK(data.format == formats[i] && data.mipCount == 1);
+	}
+
+	DdsDesc dxt3;
+	dxt3.fourCC = fourcc("DXT3");
+	CHECK(!read_bytes("legacy.dds", make_dds(dxt3, make_pattern(16, 2)), data));
+
+	// 0 mips in the header means one
+	DdsDesc no_mips = dxt1;
+	no_mips.mipCount = 0;
+	CHECK(read_bytes("legacy.dds", make_dds(no_mips, blocks), data));
+	CHECK(data.mipCount == 1 && data.pixels.size() == 32);
+}
+
+static void test_dds_rgb()
+{
+	TextureData data;
+	std::vector<unsigned char> pixels = make_pattern(4 * 4 * 4, 3);
+
+	DdsDesc rgba;
+	rgba.pixelFlags = ddpf_rgb | ddpf_alphapixels;
+	rgba.rgbBitCount = 32;
+	uint32_t rgba_masks[4] = { 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 };
+	std::memcpy(rgba.masks, rgba_masks, sizeof(rgba_masks));
+	CHECK(read_bytes("rgb.dds", make_dds(rgba, pixels), data));
+	CHECK(data.format == DXGI_FORMAT_R8G8B8A8_UNORM && data.pixels == pixels);
+
+	// BGRA comes back as RGBA
+	DdsDesc bgra = rgba;
+	bgra.masks[0] = 0x00FF0000;
+	bgra.masks[2] = 0x000000FF;
+	CHECK(read_bytes("rgb.dds", make_dds(bgra, pixels), data));
+	CHECK(data.format == DXGI_FORMAT_R8G8B8A8_UNORM);
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		CHECK(data.pixels[i] == pixels[i + 2] && data.pixels[i + 1] == pixels[i + 1] && data.pixels[i + 2] == pixels[i] &&
+			  data.pixels[i + 3] == pixels[i + 3]);
+	}
+
+	// Without alpha the padding byte is read as it is, whatever the alpha mask says
+	DdsDesc bgrx = bgra;
+	bgrx.pixelFlags = ddpf_rgb;
+	bgrx.masks[3] = 0;
+	CHECK(read_bytes("rgb.dds", make_dds(bgrx, pixels), data));
+	CHECK(data.pixels[0] == pixels[2] && data.pixels[3] == pixels[3]);
+
+	DdsDesc rgb24 = rgba;
+	rgb24.rgbBitCount = 24;
+	CHECK(!read_bytes("rgb.dds", make_dds(rgb24, pixels), data));
+	DdsDesc odd_alpha = rgba;
+	odd_alpha.masks[3] = 0x00FF0000;
+	CHECK(!read_bytes("rgb.dds", make_dds(odd_alpha, pixels), data));
+}
+
+static void test_dds_dx10_and_cubes()
+{
+	TextureData data;
+
+	DdsDesc bc7;
+	bc7.fourCC = fourcc("DX10");
+	bc7.width = 8;
+	bc7.height = 4;
+	bc7.mipCount = 2;
+	bc7.dxgiFormat = DXGI_FORMAT_BC7_UNORM_SRGB;
+	std::vector<unsigned char> blocks = make_pattern(32 + 16, 4);
+	CHECK(read_bytes("dx10.dds", make_dds(bc7, blocks), data));
+	CHECK(data.format == DXGI_FORMAT_BC7_UNORM && data.width == 8 && data.height == 4 && data.mipCount == 2 && data.pixels == blocks);
+
+	DdsDesc array = bc7;
+	array.arraySize = 2;
+	CHECK(!read_bytes("dx10.dds", make_dds(array, make_pattern(96, 4)), data));
+	DdsDesc volume = bc7;
+	volume.dimension = 4;
+	CHECK(!read_bytes("dx10.dds", make_dds(volume, blocks), data));
+	DdsDesc float_format = bc7;
+	float_format.dxgiFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	CHECK(!read_bytes("dx10.dds", make_dds(float_format, make_pattern(8 * 4 * 16 + 4 * 2 * 16, 4)), data));
+
+	// Faces are stored one after the other with all their mips, like TextureData keeps them
+	DdsDesc cube;
+	cube.fourCC = fourcc("DX10");
+	cube.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+	cube.width = 2;
+	cube.height = 2;
+	cube.mipCount = 2;
+	cube.miscFlag = 0x4;
+	std::vector<unsigned char> faces = make_pattern(6 * (16 + 4), 5);
+	CHECK(read_bytes("cube.dds", make_dds(cube, faces), data));
+	CHECK(data.faceCount == 6 && data.mipCount == 2 && data.pixels == faces);
+	CHECK(data.getMipOffset(3, 1) == 3 * 20 + 16);
+
+	DdsDesc legacy_cube;
+	legacy_cube.fourCC = fourcc("DXT1");
+	legacy_cube.caps2 = ddscaps2_cubemap | ddscaps2_all_faces;
+	CHECK(read_bytes("cube.dds", make_dds(legacy_cube, make_pattern(6 * 8, 6)), data));
+	CHECK(data.faceCount == 6 && data.format == DXGI_FORMAT_BC1_UNORM);
+
+	DdsDesc partial_cube = legacy_cube;
+	partial_cube.caps2 = ddscaps2_cubemap | 0x400 | 0x800;
+	CHECK(!read_bytes("cube.dds", make_dds(partial_cube, make_pattern(6 * 8, 6)), data));
+}
+
+static void test_dds_rejected()
+{
+	TextureData data;
+	DdsDesc rgba;
+	rgba.fourCC = fourcc("DX10");
+	rgba.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+	std::vector<unsigned char> good = make_dds(rgba, make_pattern(64, 7));
+	CHECK(read_bytes("bad.dds", good, data));
+
+	// Every truncation, down to the magic, fails instead of reading past the end
+	for (size_t size = 0; size < good.size(); size++)
+	{
+		CHECK(!read_bytes("bad.dds", std::vector<unsigned char>(good.begin(), good.begin() + size), data));
+	}
+
+	std::vector<unsigned char> bad_magic = good;
+	bad_magic[0] = 'X';
+	CHECK(!read_bytes("bad.dds", bad_magic, data));
+
+	DdsDesc zero = rgba;
+	zero.width = 0;
+	CHECK(!read_bytes("bad.dds", make_dds(zero, make_pattern(64, 7)), data));
+
+	DdsDesc too_many_mips = rgba;
+	too_many_mips.mipCount = 4;
+	CHECK(!read_bytes("bad.dds", make_dds(too_many_mips, make_pattern(1024, 7)), data));
+
+	// Sizes past what D3D11 can create are rejected before any size math, whose products would overflow otherwise
+	const uint32_t sizes[][2] = { { 16385, 1 }, { 1, 16385 }, { 0x80000000u, 0x80000000u }, { 0xFFFFFFFFu, 0xFFFFFFFFu } };
+	for (const auto& size : sizes)
+	{
+		DdsDesc huge = rgba;
+		huge.width = size[0];
+		huge.height = size[1];
+		CHECK(!read_bytes("bad.dds", make_dds(huge, make_pattern(64, 7)), data));
+	}
+
+	CHECK(!read_texture_container("missing.dds", data));
+}
+
+static void test_dds_round_trip()
+{
+	TextureData source;
+	source.width = 8;
+	source.height = 4;
+	source.faceCount = 6;
+	source.mipCount = 4;
+	source.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	source.pixels = make_pattern(source.getFaceSize() * 6, 8);
+	CHECK(write_dds("written.dds", source));
+
+	TextureData data;
+	CHECK(read_texture_container("written.dds", data));
+	CHECK(data.width == 8 && data.height == 4 && data.faceCount == 6 && data.mipCount == 4 && data.format == source.format);
+	CHECK(data.pixels == source.pixels);
+
+	TextureData bc5;
+	bc5.width = 16;
+	bc5.height = 16;
+	bc5.faceCount = 1;
+	bc5.mipCount = 5;
+	bc5.format = DXGI_FORMAT_BC5_UNORM;
+	bc5.pixels = make_pattern(bc5.getFaceSize(), 9);
+	CHECK(write_dds("written.dds", bc5));
+	CHECK(read_dds("written.dds", data));
+	CHECK(data.format == DXGI_FORMAT_BC5_UNORM && data.mipCount == 5 && data.pixels == bc5.pixels);
+	std::remove("written.dds");
+}
+
+struct KtxDesc
+{
+	uint32_t vkFormat = 37;
+	uint32_t width = 4;
+	uint32_t height = 4;
+	uint32_t depth = 0;
+	uint32_t layers = 0;
+	uint32_t faces = 1;
+	uint32_t levels = 1;
+	uint32_t supercompression = 0;
+};
+
+static const unsigned char ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// levels holds the data of each level, every face of it together. They are stored smallest first like the spec
+// recommends, so the level index is what orders them.
+static std::vector<unsigned char> make_ktx2(const KtxDesc& desc, const std::vector<std::vector<unsigned char>>& levels)
+{
+	std::vector<unsigned char> bytes(ktx2_identifier, ktx2_identifier + 12);
+	put32(bytes, desc.vkFormat);
+	put32(bytes, 1);
+	put32(bytes, desc.width);
+	put32(bytes, desc.height);
+	put32(bytes, desc.depth);
+	put32(bytes, desc.layers);
+	put32(bytes, desc.faces);
+	put32(bytes, desc.levels);
+	put32(bytes, desc.supercompression);
+	for (int i = 0; i < 4; i++)
+	{
+		put32(bytes, 0);
+	}
+	put64(bytes, 0);
+	put64(bytes, 0);
+
+	size_t offset = bytes.size() + levels.size() * 24;
+	std::vector<uint64_t> offsets(levels.size());
+	for (size_t level = levels.size(); level-- > 0;)
+	{
+		offsets[level] = offset;
+		offset += levels[level].size();
+	}
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		put64(bytes, offsets[level]);
+		put64(bytes, levels[level].size());
+		put64(bytes, levels[level].size());
+	}
+	for (size_t level = levels.size(); level-- > 0;)
+	{
+		bytes.insert(bytes.end(), levels[level].begin(), levels[level].end());
+	}
+	return bytes;
+}
+
+static void test_ktx2()
+{
+	TextureData data;
+
+	KtxDesc rgba;
+	rgba.width = 4;
+	rgba.height = 2;
+	rgba.levels = 3;
+	std::vector<std::vector<unsigned char>> levels = { make_pattern(32, 1), make_pattern(8, 2), make_pattern(4, 3) };
+	CHECK(read_bytes("image.ktx2", make_ktx2(rgba, levels), data));
+	CHECK(data.format == DXGI_FORMAT_R8G8B8A8_UNORM && data.width == 4 && data.height == 2 && data.mipCount == 3 && data.faceCount == 1);
+	for (UINT mip = 0; mip < 3; mip++)
+	{
+		CHECK(std::memcmp(data.pixels.data() + data.getMipOffset(0, mip), levels[mip].data(), levels[mip].size()) == 0);
+	}
+
+	// Level 0 asks for generated mips and reads a single level
+	KtxDesc generated = rgba;
+	generated.levels = 0;
+	CHECK(read_bytes("image.ktx2", make_ktx2(generated, { levels[0] }), data));
+	CHECK(data.mipCount == 1 && data.pixels == levels[0]);
+
+	// Cubemap levels hold every face of a mip, TextureData every mip of a face
+	KtxDesc cube;
+	cube.vkFormat = 131;
+	cube.width = 8;
+	cube.height = 8;
+	cube.faces = 6;
+	cube.levels = 2;
+	std::vector<std::vector<unsigned char>> cube_levels = { make_pattern(6 * 32, 4), make_pattern(6 * 8, 5) };
+	CHECK(read_bytes("cube.ktx2", make_ktx2(cube, cube_levels), data));
+	CHECK(data.format == DXGI_FORMAT_BC1_UNORM && data.faceCount == 6 && data.mipCount == 2);
+	for (UINT face = 0; face < 6; face++)
+	{
+		CHECK(std::memcmp(data.pixels.data() + data.getMipOffset(face, 0), cube_levels[0].data() + face * 32, 32) == 0);
+		CHECK(std::memcmp(data.pixels.data() + data.getMipOffset(face, 1), cube_levels[1].data() + face * 8, 8) == 0);
+	}
+
+	const uint32_t vk_formats[] = { 43, 132, 133, 134, 137, 138, 139, 141, 145, 146 };
+	const DXGI_FORMAT formats[] = { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM,
+									DXGI_FORMAT_BC3_UNORM,		DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM,
+									DXGI_FORMAT_BC7_UNORM,		DXGI_FORMAT_BC7_UNORM };
+	for (int i = 0; i < 10; i++)
+	{
+		KtxDesc desc;
+		desc.vkFormat = vk_formats[i];
+		CHECK(read_bytes("format.ktx2", make_ktx2(desc, { make_pattern(64, 6) }), data));
+		CHECK(data.format == formats[i]);
+	}
+}
+
+static void test_ktx2_rejected()
+{
+	TextureData data;
+	KtxDesc rgba;
+	std::vector<unsigned char> good = make_ktx2(rgba, { make_pattern(64, 1) });
+	CHECK(read_bytes("bad.ktx2", good, data));
+	for (size_t size = 0; size < good.size(); size++)
+	{
+		CHECK(!read_bytes("bad.ktx2", std::vector<unsigned char>(good.begin(), good.begin() + size), data));
+	}
+
+	KtxDesc float_format;
+	float_format.vkFormat = 109;
+	KtxDesc supercompressed;
+	supercompressed.supercompression = 1;
+	KtxDesc array;
+	array.layers = 2;
+	KtxDesc volume;
+	volume.depth = 2;
+	KtxDesc three_faces;
+	three_faces.faces = 3;
+	KtxDesc too_many_levels;
+	too_many_levels.levels = 4;
+	KtxDesc too_wide;
+	too_wide.width = 16385;
+	KtxDesc too_high;
+	too_high.height = 16385;
+	KtxDesc huge;
+	huge.width = 0xFFFFFFFFu;
+	huge.height = 0xFFFFFFFFu;
+	for (const KtxDesc& desc : { float_format, supercompressed, array, volume, three_faces, too_many_levels, too_wide, too_high, huge })
+	{
+		CHECK(!read_bytes("bad.ktx2", make_ktx2(desc, { make_pattern(64, 1), make_pattern(16, 2), make_pattern(4, 3), make_pattern(4, 4) }), data));
+	}
+
+	// A level shorter than its mip, or pointing past the end of the file
+	CHECK(!read_bytes("bad.ktx2", make_ktx2(rgba, { make_pattern(60, 1) }), data));
+	std::vector<unsigned char> past_end = good;
+	past_end[80] = 0xF0;
+	CHECK(!read_bytes("bad.ktx2", past_end, data));
+	std::vector<unsigned char> offset_overflow = good;
+	std::memset(offset_overflow.data() + 80, 0xFF, 8);
+	CHECK(!read_bytes("bad.ktx2", offset_overflow, data));
+
+	CHECK(!read_texture_container("missing.ktx2", data));
+}
+
+static void test_extensions()
+{
+	CHECK(is_texture_container("textures/albedo.dds"));
+	CHECK(is_texture_container("TEXTURES\\ALBEDO.DDS"));
+	CHECK(is_texture_container("normal.Ktx2"));
+	CHECK(!is_texture_container("albedo.png"));
+	CHECK(!is_texture_container("dds"));
+	CHECK(!is_texture_container("albedo.dds.png"));
+}
+
+int main()
+{
+	test_dds_legacy();
+	test_dds_rgb();
+	test_dds_dx10_and_cubes();
+	test_dds_rejected();
+	test_dds_round_trip();
+	test_ktx2();
+	test_ktx2_rejected();
+	test_extensions();
+	return 0;
+}
@@ -0,0 +1,127 @@
+// pack_channels against a scalar reference for every subset of source channels, at widths that leave 1 to 3 pixels
+// after the groups of 4 and at a size split across threads, and the rejection of sources it can't pack.
+// Prints the throughput.
+
+#include <random>
+#include <vector>
+
+#include <resource/TexturePacking.h>
+
+#include "TestUtils.h"
+
+static const UINT fallback = 0x80FF4020;
+
+static TextureData make_source(UINT width, UINT height, std::mt19937& rng)
+{
+	TextureData data = {};
+	data.width = width;
+	data.height = height;
+	data.faceCount = 1;
+	data.mipCount = 1;
+	data.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	data.pixels.resize(data.getFaceSize());
+	for (unsigned char& byte : data.pixels)
+	{
+		byte = (unsigned char)rng();
+	}
+	return data;
+}
+
+// Byte by byte, the red byte of a source or the byte of fallback
+static std::vector<unsigned char> pack_reference(const TextureData* const sources[4], UINT width, UINT height)
+{
+	std::vector<unsigned char> pixels(size_t(width) * height * 4);
+	for (size_t pixel = 0; pixel < size_t(width) * height; pixel++)
+	{
+		for (UINT channel = 0; channel < 4; channel++)
+		{
+			pixels[pixel * 4 + channel] = sources[channel] ? sources[channel]->pixels[pixel * 4] : (unsigned char)(fallback >> (channel * 8));
+		}
+	}
+	return pixels;
+}
+
+static void check_pack(UINT width, UINT height, std::mt19937& rng)
+{
+	TextureData channels[4];
+	for (TextureData& channel : channels)
+	{
+		channel = make_source(width, height, rng);
+	}
+	for (UINT mask = 1; mask < 16; mask++)
+	{
+		const TextureData* sources[4] = {};
+		for (UINT channel = 0; channel < 4; channel++)
+		{
+			if (mask & (1 << channel)) sources[channel] = &channels[channel];
+		}
+		TextureData packed = {};
+		CHECK(pack_channels(sources, fallback, packed));
+		CHECK(packed.width == width && packed.height == height && packed.faceCount == 1 && packed.mipCount == 1);
+		CHECK(packed.format == DXGI_FORMAT_R8G8B8A8_UNORM);
+		CHECK(packed.pixels == pack_reference(sources, width, height));
+	}
+}
+
+static void test_rejected()
+{
+	std::mt19937 rng(2);
+	TextureData source = make_source(8, 8, rng);
+	TextureData packed = {};
+
+	const TextureData* none[4] = {};
+	CHECK(!pack_channels(none, fallback, packed));
+
+	TextureData narrower = make_source(7, 8, rng);
+	TextureData shorter = make_source(8, 7, rng);
+	const TextureData* mismatched_width[4] = { &source, nullptr, &narrower, nullptr };
+	const TextureData* mismatched_height[4] = { nullptr, &shorter, nullptr, &source };
+	CHECK(!pack_channels(mismatched_width, fallback, packed));
+	CHECK(!pack_channels(mismatched_height, fallback, packed));
+
+	// Any source that isn't a single RGBA8 image, wherever it sits
+	TextureData compressed = source;
+	compressed.format = DXGI_FORMAT_BC1_UNORM;
+	TextureData srgb = source;
+	srgb.format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	TextureData mipped = source;
+	mipped.mipCount = 2;
+	TextureData cube = source;
+	cube.faceCount = 6;
+	for (const TextureData* invalid : { &compressed, &srgb, &mipped, &cube })
+	{
+		for (UINT channel = 0; channel < 4; channel++)
+		{
+			const TextureData* alone[4] = {};
+			alone[channel] = invalid;
+			CHECK(!pack_channels(alone, fallback, packed));
+			const TextureData* mixed[4] = { &source, &source, &source, &source };
+			mixed[channel] = invalid;
+			CHECK(!pack_channels(mixed, fallback, packed));
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::mt19937 rng(1);
+	// Tails of 0 to 3 pixels after the groups of 4, rows included
+	for (UINT width = 1; width <= 9; width++)
+	{
+		check_pack(width, 1, rng);
+		check_pack(width, 3, rng);
+	}
+	// Enough pixels for several jobs, with an odd total
+	check_pack(301, 257, rng);
+	test_rejected();
+
+	UINT size = (UINT)get_size_arg(argc, argv, 512);
+	TextureData channels[3] = { make_source(size, size, rng), make_source(size, size, rng), make_source(size, size, rng) };
+	const TextureData* sources[4] = { &channels[0], &channels[1], &channels[2], nullptr };
+	TextureData packed = {};
+	Timer timer;
+	CHECK(pack_channels(sources, fallback, packed));
+	double ms = timer.elapsedMs();
+	std::printf("%ux%u ORM: %.2f ms, %.1f MPix/s\n", size, size, ms, double(size) * size / (ms * 1000.0));
+	return 0;
+}
@@ -0,0 +1,152 @@
+// TextureResidency on synthetic access traces: least recently visible textures lose levels first, visible ones get
+// them back, nothing is evicted unless it makes room, and random traces keep to the budget without changing anything
+// once the visible set settles.
+
+#include <random>
+#include <vector>
+
+#include <resource/TextureResidency.h>
+
+#include "TestUtils.h"
+
+static const std::vector<size_t> mips = { 64, 16, 4, 1 };
+
+static void test_lru()
+{
+	std::vector<TextureResidency::Change> changes;
+	{
+		TextureResidency residency(1000);
+		for (UINT id = 1; id <= 3; id++) residency.add(id, mips, 2, 0);
+		residency.update(0, changes);
+		CHECK(changes.empty() && residency.getResidentBytes() == 3 * 85);
+	}
+
+	// 3 was seen last, then 1, while 2 is visible
+	TextureResidency residency(150);
+	for (UINT id = 1; id <= 3; id++) residency.add(id, mips, 2, 0);
+	residency.touch(1, 1);
+	residency.touch(2, 2);
+	residency.update(2, changes);
+	CHECK(residency.getFirstMip(3) == 2 && residency.getFirstMip(1) == 1 && residency.getFirstMip(2) == 0);
+	CHECK(residency.getResidentBytes() <= 150 && changes.size() == 2);
+
+	// 3 visible again takes its levels back from the others
+	changes.clear();
+	residency.touch(3, 3);
+	residency.update(3, changes);
+	CHECK(residency.getFirstMip(3) == 0 && residency.getResidentBytes() <= 150);
+	for (const TextureResidency::Change& change : changes)
+	{
+		CHECK(change.firstMip == residency.getFirstMip(change.id));
+	}
+
+	// Below what the visible texture needs everything goes down to its floor once, then stays there
+	residency.setBudget(10);
+	for (uint64_t frame = 4; frame < 8; frame++)
+	{
+		changes.clear();
+		residency.touch(3, frame);
+		residency.update(frame, changes);
+		CHECK(frame == 4 || changes.empty());
+	}
+	CHECK(residency.getFirstMip(1) == 2 && residency.getFirstMip(2) == 2 && residency.getFirstMip(3) == 2);
+	residency.remove(2);
+	CHECK(residency.getResidentBytes() == 10 && residency.getEvictedBytes() == 160);
+}
+
+// A level that can't fit even with every other texture at its floor must not evict anything
+static void test_no_wasted_eviction()
+{
+	std::vector<TextureResidency::Change> changes;
+	TextureResidency residency(40);
+	residency.add(1, mips, 3, 0);
+	residency.add(2, { 8, 4, 2, 1 }, 2, 0);
+	residency.touch(1, 1);
+	residency.update(1, changes);
+	CHECK(residency.getFirstMip(1) == 1 && residency.getFirstMip(2) == 2 && residency.getResidentBytes() == 24);
+
+	// 2 gets its levels back
+	residency.setBudget(60);
+	changes.clear();
+	residency.touch(2, 2);
+	residency.update(2, changes);
+	CHECK(residency.getFirstMip(2) == 0 && residency.getResidentBytes() == 36 && changes.size() == 1);
+
+	// 1 needs 64 bytes but evicting all of 2 only frees 12, so neither moves
+	for (uint64_t frame = 3; frame < 6; frame++)
+	{
+		changes.clear();
+		residency.touch(1, frame);
+		residency.update(frame, changes);
+		CHECK(changes.empty());
+		CHECK(residency.getFirstMip(1) == 1 && residency.getFirstMip(2) == 0 && residency.getResidentBytes() == 36);
+	}
+
+	// A failed change puts the texture back where it really is
+	residency.setFirstMip(2, 1);
+	CHECK(residency.getResidentBytes() == 28 && residency.getFirstMip(2) == 1);
+}
+
+static void test_random_trace(int frame_count)
+{
+	std::mt19937 rng(5);
+	TextureResidency residency(3000);
+	std::vector<size_t> floors(41, 0);
+	for (UINT id = 1; id <= 40; id++)
+	{
+		std::vector<size_t> levels;
+		for (size_t bytes = 1 + rng() % 512; bytes > 0; bytes /= 4) levels.push_back(bytes);
+		UINT max_first_mip = UINT(levels.size() - 1);
+		residency.add(id, levels, max_first_mip, 0);
+		floors[id] = levels.back();
+	}
+	size_t floor_bytes = 0;
+	for (size_t bytes : floors) floor_bytes += bytes;
+
+	std::vector<TextureResidency::Change> changes;
+	std::vector<UINT> visible;
+	for (uint64_t frame = 1; frame < uint64_t(frame_count); frame++)
+	{
+		// The visible set changes every 50 frames, the budget every 300
+		if (frame % 50 == 1)
+		{
+			visible.clear();
+			for (int i = 0; i < 5; i++) visible.push_back(1 + rng() % 40);
+		}
+		if (frame % 300 == 0) residency.setBudget(500 + rng() % 5000);
+		for (UINT id : visible) residency.touch(id, frame);
+
+		std::vector<UINT> before(41);
+		for (UINT id = 1; id <= 40; id++) before[id] = residency.getFirstMip(id);
+		size_t resident_before = residency.getResidentBytes();
+		changes.clear();
+		residency.update(frame, changes);
+
+		CHECK(residency.getResidentBytes() <= std::max(residency.getBudget(), floor_bytes));
+		for (const TextureResidency::Change& change : changes)
+		{
+			CHECK(change.firstMip == residency.getFirstMip(change.id) && change.firstMip != before[change.id]);
+		}
+		// Within budget, levels are only evicted to make room for the visible textures
+		bool evicted = false;
+		bool restored = false;
+		for (UINT id = 1; id <= 40; id++)
+		{
+			evicted |= residency.getFirstMip(id) > before[id];
+			restored |= residency.getFirstMip(id) < before[id];
+		}
+		CHECK(!evicted || restored || resident_before > residency.getBudget());
+		// Settled after the first frame of a visible set
+		CHECK(frame % 50 == 1 || frame % 300 == 0 || changes.empty());
+	}
+	std::printf("random trace: %zu resident of %zu budget, %zu evicted\n", residency.getResidentBytes(), residency.getBudget(),
+				residency.getEvictedBytes());
+}
+
+int main(int argc, char** argv)
+{
+	test_lru();
+	test_no_wasted_eviction();
+	test_random_trace(int(get_size_arg(argc, argv, 3000)));
+	return 0;
+}
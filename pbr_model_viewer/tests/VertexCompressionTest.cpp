@@ -0,0 +1,150 @@
+// compress_vertices round trip: positions within half a quantization step of the mesh bounds, normals and tangents
+// within the octahedral snorm16 precision, uvs within half float rounding, the bitangent sign kept and 20 bytes per
+// vertex. Also checks the half float stand-in the Linux build uses against every half value.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <DirectXPackedVector.h>
+#include <mesh/VertexCompression.h>
+
+#include "TestUtils.h"
+
+using DirectX::XMFLOAT3;
+
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex must stay 20 bytes");
+
+static XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static XMFLOAT3 normalize(const XMFLOAT3& v)
+{
+	float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	return { v.x / length, v.y / length, v.z / length };
+}
+
+static Vertex make_vertex(const XMFLOAT3& position, const XMFLOAT3& normal, const XMFLOAT3& direction, float sign, float u, float v)
+{
+	Vertex vert = {};
+	vert.position = position;
+	vert.normal = normalize(normal);
+	vert.tangent = normalize(cross(cross(vert.normal, direction), vert.normal));
+	XMFLOAT3 bitangent = cross(vert.normal, vert.tangent);
+	vert.bitangent = { bitangent.x * sign, bitangent.y * sign, bitangent.z * sign };
+	vert.uvs = { u, v };
+	return vert;
+}
+
+static std::vector<Vertex> make_vertices(UINT count, const XMFLOAT3& scale, const XMFLOAT3& offset)
+{
+	std::mt19937 rng(count);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<Vertex> vertices;
+	// Axis aligned normals and the corners of the octahedron, where the folding of the lower half meets the upper one
+	const XMFLOAT3 directions[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+									{ 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { 1, 1, 1 }, { -1, -1, -1 }, { 1, 0, -1 } };
+	for (const XMFLOAT3& normal : directions)
+	{
+		for (const XMFLOAT3& direction : directions)
+		{
+			if (std::fabs(std::fabs(normalize(normal).x * normalize(direction).x + normalize(normal).y * normalize(direction).y +
+									normalize(normal).z * normalize(direction).z) - 1.0f) < 1e-3f)
+			{
+				continue;
+			}
+			vertices.push_back(make_vertex(offset, normal, direction, vertices.size() % 2 ? 1.0f : -1.0f, 0.0f, 1.0f));
+		}
+	}
+	while (vertices.size() < count)
+	{
+		XMFLOAT3 position = { offset.x + unit(rng) * scale.x, offset.y + unit(rng) * scale.y, offset.z + unit(rng) * scale.z };
+		XMFLOAT3 normal = { unit(rng), unit(rng), unit(rng) };
+		XMFLOAT3 direction = { unit(rng), unit(rng), unit(rng) };
+		if (normal.x * normal.x + normal.y * normal.y + normal.z * normal.z < 1e-4f) continue;
+		if (std::fabs(cross(normalize(normal), direction).x) + std::fabs(cross(normalize(normal), direction).y) < 1e-3f) continue;
+		float sign = rng() % 2 ? 1.0f : -1.0f;
+		// Tiled uvs go well past [0, 1], where half floats lose precision
+		vertices.push_back(make_vertex(position, normal, direction, sign, unit(rng) * 8.0f, unit(rng) * 0.01f));
+	}
+	return vertices;
+}
+
+static void check_round_trip(const std::vector<Vertex>& vertices)
+{
+	XMFLOAT3 bounds_min = vertices[0].position;
+	XMFLOAT3 bounds_max = vertices[0].position;
+	for (const Vertex& vert : vertices)
+	{
+		bounds_min = { std::min(bounds_min.x, vert.position.x), std::min(bounds_min.y, vert.position.y), std::min(bounds_min.z, vert.position.z) };
+		bounds_max = { std::max(bounds_max.x, vert.position.x), std::max(bounds_max.y, vert.position.y), std::max(bounds_max.z, vert.position.z) };
+	}
+	MeshDequantization dequantization = make_dequantization(bounds_min, bounds_max);
+	std::vector<CompactVertex> compressed(vertices.size());
+	compress_vertices(vertices.data(), UINT(vertices.size()), dequantization, compressed.data());
+	CHECK(compressed.size() * sizeof(CompactVertex) == vertices.size() * 20);
+
+	// Half a step of 1/32767 of the extent per axis, plus float rounding of the center and extent
+	const DirectX::XMFLOAT4& extent = dequantization.boundsExtent;
+	const DirectX::XMFLOAT4& center = dequantization.boundsCenter;
+	float magnitude = std::fabs(center.x) + std::fabs(center.y) + std::fabs(center.z) + extent.x + extent.y + extent.z;
+	float max_position_error = 0.5f * std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z) / 32767.0f + magnitude * 1e-6f;
+
+	VertexCompressionStats stats = measure_compression_error(vertices.data(), compressed.data(), UINT(vertices.size()), dequantization);
+	std::printf("%zu vertices: position %g (bound %g), normal %.4f deg, tangent %.4f deg, uv %g\n", vertices.size(), stats.maxPositionError,
+				max_position_error, stats.maxNormalError, stats.maxTangentError, stats.maxUvError);
+	CHECK(stats.maxPositionError <= max_position_error);
+	// snorm16 octahedral directions are good to a few thousandths of a degree, but the float acos of the measurement
+	// can't resolve less than about 0.03 degrees
+	CHECK(stats.maxNormalError < 0.05f && stats.maxTangentError < 0.05f);
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& vert = vertices[i];
+		const CompactVertex& compact = compressed[i];
+		// The shader rebuilds the bitangent as cross(normal, tangent) * sign
+		XMFLOAT3 rebuilt = cross(vert.normal, vert.tangent);
+		float sign = compact.position[3] / 32767.0f;
+		CHECK(sign == 1.0f || sign == -1.0f);
+		CHECK(rebuilt.x * vert.bitangent.x * sign + rebuilt.y * vert.bitangent.y * sign + rebuilt.z * vert.bitangent.z * sign > 0.99f);
+
+		// Half floats keep 11 significant bits, 2^-24 steps below 2^-14, and round to nearest loses half a step
+		for (int c = 0; c < 2; c++)
+		{
+			float uv = c == 0 ? vert.uvs.x : vert.uvs.y;
+			float decoded = DirectX::PackedVector::XMConvertHalfToFloat(compact.uvs[c]);
+			CHECK(std::fabs(decoded - uv) <= std::max(std::fabs(uv), std::ldexp(1.0f, -14)) * std::ldexp(1.0f, -11));
+		}
+	}
+}
+
+// Every finite half comes back from float unchanged, and floats halfway between two halves round to the even one
+static void test_half_conversion()
+{
+	for (UINT bits = 0; bits < 0x10000; bits++)
+	{
+		if ((bits & 0x7C00) == 0x7C00) continue;
+		float value = DirectX::PackedVector::XMConvertHalfToFloat(DirectX::PackedVector::HALF(bits));
+		CHECK(DirectX::PackedVector::XMConvertFloatToHalf(value) == bits);
+	}
+	CHECK(DirectX::PackedVector::XMConvertHalfToFloat(0x3C00) == 1.0f);
+	CHECK(DirectX::PackedVector::XMConvertHalfToFloat(0xC000) == -2.0f);
+	CHECK(DirectX::PackedVector::XMConvertHalfToFloat(0x0001) == std::ldexp(1.0f, -24));
+	CHECK(DirectX::PackedVector::XMConvertFloatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3C00);
+	CHECK(DirectX::PackedVector::XMConvertFloatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)) == 0x3C02);
+	CHECK(DirectX::PackedVector::XMConvertFloatToHalf(1e6f) == 0x7C00);
+}
+
+int main(int argc, char** argv)
+{
+	test_half_conversion();
+	UINT count = (UINT)get_size_arg(argc, argv, 100000);
+	check_round_trip(make_vertices(count, { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }));
+	// Far from the origin and stretched, each axis gets its own scale
+	check_round_trip(make_vertices(count, { 500.0f, 0.25f, 20.0f }, { 1000.0f, -30.0f, 7.0f }));
+	// Flat along z, the extent stays above zero
+	check_round_trip(make_vertices(count, { 3.0f, 3.0f, 0.0f }, { 0.0f, 0.0f, 2.0f }));
+	return 0;
+}
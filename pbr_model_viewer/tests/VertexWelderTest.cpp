@@ -0,0 +1,144 @@
+// weld_vertices keeps every corner's vertex, leaves no duplicates inside a submesh and gives the same bytes whatever
+// the thread count. Prints the throughput.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <JobSystem.h>
+#include <mesh/VertexWelder.h>
+
+#include "TestUtils.h"
+
+// Submeshes of unindexed corners picked from small vertex pools, like assimp output after normal generation.
+// Positions sit in the middle of 0.5 grid cells plus some jitter, so epsilon welding merges a known amount.
+static MeshData make_mesh(size_t corner_count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	MeshData mesh_data;
+	for (int s = 0; s < 3; s++)
+	{
+		Submesh submesh;
+		submesh.baseVertex = (UINT)mesh_data.vertices.size();
+		submesh.firstIndex = (UINT)mesh_data.indices.size();
+		std::vector<Vertex> pool(corner_count / 5 + 1);
+		for (Vertex& vertex : pool)
+		{
+			vertex = {};
+			vertex.position = { float(rng() % 100) + 0.25f, float(rng() % 100) + 0.25f, float(s) + 0.25f };
+			vertex.normal = { 0.0f, 0.0f, 1.0f };
+			vertex.uvs = { float(rng() % 4) * 0.5f + 0.25f, 0.25f };
+		}
+		for (size_t i = 0; i < corner_count; i++)
+		{
+			Vertex vertex = pool[rng() % pool.size()];
+			// Every other corner gets jittered within its 0.5 cell
+			if (rng() % 2)
+			{
+				vertex.position.x += float(rng() % 100) * 0.001f;
+			}
+			mesh_data.vertices.push_back(vertex);
+			mesh_data.indices.push_back((UINT)i);
+		}
+		submesh.vertexCount = (UINT)corner_count;
+		submesh.indexCount = (UINT)corner_count;
+		mesh_data.submeshes.push_back(submesh);
+	}
+	return mesh_data;
+}
+
+static bool same_vertex(const Vertex& a, const Vertex& b, float epsilon)
+{
+	if (epsilon == 0.0f)
+	{
+		return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+	}
+	const float* fa = reinterpret_cast<const float*>(&a);
+	const float* fb = reinterpret_cast<const float*>(&b);
+	for (size_t i = 0; i < sizeof(Vertex) / sizeof(float); i++)
+	{
+		if (std::fabs(fa[i] - fb[i]) > epsilon) return false;
+	}
+	return true;
+}
+
+// Welds a copy of the mesh single threaded and with thread_count threads and compares the results byte by byte
+static bool verify_weld_determinism(const MeshData& mesh_data, float epsilon, size_t thread_count)
+{
+	MeshData single = mesh_data;
+	MeshData threaded = mesh_data;
+	weld_vertices(single, epsilon, 1);
+	weld_vertices(threaded, epsilon, thread_count);
+	auto same = [](const auto& a, const auto& b)
+	{
+		return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0);
+	};
+	return same(single.vertices, threaded.vertices) && same(single.indices, threaded.indices) && same(single.submeshes, threaded.submeshes);
+}
+
+static void check_weld(const MeshData& original, float epsilon, size_t thread_count)
+{
+	MeshData welded = original;
+	Timer timer;
+	UINT removed = weld_vertices(welded, epsilon, thread_count);
+	double ms = timer.elapsedMs();
+	CHECK(removed > 0);
+	CHECK(welded.vertices.size() == original.vertices.size() - removed);
+	CHECK(welded.submeshes.size() == original.submeshes.size());
+
+	UINT next_vertex = 0;
+	for (size_t s = 0; s < original.submeshes.size(); s++)
+	{
+		const Submesh& before = original.submeshes[s];
+		const Submesh& after = welded.submeshes[s];
+		CHECK(after.baseVertex == next_vertex);
+		CHECK(after.firstIndex == before.firstIndex && after.indexCount == before.indexCount);
+		next_vertex += after.vertexCount;
+		for (UINT i = 0; i < before.indexCount; i++)
+		{
+			UINT index = welded.indices[after.firstIndex + i];
+			CHECK(index < after.vertexCount);
+			const Vertex& expected = original.vertices[before.baseVertex + original.indices[before.firstIndex + i]];
+			CHECK(same_vertex(expected, welded.vertices[after.baseVertex + index], epsilon));
+		}
+		// Exact welding leaves no two identical vertices in a submesh
+		if (epsilon == 0.0f)
+		{
+			std::set<std::string> unique;
+			for (UINT v = 0; v < after.vertexCount; v++)
+			{
+				unique.insert(std::string(reinterpret_cast<const char*>(&welded.vertices[after.baseVertex + v]), sizeof(Vertex)));
+			}
+			CHECK(unique.size() == after.vertexCount);
+		}
+	}
+	CHECK(next_vertex == welded.vertices.size());
+	std::printf("epsilon %g, %zu threads: %zu -> %zu vertices, %.1f Mvertices/s\n", epsilon, thread_count, original.vertices.size(),
+		welded.vertices.size(), original.vertices.size() / (ms * 1000.0));
+}
+
+int main(int argc, char** argv)
+{
+	size_t corner_count = get_size_arg(argc, argv, 60000);
+	MeshData mesh_data = make_mesh(corner_count, 1);
+	size_t thread_count = JobSystem::get().getThreadCount();
+
+	for (float epsilon : { 0.0f, 0.5f })
+	{
+		check_weld(mesh_data, epsilon, 1);
+		check_weld(mesh_data, epsilon, std::max<size_t>(thread_count, 4));
+
+		// On the unwelded input, more shards than cores included
+		for (size_t threads : { 2, 3, 4, 7, 16 })
+		{
+			CHECK(verify_weld_determinism(mesh_data, epsilon, threads));
+		}
+	}
+	// A mesh too small to shard
+	CHECK(verify_weld_determinism(make_mesh(10, 2), 0.0f, 8));
+	return 0;
+}
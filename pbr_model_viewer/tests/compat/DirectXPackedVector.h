@@ -0,0 +1,77 @@
+#pragma once
+
+// Scalar stand-in for the half float conversions of DirectXPackedVector.h, rounding to nearest even like the real ones
+
+#include <cstdint>
+#include <cstring>
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		typedef uint16_t HALF;
+
+		inline float XMConvertHalfToFloat(HALF value)
+		{
+			uint32_t mantissa = value & 0x03FF;
+			uint32_t exponent = (value >> 10) & 0x1F;
+			uint32_t sign = uint32_t(value & 0x8000) << 16;
+			uint32_t bits;
+			if (exponent == 0x1F)
+			{
+				bits = sign | 0x7F800000 | (mantissa << 13);
+			}
+			else if (exponent != 0)
+			{
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			}
+			else if (mantissa != 0)
+			{
+				// Denormal, shifted up until the implicit bit shows
+				exponent = 113;
+				while (!(mantissa & 0x0400))
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+				bits = sign | (exponent << 23) | ((mantissa & 0x03FF) << 13);
+			}
+			else
+			{
+				bits = sign;
+			}
+			float result;
+			memcpy(&result, &bits, sizeof(result));
+			return result;
+		}
+
+		inline HALF XMConvertFloatToHalf(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			uint32_t sign = (bits >> 16) & 0x8000;
+			bits &= 0x7FFFFFFF;
+			uint32_t result;
+			if (bits >= 0x47FFF000)
+			{
+				// Too large for a half, infinities and NaNs included
+				result = bits > 0x7F800000 ? 0x7FFF : 0x7C00;
+			}
+			else
+			{
+				if (bits < 0x38800000)
+				{
+					// Denormal half, the implicit bit becomes explicit
+					uint32_t shift = 113 - (bits >> 23);
+					bits = shift < 24 ? (0x800000 | (bits & 0x7FFFFF)) >> shift : 0;
+				}
+				else
+				{
+					bits += 0xC8000000;
+				}
+				result = ((bits + 0x0FFF + ((bits >> 13) & 1)) >> 13) & 0x7FFF;
+			}
+			return HALF(result | sign);
+		}
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Win32 calls used by the portable sources, mapped to POSIX for the test build
+
+#include <sys/stat.h>
+
+inline int CreateDirectoryA(const char* path, void*)
+{
+	return mkdir(path, 0755) == 0;
+}
@@ -0,0 +1,25 @@
+// The header only assimp helpers (fast_atof, aiMesh) reference the logger and heap of the assimp library,
+// which isn't available on Linux. Logging goes nowhere in the test build.
+
+#include <assimp/DefaultLogger.hpp>
+
+namespace Assimp
+{
+	namespace Intern
+	{
+		void AllocateFromAssimpHeap::operator delete(void* data)
+		{
+			::operator delete(data);
+		}
+	}
+
+	Logger* DefaultLogger::get()
+	{
+		static NullLogger logger;
+		return &logger;
+	}
+
+	void Logger::warn(const char*)
+	{
+	}
+}
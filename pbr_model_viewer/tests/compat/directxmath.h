@@ -0,0 +1,68 @@
+#pragma once
+
+// Scalar stand-in for the DirectXMath types and functions used by the portable sources
+
+#include <cmath>
+
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+
+	struct XMFLOAT2
+	{
+		float x, y;
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+	};
+
+	struct alignas(16) XMVECTOR
+	{
+		float v[4];
+	};
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w)
+	{
+		return { { x, y, z, w } };
+	}
+
+	inline XMVECTOR XMVectorAdd(XMVECTOR a, XMVECTOR b)
+	{
+		return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+	}
+
+	inline XMVECTOR XMVectorSubtract(XMVECTOR a, XMVECTOR b)
+	{
+		return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+	}
+
+	inline XMVECTOR XMPlaneNormalize(XMVECTOR p)
+	{
+		float length = std::sqrt(p.v[0] * p.v[0] + p.v[1] * p.v[1] + p.v[2] * p.v[2]);
+		float scale = length > 0.0f ? 1.0f / length : 0.0f;
+		return { { p.v[0] * scale, p.v[1] * scale, p.v[2] * scale, p.v[3] * scale } };
+	}
+
+	inline void XMStoreFloat4(XMFLOAT4* out, XMVECTOR v)
+	{
+		*out = XMFLOAT4(v.v[0], v.v[1], v.v[2], v.v[3]);
+	}
+}
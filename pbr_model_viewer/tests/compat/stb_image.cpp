@@ -0,0 +1,3 @@
+// main.cpp owns the stb_image implementation in the application build
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <atomic>
+
+// Test double without the Direct3D dependency, counts destructions so tests can tell whether a bindable was freed
+class IBindable
+{
+public:
+	virtual ~IBindable() { destroyed++; }
+
+	static std::atomic<int> destroyed;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <bindable/IBindable.h>
+
+// Test double of the drawable: owns its bindables like IDrawable and registers itself while alive,
+// so tests can check when a mesh gets deleted. payload is filled by the producer and checked by the consumer.
+class Mesh
+{
+public:
+	Mesh()
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		live().insert(this);
+	}
+
+	~Mesh()
+	{
+		for (IBindable* bindable : bindables)
+		{
+			delete bindable;
+		}
+		std::lock_guard<std::mutex> lock(mutex());
+		live().erase(this);
+	}
+
+	void removeBindable(IBindable* bindable)
+	{
+		bindables.erase(std::remove(bindables.begin(), bindables.end(), bindable), bindables.end());
+	}
+
+	static bool isAlive(const Mesh* mesh)
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		return live().count(mesh) != 0;
+	}
+
+	static size_t getLiveCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		return live().size();
+	}
+
+	std::vector<IBindable*> bindables;
+	int payload[64];
+
+private:
+	static std::mutex& mutex()
+	{
+		static std::mutex instance;
+		return instance;
+	}
+
+	static std::set<const Mesh*>& live()
+	{
+		static std::set<const Mesh*> instance;
+		return instance;
+	}
+};